@@ -0,0 +1,249 @@
+#include <property_bag/serialization/property_bag_boost_serialization.h>
+#include <property_bag/serialization/eigen_boost_serialization.h>
+#include <property_bag/serialization/bulk_layout.h>
+#include <property_bag/serialization/endian.h>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * Boost archive internals : the type ids, byte swapping,
+ * vectors in bulk and sparse matrices.
+ */
+
+namespace {
+
+using property_bag::PropertyBag;
+
+// Many small properties
+const PropertyBag& small_properties_bag()
+{
+  static const PropertyBag bag = []()
+  {
+    PropertyBag bag;
+    for (int i=0; i<10000; ++i)
+      bag.addProperties("i" + std::to_string(i), i, "d" + std::to_string(i), i * 0.5);
+    return bag;
+  }();
+
+  return bag;
+}
+
+// Arg 0 : boost guids, 1 : compact type ids
+void BM_LoadTypeIds(benchmark::State& state)
+{
+  std::stringstream ss;
+  {
+    boost::archive::binary_oarchive oa(ss);
+    property_bag::set_compact_type_ids(oa, state.range(0) != 0);
+    oa << small_properties_bag();
+  }
+  const std::string bytes = ss.str();
+
+  state.SetLabel(state.range(0) != 0? "compact" : "guids");
+
+  for (auto _ : state)
+  {
+    PropertyBag loaded;
+    property_bag::from_bytes(bytes, loaded);
+    benchmark::DoNotOptimize(loaded);
+  }
+
+  state.counters["bytes"] = bytes.size();
+}
+
+// What loading a large array costs on a host
+// whose byte order differs from the archive's
+void BM_ByteSwap_PerValue(benchmark::State& state)
+{
+  std::vector<double> values(state.range(0));
+  for (std::size_t i=0; i<values.size(); ++i) values[i] = i * 0.5;
+
+  for (auto _ : state)
+  {
+    for (double& v : values) property_bag::details::byte_swap(v);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * values.size() * sizeof(double));
+}
+
+void BM_ByteSwap_Block(benchmark::State& state)
+{
+  std::vector<double> values(state.range(0));
+  for (std::size_t i=0; i<values.size(); ++i) values[i] = i * 0.5;
+
+  for (auto _ : state)
+  {
+    property_bag::details::byte_swap_block(values.data(), values.size());
+    benchmark::ClobberMemory();
+  }
+
+  state.SetBytesProcessed(state.iterations() * values.size() * sizeof(double));
+}
+
+template <typename T>
+std::vector<T> make_values();
+
+template <>
+std::vector<Eigen::Vector3d> make_values()
+{
+  std::vector<Eigen::Vector3d> points(100000);
+  for (auto& point : points) point = Eigen::Vector3d::Random();
+  return points;
+}
+
+template <>
+std::vector<Eigen::Isometry3d> make_values()
+{
+  std::vector<Eigen::Isometry3d> poses(10000);
+  for (auto& pose : poses)
+    pose = Eigen::Translation3d(Eigen::Vector3d::Random()) * Eigen::Quaterniond::UnitRandom();
+  return poses;
+}
+
+// The scalars of a point cloud as one array
+struct Bulk
+{
+  template <typename Archive, typename T>
+  static void save(Archive& oa, const std::vector<T>& values) { property_bag::details::save_bulk(oa, values); }
+
+  template <typename Archive, typename T>
+  static void load(Archive& ia, std::vector<T>& values) { property_bag::details::load_bulk(ia, values); }
+};
+
+// Boost, element by element
+struct PerElement
+{
+  template <typename Archive, typename T>
+  static void save(Archive& oa, const std::vector<T>& values) { oa << values; }
+
+  template <typename Archive, typename T>
+  static void load(Archive& ia, std::vector<T>& values) { ia >> values; }
+};
+
+template <typename Layout, typename OArchive, typename T>
+void BM_SaveVector(benchmark::State& state)
+{
+  const std::vector<T> values = make_values<T>();
+
+  for (auto _ : state)
+  {
+    std::stringstream ss;
+    { OArchive oa(ss, boost::archive::no_header); Layout::save(oa, values); }
+    benchmark::DoNotOptimize(ss.str());
+  }
+
+  state.SetBytesProcessed(state.iterations() * values.size() * sizeof(T));
+}
+
+template <typename Layout, typename OArchive, typename IArchive, typename T>
+void BM_LoadVector(benchmark::State& state)
+{
+  const std::vector<T> values = make_values<T>();
+
+  std::stringstream saved;
+  { OArchive oa(saved, boost::archive::no_header); Layout::save(oa, values); }
+  const std::string bytes = saved.str();
+
+  for (auto _ : state)
+  {
+    std::vector<T> loaded;
+    std::stringstream ss(bytes);
+    IArchive ia(ss, boost::archive::no_header);
+    Layout::load(ia, loaded);
+    benchmark::DoNotOptimize(loaded.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * values.size() * sizeof(T));
+}
+
+// About 10% of non zeros
+Eigen::SparseMatrix<double> random_sparse(const int rows, const int cols)
+{
+  std::default_random_engine gen;
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+
+  std::vector<Eigen::Triplet<double>> triplets;
+  for (int i=0; i<rows; ++i)
+    for (int j=0; j<cols; ++j)
+    {
+      const double v_ij = dist(gen);
+      if (v_ij < 0.1) triplets.emplace_back(i, j, v_ij*100);
+    }
+
+  Eigen::SparseMatrix<double> m(rows, cols);
+  m.setFromTriplets(triplets.begin(), triplets.end());
+  return m;
+}
+
+void BM_SaveSparseMatrix(benchmark::State& state)
+{
+  const Eigen::SparseMatrix<double> m = random_sparse(state.range(0), state.range(0));
+
+  for (auto _ : state)
+  {
+    std::stringstream ss;
+    { boost::archive::binary_oarchive oa(ss); oa << m; }
+    benchmark::DoNotOptimize(ss.str());
+  }
+
+  state.counters["non_zeros"] = m.nonZeros();
+}
+
+void BM_LoadSparseMatrix(benchmark::State& state)
+{
+  const Eigen::SparseMatrix<double> m = random_sparse(state.range(0), state.range(0));
+
+  std::stringstream saved;
+  { boost::archive::binary_oarchive oa(saved); oa << m; }
+  const std::string bytes = saved.str();
+
+  for (auto _ : state)
+  {
+    Eigen::SparseMatrix<double> loaded;
+    std::stringstream ss(bytes);
+    boost::archive::binary_iarchive ia(ss);
+    ia >> loaded;
+    benchmark::DoNotOptimize(loaded.valuePtr());
+  }
+
+  state.counters["non_zeros"] = m.nonZeros();
+}
+
+} // namespace
+
+BENCHMARK(BM_LoadTypeIds)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ByteSwap_PerValue)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ByteSwap_Block)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_TEMPLATE(BM_SaveVector, Bulk, boost::archive::binary_oarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_SaveVector, PerElement, boost::archive::binary_oarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_SaveVector, Bulk, property_bag::portable_binary_oarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_SaveVector, PerElement, property_bag::portable_binary_oarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_SaveVector, Bulk, boost::archive::binary_oarchive, Eigen::Isometry3d);
+BENCHMARK_TEMPLATE(BM_SaveVector, PerElement, boost::archive::binary_oarchive, Eigen::Isometry3d);
+
+BENCHMARK_TEMPLATE(BM_LoadVector, Bulk, boost::archive::binary_oarchive,
+                   boost::archive::binary_iarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_LoadVector, PerElement, boost::archive::binary_oarchive,
+                   boost::archive::binary_iarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_LoadVector, Bulk, property_bag::portable_binary_oarchive,
+                   property_bag::portable_binary_iarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_LoadVector, PerElement, property_bag::portable_binary_oarchive,
+                   property_bag::portable_binary_iarchive, Eigen::Vector3d);
+BENCHMARK_TEMPLATE(BM_LoadVector, Bulk, boost::archive::binary_oarchive,
+                   boost::archive::binary_iarchive, Eigen::Isometry3d);
+BENCHMARK_TEMPLATE(BM_LoadVector, PerElement, boost::archive::binary_oarchive,
+                   boost::archive::binary_iarchive, Eigen::Isometry3d);
+
+BENCHMARK(BM_SaveSparseMatrix)->Arg(300)->Arg(3000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadSparseMatrix)->Arg(300)->Arg(3000)->Unit(benchmark::kMillisecond);
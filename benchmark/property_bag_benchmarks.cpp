@@ -0,0 +1,315 @@
+#include <property_bag/property_bag.h>
+#include <property_bag/eigen_type_names.h>
+
+#include <benchmark/benchmark.h>
+
+#include <Eigen/Core>
+
+#include <string>
+#include <vector>
+
+/*
+ * Core PropertyBag operations across bag sizes and value types.
+ *
+ * Run with
+ *   property_bag_benchmarks --benchmark_out=results.json --benchmark_out_format=json
+ * or 'make run_property_bag_benchmarks' to have the results in JSON,
+ * to be compared across releases, e.g. with tools/compare.py of
+ * Google Benchmark.
+ */
+
+namespace {
+
+using property_bag::PropertyBag;
+using property_bag::RetrievalHandling;
+
+// Typical of a robot configuration, keys sharing a long prefix
+std::vector<std::string> make_keys(const std::size_t size, const std::string& prefix = "joint_")
+{
+  std::vector<std::string> keys;
+  keys.reserve(size);
+
+  for (std::size_t i=0; i<size; ++i)
+    keys.push_back("robot/arm/" + prefix + std::to_string(i) + "/gain");
+
+  return keys;
+}
+
+template <typename T>
+struct Value;
+
+template <>
+struct Value<double>
+{
+  static double make(const std::size_t i) { return i * 0.5; }
+};
+
+template <>
+struct Value<std::string>
+{
+  static std::string make(const std::size_t i) { return "base_link_" + std::to_string(i); }
+};
+
+template <>
+struct Value<Eigen::MatrixXd>
+{
+  static Eigen::MatrixXd make(const std::size_t i)
+  {
+    return Eigen::MatrixXd::Constant(6, 6, double(i));
+  }
+};
+
+template <>
+struct Value<PropertyBag>
+{
+  static PropertyBag make(const std::size_t i)
+  {
+    return PropertyBag("p", double(i), "i", int(i), "frame_id", std::string("link"));
+  }
+};
+
+template <typename T>
+PropertyBag make_bag(const std::vector<std::string>& keys)
+{
+  PropertyBag bag;
+  for (std::size_t i=0; i<keys.size(); ++i)
+    bag.addProperty(keys[i], Value<T>::make(i));
+  return bag;
+}
+
+template <typename T>
+void BM_AddProperty(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+
+  std::vector<T> values;
+  for (std::size_t i=0; i<keys.size(); ++i)
+    values.push_back(Value<T>::make(i));
+
+  for (auto _ : state)
+  {
+    PropertyBag bag;
+    for (std::size_t i=0; i<keys.size(); ++i)
+      bag.addProperty(keys[i], values[i]);
+
+    benchmark::DoNotOptimize(bag);
+  }
+
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename T>
+void BM_GetPropertyValue_Hit(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+  const PropertyBag bag = make_bag<T>(keys);
+
+  T value;
+  std::size_t i = 0;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(bag.getPropertyValue(keys[i], value));
+    if (++i == keys.size()) i = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+void BM_GetPropertyValue_Miss(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+  const std::vector<std::string> missing = make_keys(state.range(0), "missing_");
+  const PropertyBag bag = make_bag<T>(keys);
+
+  T value;
+  std::size_t i = 0;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(bag.getPropertyValue(missing[i], value));
+    if (++i == missing.size()) i = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+void BM_UpdateProperty(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+  PropertyBag bag = make_bag<T>(keys);
+
+  const T value = Value<T>::make(42);
+  std::size_t i = 0;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(bag.updateProperty(keys[i], value));
+    if (++i == keys.size()) i = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// A key found with another type
+void BM_GetPropertyValue_Mismatch_Quiet(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+  const PropertyBag bag = make_bag<double>(keys);
+
+  int value;
+  std::size_t i = 0;
+
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(bag.getPropertyValue(keys[i], value, RetrievalHandling::QUIET));
+    if (++i == keys.size()) i = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_GetPropertyValue_Mismatch_Throw(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+  const PropertyBag bag = make_bag<double>(keys);
+
+  int value;
+  std::size_t i = 0;
+
+  for (auto _ : state)
+  {
+    try
+    {
+      bag.getPropertyValue(keys[i], value, RetrievalHandling::THROW);
+    }
+    catch (const property_bag::PropertyException& e)
+    {
+      benchmark::DoNotOptimize(e.what());
+    }
+    if (++i == keys.size()) i = 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The message lists every key of the bag
+void BM_GetPropertyValue_Miss_Throw(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+  const PropertyBag bag = make_bag<double>(keys);
+
+  double value;
+
+  for (auto _ : state)
+  {
+    try
+    {
+      bag.getPropertyValue("missing", value, RetrievalHandling::THROW);
+    }
+    catch (const property_bag::PropertyException& e)
+    {
+      benchmark::DoNotOptimize(e.what());
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+void BM_Copy(benchmark::State& state)
+{
+  const PropertyBag bag = make_bag<T>(make_keys(state.range(0)));
+
+  for (auto _ : state)
+  {
+    PropertyBag copy(bag);
+    benchmark::DoNotOptimize(copy);
+  }
+
+  state.SetItemsProcessed(state.iterations() * bag.size());
+}
+
+template <typename T>
+void BM_Move(benchmark::State& state)
+{
+  PropertyBag bag = make_bag<T>(make_keys(state.range(0)));
+
+  for (auto _ : state)
+  {
+    PropertyBag moved(std::move(bag));
+    bag = std::move(moved);
+    benchmark::DoNotOptimize(bag);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Half of the keys of 'other' are already in the bag
+template <typename T>
+void BM_Append(benchmark::State& state)
+{
+  const std::vector<std::string> keys = make_keys(state.range(0));
+
+  const PropertyBag bag = make_bag<T>(keys);
+  const PropertyBag other = make_bag<T>(
+        std::vector<std::string>(keys.begin() + keys.size()/2, keys.end()));
+  const PropertyBag others = make_bag<T>(make_keys(keys.size()/2, "other_"));
+
+  PropertyBag appended;
+  appended.append(other);
+  appended.append(others);
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    PropertyBag target(bag);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(target.append(appended));
+  }
+
+  state.SetItemsProcessed(state.iterations() * appended.size());
+}
+
+template <typename T>
+void BM_ListProperties(benchmark::State& state)
+{
+  const PropertyBag bag = make_bag<T>(make_keys(state.range(0)));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(bag.listProperties());
+
+  state.SetItemsProcessed(state.iterations() * bag.size());
+}
+
+// 10 to 100k keys
+void Sizes(benchmark::internal::Benchmark* b)
+{
+  b->RangeMultiplier(10)->Range(10, 100000);
+}
+
+} // namespace
+
+#define PROPERTY_BAG_BENCHMARK_TYPES(Benchmark)                   \
+  BENCHMARK_TEMPLATE(Benchmark, double)->Apply(Sizes);           \
+  BENCHMARK_TEMPLATE(Benchmark, std::string)->Apply(Sizes);      \
+  BENCHMARK_TEMPLATE(Benchmark, Eigen::MatrixXd)->Apply(Sizes);  \
+  BENCHMARK_TEMPLATE(Benchmark, PropertyBag)->Apply(Sizes);
+
+PROPERTY_BAG_BENCHMARK_TYPES(BM_AddProperty)
+PROPERTY_BAG_BENCHMARK_TYPES(BM_GetPropertyValue_Hit)
+PROPERTY_BAG_BENCHMARK_TYPES(BM_GetPropertyValue_Miss)
+PROPERTY_BAG_BENCHMARK_TYPES(BM_UpdateProperty)
+PROPERTY_BAG_BENCHMARK_TYPES(BM_Copy)
+PROPERTY_BAG_BENCHMARK_TYPES(BM_Move)
+PROPERTY_BAG_BENCHMARK_TYPES(BM_Append)
+PROPERTY_BAG_BENCHMARK_TYPES(BM_ListProperties)
+
+BENCHMARK(BM_GetPropertyValue_Mismatch_Quiet)->Apply(Sizes);
+BENCHMARK(BM_GetPropertyValue_Mismatch_Throw)->Apply(Sizes);
+BENCHMARK(BM_GetPropertyValue_Miss_Throw)->Apply(Sizes);
+
+BENCHMARK_MAIN();
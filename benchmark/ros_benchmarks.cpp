@@ -0,0 +1,327 @@
+#include <property_bag/serialization/ros_boost_serialization.h>
+#include <property_bag/serialization/ros_serialization.h>
+#include <property_bag/serialization/property_bag_boost_serialization.h>
+#include <property_bag/xmlrpc.h>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/split_member.hpp>
+
+#include <geometry_msgs/PoseStamped.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * ROS messages in boost archives, bags in ROS messages
+ * and bags from the parameter server.
+ */
+
+namespace {
+
+using property_bag::PropertyBag;
+
+/**
+ * @brief Legacy. The version 0 serialization of
+ * a message, allocating a buffer for each.
+ */
+template <typename Msg>
+struct Legacy
+{
+  Msg& m;
+
+  template<class Archive>
+  void save(Archive & ar, const unsigned int /*version*/) const
+  {
+    ros::SerializedMessage serialized_msg = ros::serialization::serializeMessage(m);
+    size_t num_bytes = serialized_msg.num_bytes;
+    ptrdiff_t start_offset = serialized_msg.message_start - serialized_msg.buf.get();
+    ar & BOOST_SERIALIZATION_NVP(num_bytes);
+    ar & BOOST_SERIALIZATION_NVP(start_offset);
+    ar & boost::serialization::make_nvp("buffer",
+          boost::serialization::make_array(serialized_msg.buf.get(), num_bytes));
+  }
+
+  template<class Archive>
+  void load(Archive & ar, const unsigned int /*version*/)
+  {
+    ros::SerializedMessage serialized_msg;
+    ar & boost::serialization::make_nvp("num_bytes", serialized_msg.num_bytes);
+    ptrdiff_t start_offset;
+    ar & BOOST_SERIALIZATION_NVP(start_offset);
+    serialized_msg.buf.reset(new uint8_t[serialized_msg.num_bytes]);
+    ar & boost::serialization::make_nvp("buffer",
+          boost::serialization::make_array(serialized_msg.buf.get(), serialized_msg.num_bytes));
+    serialized_msg.message_start = serialized_msg.buf.get() + start_offset;
+    ros::serialization::deserializeMessage(serialized_msg, m);
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+};
+
+// The message itself
+template <typename Msg>
+struct Current
+{
+  Msg& m;
+
+  template<class Archive>
+  void serialize(Archive & ar, const unsigned int /*version*/)
+  {
+    ar & m;
+  }
+};
+
+geometry_msgs::PoseStamped make_pose()
+{
+  geometry_msgs::PoseStamped pose_stamped;
+  pose_stamped.header.frame_id = "base_link";
+  pose_stamped.pose.orientation.w = 1.0;
+  return pose_stamped;
+}
+
+// Arg messages per archive
+template <template <typename> class Layout>
+void BM_SavePoseStamped(benchmark::State& state)
+{
+  geometry_msgs::PoseStamped pose_stamped = make_pose();
+  const Layout<geometry_msgs::PoseStamped> layout{pose_stamped};
+
+  for (auto _ : state)
+  {
+    std::stringstream ss;
+    {
+      boost::archive::binary_oarchive oa(ss);
+      for (int i=0; i<state.range(0); ++i)
+        oa << layout;
+    }
+    benchmark::DoNotOptimize(ss.str());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <template <typename> class Layout>
+void BM_LoadPoseStamped(benchmark::State& state)
+{
+  geometry_msgs::PoseStamped pose_stamped = make_pose();
+
+  std::stringstream saved;
+  {
+    boost::archive::binary_oarchive oa(saved);
+    const Layout<geometry_msgs::PoseStamped> layout{pose_stamped};
+    for (int i=0; i<state.range(0); ++i)
+      oa << layout;
+  }
+  const std::string bytes = saved.str();
+
+  geometry_msgs::PoseStamped loaded;
+  Layout<geometry_msgs::PoseStamped> layout{loaded};
+
+  for (auto _ : state)
+  {
+    std::stringstream ss(bytes);
+    boost::archive::binary_iarchive ia(ss);
+    for (int i=0; i<state.range(0); ++i)
+      ia >> layout;
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+const PropertyBag& message_bag()
+{
+  static const PropertyBag bag = []()
+  {
+    PropertyBag bag;
+    for (int i=0; i<1000; ++i)
+      bag.addProperties("joint_" + std::to_string(i) + "/gain", 100. + i,
+                        "joint_" + std::to_string(i) + "/frame_id", "joint_" + std::to_string(i) + "_link");
+    bag.addProperty("calibration", std::vector<double>(10000, 0.1));
+    return bag;
+  }();
+
+  return bag;
+}
+
+template <typename T>
+std::vector<std::uint8_t> serialize(const T& t)
+{
+  std::vector<std::uint8_t> buffer(ros::serialization::serializationLength(t));
+
+  ros::serialization::OStream stream(buffer.data(), buffer.size());
+  ros::serialization::serialize(stream, t);
+
+  return buffer;
+}
+
+template <typename T>
+void deserialize(std::vector<std::uint8_t>& buffer, T& t)
+{
+  ros::serialization::IStream stream(buffer.data(), buffer.size());
+  ros::serialization::deserialize(stream, t);
+}
+
+// The bag as a message field
+void BM_SaveBagField(benchmark::State& state)
+{
+  for (auto _ : state)
+    benchmark::DoNotOptimize(serialize(message_bag()));
+}
+
+void BM_LoadBagField(benchmark::State& state)
+{
+  std::vector<std::uint8_t> buffer = serialize(message_bag());
+
+  for (auto _ : state)
+  {
+    PropertyBag loaded;
+    deserialize(buffer, loaded);
+    benchmark::DoNotOptimize(loaded);
+  }
+
+  state.counters["bytes"] = buffer.size();
+}
+
+// A boost text archive held by a std_msgs/String
+void BM_SaveBagString(benchmark::State& state)
+{
+  for (auto _ : state)
+    benchmark::DoNotOptimize(serialize(property_bag::to_str(message_bag())));
+}
+
+void BM_LoadBagString(benchmark::State& state)
+{
+  std::vector<std::uint8_t> buffer = serialize(property_bag::to_str(message_bag()));
+
+  for (auto _ : state)
+  {
+    std::string data;
+    deserialize(buffer, data);
+
+    PropertyBag loaded;
+    property_bag::from_str(data, loaded);
+    benchmark::DoNotOptimize(loaded);
+  }
+
+  state.counters["bytes"] = buffer.size();
+}
+
+// 5000 parameters
+XmlRpc::XmlRpcValue make_params()
+{
+  XmlRpc::XmlRpcValue params;
+  for (int i=0; i<1000; ++i)
+  {
+    XmlRpc::XmlRpcValue& joint = params["joint_" + std::to_string(i)];
+    joint["gain"] = XmlRpc::XmlRpcValue(100. + i);
+    joint["enabled"] = XmlRpc::XmlRpcValue(i%2 == 0);
+    joint["index"] = XmlRpc::XmlRpcValue(i);
+    joint["frame_id"] = XmlRpc::XmlRpcValue("joint_" + std::to_string(i) + "_link");
+    joint["limits"][0] = XmlRpc::XmlRpcValue(-1.5);
+    joint["limits"][1] = XmlRpc::XmlRpcValue(1.5);
+  }
+  return params;
+}
+
+// What ros::param::get does once the value is fetched from the master
+bool get_param(XmlRpc::XmlRpcValue& root, const std::string& key, XmlRpc::XmlRpcValue& value)
+{
+  XmlRpc::XmlRpcValue* node = &root;
+
+  for (std::size_t begin = 0, end = 0; begin < key.size(); begin = end + 1)
+  {
+    end = key.find('/', begin);
+    if (end == std::string::npos) end = key.size();
+
+    const std::string name = key.substr(begin, end - begin);
+    if (!node->hasMember(name)) return false;
+
+    node = &(*node)[name];
+  }
+
+  value = *node; // handed out by copy
+  return true;
+}
+
+template <typename T>
+void load_param(XmlRpc::XmlRpcValue& root, const std::string& key, PropertyBag& bag)
+{
+  XmlRpc::XmlRpcValue value;
+  if (get_param(root, key, value))
+    bag.addProperty(key, T(static_cast<T&>(value)));
+}
+
+void load_vector_param(XmlRpc::XmlRpcValue& root, const std::string& key, PropertyBag& bag)
+{
+  XmlRpc::XmlRpcValue value;
+  if (!get_param(root, key, value)) return;
+
+  std::vector<double> values(value.size());
+  for (int i=0; i<value.size(); ++i)
+    values[i] = static_cast<double&>(value[i]);
+
+  bag.addProperty(key, std::move(values));
+}
+
+// Typically one getParam call per key, each call being an additional
+// round trip to the master, not accounted for here.
+void BM_ParamsPerKey(benchmark::State& state)
+{
+  XmlRpc::XmlRpcValue params = make_params();
+
+  for (auto _ : state)
+  {
+    PropertyBag bag;
+    for (int i=0; i<1000; ++i)
+    {
+      const std::string joint = "joint_" + std::to_string(i) + "/";
+      load_param<double>(params, joint + "gain", bag);
+      load_param<bool>(params, joint + "enabled", bag);
+      load_param<int>(params, joint + "index", bag);
+      load_param<std::string>(params, joint + "frame_id", bag);
+      load_vector_param(params, joint + "limits", bag);
+    }
+    benchmark::DoNotOptimize(bag);
+  }
+}
+
+void BM_FromXmlRpc(benchmark::State& state)
+{
+  const XmlRpc::XmlRpcValue params = make_params();
+
+  for (auto _ : state)
+  {
+    PropertyBag bag;
+    property_bag::from_xmlrpc(params, bag);
+    benchmark::DoNotOptimize(bag);
+  }
+}
+
+void BM_ToXmlRpc(benchmark::State& state)
+{
+  PropertyBag bag;
+  property_bag::from_xmlrpc(make_params(), bag);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property_bag::to_xmlrpc(bag));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_SavePoseStamped, Legacy)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SavePoseStamped, Current)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_LoadPoseStamped, Legacy)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_LoadPoseStamped, Current)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_SaveBagField)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadBagField)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SaveBagString)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadBagString)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ParamsPerKey)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FromXmlRpc)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ToXmlRpc)->Unit(benchmark::kMillisecond);
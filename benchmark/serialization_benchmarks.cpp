@@ -0,0 +1,526 @@
+#include <property_bag/serialization/property_bag_boost_serialization.h>
+#include <property_bag/serialization/eigen_boost_serialization.h>
+#include <property_bag/serialization/eigen_wire_format.h>
+#include <property_bag/serialization/eigen_json_format.h>
+#include <property_bag/serialization/eigen_mapped_bag.h>
+#include <property_bag/serialization/delta_boost_serialization.h>
+#include <property_bag/serialization/journal.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <list>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+/*
+ * Serialization formats, compression, mapped bags,
+ * the journal and deltas, on two typical bags:
+ * a configuration, many small values with descriptions,
+ * and a calibration, a few large arrays.
+ */
+
+namespace {
+
+using property_bag::PropertyBag;
+
+// Many keys, descriptions and small values
+PropertyBag make_configuration_bag()
+{
+  PropertyBag bag;
+  bag.name("robot_configuration");
+
+  const std::vector<std::string> joints = {"arm_left", "arm_right", "head", "torso", "wheel"};
+
+  for (int i=0; i<400; ++i)
+  {
+    const std::string joint = joints[i % joints.size()] + "_" + std::to_string(i/joints.size()+1) + "_joint";
+
+    bag.addPropertiesWithDoc(joint + "/controller/gains/p", 100. + i%7, "Proportional gain of the " + joint + " position controller",
+                             joint + "/controller/gains/d", 0.5, "Derivative gain of the " + joint + " position controller",
+                             joint + "/limits/max_velocity", 2.5, "Maximum velocity of the " + joint + " in rad/s",
+                             joint + "/enabled", true, "Whether " + joint + " is enabled",
+                             joint + "/frame_id", joint + "_link", "The frame attached to " + joint);
+  }
+
+  return bag;
+}
+
+// Smooth numeric arrays
+PropertyBag make_calibration_bag()
+{
+  PropertyBag bag;
+  bag.name("camera_calibration");
+
+  for (int c=0; c<8; ++c)
+  {
+    Eigen::VectorXd lut(20000);
+    for (int i=0; i<lut.size(); ++i)
+      lut[i] = std::round(std::sin(i*1e-3 + c) * 1e4) * 1e-4;
+
+    bag.addProperty("camera_" + std::to_string(c) + "/distortion_lut", lut);
+    bag.addProperty("camera_" + std::to_string(c) + "/offsets", std::vector<double>(5000, c * 0.125));
+  }
+
+  return bag;
+}
+
+// Arg 0 : configuration, 1 : calibration
+const PropertyBag& bag_of(const benchmark::State& state)
+{
+  static const PropertyBag configuration = make_configuration_bag();
+  static const PropertyBag calibration   = make_calibration_bag();
+
+  return (state.range(0) == 0)? configuration : calibration;
+}
+
+struct Text
+{
+  static std::string save(const PropertyBag& bag) { return property_bag::to_str(bag); }
+  static void load(const std::string& s, PropertyBag& bag) { property_bag::from_str(s, bag); }
+};
+
+struct Binary
+{
+  static std::string save(const PropertyBag& bag) { return property_bag::to_bytes(bag); }
+  static void load(const std::string& s, PropertyBag& bag) { property_bag::from_bytes(s, bag); }
+};
+
+struct PortableBinary
+{
+  static std::string save(const PropertyBag& bag)
+  {
+    return property_bag::to_bytes<property_bag::portable_binary_oarchive>(bag);
+  }
+  static void load(const std::string& s, PropertyBag& bag)
+  {
+    property_bag::from_bytes<property_bag::portable_binary_iarchive>(s, bag);
+  }
+};
+
+struct Wire
+{
+  static std::string save(const PropertyBag& bag) { return property_bag::to_wire(bag); }
+  static void load(const std::string& s, PropertyBag& bag) { property_bag::from_wire(s, bag); }
+};
+
+struct Json
+{
+  static std::string save(const PropertyBag& bag) { return property_bag::to_json(bag); }
+  static void load(const std::string& s, PropertyBag& bag) { property_bag::from_json(s, bag); }
+};
+
+template <typename Format>
+void BM_Save(benchmark::State& state)
+{
+  const PropertyBag& bag = bag_of(state);
+
+  std::size_t size = 0;
+  for (auto _ : state)
+  {
+    const std::string bytes = Format::save(bag);
+    size = bytes.size();
+    benchmark::DoNotOptimize(bytes.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * size);
+  state.counters["bytes"] = size;
+}
+
+template <typename Format>
+void BM_Load(benchmark::State& state)
+{
+  const std::string bytes = Format::save(bag_of(state));
+
+  for (auto _ : state)
+  {
+    PropertyBag loaded;
+    Format::load(bytes, loaded);
+    benchmark::DoNotOptimize(loaded);
+  }
+
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// A shared robot configuration of which 5% of the keys are read
+void BM_WireStartup(benchmark::State& state)
+{
+  PropertyBag bag;
+  for (int i=0; i<500; ++i)
+  {
+    const std::string n = std::to_string(i);
+
+    const PropertyBag joint("limit", double(i),
+                            "frame", "joint_" + n,
+                            "gains", std::vector<double>{1., 2., 3.});
+
+    bag.addProperties("matrix_" + n, Eigen::MatrixXd(Eigen::MatrixXd::Random(6, 6)),
+                      "lut_" + n,    std::vector<double>(256, 0.1),
+                      "frame_" + n,  "link_" + n + "_frame",
+                      "joint_" + n,  joint);
+  }
+
+  const std::string bytes = property_bag::to_wire(bag);
+
+  std::vector<std::string> used;
+  std::size_t k = 0;
+  for (const auto& key : bag.listProperties())
+    if (k++ % 20 == 0) used.push_back(key);
+
+  const property_bag::wire::LoadMode mode = (state.range(0) == 0)?
+        property_bag::wire::LoadMode::EAGER : property_bag::wire::LoadMode::LAZY;
+
+  state.SetLabel(state.range(0) == 0? "eager" : "lazy");
+
+  for (auto _ : state)
+  {
+    PropertyBag loaded;
+    property_bag::from_wire(bytes, loaded, mode);
+
+    // Decodes a lazily loaded value
+    for (const auto& key : used)
+    {
+      const property_bag::Property& p = loaded.getProperty(key);
+      benchmark::DoNotOptimize(p.is_same<std::string>()          ? p.get_if<std::string>() != nullptr          :
+                               p.is_same<Eigen::MatrixXd>()      ? p.get_if<Eigen::MatrixXd>() != nullptr      :
+                               p.is_same<std::vector<double>>()  ? p.get_if<std::vector<double>>() != nullptr  :
+                                                                   p.get_if<PropertyBag>() != nullptr);
+    }
+  }
+}
+
+// Copies the bytes into a fixed buffer, as a socket or a file would
+class ScratchBuffer : public std::streambuf
+{
+protected:
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override
+  {
+    for (std::streamsize done=0; done<n; )
+    {
+      const std::streamsize chunk = std::min<std::streamsize>(n - done, scratch_.size());
+      std::memcpy(scratch_.data(), s + done, chunk);
+      done += chunk;
+    }
+    benchmark::ClobberMemory();
+    return n;
+  }
+
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+
+private:
+
+  std::vector<char> scratch_ = std::vector<char>(1 << 16);
+};
+
+// Streamed against held in memory
+void BM_WireStream(benchmark::State& state)
+{
+  PropertyBag bag;
+  for (int i=0; i<8; ++i)
+  {
+    const PropertyBag nested("samples", std::vector<double>(500000, double(i)),
+                             "matrix", Eigen::MatrixXd(Eigen::MatrixXd::Constant(500, 500, i)));
+
+    bag.addProperty("nested_" + std::to_string(i), nested);
+  }
+
+  const bool streamed = state.range(0) != 0;
+  state.SetLabel(streamed? "stream" : "memory");
+
+  ScratchBuffer sink;
+  std::ostream os(&sink);
+
+  for (auto _ : state)
+  {
+    if (streamed)
+      property_bag::to_wire(bag, os);
+    else
+      benchmark::DoNotOptimize(property_bag::to_wire(bag));
+  }
+
+  state.SetBytesProcessed(state.iterations() * property_bag::wire_size(bag));
+}
+
+const PropertyBag& parallel_bag()
+{
+  static const PropertyBag bag = []()
+  {
+    PropertyBag bag;
+    for (int i=0; i<2000; ++i)
+    {
+      bag.addProperty("matrix_" + std::to_string(i), Eigen::MatrixXd(Eigen::MatrixXd::Random(30, 30)));
+      bag.addProperty("lut_" + std::to_string(i), std::vector<double>(1000, i));
+      bag.addProperty("name_" + std::to_string(i), std::string(64, 'n'));
+    }
+    return bag;
+  }();
+
+  return bag;
+}
+
+void BM_WireSaveParallel(benchmark::State& state)
+{
+  const PropertyBag& bag = parallel_bag();
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property_bag::to_wire_parallel(bag, state.range(0)));
+
+  state.SetBytesProcessed(state.iterations() * property_bag::wire_size(bag));
+}
+
+void BM_WireLoadParallel(benchmark::State& state)
+{
+  const std::string bytes = property_bag::to_wire(parallel_bag());
+
+  for (auto _ : state)
+  {
+    PropertyBag loaded;
+    property_bag::from_wire_parallel(bytes, loaded, state.range(0));
+    benchmark::DoNotOptimize(loaded);
+  }
+
+  state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+
+// Args : bag, compression, level
+void BM_Compress(benchmark::State& state)
+{
+  const std::string binary = property_bag::to_bytes(bag_of(state));
+
+  const property_bag::Compression compression = (state.range(1) == 0)?
+        property_bag::Compression::ZLIB : property_bag::Compression::BZIP2;
+
+  std::size_t size = 0;
+  for (auto _ : state)
+  {
+    const std::string compressed = property_bag::compress(binary, compression, state.range(2));
+    size = compressed.size();
+  }
+
+  state.SetBytesProcessed(state.iterations() * binary.size());
+  state.counters["ratio"] = double(binary.size()) / size;
+}
+
+void BM_Decompress(benchmark::State& state)
+{
+  const std::string binary = property_bag::to_bytes(bag_of(state));
+
+  const property_bag::Compression compression = (state.range(1) == 0)?
+        property_bag::Compression::ZLIB : property_bag::Compression::BZIP2;
+
+  const std::string compressed = property_bag::compress(binary, compression, state.range(2));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property_bag::decompress(compressed));
+
+  state.SetBytesProcessed(state.iterations() * binary.size());
+}
+
+struct TemporaryFile
+{
+  TemporaryFile()
+  {
+    char name[] = "/tmp/property_bag_XXXXXX";
+    ::close(::mkstemp(name));
+    path = name;
+  }
+
+  ~TemporaryFile() { std::remove(path.c_str()); }
+
+  std::string path;
+};
+
+// Independent of the payload, 20 matrices of Arg x Arg
+void BM_MappedOpen(benchmark::State& state)
+{
+  PropertyBag bag;
+  for (int i=0; i<20; ++i)
+    bag.addProperty("matrix_" + std::to_string(i),
+                    Eigen::MatrixXd(Eigen::MatrixXd::Random(state.range(0), state.range(0))));
+
+  TemporaryFile file;
+  property_bag::write_mapped(bag, file.path);
+
+  for (auto _ : state)
+  {
+    property_bag::MappedPropertyBag mapped(file.path);
+    benchmark::DoNotOptimize(mapped.size());
+  }
+}
+
+// The same bag decoded from the wire format
+void BM_MappedOpen_WireLoad(benchmark::State& state)
+{
+  PropertyBag bag;
+  for (int i=0; i<20; ++i)
+    bag.addProperty("matrix_" + std::to_string(i),
+                    Eigen::MatrixXd(Eigen::MatrixXd::Random(state.range(0), state.range(0))));
+
+  const std::string bytes = property_bag::to_wire(bag);
+
+  for (auto _ : state)
+  {
+    PropertyBag loaded;
+    property_bag::from_wire(bytes, loaded);
+    benchmark::DoNotOptimize(loaded);
+  }
+}
+
+struct TemporaryDirectory
+{
+  TemporaryDirectory()
+  {
+    char name[] = "/tmp/property_bag_XXXXXX";
+    path = ::mkdtemp(name);
+  }
+
+  ~TemporaryDirectory()
+  {
+    // The snapshot and the journals of a few generations
+    std::remove((path + "/bag").c_str());
+    for (int g=0; g<1000; ++g)
+      std::remove((path + "/bag." + std::to_string(g) + ".journal").c_str());
+    ::rmdir(path.c_str());
+  }
+
+  std::string path;
+};
+
+// Appended records only, never compacted
+void BM_JournalUpdate(benchmark::State& state)
+{
+  TemporaryDirectory dir;
+
+  property_bag::JournaledPropertyBag journaled(dir.path + "/bag", std::size_t(-1));
+
+  for (int i=0; i<5000; ++i)
+    journaled.addProperty("joint_" + std::to_string(i) + "/gain", double(i));
+  journaled.addProperty("calibration", std::vector<double>(100000, 1.));
+
+  journaled.compact();
+
+  const std::size_t before = journaled.journalSize();
+
+  int i = 0;
+  for (auto _ : state)
+  {
+    journaled.updateProperty("joint_" + std::to_string(i%5000) + "/gain", i * 0.5);
+    ++i;
+  }
+
+  state.counters["bytes_per_update"] = double(journaled.journalSize() - before) / i;
+}
+
+// A snapshot then 20000 records
+void BM_JournalRecovery(benchmark::State& state)
+{
+  TemporaryDirectory dir;
+  const std::string path = dir.path + "/bag";
+
+  {
+    property_bag::JournaledPropertyBag journaled(path, std::size_t(-1));
+
+    for (int i=0; i<5000; ++i)
+      journaled.addProperty("joint_" + std::to_string(i) + "/gain", double(i));
+    journaled.addProperty("calibration", std::vector<double>(100000, 1.));
+
+    journaled.compact();
+
+    for (int i=0; i<20000; ++i)
+      journaled.updateProperty("joint_" + std::to_string(i%5000) + "/gain", i * 0.5);
+  }
+
+  for (auto _ : state)
+  {
+    property_bag::JournaledPropertyBag journaled(path, std::size_t(-1));
+    benchmark::DoNotOptimize(journaled.bag().size());
+  }
+}
+
+// 10 of Arg properties changed, against a full archive
+void BM_ToDelta(benchmark::State& state)
+{
+  PropertyBag bag;
+  for (int i=0; i<state.range(0); ++i)
+    bag.addProperty("joint_" + std::to_string(i) + "/gain", 100. + i,
+                    "Proportional gain of joint " + std::to_string(i));
+
+  const property_bag::PropertyBagCheckpoint checkpoint(bag);
+
+  for (int i=0; i<10; ++i)
+    bag.updateProperty("joint_" + std::to_string(i * (state.range(0) / 10)) + "/gain", 0.5 * i);
+
+  std::size_t size = 0;
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    property_bag::PropertyBagCheckpoint copy(checkpoint);
+    state.ResumeTiming();
+
+    size = property_bag::to_delta(bag, copy).size();
+  }
+
+  state.counters["bytes"] = size;
+  state.counters["full_bytes"] = property_bag::to_bytes(bag).size();
+}
+
+// Nothing changed since the checkpoint
+void BM_MakeDelta_Unchanged(benchmark::State& state)
+{
+  PropertyBag bag;
+  for (int i=0; i<state.range(0); ++i)
+    bag.addProperty("joint_" + std::to_string(i) + "/gain", 100. + i);
+
+  // Already at the state of the bag, stays there
+  property_bag::PropertyBagCheckpoint checkpoint(bag);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(property_bag::make_delta(bag, checkpoint));
+
+  state.SetItemsProcessed(state.iterations() * bag.size());
+}
+
+void Bags(benchmark::internal::Benchmark* b)
+{
+  b->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Save, Text)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Save, Binary)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Save, PortableBinary)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Save, Wire)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Save, Json)->Apply(Bags);
+
+BENCHMARK_TEMPLATE(BM_Load, Text)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Load, Binary)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Load, PortableBinary)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Load, Wire)->Apply(Bags);
+BENCHMARK_TEMPLATE(BM_Load, Json)->Apply(Bags);
+
+BENCHMARK(BM_WireStartup)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WireStream)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_WireSaveParallel)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_WireLoadParallel)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Compress)->ArgsProduct({{0, 1}, {0, 1}, {1, property_bag::default_compression_level, 9}})
+                      ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Decompress)->ArgsProduct({{0, 1}, {0, 1}, {1, property_bag::default_compression_level, 9}})
+                        ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_MappedOpen)->Arg(10)->Arg(500);
+BENCHMARK(BM_MappedOpen_WireLoad)->Arg(10)->Arg(500);
+
+BENCHMARK(BM_JournalUpdate);
+BENCHMARK(BM_JournalRecovery)->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ToDelta)->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MakeDelta_Unchanged)->RangeMultiplier(10)->Range(1000, 100000);
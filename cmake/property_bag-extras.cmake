@@ -0,0 +1,25 @@
+# The Eigen and ROS types are registered by their own libraries,
+# not linked by default. Link them along with property_bag if needed :
+#
+#   find_package(catkin REQUIRED COMPONENTS property_bag)
+#   target_link_libraries(my_target ${catkin_LIBRARIES} ${property_bag_EIGEN_LIBRARIES})
+#
+# property_bag_ROS_LIBRARIES is only set if property_bag was built
+# along with ROS, the user is then expected to depend on roscpp itself.
+
+foreach(_property_bag_component eigen ros)
+  string(TOUPPER ${_property_bag_component} _property_bag_COMPONENT)
+
+  # Built in the same workspace
+  if(TARGET property_bag_${_property_bag_component})
+    set(property_bag_${_property_bag_COMPONENT}_LIBRARIES property_bag_${_property_bag_component})
+  else()
+    find_library(property_bag_${_property_bag_COMPONENT}_LIBRARY property_bag_${_property_bag_component}
+      PATHS ${property_bag_LIBRARY_DIRS} NO_DEFAULT_PATH NO_CMAKE_FIND_ROOT_PATH)
+
+    if(property_bag_${_property_bag_COMPONENT}_LIBRARY)
+      set(property_bag_${_property_bag_COMPONENT}_LIBRARIES
+          ${property_bag_${_property_bag_COMPONENT}_LIBRARY})
+    endif()
+  endif()
+endforeach()
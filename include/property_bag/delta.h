@@ -0,0 +1,238 @@
+/**
+ * \file delta.h
+ * \brief Changes of a bag since a checkpoint.
+ */
+
+#ifndef PROPERTY_BAG_DELTA_H
+#define PROPERTY_BAG_DELTA_H
+
+#include "property_bag/property_bag.h"
+
+#include <vector>
+
+namespace property_bag
+{
+
+/**
+ * @brief The AbstractPropertyBagCheckpoint class.
+ * The state of a bag a delta is computed against:
+ * the keys it held, the revision of the clock and
+ * how many times each property had changed.
+ *
+ * A default constructed checkpoint predates everything,
+ * the first delta against it holds the whole bag.
+ *
+ * @see Property::revision(), Property::changes()
+ */
+template <typename KeyType = std::string>
+class AbstractPropertyBagCheckpoint
+{
+public:
+
+  AbstractPropertyBagCheckpoint()  = default;
+  ~AbstractPropertyBagCheckpoint() = default;
+
+  /**
+   * @brief AbstractPropertyBagCheckpoint.
+   * A checkpoint of the current state of 'bag'.
+   */
+  explicit AbstractPropertyBagCheckpoint(const AbstractPropertyBag<KeyType>& bag);
+
+  /**
+   * @brief revision. Properties of a later revision changed.
+   */
+  inline std::uint64_t revision() const noexcept { return revision_; }
+
+  /**
+   * @brief keys. The sorted keys of the bag at the checkpoint.
+   */
+  inline const std::vector<KeyType>& keys() const noexcept { return keys_; }
+
+protected:
+
+  std::uint64_t revision_ = 0;
+
+  std::vector<KeyType> keys_;
+
+  // Property::changes() of each key
+  std::vector<std::uint64_t> changes_;
+
+  friend struct AbstractPropertyBag<KeyType>::delta_accessor;
+};
+
+using PropertyBagCheckpoint = AbstractPropertyBagCheckpoint<std::string>;
+
+/**
+ * @brief The AbstractPropertyBagDelta struct.
+ * The properties added, changed or removed.
+ */
+template <typename KeyType = std::string>
+struct AbstractPropertyBagDelta
+{
+  /**
+   * @brief changed. The properties added or changed,
+   * sharing their value with the bag. Carries the name
+   * and retrieval handling of the bag.
+   */
+  AbstractPropertyBag<KeyType> changed;
+
+  /**
+   * @brief removed. The keys removed.
+   */
+  std::vector<KeyType> removed;
+
+  inline bool empty() const noexcept { return changed.empty() && removed.empty(); }
+};
+
+using PropertyBagDelta = AbstractPropertyBagDelta<std::string>;
+
+template <typename KeyType>
+struct AbstractPropertyBag<KeyType>::delta_accessor
+{
+  static void reset(const AbstractPropertyBag& bag,
+                    AbstractPropertyBagCheckpoint<KeyType>& checkpoint)
+  {
+    checkpoint.revision_ = details::current_revision();
+
+    checkpoint.keys_.clear();
+    checkpoint.keys_.reserve(bag.properties_.size());
+
+    checkpoint.changes_.clear();
+    checkpoint.changes_.reserve(bag.properties_.size());
+
+    for (const auto& property : bag.properties_)
+    {
+      checkpoint.keys_.push_back(property.first);
+      checkpoint.changes_.push_back(property.second.changes());
+    }
+  }
+
+  static AbstractPropertyBagDelta<KeyType>
+  make(const AbstractPropertyBag& bag,
+       AbstractPropertyBagCheckpoint<KeyType>& checkpoint)
+  {
+    // Taken first, a concurrent change lands in the next delta
+    const std::uint64_t now = details::current_revision();
+
+    AbstractPropertyBagDelta<KeyType> delta;
+    delta.changed.name(bag.name_);
+    delta.changed.default_handling_ = bag.default_handling_;
+
+    const auto& keys = checkpoint.keys_;
+    const auto less  = bag.properties_.key_comp();
+
+    // Replaced wholesale since, e.g. assigned or loaded
+    const bool replaced = bag.generation_ > checkpoint.revision_;
+
+    bool added = false;
+
+    // Both sorted, a single walk
+    auto key = keys.cbegin();
+    for (const auto& property : bag.properties_)
+    {
+      for (; key != keys.cend() && less(*key, property.first); ++key)
+        delta.removed.push_back(*key);
+
+      const bool known = key != keys.cend() && !less(property.first, *key);
+
+      bool changed = !known || replaced || property.second.revision() > checkpoint.revision_;
+
+      if (known)
+      {
+        std::uint64_t& changes = checkpoint.changes_[key - keys.cbegin()];
+
+        changed |= property.second.changes() != changes;
+        changes  = property.second.changes();
+
+        ++key;
+      }
+      else
+      {
+        added = true;
+      }
+
+      if (changed)
+        delta.changed.properties_.emplace_hint(delta.changed.properties_.end(),
+                                               property.first, property.second);
+    }
+
+    for (; key != keys.cend(); ++key)
+      delta.removed.push_back(*key);
+
+    // Same keys, only values changed
+    if (added || !delta.removed.empty())
+      reset(bag, checkpoint);
+
+    checkpoint.revision_ = now;
+
+    return delta;
+  }
+
+  static bool apply(const AbstractPropertyBagDelta<KeyType>& delta,
+                    AbstractPropertyBag& bag)
+  {
+    if (bag.realtime_) return false;
+
+    for (const auto& key : delta.removed)
+      bag.properties_.erase(key);
+
+    for (const auto& property : delta.changed.properties_)
+    {
+      auto it = bag.properties_.lower_bound(property.first);
+
+      if (it != bag.properties_.end() &&
+          !bag.properties_.key_comp()(property.first, it->first))
+        it->second = property.second;
+      else
+        bag.properties_.emplace_hint(it, property.first, property.second)->second.touch();
+    }
+
+    bag.name_             = delta.changed.name_;
+    bag.default_handling_ = delta.changed.default_handling_;
+
+    return true;
+  }
+};
+
+template <typename KeyType>
+AbstractPropertyBagCheckpoint<KeyType>::AbstractPropertyBagCheckpoint(
+    const AbstractPropertyBag<KeyType>& bag)
+{
+  AbstractPropertyBag<KeyType>::delta_accessor::reset(bag, *this);
+}
+
+/**
+ * @brief make_delta. The properties of 'bag' added, changed or
+ * removed since 'checkpoint', which is then moved to the current
+ * state of the bag. Values are shared, not copied.
+ *
+ * Costs a walk over the keys, values are compared through their
+ * revision and count of changes only. A property is changed when
+ * it is updated or accessed through a non-const reference, even
+ * to the same value. All properties are changed once the bag
+ * is assigned or loaded as a whole.
+ */
+template <typename KeyType>
+AbstractPropertyBagDelta<KeyType>
+make_delta(const AbstractPropertyBag<KeyType>& bag,
+           AbstractPropertyBagCheckpoint<KeyType>& checkpoint)
+{
+  return AbstractPropertyBag<KeyType>::delta_accessor::make(bag, checkpoint);
+}
+
+/**
+ * @brief apply_delta. Update 'bag' in place, removing, adding and
+ * replacing the properties of 'delta'. Replaced properties take
+ * their description and flags from the delta.
+ * @return false in real-time mode.
+ */
+template <typename KeyType>
+bool apply_delta(const AbstractPropertyBagDelta<KeyType>& delta,
+                 AbstractPropertyBag<KeyType>& bag)
+{
+  return AbstractPropertyBag<KeyType>::delta_accessor::apply(delta, bag);
+}
+
+} //namespace property_bag
+
+#endif // PROPERTY_BAG_DELTA_H
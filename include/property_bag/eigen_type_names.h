@@ -0,0 +1,34 @@
+/**
+ * \file eigen_type_names.h
+ * \brief Stable names for the common Eigen types.
+ * Included by eigen_boost_serialization.h,
+ * eigen_wire_format.h and eigen_json_format.h,
+ * include it wherever these types are stored in a property
+ * without being serialized.
+ */
+
+#ifndef PROPERTY_BAG_EIGEN_TYPE_NAMES_H
+#define PROPERTY_BAG_EIGEN_TYPE_NAMES_H
+
+#include "property_bag/utils.h"
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+
+PROPERTY_BAG_TYPE_NAME(Eigen::Vector2d, "Eigen::Vector2d")
+PROPERTY_BAG_TYPE_NAME(Eigen::Vector3d, "Eigen::Vector3d")
+PROPERTY_BAG_TYPE_NAME(Eigen::Vector4d, "Eigen::Vector4d")
+PROPERTY_BAG_TYPE_NAME(Eigen::VectorXd, "Eigen::VectorXd")
+PROPERTY_BAG_TYPE_NAME(Eigen::Matrix3d, "Eigen::Matrix3d")
+PROPERTY_BAG_TYPE_NAME(Eigen::Matrix4d, "Eigen::Matrix4d")
+PROPERTY_BAG_TYPE_NAME(Eigen::MatrixXd, "Eigen::MatrixXd")
+PROPERTY_BAG_TYPE_NAME(Eigen::Quaterniond, "Eigen::Quaterniond")
+PROPERTY_BAG_TYPE_NAME(Eigen::Isometry3d, "Eigen::Isometry3d")
+PROPERTY_BAG_TYPE_NAME(Eigen::Affine3d, "Eigen::Affine3d")
+
+PROPERTY_BAG_TYPE_NAME(std::vector<Eigen::Vector3d>, "std::vector<Eigen::Vector3d>")
+PROPERTY_BAG_TYPE_NAME(std::vector<Eigen::VectorXd>, "std::vector<Eigen::VectorXd>")
+PROPERTY_BAG_TYPE_NAME(std::vector<Eigen::Quaterniond>, "std::vector<Eigen::Quaterniond>")
+PROPERTY_BAG_TYPE_NAME(std::vector<Eigen::Isometry3d>, "std::vector<Eigen::Isometry3d>")
+
+#endif /* PROPERTY_BAG_EIGEN_TYPE_NAMES_H */
@@ -8,7 +8,10 @@
 #ifndef PROPERTY_BAG_PROPERTY_H
 #define PROPERTY_BAG_PROPERTY_H
 
+#include <atomic>
 #include <bitset>
+#include <cstdint>
+#include <memory>
 #include <sstream>
 
 #include "property_bag/utils.h"
@@ -96,8 +99,56 @@ struct PropertyException : public std::exception
   const std::string message_;
 };
 
+/**
+ * @brief The ErrorCode enum.
+ * Reports the outcome of the non-throwing operations.
+ */
+enum class ErrorCode : std::size_t
+{
+  OK = 0,
+  NOT_FOUND,         //< No such property.
+  TYPE_MISMATCH,     //< The property holds another type.
+  NOT_REALTIME_SAFE  //< The operation would allocate.
+};
+
+inline std::ostream& operator <<(std::ostream& s, const ErrorCode e)
+{
+  switch (e) {
+  case ErrorCode::OK:
+    s << "OK";
+    break;
+  case ErrorCode::NOT_FOUND:
+    s << "NOT_FOUND";
+    break;
+  case ErrorCode::TYPE_MISMATCH:
+    s << "TYPE_MISMATCH";
+    break;
+  case ErrorCode::NOT_REALTIME_SAFE:
+    s << "NOT_REALTIME_SAFE";
+    break;
+  }
+  return s;
+}
+
 namespace details
 {
+
+/**
+ * @brief next_revision. Tick the process-wide clock
+ * dating the changes of every Property.
+ */
+std::uint64_t next_revision() noexcept;
+
+/**
+ * @brief current_revision. The last revision handed out,
+ * every later change is dated after it.
+ */
+std::uint64_t current_revision() noexcept;
+
+class PlaceHolder;
+
+using PlaceHolderPtr = shared_ptr<PlaceHolder>;
+
 /**
  * @brief The PlaceHolder class.
  * A place holder base class.
@@ -106,13 +157,53 @@ class PlaceHolder
 {
 public:
 
-  PlaceHolder()          = default;
-  virtual ~PlaceHolder() = default;
+  /**
+   * @brief Decoder. Decodes 'size' bytes in a place holder.
+   */
+  using Decoder = void (*)(const char* data, std::size_t size, PlaceHolder& holder);
+
+  PlaceHolder();
+  virtual ~PlaceHolder();
 
   virtual const std::type_info& type() = 0;
-};
 
-using PlaceHolderPtr = shared_ptr<PlaceHolder>;
+  virtual string_view type_name() const noexcept = 0;
+
+  /**
+   * @brief clone. A deep copy of this place holder.
+   * @return the copy, or an empty pointer if the
+   * held type is not copy constructible.
+   */
+  virtual PlaceHolderPtr clone() const = 0;
+
+  /**
+   * @brief defer. Leave the value to be decoded from
+   * 'size' bytes of 'buffer' on its first access.
+   * Must be called before the place holder is shared.
+   */
+  void defer(Decoder decoder, shared_ptr<const std::string> buffer,
+             const char* data, std::size_t size);
+
+  /**
+   * @brief load. Decode a deferred value, once,
+   * by whichever thread first accesses it.
+   * @return false if it could not be decoded.
+   */
+  inline bool load() const noexcept
+  {
+    return !deferred_.load(std::memory_order_acquire) || load_deferred();
+  }
+
+protected:
+
+  struct Deferred;
+
+  bool load_deferred() const noexcept;
+
+  mutable std::atomic<bool> deferred_;
+
+  std::unique_ptr<Deferred> deferred_value_;
+};
 
 // Forward declaration
 class Any;
@@ -132,6 +223,12 @@ public:
    */
   struct serialization_accessor;
 
+  /**
+   * @brief 'pimpl' struct to enable access to
+   * private members in the wire format
+   */
+  struct wire_accessor;
+
   /**
    * @brief PlaceHolderImpl. Default constructor
    */
@@ -208,10 +305,39 @@ public:
    */
   inline const std::type_info& type() override { return typeid(T); }
 
+  /**
+   * @brief type_name
+   * @return string_view. name_of<T>()
+   */
+  inline string_view type_name() const noexcept override { return property_bag::name_of<T>(); }
+
+  /**
+   * @brief clone
+   * @return PlaceHolderPtr. A copy of this PlaceHolderImpl<T>
+   */
+  PlaceHolderPtr clone() const override
+  {
+    if (!load()) return PlaceHolderPtr();
+
+    return clone(std::is_copy_constructible<T>());
+  }
+
 protected:
 
+  PlaceHolderPtr clone(std::true_type /*copyable*/) const
+  {
+    return make_ptr<PlaceHolderImpl<T>>(value_);
+  }
+
+  PlaceHolderPtr clone(std::false_type /*copyable*/) const
+  {
+    return PlaceHolderPtr();
+  }
+
   T value_;
 
+  friend class Any;
+
   template<typename TT>
   friend TT& anycast(Any &val);
 
@@ -236,6 +362,12 @@ public:
    */
   struct serialization_accessor;
 
+  /**
+   * @brief 'pimpl' struct to enable access to
+   * private members in the wire format
+   */
+  struct wire_accessor;
+
   Any()  = default;
   ~Any() = default;
 
@@ -253,14 +385,87 @@ public:
         make_ptr<PlaceHolderImpl<typename std::decay<T>::type>>(std::forward<T>(value));
   }
 
+  /**
+   * @brief operator =. If Any solely owns a value of the
+   * same type, the value is assigned in place, otherwise
+   * a new place holder is allocated.
+   */
   template<typename T,
            typename = typename disable_if_same_or_derived<Any,T>::type>
   void operator=(T&& value)
   {
-    placeholder_ =
-        make_ptr<PlaceHolderImpl<typename std::decay<T>::type>>(std::forward<T>(value));
+    using U = typename std::decay<T>::type;
+
+    if (!assign<U>(std::forward<T>(value)))
+      placeholder_ = make_ptr<PlaceHolderImpl<U>>(std::forward<T>(value));
+  }
+
+  /**
+   * @brief assign. Assign the holded value in place.
+   * Never allocates a new place holder.
+   * @return false if Any does not solely own a value of type U.
+   */
+  template<typename U, typename T>
+  bool assign(T&& value)
+      noexcept(std::is_nothrow_assignable<U&, T&&>::value)
+  {
+    if (!unique() || placeholder_->type() != typeid(U) || !placeholder_->load())
+      return false;
+
+    static_cast<PlaceHolderImpl<U>*>(placeholder_.get())->value_ =
+        std::forward<T>(value);
+
+    return true;
+  }
+
+  /**
+   * @brief get_if. Non-throwing access to the holded value.
+   * @return a pointer to the value, nullptr if Any
+   * does not hold a value of type T.
+   */
+  template<typename T>
+  const T* get_if() const noexcept
+  {
+    if (empty() || placeholder_->type() != typeid(T) || !placeholder_->load())
+      return nullptr;
+
+    return &static_cast<const PlaceHolderImpl<T>*>(placeholder_.get())->value_;
+  }
+
+  template<typename T>
+  T* get_if() noexcept
+  {
+    if (empty() || placeholder_->type() != typeid(T) || !placeholder_->load())
+      return nullptr;
+
+    return &static_cast<PlaceHolderImpl<T>*>(placeholder_.get())->value_;
   }
 
+  /**
+   * @brief swap. Exchange the place holders, never allocates.
+   */
+  inline void swap(Any& o) noexcept
+  {
+    placeholder_.swap(o.placeholder_);
+  }
+
+  /**
+   * @brief unique. Whether Any is the sole owner
+   * of its place holder. Copies of Any share it.
+   */
+  inline bool unique() const noexcept
+  {
+    return !empty() && placeholder_.use_count() == 1;
+  }
+
+  /**
+   * @brief unshare. Deep copy the place holder
+   * if it is shared with another Any, decoding
+   * a deferred value.
+   * @return false if it could not be copied or decoded.
+   */
+  bool unshare();
+
   /**
    * @brief type. Return the type info of the holded value, typeid(T).
    * @return std::type_info.
@@ -270,6 +475,15 @@ public:
     return placeholder_->type();
   }
 
+  /**
+   * @brief type_name. Return the name of the holded value type.
+   * @return string_view. name_of<T>().
+   */
+  inline string_view type_name() const noexcept
+  {
+    return placeholder_->type_name();
+  }
+
   /**
    * @brief empty. Whether Any holds something or not.
    * @return true if holding, false otherwise.
@@ -298,9 +512,13 @@ T& anycast(Any& val)
 
   if (empty(concrete))
     throw PropertyException(std::string("Could not convert from ") +
-                            details::name_of(val.type()) +
+                            val.type_name() +
                             std::string(" to ") +
-                            details::name_of(typeid(T)));
+                            property_bag::name_of<T>());
+
+  if (!concrete->load())
+    throw PropertyException(std::string("Could not decode deferred ") +
+                            property_bag::name_of<T>());
 
   return concrete->value_;
 }
@@ -314,11 +532,15 @@ const T& anycast(const Any& val)
   if (empty(concrete))
   {
     throw PropertyException(std::string("Could not convert from ") +
-                            details::name_of(val.type()) +
+                            val.type_name() +
                             std::string(" to ") +
-                            details::name_of(typeid(T)));
+                            property_bag::name_of<T>());
   }
 
+  if (!concrete->load())
+    throw PropertyException(std::string("Could not decode deferred ") +
+                            property_bag::name_of<T>());
+
   return concrete->value_;
 }
 } // namespace details
@@ -336,6 +558,18 @@ public:
    */
   struct serialization_accessor;
 
+  /**
+   * @brief 'pimpl' struct to enable access to
+   * private members in the wire format
+   */
+  struct wire_accessor;
+
+  /**
+   * @brief 'pimpl' struct to enable access to
+   * private members in JSON
+   */
+  struct json_accessor;
+
   enum
   {
     NONE = 0,
@@ -388,7 +622,8 @@ public:
             typename = typename disable_if_same_or_derived<Property,T>::type>
   Property(T&& t, const std::string& doc = "") :
     description_{doc},
-    flags_()
+    flags_(),
+    revision_(details::next_revision())
   {
     set_holder(std::forward<T>(t));
 
@@ -401,11 +636,12 @@ public:
   /**
    * \brief type_name. Type name of whatever Property is holding.
    *
-   * @return std::string. A name equivalent to typeid(T).name
+   * @return string_view. A view over a statically allocated
+   * name equivalent to name_of<T>().
    *
    * @see type().
    */
-  std::string type_name() const noexcept;
+  string_view type_name() const noexcept;
 
   /**
    * @brief type. The type_info of whatever Property is holding.
@@ -417,6 +653,29 @@ public:
   inline bool is_default()  const noexcept { return  flags_[DEFAULT_VALUE];  }
   inline bool is_modified() const noexcept { return  flags_[PROVIDED_VALUE]; }
 
+  /**
+   * @brief revision. When the Property was last replaced, on the
+   * clock of details::next_revision(). Copies keep the revision
+   * of their source, assignments, insertions in a bag and changes
+   * of the description take a new one.
+   * @see changes().
+   */
+  inline std::uint64_t revision() const noexcept { return revision_; }
+
+  /**
+   * @brief changes. Counts the updates of the value in place,
+   * set(), try_set(), try_swap() and non-const accesses.
+   * Kept per Property so that real-time updates do not
+   * tick the process-wide clock. Copies keep it.
+   */
+  inline std::uint64_t changes() const noexcept { return changes_; }
+
+  /**
+   * @brief touch. Mark the Property as changed, e.g. after
+   * modifying its value through a reference kept around.
+   */
+  inline void touch() noexcept { revision_ = details::next_revision(); }
+
   /**
    * \brief A doc string for this Property, "foo is for the input
    * and will be mashed with spam."
@@ -467,21 +726,70 @@ public:
   {
     enforce_type_set<T>();
 
-    if (flags_[NONE])
-    {
-      flags_[NONE]           = false;
-      flags_[DEFAULT_VALUE]  = true;
-      flags_[PROVIDED_VALUE] = false;
-    }
-    else if (flags_[DEFAULT_VALUE])
-    {
-      flags_[DEFAULT_VALUE]  = false;
-      flags_[PROVIDED_VALUE] = true;
-    }
+    update_flags();
 
     set_holder(std::forward<T>(val));
   }
 
+  /**
+   * \brief Non-throwing, non-allocating, update of the value.
+   * Only succeeds if the Property already holds a value
+   * of the same type that it does not share with a copy.
+   * @return ErrorCode::OK on success,
+   * ErrorCode::TYPE_MISMATCH if the types differ,
+   * ErrorCode::NOT_REALTIME_SAFE if the value is shared.
+   */
+  template<typename T>
+  ErrorCode try_set(T&& val)
+      noexcept(std::is_nothrow_assignable<typename std::decay<T>::type&, T&&>::value)
+  {
+    if (!is_same<T>()) return ErrorCode::TYPE_MISMATCH;
+
+    if (!holder_.template assign<typename std::decay<T>::type>(std::forward<T>(val)))
+      return ErrorCode::NOT_REALTIME_SAFE;
+
+    update_flags();
+
+    return ErrorCode::OK;
+  }
+
+  /**
+   * \brief Non-throwing, non-allocating, exchange of the values
+   * of two Property holding the same type. Only this Property
+   * flags are updated as per set(), 'rhs' keeps its own.
+   * @return ErrorCode::OK on success,
+   * ErrorCode::TYPE_MISMATCH if the types differ.
+   */
+  ErrorCode try_swap(Property& rhs) noexcept;
+
+  /**
+   * \brief Non-throwing access to the value.
+   * @return a pointer to the value, nullptr if
+   * the Property does not hold a T.
+   */
+  template<typename T>
+  inline const T* get_if() const noexcept
+  {
+    return holder_.template get_if<T>();
+  }
+
+  template<typename T>
+  inline T* get_if() noexcept
+  {
+    T* value = holder_.template get_if<T>();
+    if (value != nullptr) ++changes_;
+    return value;
+  }
+
+  /**
+   * \brief Make sure the value is not shared with
+   * a copy of this Property, nor left to be decoded,
+   * so that it can be updated in place.
+   * @return false if the value could not be copied
+   * or decoded.
+   */
+  bool unshare();
+
   template<typename T>
   inline const T& get() const
   {
@@ -493,7 +801,9 @@ public:
   inline T& get()
   {
     enforce_type<T>();
-    return unsafe_get<T>();
+    T& value = unsafe_get<T>();
+    ++changes_;
+    return value;
   }
 
   /**
@@ -554,11 +864,32 @@ protected:
     holder_ = std::forward<T>(t);
   }
 
+  inline void update_flags() noexcept
+  {
+    ++changes_;
+
+    if (flags_[NONE])
+    {
+      flags_[NONE]           = false;
+      flags_[DEFAULT_VALUE]  = true;
+      flags_[PROVIDED_VALUE] = false;
+    }
+    else if (flags_[DEFAULT_VALUE])
+    {
+      flags_[DEFAULT_VALUE]  = false;
+      flags_[PROVIDED_VALUE] = true;
+    }
+  }
+
   details::Any holder_;
 
   std::string description_;
 
   std::bitset<3> flags_;
+
+  std::uint64_t revision_;
+
+  std::uint64_t changes_ = 0;
 };
 
 } //namespace property_bag
@@ -80,6 +80,18 @@ inline std::ostream& operator <<(std::ostream& s, const RetrievalHandling r)
 }
 
 template <typename KeyType = std::string>
+class AbstractPropertyBag;
+
+using PropertyBag = AbstractPropertyBag<std::string>;
+
+} //namespace property_bag
+
+PROPERTY_BAG_TYPE_NAME(property_bag::PropertyBag, "property_bag::PropertyBag")
+
+namespace property_bag
+{
+
+template <typename KeyType>
 class AbstractPropertyBag
 {
   using PropertyMap = std::map<KeyType, Property>;
@@ -97,6 +109,24 @@ public:
    */
   struct serialization_accessor;
 
+  /**
+   * @brief 'pimpl' struct to enable access to
+   * private members in the wire format
+   */
+  struct wire_accessor;
+
+  /**
+   * @brief 'pimpl' struct to enable access to
+   * private members when computing and applying deltas
+   */
+  struct delta_accessor;
+
+  /**
+   * @brief 'pimpl' struct to enable access to
+   * private members in JSON
+   */
+  struct json_accessor;
+
   static constexpr WithDocHelper WithDoc = {};
 
   AbstractPropertyBag()          = default;
@@ -113,6 +143,8 @@ public:
   template <typename T>
   bool addProperty(const KeyType &name, T&& value, const std::string& doc = "")
   {
+    if (realtime_) return false;
+
     auto it = properties_.find(name);
 
     if (it == properties_.end())
@@ -170,6 +202,8 @@ public:
   bool getPropertyValue(const KeyType &name, T& value,
                         const RetrievalHandling handling) const
   {
+    if (realtime_) return tryGetPropertyValue(name, value) == ErrorCode::OK;
+
     auto it = properties_.find(name);
 
     if (it != properties_.end())
@@ -243,6 +277,9 @@ public:
   template <typename T>
   bool updateProperty(const KeyType &name, T&& value)
   {
+    if (realtime_)
+      return tryUpdateProperty(name, std::forward<T>(value)) == ErrorCode::OK;
+
     auto it = properties_.find(name);
 
     if (it != properties_.end())
@@ -275,6 +312,92 @@ public:
     return true;
   }
 
+  /**
+   * @brief tryGetPropertyValue. Non-throwing retrieval of a value.
+   * Does not allocate as long as T's copy assignment does not.
+   * @return ErrorCode::OK on success, ErrorCode::NOT_FOUND
+   * or ErrorCode::TYPE_MISMATCH otherwise.
+   */
+  template <typename T>
+  ErrorCode tryGetPropertyValue(const KeyType &name, T& value) const
+      noexcept(std::is_nothrow_copy_assignable<T>::value)
+  {
+    auto it = properties_.find(name);
+
+    if (it == properties_.end()) return ErrorCode::NOT_FOUND;
+
+    const T* held = it->second.template get_if<T>();
+
+    if (held == nullptr) return ErrorCode::TYPE_MISMATCH;
+
+    value = *held;
+
+    return ErrorCode::OK;
+  }
+
+  /**
+   * @brief tryUpdateProperty. Non-throwing, in place, update of a value.
+   * Does not allocate as long as T's assignment does not.
+   * @return ErrorCode::OK on success, ErrorCode::NOT_FOUND,
+   * ErrorCode::TYPE_MISMATCH or ErrorCode::NOT_REALTIME_SAFE otherwise.
+   *
+   * @see Property::try_set
+   */
+  template <typename T>
+  ErrorCode tryUpdateProperty(const KeyType &name, T&& value)
+      noexcept(noexcept(std::declval<Property&>().try_set(std::forward<T>(value))))
+  {
+    auto it = properties_.find(name);
+
+    if (it == properties_.end()) return ErrorCode::NOT_FOUND;
+
+    return it->second.try_set(std::forward<T>(value));
+  }
+
+  /**
+   * @brief trySwapPropertyValue. Non-throwing, non-allocating,
+   * exchange of a property value with the one held by 'value'.
+   * The former value ends up in 'value'.
+   * @return ErrorCode::OK on success, ErrorCode::NOT_FOUND
+   * or ErrorCode::TYPE_MISMATCH otherwise.
+   *
+   * @see Property::try_swap
+   */
+  ErrorCode trySwapPropertyValue(const KeyType &name, Property& value) noexcept
+  {
+    auto it = properties_.find(name);
+
+    if (it == properties_.end()) return ErrorCode::NOT_FOUND;
+
+    return it->second.try_swap(value);
+  }
+
+  /**
+   * @brief enterRealTime. Switch the bag to real-time mode.
+   * Values shared with copies of the bag are deep-copied
+   * and lazily loaded values are decoded first, so that
+   * updates can then happen in place.
+   *
+   * In real-time mode getPropertyValue and updateProperty
+   * neither allocate nor throw (RetrievalHandling::THROW
+   * is ignored) while addProperty, removeProperty
+   * and append are refused.
+   *
+   * Replacing the whole bag, by assignment or by loading it
+   * (boost archives, from_wire, from_json, from_xmlrpc),
+   * leaves real-time mode, enterRealTime is to be called again.
+   * @return false if a value could not be unshared,
+   * the bag then stays out of real-time mode.
+   */
+  bool enterRealTime();
+
+  /**
+   * @brief exitRealTime. Back to configuration mode.
+   */
+  inline void exitRealTime() noexcept { realtime_ = false; }
+
+  inline bool isRealTime() const noexcept { return realtime_; }
+
   bool removeProperty(const KeyType &name);
 
   std::list<KeyType> listProperties() const;
@@ -297,15 +420,32 @@ public:
   const_iterator end() const;
 
   inline void name(const KeyType& bag_name) { name_ = bag_name; }
-  inline const KeyType& name() { return name_; }
+  inline const KeyType& name() const noexcept { return name_; }
 
   /**
    * @brief append another property bag to this one
    * If a key exists on both bags, the property present on this map is kept
+   * @return false in real-time mode.
    */
-  void append(const AbstractPropertyBag<KeyType> &other)
+  bool append(const AbstractPropertyBag<KeyType> &other)
   {
-    properties_.insert(other.begin(), other.end());
+    if (realtime_) return false;
+
+    auto hint = properties_.begin();
+
+    for (const auto& property : other)
+    {
+      const std::size_t size = properties_.size();
+
+      hint = properties_.insert(hint, property);
+
+      // Possibly older than a checkpoint of this bag
+      if (properties_.size() != size) hint->second.touch();
+
+      ++hint;
+    }
+
+    return true;
   }
 
 private:
@@ -316,6 +456,12 @@ private:
 
   RetrievalHandling default_handling_ = RetrievalHandling::QUIET;
 
+  bool realtime_ = false;
+
+  // When the properties were last replaced wholesale,
+  // on the clock of details::next_revision()
+  std::uint64_t generation_ = 0;
+
   PropertyMap properties_;
 
   void addProperties();
@@ -323,8 +469,6 @@ private:
   void addPropertiesWithDoc();
 };
 
-using PropertyBag = AbstractPropertyBag<std::string>;
-
 } //namespace property_bag
 
 #include <property_bag/property_bag.hpp>
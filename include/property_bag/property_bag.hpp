@@ -15,6 +15,7 @@ namespace property_bag
 template<typename KeyType>
 AbstractPropertyBag<KeyType>::AbstractPropertyBag(const AbstractPropertyBag<KeyType>& rhs) :
   default_handling_(rhs.default_handling_),
+  generation_(rhs.generation_),
   properties_(rhs.properties_)
 {
   //
@@ -23,6 +24,7 @@ AbstractPropertyBag<KeyType>::AbstractPropertyBag(const AbstractPropertyBag<KeyT
 template<typename KeyType>
 AbstractPropertyBag<KeyType>::AbstractPropertyBag(AbstractPropertyBag<KeyType>&& rhs) :
   default_handling_(rhs.default_handling_),
+  generation_(rhs.generation_),
   properties_(std::move(rhs.properties_))
 {
   //
@@ -33,6 +35,12 @@ AbstractPropertyBag<KeyType>& AbstractPropertyBag<KeyType>::operator=(const Abst
 {
   default_handling_ = rhs.default_handling_;
   this->properties_ = rhs.properties_;
+
+  // Replaced wholesale, changed for the deltas
+  // and back to configuration mode
+  generation_ = details::next_revision();
+  realtime_   = false;
+
   return *this;
 }
 
@@ -41,6 +49,12 @@ AbstractPropertyBag<KeyType>& AbstractPropertyBag<KeyType>::operator=(AbstractPr
 {
   default_handling_ = rhs.default_handling_;
   this->properties_ = std::move(rhs.properties_);
+
+  // Replaced wholesale, changed for the deltas
+  // and back to configuration mode
+  generation_ = details::next_revision();
+  realtime_   = false;
+
   return *this;
 }
 
@@ -73,9 +87,23 @@ const Property& AbstractPropertyBag<KeyType>::getProperty(const KeyType &name) c
 template<typename KeyType>
 bool AbstractPropertyBag<KeyType>::removeProperty(const KeyType &name)
 {
+  if (realtime_) return false;
+
   return (bool)properties_.erase(name);
 }
 
+template<typename KeyType>
+bool AbstractPropertyBag<KeyType>::enterRealTime()
+{
+  bool unshared = true;
+
+  for (auto& p : properties_) unshared &= p.second.unshare();
+
+  realtime_ = unshared;
+
+  return unshared;
+}
+
 template<typename KeyType>
 std::list<KeyType> AbstractPropertyBag<KeyType>::listProperties() const
 {
@@ -0,0 +1,21 @@
+/**
+ * \file ros_type_names.h
+ * \brief Stable names for ros::Time and ros::Duration.
+ * Included by ros_boost_serialization.h
+ * and ros_wire_format.h,
+ * include it wherever these types are stored in a property
+ * without being serialized. The supported messages are
+ * named by ros_message.h.
+ */
+
+#ifndef PROPERTY_BAG_ROS_TYPE_NAMES_H
+#define PROPERTY_BAG_ROS_TYPE_NAMES_H
+
+#include "property_bag/utils.h"
+
+#include <ros/time.h>
+
+PROPERTY_BAG_TYPE_NAME(ros::Time, "ros::Time")
+PROPERTY_BAG_TYPE_NAME(ros::Duration, "ros::Duration")
+
+#endif /* PROPERTY_BAG_ROS_TYPE_NAMES_H */
@@ -0,0 +1,145 @@
+/**
+ * \file bulk_layout.h
+ * \brief Boost serialization of std::vector of fixed-size
+ * elements as a single array of their scalars.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_BULK_LAYOUT_H
+#define PROPERTY_BAG_SERIALIZATION_BULK_LAYOUT_H
+
+#include <boost/serialization/array_wrapper.hpp>
+#include <boost/serialization/collection_size_type.hpp>
+#include <boost/serialization/nvp.hpp>
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace property_bag {
+namespace details {
+
+/**
+ * @brief The BulkLayout struct. Whether a T is made of a
+ * fixed number of arithmetic values, specialized with
+ *
+ *   using Scalar = ...;
+ *   static constexpr std::size_t size = ...;
+ *   // Whether a T is laid out in memory as its packed scalars
+ *   static constexpr bool contiguous = ...;
+ *   static void pack(const T&, Scalar*);
+ *   static void unpack(const Scalar*, T&);
+ *
+ * A std::vector of such T is archived as its size followed by
+ * a single array of scalars, written as one block by binary
+ * archives, rather than element by element.
+ * Arithmetic types are left to boost, which already
+ * writes their vectors as one block.
+ */
+template <typename T, typename Enable = void>
+struct BulkLayout : std::false_type { };
+
+template <typename T>
+struct is_bulk_vector : std::false_type { };
+
+template <typename T, typename Alloc>
+struct is_bulk_vector<std::vector<T, Alloc>> :
+    std::integral_constant<bool, BulkLayout<T>::value> { };
+
+/**
+ * @brief is_bulk_contiguous. Whether the elements of a
+ * std::vector<T> are read and written in place.
+ */
+template <typename T>
+using is_bulk_contiguous = std::integral_constant<bool,
+  BulkLayout<T>::contiguous &&
+  sizeof(T) == BulkLayout<T>::size * sizeof(typename BulkLayout<T>::Scalar)>;
+
+// Elements packed at once by non-contiguous layouts
+constexpr std::size_t bulk_chunk_size = 1024;
+
+template <class Archive, typename T, typename Alloc>
+void save_bulk(Archive& ar, const std::vector<T, Alloc>& v, std::true_type /*contiguous*/)
+{
+  using Scalar = typename BulkLayout<T>::Scalar;
+
+  ar << boost::serialization::make_array<const Scalar>(
+          reinterpret_cast<const Scalar*>(v.data()), v.size() * BulkLayout<T>::size);
+}
+
+template <class Archive, typename T, typename Alloc>
+void save_bulk(Archive& ar, const std::vector<T, Alloc>& v, std::false_type /*contiguous*/)
+{
+  using Layout = BulkLayout<T>;
+  using Scalar = typename Layout::Scalar;
+
+  std::vector<Scalar> chunk((v.size() < bulk_chunk_size ? v.size() : bulk_chunk_size) * Layout::size);
+
+  for (std::size_t begin = 0; begin < v.size(); begin += bulk_chunk_size)
+  {
+    const std::size_t end = (v.size() - begin < bulk_chunk_size) ? v.size() : begin + bulk_chunk_size;
+
+    for (std::size_t i = begin; i < end; ++i)
+      Layout::pack(v[i], &chunk[(i - begin) * Layout::size]);
+
+    ar << boost::serialization::make_array<Scalar>(chunk.data(), (end - begin) * Layout::size);
+  }
+}
+
+template <class Archive, typename T, typename Alloc>
+void load_bulk(Archive& ar, std::vector<T, Alloc>& v, std::true_type /*contiguous*/)
+{
+  using Scalar = typename BulkLayout<T>::Scalar;
+
+  ar >> boost::serialization::make_array<Scalar>(
+          reinterpret_cast<Scalar*>(v.data()), v.size() * BulkLayout<T>::size);
+}
+
+template <class Archive, typename T, typename Alloc>
+void load_bulk(Archive& ar, std::vector<T, Alloc>& v, std::false_type /*contiguous*/)
+{
+  using Layout = BulkLayout<T>;
+  using Scalar = typename Layout::Scalar;
+
+  std::vector<Scalar> chunk((v.size() < bulk_chunk_size ? v.size() : bulk_chunk_size) * Layout::size);
+
+  for (std::size_t begin = 0; begin < v.size(); begin += bulk_chunk_size)
+  {
+    const std::size_t end = (v.size() - begin < bulk_chunk_size) ? v.size() : begin + bulk_chunk_size;
+
+    ar >> boost::serialization::make_array<Scalar>(chunk.data(), (end - begin) * Layout::size);
+
+    for (std::size_t i = begin; i < end; ++i)
+      Layout::unpack(&chunk[(i - begin) * Layout::size], v[i]);
+  }
+}
+
+/**
+ * @brief save_bulk. Write the size of 'v' then its scalars.
+ */
+template <class Archive, typename T, typename Alloc>
+void save_bulk(Archive& ar, const std::vector<T, Alloc>& v)
+{
+  const boost::serialization::collection_size_type count(v.size());
+  ar << BOOST_SERIALIZATION_NVP(count);
+
+  if (!v.empty()) save_bulk(ar, v, is_bulk_contiguous<T>());
+}
+
+/**
+ * @brief load_bulk. Read a vector written by save_bulk.
+ */
+template <class Archive, typename T, typename Alloc>
+void load_bulk(Archive& ar, std::vector<T, Alloc>& v)
+{
+  boost::serialization::collection_size_type count;
+  ar >> BOOST_SERIALIZATION_NVP(count);
+
+  v.resize(count);
+
+  if (!v.empty()) load_bulk(ar, v, is_bulk_contiguous<T>());
+}
+
+} /* namespace details */
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_BULK_LAYOUT_H */
@@ -0,0 +1,148 @@
+/**
+ * \file compression.h
+ * \brief Compression of serialized bags.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_COMPRESSION_H
+#define PROPERTY_BAG_SERIALIZATION_COMPRESSION_H
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace property_bag {
+
+/**
+ * @brief The Compression enum.
+ * The codecs of boost::iostreams.
+ */
+enum class Compression : std::uint8_t
+{
+  NONE = 0,
+  ZLIB,     //< zlib stream, fast.
+  BZIP2     //< bzip2 stream, smaller, slower.
+};
+
+/**
+ * @brief default_compression_level. Level 6 for zlib,
+ * blocks of 900k for bzip2.
+ */
+constexpr int default_compression_level = -1;
+
+/**
+ * @brief detect_compression. The codec of
+ * compressed bytes, from their stream header.
+ * @return Compression::NONE if none matches.
+ * @note Archives with a header and the wire format can
+ * not be mistaken for compressed bytes.
+ */
+Compression detect_compression(const char* data, const std::size_t size) noexcept;
+
+/**
+ * @brief compress. Compress bytes.
+ * @param level. 1 (fastest) to 9 (smallest).
+ * Throws a PropertyException if 'level' is out of range.
+ */
+std::string compress(const char* data, const std::size_t size,
+                     const Compression compression,
+                     const int level = default_compression_level);
+
+inline std::string compress(const std::string& bytes,
+                            const Compression compression,
+                            const int level = default_compression_level)
+{
+  return compress(bytes.data(), bytes.size(), compression, level);
+}
+
+/**
+ * @brief decompress. Decompress bytes, their codec is detected.
+ * Bytes that are not compressed are returned as is.
+ * Throws a PropertyException if the input is corrupted.
+ */
+std::string decompress(const char* data, const std::size_t size);
+
+inline std::string decompress(const std::string& bytes)
+{
+  return decompress(bytes.data(), bytes.size());
+}
+
+/**
+ * @brief The CompressedOStream class.
+ * Compresses what is written to it into another stream.
+ */
+class CompressedOStream : public std::ostream
+{
+public:
+
+  /**
+   * @brief CompressedOStream.
+   * Throws a PropertyException if 'level' is out of range.
+   */
+  CompressedOStream(std::ostream& os, const Compression compression,
+                    const int level = default_compression_level);
+
+  /**
+   * @brief ~CompressedOStream. Closes, ignoring errors,
+   * call close() to have them reported.
+   */
+  ~CompressedOStream();
+
+  /**
+   * @brief close. Flush the compressed stream
+   * and write its end. Nothing can be written after.
+   * Throws a PropertyException on failure.
+   */
+  void close();
+
+protected:
+
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+/**
+ * @brief The DecompressedIStream class.
+ * Reads another stream, decompressing it
+ * if it is compressed.
+ */
+class DecompressedIStream : public std::istream
+{
+public:
+
+  /**
+   * @brief DecompressedIStream. Reads the first bytes
+   * of 'is' to detect its compression.
+   */
+  explicit DecompressedIStream(std::istream& is);
+
+  ~DecompressedIStream();
+
+  /**
+   * @brief compression. The detected codec.
+   */
+  Compression compression() const noexcept;
+
+protected:
+
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+namespace details {
+
+/**
+ * @brief may_be_compressed. Whether a stream starting
+ * with 'byte' may be compressed, no false negative.
+ */
+constexpr bool may_be_compressed(const int byte) noexcept
+{
+  return byte == 0x78 /*zlib*/ || byte == 'B' /*bzip2*/;
+}
+
+} /* namespace details */
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_COMPRESSION_H */
@@ -0,0 +1,84 @@
+/**
+ * \file delta_boost_serialization.h
+ * \brief Boost serialization of bag deltas.
+ */
+
+#ifndef PROPERTY_BAG_BOOST_SERIALIZATION_DELTA_H
+#define PROPERTY_BAG_BOOST_SERIALIZATION_DELTA_H
+
+#include <property_bag/serialization/property_bag_boost_serialization.h>
+#include <property_bag/delta.h>
+
+#include <boost/serialization/vector.hpp>
+
+namespace boost {
+namespace serialization {
+
+template<class Archive, typename KeyType>
+void serialize(
+    Archive &ar,
+    property_bag::AbstractPropertyBagDelta<KeyType> &delta,
+    const unsigned int /*file_version*/)
+{
+  ar & boost::serialization::make_nvp("changed", delta.changed);
+  ar & boost::serialization::make_nvp("removed", delta.removed);
+}
+
+} //namespace serialization
+} //namespace boost
+
+namespace property_bag {
+
+/**
+ * @brief to_delta. Serialize the properties of 'bag' added, changed
+ * or removed since 'checkpoint', which is then moved to the current
+ * state of the bag. Against a default constructed checkpoint,
+ * the whole bag is written.
+ * @tparam OArchive. The boost output archive, native binary by default.
+ * @see make_delta.
+ */
+template <typename OArchive = boost::archive::binary_oarchive, typename KeyType>
+std::string to_delta(const property_bag::AbstractPropertyBag<KeyType> &property_bag,
+                     AbstractPropertyBagCheckpoint<KeyType> &checkpoint)
+{
+  const AbstractPropertyBagDelta<KeyType> delta = make_delta(property_bag, checkpoint);
+
+  std::string str;
+  {
+    boost::iostreams::stream<boost::iostreams::back_insert_device<std::string>> os(str);
+    {
+      OArchive oa(os);
+      oa << boost::serialization::make_nvp("delta", delta);
+    }
+    os.flush();
+  }
+
+  return str;
+}
+
+/**
+ * @brief apply_delta. Deserialize a delta written by to_delta
+ * and update 'bag' in place. The bag is left untouched
+ * if the delta can not be read.
+ * @tparam IArchive. The boost input archive, native binary by default.
+ * @return false in real-time mode.
+ */
+template <typename IArchive = boost::archive::binary_iarchive, typename KeyType>
+bool apply_delta(const std::string &bytes,
+                 property_bag::AbstractPropertyBag<KeyType> &property_bag)
+{
+  if (property_bag.isRealTime()) return false;
+
+  AbstractPropertyBagDelta<KeyType> delta;
+  {
+    boost::iostreams::stream<boost::iostreams::array_source> is(bytes.data(), bytes.size());
+    IArchive ia(is);
+    ia >> boost::serialization::make_nvp("delta", delta);
+  }
+
+  return apply_delta(delta, property_bag);
+}
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_BOOST_SERIALIZATION_DELTA_H */
@@ -21,26 +21,88 @@ THE SOFTWARE.
 #define EIGEN_BOOST_SERIALIZATION
 #include <Eigen/Sparse>
 #include <Eigen/Dense>
+#include <boost/archive/archive_exception.hpp>
 #include <boost/serialization/split_free.hpp>
+#include <boost/serialization/throw_exception.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
+#include <property_bag/eigen_type_names.h>
+#include <property_bag/serialization/bulk_layout.h>
+#include <property_bag/serialization/registry_link.h>
+
+/*
+ * Versions :
+ *  - Matrix    1 : fixed-size matrices are written without their dimensions.
+ *  - Quaternion 1 : coefficients written as one block, x y z w.
+ *  - Transform 1 : written without dimensions, Isometry and Affine
+ *                  without their constant last row.
+ *  - SparseMatrix 1 : the compressed storage, outer starts, inner
+ *                     indices and values, as contiguous blocks.
+ * Archives of version 0 are still read.
+ *
+ * A std::vector of fixed-size matrices, quaternions, isometries
+ * or affine transforms held by a Property is written as a single
+ * array, see property_bag::details::BulkLayout.
+ */
 
 namespace boost{
 namespace serialization{
 
+template <typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows, int _MaxCols>
+struct version<Eigen::Matrix<_Scalar,_Rows,_Cols,_Options,_MaxRows,_MaxCols>>
+{
+  typedef mpl::int_<1> type;
+  typedef mpl::integral_c_tag tag;
+  BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
+
+template <typename _Scalar, int _Options>
+struct version<Eigen::Quaternion<_Scalar,_Options>>
+{
+  typedef mpl::int_<1> type;
+  typedef mpl::integral_c_tag tag;
+  BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
+
+template <typename _Scalar, int _Dim, int _Mode, int _Options>
+struct version<Eigen::Transform<_Scalar,_Dim,_Mode,_Options>>
+{
+  typedef mpl::int_<1> type;
+  typedef mpl::integral_c_tag tag;
+  BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
+
+template <typename _Scalar, int _Options, typename _Index>
+struct version<Eigen::SparseMatrix<_Scalar,_Options,_Index>>
+{
+  typedef mpl::int_<1> type;
+  typedef mpl::integral_c_tag tag;
+  BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
+
 template <class Archive, typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows, int _MaxCols>
 void save(Archive & ar, const Eigen::Matrix<_Scalar,_Rows,_Cols,_Options,_MaxRows,_MaxCols>& m, const unsigned int /*version*/) {
-  int rows=m.rows(),cols=m.cols();
-  ar & rows;
-  ar & cols;
-  ar & boost::serialization::make_array(m.data(), rows*cols);
+  if (_Rows == Eigen::Dynamic || _Cols == Eigen::Dynamic) {
+    int rows=m.rows(),cols=m.cols();
+    ar & rows;
+    ar & cols;
+  }
+  ar & boost::serialization::make_array(m.data(), m.size());
 }
 template <class Archive, typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows, int _MaxCols>
-void load(Archive & ar, Eigen::Matrix<_Scalar,_Rows,_Cols,_Options,_MaxRows,_MaxCols>& m, const unsigned int /*version*/) {
-  int rows,cols;
-  ar & rows;
-  ar & cols;
-  m.resize(rows,cols);
-  ar & boost::serialization::make_array(m.data(), rows*cols);
+void load(Archive & ar, Eigen::Matrix<_Scalar,_Rows,_Cols,_Options,_MaxRows,_MaxCols>& m, const unsigned int version) {
+  const bool fixed = (_Rows != Eigen::Dynamic && _Cols != Eigen::Dynamic);
+  if (version == 0 || !fixed) {
+    int rows,cols;
+    ar & rows;
+    ar & cols;
+    if (!fixed)
+      m.resize(rows,cols);
+    else if (rows != m.rows() || cols != m.cols())
+      boost::serialization::throw_exception(boost::archive::archive_exception(
+        boost::archive::archive_exception::array_size_too_short));
+  }
+  ar & boost::serialization::make_array(m.data(), m.size());
 }
 
 template <class Archive, typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows, int _MaxCols>
@@ -73,21 +135,24 @@ void serialize(Archive & ar, Eigen::Triplet<_Scalar,Index> & m, const unsigned i
 
 template <class Archive, typename _Scalar, int _Options,typename _Index>
 void save(Archive & ar, const Eigen::SparseMatrix<_Scalar,_Options,_Index> & m, const unsigned int /*version*/) {
-  int innerSize=m.innerSize();
-  int outerSize=m.outerSize();
-  typedef typename Eigen::Triplet<_Scalar> Triplet;
-  std::vector<Triplet> triplets;
-  for(int i=0; i < outerSize; ++i) {
-    for(typename Eigen::SparseMatrix<_Scalar,_Options,_Index>::InnerIterator it(m,i); it; ++it) {
-      triplets.push_back(Triplet(it.row(), it.col(), it.value()));
-    }
+  typedef Eigen::SparseMatrix<_Scalar,_Options,_Index> Sparse;
+  if (!m.isCompressed()) {
+    Sparse compressed(m);
+    compressed.makeCompressed();
+    save(ar, compressed, 1);
+    return;
   }
-  ar & innerSize;
-  ar & outerSize;
-  ar & triplets;
+  int rows=m.rows(),cols=m.cols();
+  _Index nnz=m.nonZeros();
+  ar & rows;
+  ar & cols;
+  ar & nnz;
+  ar & boost::serialization::make_array(m.outerIndexPtr(), m.outerSize()+1);
+  ar & boost::serialization::make_array(m.innerIndexPtr(), nnz);
+  ar & boost::serialization::make_array(m.valuePtr(), nnz);
 }
 template <class Archive, typename _Scalar, int _Options, typename _Index>
-void load(Archive & ar, Eigen::SparseMatrix<_Scalar,_Options,_Index>  & m, const unsigned int /*version*/) {
+void load_triplets(Archive & ar, Eigen::SparseMatrix<_Scalar,_Options,_Index>  & m) {
   int innerSize;
   int outerSize;
   ar & innerSize;
@@ -99,7 +164,41 @@ void load(Archive & ar, Eigen::SparseMatrix<_Scalar,_Options,_Index>  & m, const
   std::vector<Triplet> triplets;
   ar & triplets;
   m.setFromTriplets(triplets.begin(), triplets.end());
-
+}
+template <class Archive, typename _Scalar, int _Options, typename _Index>
+void load(Archive & ar, Eigen::SparseMatrix<_Scalar,_Options,_Index>  & m, const unsigned int version) {
+  if (version == 0) {
+    load_triplets(ar, m);
+    return;
+  }
+  int rows,cols;
+  _Index nnz;
+  ar & rows;
+  ar & cols;
+  ar & nnz;
+  if (rows < 0 || cols < 0 || nnz < 0)
+    boost::serialization::throw_exception(boost::archive::archive_exception(
+      boost::archive::archive_exception::input_stream_error));
+  m.resize(rows,cols);
+  m.resizeNonZeros(nnz);
+  const _Index outerSize = m.outerSize(), innerSize = m.innerSize();
+  _Index* outer = m.outerIndexPtr();
+  _Index* inner = m.innerIndexPtr();
+  ar & boost::serialization::make_array(outer, outerSize+1);
+  ar & boost::serialization::make_array(inner, nnz);
+  ar & boost::serialization::make_array(m.valuePtr(), nnz);
+  // O(nnz) check of the storage, no sorting involved
+  bool valid = (outer[0] == 0 && outer[outerSize] == nnz);
+  for (_Index j=0; valid && j<outerSize; ++j) {
+    valid = (outer[j] <= outer[j+1] && outer[j+1] <= nnz);
+    for (_Index k=outer[j]; valid && k<outer[j+1]; ++k)
+      valid = (inner[k] >= 0 && inner[k] < innerSize && (k == outer[j] || inner[k-1] < inner[k]));
+  }
+  if (!valid) {
+    m.setZero();
+    boost::serialization::throw_exception(boost::archive::archive_exception(
+      boost::archive::archive_exception::input_stream_error));
+  }
 }
 template <class Archive, typename _Scalar, int _Options, typename _Index>
 void serialize(Archive & ar, Eigen::SparseMatrix<_Scalar,_Options,_Index> & m, const unsigned int version) {
@@ -107,12 +206,47 @@ void serialize(Archive & ar, Eigen::SparseMatrix<_Scalar,_Options,_Index> & m, c
 }
 
 template<class Archive, typename _Scalar, int _Options>
-void serialize(Archive & ar, Eigen::Quaternion<_Scalar,_Options>& q, const unsigned int /*version*/)
+void serialize(Archive & ar, Eigen::Quaternion<_Scalar,_Options>& q, const unsigned int version)
+{
+  if (version == 0) {
+    ar & q.w();
+    ar & q.x();
+    ar & q.y();
+    ar & q.z();
+    return;
+  }
+  ar & boost::serialization::make_array(q.coeffs().data(), 4);
+}
+
+template<class Archive, typename _Scalar, int _Dim, int _Mode, int _Options>
+void save(Archive& ar,
+          const Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& t,
+          const unsigned int /*version*/)
+{
+  if (_Mode == Eigen::Isometry || _Mode == Eigen::Affine) {
+    // The last row is constant
+    const Eigen::Matrix<_Scalar, _Dim, _Dim+1> affine = t.affine();
+    ar & boost::serialization::make_array(affine.data(), affine.size());
+  } else {
+    ar & boost::serialization::make_array(t.matrix().data(), t.matrix().size());
+  }
+}
+
+template<class Archive, typename _Scalar, int _Dim, int _Mode, int _Options>
+void load(Archive& ar,
+          Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& t,
+          const unsigned int version)
 {
-  ar & q.w();
-  ar & q.x();
-  ar & q.y();
-  ar & q.z();
+  if (version == 0) {
+    load(ar, t.matrix(), version);
+  } else if (_Mode == Eigen::Isometry || _Mode == Eigen::Affine) {
+    Eigen::Matrix<_Scalar, _Dim, _Dim+1> affine;
+    ar & boost::serialization::make_array(affine.data(), affine.size());
+    t.affine() = affine;
+    t.makeAffine();
+  } else {
+    ar & boost::serialization::make_array(t.matrix().data(), t.matrix().size());
+  }
 }
 
 template<class Archive, typename _Scalar, int _Dim, int _Mode, int _Options>
@@ -120,10 +254,69 @@ inline void serialize(Archive& ar,
                       Eigen::Transform<_Scalar, _Dim, _Mode, _Options>& t,
                       const unsigned int version)
 {
-  serialize(ar, t.matrix(), version);
+  split_free(ar, t, version);
 }
 
 } /* namespace serialization */
 } /* namespace boost */
 
+namespace property_bag {
+namespace details {
+
+template <typename _Scalar, int _Rows, int _Cols, int _Options, int _MaxRows, int _MaxCols>
+struct BulkLayout<Eigen::Matrix<_Scalar,_Rows,_Cols,_Options,_MaxRows,_MaxCols>,
+                  typename std::enable_if<_Rows != Eigen::Dynamic && _Cols != Eigen::Dynamic>::type>
+  : std::true_type
+{
+  using Scalar = _Scalar;
+  using Matrix = Eigen::Matrix<_Scalar,_Rows,_Cols,_Options,_MaxRows,_MaxCols>;
+
+  static constexpr std::size_t size = _Rows*_Cols;
+  static constexpr bool contiguous = true;
+
+  static void pack(const Matrix& m, Scalar* out) { std::copy(m.data(), m.data()+size, out); }
+  static void unpack(const Scalar* in, Matrix& m) { std::copy(in, in+size, m.data()); }
+};
+
+// x y z w
+template <typename _Scalar, int _Options>
+struct BulkLayout<Eigen::Quaternion<_Scalar,_Options>> : std::true_type
+{
+  using Scalar = _Scalar;
+  using Quaternion = Eigen::Quaternion<_Scalar,_Options>;
+
+  static constexpr std::size_t size = 4;
+  static constexpr bool contiguous = true;
+
+  static void pack(const Quaternion& q, Scalar* out) { std::copy(q.coeffs().data(), q.coeffs().data()+size, out); }
+  static void unpack(const Scalar* in, Quaternion& q) { std::copy(in, in+size, q.coeffs().data()); }
+};
+
+// Without the constant last row
+template <typename _Scalar, int _Dim, int _Mode, int _Options>
+struct BulkLayout<Eigen::Transform<_Scalar,_Dim,_Mode,_Options>,
+                  typename std::enable_if<_Mode == Eigen::Isometry || _Mode == Eigen::Affine>::type>
+  : std::true_type
+{
+  using Scalar = _Scalar;
+  using Transform = Eigen::Transform<_Scalar,_Dim,_Mode,_Options>;
+  using Affine = Eigen::Matrix<_Scalar,_Dim,_Dim+1>;
+
+  static constexpr std::size_t size = _Dim*(_Dim+1);
+  static constexpr bool contiguous = false;
+
+  static void pack(const Transform& t, Scalar* out) { Eigen::Map<Affine> affine(out); affine = t.affine(); }
+  static void unpack(const Scalar* in, Transform& t)
+  {
+    t.affine() = Eigen::Map<const Affine>(in);
+    t.makeAffine();
+  }
+};
+
+} /* namespace details */
+} /* namespace property_bag */
+
+// Types registered in property_bag_eigen
+PROPERTY_BAG_LINK_REGISTRY(eigen_boost)
+
 #endif /* EIGEN_BOOST_SERIALIZATION */
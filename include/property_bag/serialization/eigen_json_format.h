@@ -0,0 +1,176 @@
+/**
+ * \file eigen_json_format.h
+ * \brief JSON codecs for Eigen types.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_EIGEN_JSON_FORMAT_H
+#define PROPERTY_BAG_SERIALIZATION_EIGEN_JSON_FORMAT_H
+
+#include <property_bag/serialization/json_format.h>
+#include <property_bag/eigen_type_names.h>
+#include <property_bag/serialization/registry_link.h>
+
+#include <Eigen/Dense>
+
+namespace property_bag {
+namespace json {
+
+// Column vectors: [v0, v1, ...], matrices: [[row 0], [row 1], ...]
+template <typename Scalar, int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+struct Codec<Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>>
+{
+  using Matrix = Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>;
+
+  using is_vector = std::integral_constant<bool, Cols == 1>;
+
+  static void encode(Writer& w, const Matrix& m)
+  {
+    encode(w, m, is_vector());
+  }
+
+  static void decode(Reader& r, Matrix& m)
+  {
+    // Kept between values, decoding does not allocate once warm
+    static thread_local std::vector<Scalar> values;
+    values.clear();
+
+    Eigen::Index rows = 0, cols = 0;
+    decode(r, values, rows, cols, is_vector());
+
+    if ((Rows != Eigen::Dynamic && rows != Rows) ||
+        (Cols != Eigen::Dynamic && cols != Cols))
+      r.error("Eigen matrix size mismatch");
+
+    using RowMajor = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+    m = Eigen::Map<const RowMajor>(values.data(), rows, cols);
+  }
+
+protected:
+
+  static void encode(Writer& w, const Matrix& m, std::true_type)
+  {
+    w.begin_array();
+    for (Eigen::Index i=0; i<m.size(); ++i)
+      Codec<Scalar>::encode(w, m(i));
+    w.end_array();
+  }
+
+  static void encode(Writer& w, const Matrix& m, std::false_type)
+  {
+    w.begin_array();
+    for (Eigen::Index i=0; i<m.rows(); ++i)
+    {
+      w.begin_array();
+      for (Eigen::Index j=0; j<m.cols(); ++j)
+        Codec<Scalar>::encode(w, m(i, j));
+      w.end_array();
+    }
+    w.end_array();
+  }
+
+  static void decode_row(Reader& r, std::vector<Scalar>& values)
+  {
+    r.expect('[');
+
+    bool first = true;
+    while (r.more(']', first))
+    {
+      values.emplace_back();
+      Codec<Scalar>::decode(r, values.back());
+    }
+  }
+
+  static void decode(Reader& r, std::vector<Scalar>& values,
+                     Eigen::Index& rows, Eigen::Index& cols, std::true_type)
+  {
+    decode_row(r, values);
+
+    rows = values.size();
+    cols = 1;
+  }
+
+  static void decode(Reader& r, std::vector<Scalar>& values,
+                     Eigen::Index& rows, Eigen::Index& cols, std::false_type)
+  {
+    r.expect('[');
+
+    bool first = true;
+    while (r.more(']', first))
+    {
+      decode_row(r, values);
+
+      if (rows++ == 0) cols = values.size();
+      else if (Eigen::Index(values.size()) != rows * cols)
+        r.error("Eigen matrix rows of different sizes");
+    }
+  }
+};
+
+// {"x": x, "y": y, "z": z, "w": w}
+template <typename Scalar, int Options>
+struct Codec<Eigen::Quaternion<Scalar, Options>>
+{
+  using Quaternion = Eigen::Quaternion<Scalar, Options>;
+
+  static void encode(Writer& w, const Quaternion& q)
+  {
+    w.begin_object();
+    w.key("x", 1); Codec<Scalar>::encode(w, q.x());
+    w.key("y", 1); Codec<Scalar>::encode(w, q.y());
+    w.key("z", 1); Codec<Scalar>::encode(w, q.z());
+    w.key("w", 1); Codec<Scalar>::encode(w, q.w());
+    w.end_object();
+  }
+
+  static void decode(Reader& r, Quaternion& q)
+  {
+    std::string key;
+    int found = 0;
+
+    r.expect('{');
+
+    bool first = true;
+    while (r.more('}', first))
+    {
+      r.read_key(key);
+
+      if (key.size() != 1) r.error("unknown quaternion coefficient '" + key + "'");
+
+      switch (key[0])
+      {
+      case 'x': Codec<Scalar>::decode(r, q.x()); found |= 1; break;
+      case 'y': Codec<Scalar>::decode(r, q.y()); found |= 2; break;
+      case 'z': Codec<Scalar>::decode(r, q.z()); found |= 4; break;
+      case 'w': Codec<Scalar>::decode(r, q.w()); found |= 8; break;
+      default: r.error("unknown quaternion coefficient '" + key + "'");
+      }
+    }
+
+    if (found != 15) r.error("missing quaternion coefficient");
+  }
+};
+
+// The rows of its matrix
+template <typename Scalar, int Dim, int Mode, int Options>
+struct Codec<Eigen::Transform<Scalar, Dim, Mode, Options>>
+{
+  using Transform = Eigen::Transform<Scalar, Dim, Mode, Options>;
+
+  static void encode(Writer& w, const Transform& t)
+  {
+    Codec<typename Transform::MatrixType>::encode(w, t.matrix());
+  }
+
+  static void decode(Reader& r, Transform& t)
+  {
+    Codec<typename Transform::MatrixType>::decode(r, t.matrix());
+  }
+};
+
+} /* namespace json */
+} /* namespace property_bag */
+
+// Types registered in property_bag_eigen
+PROPERTY_BAG_LINK_REGISTRY(eigen_json)
+
+#endif /* PROPERTY_BAG_SERIALIZATION_EIGEN_JSON_FORMAT_H */
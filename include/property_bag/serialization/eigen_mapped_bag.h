@@ -0,0 +1,47 @@
+/**
+ * \file eigen_mapped_bag.h
+ * \brief In place access to Eigen data of a mapped bag.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_EIGEN_MAPPED_BAG_H
+#define PROPERTY_BAG_SERIALIZATION_EIGEN_MAPPED_BAG_H
+
+#include <property_bag/serialization/mapped_bag.h>
+#include <property_bag/serialization/eigen_wire_format.h>
+
+namespace property_bag {
+
+/**
+ * @brief getMap. Map a block of a mapped bag, no copy involved.
+ * Throws a PropertyException if there is no such property,
+ * if it is not a block of Matrix::Scalar or if its size
+ * does not fit Matrix.
+ * @tparam Matrix. An Eigen matrix type with the
+ * storage order of the written value.
+ */
+template <typename Matrix>
+Eigen::Map<const Matrix, Eigen::AlignedMax>
+getMap(const MappedPropertyBag& bag, const std::string& name)
+{
+  using Scalar = typename Matrix::Scalar;
+
+  std::size_t rows = 0, cols = 0;
+  const Scalar* data = bag.getBlock<Scalar>(name, rows, cols);
+
+  if (data == nullptr)
+    throw PropertyException("named '" + name + "' is not a block of " +
+                            property_bag::name_of<Scalar>() + " in mapped bag.");
+
+  if ((Matrix::RowsAtCompileTime != Eigen::Dynamic &&
+       rows != std::size_t(Matrix::RowsAtCompileTime)) ||
+      (Matrix::ColsAtCompileTime != Eigen::Dynamic &&
+       cols != std::size_t(Matrix::ColsAtCompileTime)))
+    throw PropertyException("named '" + name + "' is a " + std::to_string(rows) +
+                            "x" + std::to_string(cols) + " block, size mismatch.");
+
+  return Eigen::Map<const Matrix, Eigen::AlignedMax>(data, rows, cols);
+}
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_EIGEN_MAPPED_BAG_H */
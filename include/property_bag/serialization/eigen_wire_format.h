@@ -0,0 +1,113 @@
+/**
+ * \file eigen_wire_format.h
+ * \brief Wire format codecs for Eigen types.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_EIGEN_WIRE_FORMAT_H
+#define PROPERTY_BAG_SERIALIZATION_EIGEN_WIRE_FORMAT_H
+
+#include <property_bag/serialization/wire_format.h>
+#include <property_bag/eigen_type_names.h>
+#include <property_bag/serialization/registry_link.h>
+
+#include <Eigen/Dense>
+
+namespace property_bag {
+namespace wire {
+
+// rows:varint cols:varint data:Scalar[rows*cols]
+template <typename Scalar, int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+struct Codec<Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>>
+{
+  using Matrix = Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>;
+
+  template <class W>
+  static void encode(W& w, const Matrix& m)
+  {
+    w.write_varint(m.rows());
+    w.write_varint(m.cols());
+    w.write_block(m.data(), m.size());
+  }
+
+  static void decode(Reader& r, Matrix& m)
+  {
+    const std::uint64_t rows = r.read_varint();
+    const std::uint64_t cols = r.read_varint();
+
+    if ((Rows != Eigen::Dynamic && rows != std::uint64_t(Rows)) ||
+        (Cols != Eigen::Dynamic && cols != std::uint64_t(Cols)))
+      throw PropertyException("Wire format: Eigen matrix size mismatch.");
+
+    if (cols != 0) r.check_count(rows, cols*sizeof(Scalar));
+
+    m.resize(rows, cols);
+    r.read_block(m.data(), m.size());
+  }
+};
+
+template <typename Scalar, int Rows, int Cols, int Options, int MaxRows, int MaxCols>
+struct RawLayout<Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>,
+                 typename std::enable_if<has_fixed_width<Scalar>::value>::type>
+    : std::true_type
+{
+  using Matrix = Eigen::Matrix<Scalar, Rows, Cols, Options, MaxRows, MaxCols>;
+
+  static RawView view(const Matrix& m)
+  {
+    return RawView{scalar_id<Scalar>(), std::uint64_t(m.rows()),
+                   std::uint64_t(m.cols()), m.data()};
+  }
+
+  static void load(const RawView& v, Matrix& m)
+  {
+    if ((Rows != Eigen::Dynamic && v.rows != std::uint64_t(Rows)) ||
+        (Cols != Eigen::Dynamic && v.cols != std::uint64_t(Cols)))
+      throw PropertyException("Eigen matrix size mismatch.");
+
+    m = Eigen::Map<const Matrix>(static_cast<const Scalar*>(v.data), v.rows, v.cols);
+  }
+};
+
+// coeffs:Scalar[4], x y z w
+template <typename Scalar, int Options>
+struct Codec<Eigen::Quaternion<Scalar, Options>>
+{
+  using Quaternion = Eigen::Quaternion<Scalar, Options>;
+
+  template <class W>
+  static void encode(W& w, const Quaternion& q)
+  {
+    w.write_block(q.coeffs().data(), 4);
+  }
+
+  static void decode(Reader& r, Quaternion& q)
+  {
+    r.read_block(q.coeffs().data(), 4);
+  }
+};
+
+// matrix:Scalar[rows*cols]
+template <typename Scalar, int Dim, int Mode, int Options>
+struct Codec<Eigen::Transform<Scalar, Dim, Mode, Options>>
+{
+  using Transform = Eigen::Transform<Scalar, Dim, Mode, Options>;
+
+  template <class W>
+  static void encode(W& w, const Transform& t)
+  {
+    w.write_block(t.matrix().data(), t.matrix().size());
+  }
+
+  static void decode(Reader& r, Transform& t)
+  {
+    r.read_block(t.matrix().data(), t.matrix().size());
+  }
+};
+
+} /* namespace wire */
+} /* namespace property_bag */
+
+// Types registered in property_bag_eigen
+PROPERTY_BAG_LINK_REGISTRY(eigen_wire)
+
+#endif /* PROPERTY_BAG_SERIALIZATION_EIGEN_WIRE_FORMAT_H */
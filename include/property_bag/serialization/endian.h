@@ -0,0 +1,140 @@
+/**
+ * \file endian.h
+ * \brief Byte order helpers shared by the binary formats.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_ENDIAN_H
+#define PROPERTY_BAG_SERIALIZATION_ENDIAN_H
+
+#include <boost/predef/other/endian.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace property_bag {
+namespace details {
+
+constexpr bool native_little_endian() noexcept
+{
+#if BOOST_ENDIAN_LITTLE_BYTE
+  return true;
+#else
+  return false;
+#endif
+}
+
+template <typename T>
+inline void byte_swap(T& t) noexcept
+{
+  char* bytes = reinterpret_cast<char*>(&t);
+  std::reverse(bytes, bytes + sizeof(T));
+}
+
+constexpr std::uint16_t byte_swap_value(const std::uint16_t v) noexcept
+{
+  return std::uint16_t((v >> 8) | (v << 8));
+}
+
+constexpr std::uint32_t byte_swap_value(const std::uint32_t v) noexcept
+{
+  return ((v & 0x000000ffu) << 24) | ((v & 0x0000ff00u) <<  8) |
+         ((v & 0x00ff0000u) >>  8) | ((v & 0xff000000u) >> 24);
+}
+
+constexpr std::uint64_t byte_swap_value(const std::uint64_t v) noexcept
+{
+  return (std::uint64_t(byte_swap_value(std::uint32_t(v))) << 32) |
+          std::uint64_t(byte_swap_value(std::uint32_t(v >> 32)));
+}
+
+template <std::size_t Size> struct uint_of_size { };
+template <> struct uint_of_size<2> { using type = std::uint16_t; };
+template <> struct uint_of_size<4> { using type = std::uint32_t; };
+template <> struct uint_of_size<8> { using type = std::uint64_t; };
+
+/**
+ * @brief byte_swap_block. Copy 'count' values from 'in'
+ * to 'out', which may be the same, swapping their bytes.
+ *
+ * Values are swapped as integers of their size in a plain
+ * loop, that compilers turn into vector byte shuffles
+ * (SSSE3 pshufb, NEON rev), rather than byte by byte.
+ */
+template <typename T>
+typename std::enable_if<sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8>::type
+byte_swap_block(const T* in, T* out, const std::size_t count) noexcept
+{
+  using UInt = typename uint_of_size<sizeof(T)>::type;
+
+  for (std::size_t i=0; i<count; ++i)
+  {
+    UInt u;
+    std::memcpy(&u, in + i, sizeof(T));
+    u = byte_swap_value(u);
+    std::memcpy(out + i, &u, sizeof(T));
+  }
+}
+
+template <typename T>
+typename std::enable_if<sizeof(T) == 1>::type
+byte_swap_block(const T* in, T* out, const std::size_t count) noexcept
+{
+  if (in != out) std::memmove(out, in, count);
+}
+
+template <typename T>
+inline void byte_swap_block(T* data, const std::size_t count) noexcept
+{
+  byte_swap_block(data, data, count);
+}
+
+// Bytes swapped at once by the writers, on the stack
+constexpr std::size_t byte_swap_chunk_size = 4096;
+
+/**
+ * @brief write_little_endian. Call write(const void*, std::size_t)
+ * with the bytes of 'count' values in little endian, at once
+ * on little endian hosts, through a swapped chunk otherwise.
+ */
+template <typename T, typename Write>
+void write_little_endian(const T* data, const std::size_t count, Write&& write)
+{
+  if (native_little_endian() || sizeof(T) == 1)
+  {
+    write(data, count*sizeof(T));
+    return;
+  }
+
+  constexpr std::size_t chunk = byte_swap_chunk_size / sizeof(T);
+
+  typename std::remove_const<T>::type swapped[chunk];
+
+  for (std::size_t begin = 0; begin < count; begin += chunk)
+  {
+    const std::size_t size = (count - begin < chunk) ? count - begin : chunk;
+
+    byte_swap_block(data + begin, swapped, size);
+    write(swapped, size*sizeof(T));
+  }
+}
+
+/**
+ * @brief from_little_endian. Convert in place 'count'
+ * values read in little endian, a no-op on little
+ * endian hosts.
+ */
+template <typename T>
+inline void from_little_endian(T* data, const std::size_t count) noexcept
+{
+  if (native_little_endian() || sizeof(T) == 1) return;
+
+  byte_swap_block(data, count);
+}
+
+} /* namespace details */
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_ENDIAN_H */
@@ -0,0 +1,195 @@
+/**
+ * \file journal.h
+ * \brief Property bag persisted as a snapshot and a journal of changes.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_JOURNAL_H
+#define PROPERTY_BAG_SERIALIZATION_JOURNAL_H
+
+#include <property_bag/serialization/wire_format.h>
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+/*
+ * Files, every number is little endian :
+ *
+ *  <path>             := 'P' 'B' 'S' version:u8 generation:u64
+ *                        size:u64 crc:u32 bag:u8[size]
+ *  <path>.<g>.journal := 'P' 'B' 'J' version:u8 generation:u64 record*
+ *
+ *  record  := size:u32 crc:u32 payload:u8[size]
+ *  payload := PUT:u8 name:string type_name:string property
+ *           | REMOVE:u8 name:string
+ *
+ * 'bag' is in the wire format, 'property' as in the wire format
+ * (flags, description and value), 'crc' is the CRC-32 of what
+ * follows it. The snapshot holds the changes of the journals
+ * of earlier generations, it is replaced atomically.
+ *
+ * Recovery loads the snapshot then replays the journals from
+ * its generation on, up to the first incomplete or corrupted
+ * record, left by a crash while appending, which is dropped.
+ */
+
+namespace property_bag {
+
+/**
+ * @brief The JournaledPropertyBag class.
+ * A bag whose changes are persisted as they are made.
+ *
+ * Each addProperty, updateProperty and removeProperty appends a
+ * record of the change only to a journal, rather than rewriting
+ * the whole bag. Once the journal grows past a threshold,
+ * a new one is started and the bag is written as a snapshot
+ * by a background thread, replacing the previous snapshot
+ * and journals.
+ *
+ * Held types must have been exported to the wire format,
+ * see EXPORT_PROPERTY_WIRE_TYPE. Not thread-safe, the
+ * same way a PropertyBag is not.
+ */
+class JournaledPropertyBag
+{
+public:
+
+  static constexpr std::size_t default_compaction_threshold = 4*1024*1024;
+
+  /**
+   * @brief JournaledPropertyBag. Open the bag stored at 'path',
+   * created if none. Throws a PropertyException if the
+   * snapshot is corrupted or a type is not exported.
+   * @param compaction_threshold. Size of the journal, in bytes,
+   * past which it is compacted into a new snapshot.
+   * @param sync. Whether each record reaches the disk before the
+   * change returns (fdatasync), surviving a power loss rather
+   * than only a crash of the process.
+   */
+  explicit JournaledPropertyBag(const std::string& path,
+                                const std::size_t compaction_threshold = default_compaction_threshold,
+                                const bool sync = false);
+
+  /**
+   * @brief ~JournaledPropertyBag. Waits for
+   * the compaction in progress, if any.
+   */
+  ~JournaledPropertyBag();
+
+  JournaledPropertyBag(const JournaledPropertyBag&)            = delete;
+  JournaledPropertyBag& operator=(const JournaledPropertyBag&) = delete;
+
+  /**
+   * @brief addProperty. @see PropertyBag::addProperty.
+   * Throws a PropertyException if T is not exported to the
+   * wire format or if the journal can not be written,
+   * the change is then only held in memory.
+   */
+  template <typename T>
+  bool addProperty(const std::string& name, T&& value, const std::string& doc = "")
+  {
+    check_exported(typeid(typename std::decay<T>::type));
+
+    if (!bag_.addProperty(name, std::forward<T>(value), doc)) return false;
+
+    append_put(name);
+    return true;
+  }
+
+  /**
+   * @brief updateProperty. @see PropertyBag::updateProperty.
+   * @see addProperty for the exceptions.
+   */
+  template <typename T>
+  bool updateProperty(const std::string& name, T&& value)
+  {
+    check_exported(typeid(typename std::decay<T>::type));
+
+    if (!bag_.updateProperty(name, std::forward<T>(value))) return false;
+
+    append_put(name);
+    return true;
+  }
+
+  /**
+   * @brief removeProperty. @see PropertyBag::removeProperty.
+   * @see addProperty for the exceptions.
+   */
+  bool removeProperty(const std::string& name);
+
+  /**
+   * @brief bag. The bag, only changed
+   * through this class to be persisted.
+   */
+  inline const PropertyBag& bag() const noexcept { return bag_; }
+
+  /**
+   * @brief compact. Write a snapshot now, waiting for it.
+   * Rethrows the error of a previous background compaction,
+   * which is otherwise tried again past the next threshold,
+   * without compacting. The next call compacts.
+   */
+  void compact();
+
+  /**
+   * @brief sync. Flush the journal to the disk.
+   */
+  void sync();
+
+  /**
+   * @brief journalSize. Size of the current journal in bytes.
+   */
+  inline std::size_t journalSize() const noexcept { return journal_size_; }
+
+  /**
+   * @brief generation. Incremented by each compaction.
+   */
+  inline std::uint64_t generation() const noexcept { return generation_; }
+
+protected:
+
+  void check_exported(const std::type_info& type) const;
+
+  void append_put(const std::string& name);
+
+  void append(wire::Writer& record);
+
+  void recover();
+
+  std::size_t replay(const std::string& journal, const std::uint64_t generation);
+
+  void open_journal(const std::uint64_t generation, const std::size_t size);
+
+  // Starts a new journal and snapshots the bag in the background
+  void start_compaction();
+
+  // Joins the compaction thread, keeps its error if any
+  void wait_compaction();
+
+  std::string journal_path(const std::uint64_t generation) const;
+
+  PropertyBag bag_;
+
+  std::string path_;
+  std::size_t compaction_threshold_;
+  bool sync_;
+
+  int fd_ = -1;
+  std::size_t journal_size_ = 0;
+
+  std::uint64_t generation_ = 0;
+
+  // Only accessed by the compaction thread while it runs
+  std::uint64_t snapshot_generation_ = 0;
+  std::exception_ptr compaction_error_;
+
+  // Of a background compaction, until compact() reports it
+  std::exception_ptr failed_compaction_;
+
+  std::thread compaction_;
+  std::atomic<bool> compacting_{false};
+};
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_JOURNAL_H */
@@ -0,0 +1,825 @@
+/**
+ * \file json_format.h
+ * \brief JSON import/export of property bags.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_JSON_FORMAT_H
+#define PROPERTY_BAG_SERIALIZATION_JSON_FORMAT_H
+
+#include <property_bag/property_bag.h>
+#include <property_bag/serialization/lazy_registry.h>
+
+#include <cmath>
+#include <cstdint>
+#include <iosfwd>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+/*
+ * Layout :
+ *
+ *  bag      := { "name": key, "handling": "QUIET" | "THROW",
+ *                "properties": { key: property, ... } }
+ *  property := { "type": string, "description": string,
+ *                "modified": true, "value": value }
+ *
+ * 'type' is the name given to EXPORT_PROPERTY_JSON_TYPE,
+ * "description" and "modified" are omitted when empty / false.
+ * Arithmetic values are numbers, written with the fewest digits
+ * that read back to the same value, NaN and infinities being the
+ * strings "NaN", "Infinity" and "-Infinity". Strings are strings,
+ * vectors are arrays and nested bags are bags.
+ * Eigen vectors are arrays, matrices arrays of rows.
+ * Keys that are not strings are written as strings
+ * holding their number.
+ */
+
+#define EXPORT_PROPERTY_JSON_TYPE(Type, Name) \
+  namespace { \
+  const property_bag::json::Registrar<Type> property_bag_json_type_##Name(#Name); \
+  }
+
+namespace property_bag {
+namespace json {
+
+constexpr std::size_t default_stream_buffer_size = 64*1024;
+
+/**
+ * @brief format_number. Write 't' in 'buffer', which
+ * holds at least 32 chars, as a JSON number.
+ * Floating point values must be finite.
+ * @return the number of chars written.
+ */
+std::size_t format_number(char* buffer, const std::int64_t t) noexcept;
+std::size_t format_number(char* buffer, const std::uint64_t t) noexcept;
+std::size_t format_number(char* buffer, const double t) noexcept;
+std::size_t format_number(char* buffer, const float t) noexcept;
+
+/**
+ * @brief The Writer class. Writes JSON in a growing buffer
+ * or, through a fixed-size buffer, to a std::ostream.
+ * Objects are indented by 'indent' spaces per level,
+ * arrays are kept on a single line.
+ * Throws a PropertyException if the output fails.
+ */
+class Writer
+{
+public:
+
+  explicit Writer(const int indent = 0);
+
+  Writer(std::ostream& os, const int indent = 0,
+         const std::size_t buffer_size = default_stream_buffer_size);
+
+  /**
+   * @brief ~Writer. Flushes, ignoring errors,
+   * call flush() to have them reported.
+   */
+  ~Writer();
+
+  Writer(const Writer&)            = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  inline void begin_object() { open('{', true); }
+  inline void end_object()   { close('}'); }
+
+  inline void begin_array() { open('[', false); }
+  inline void end_array()   { close(']'); }
+
+  void key(const char* data, const std::size_t size);
+
+  inline void key(const std::string& k) { key(k.data(), k.size()); }
+
+  /**
+   * @brief key. A number as the key of a member.
+   */
+  template <typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type
+  key(const T t)
+  {
+    char buffer[32];
+    key(buffer, format_number(buffer, widen(t)));
+  }
+
+  void write_null();
+
+  void write_bool(const bool b);
+
+  template <typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type
+  write_number(const T t)
+  {
+    write_number(widen(t), std::is_floating_point<T>());
+  }
+
+  void write_string(const char* data, const std::size_t size);
+
+  inline void write_string(const std::string& s) { write_string(s.data(), s.size()); }
+
+  void flush();
+
+  /**
+   * @brief release. Move the written JSON out,
+   * when not writing to a stream.
+   */
+  inline std::string release() { return std::move(buffer_); }
+
+protected:
+
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value &&
+                                 !std::is_same<T, float>::value, double>::type
+  widen(const T t) { return static_cast<double>(t); }
+
+  static float widen(const float t) { return t; }
+
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value,
+                                 std::int64_t>::type
+  widen(const T t) { return t; }
+
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value,
+                                 std::uint64_t>::type
+  widen(const T t) { return t; }
+
+  template <typename T>
+  void write_number(const T t, std::false_type /*floating_point*/)
+  {
+    separate();
+
+    char buffer[32];
+    append(buffer, format_number(buffer, t));
+  }
+
+  template <typename T>
+  void write_number(const T t, std::true_type /*floating_point*/)
+  {
+    if (std::isnan(t))      { write_string("NaN", 3);                        return; }
+    if (std::isinf(t))      { t > 0? write_string("Infinity", 8) :
+                                     write_string("-Infinity", 9);           return; }
+
+    write_number(t, std::false_type());
+  }
+
+  /**
+   * @brief separate. Comma and indentation before a value.
+   */
+  void separate();
+
+  void open(const char c, const bool object);
+  void close(const char c);
+
+  void newline();
+
+  void write_escaped(const char* data, const std::size_t size);
+
+  inline void put(const char c) { buffer_.push_back(c); }
+
+  inline void append(const char* data, const std::size_t size)
+  {
+    buffer_.append(data, size);
+  }
+
+  std::string buffer_;
+
+  std::ostream* os_ = nullptr;
+  std::size_t buffer_size_ = 0;
+
+  int indent_;
+
+  // Whether each open scope is an object
+  std::vector<bool> scopes_;
+
+  bool first_     = true;
+  bool after_key_ = false;
+};
+
+/**
+ * @brief The Reader class. A single pass parser over
+ * a buffer it does not own, values are decoded straight
+ * from the text without an intermediate tree.
+ * Throws a PropertyException on malformed inputs.
+ */
+class Reader
+{
+public:
+
+  Reader(const char* data, const std::size_t size) :
+    begin_(data), data_(data), end_(data + size) { }
+
+  /**
+   * @brief peek. The next char that is not a white space,
+   * '\0' at the end of the input.
+   */
+  inline char peek()
+  {
+    skip_whitespaces();
+    return (data_ != end_)? *data_ : '\0';
+  }
+
+  void expect(const char c);
+
+  /**
+   * @brief more. Whether an object or array has another
+   * member / element, consuming the comma before it or
+   * the closing char 'close' after the last one.
+   * @param first. Set by the caller for the first call.
+   */
+  bool more(const char close, bool& first);
+
+  void read_null();
+
+  bool read_bool();
+
+  template <typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type
+  read_number(T& t)
+  {
+    read_number(t, std::is_floating_point<T>());
+  }
+
+  void read_string(std::string& s);
+
+  /**
+   * @brief read_key. The key of a member, and its ':'.
+   */
+  inline void read_key(std::string& k)
+  {
+    read_string(k);
+    expect(':');
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value>::type
+  read_key(T& t)
+  {
+    std::string k;
+    read_key(k);
+
+    Reader number(k.data(), k.size());
+    number.read_number(t);
+    number.end();
+  }
+
+  /**
+   * @brief skip_value. Skip a value without decoding it.
+   * @return a reader over the value.
+   */
+  Reader skip_value();
+
+  /**
+   * @brief end. Throws if anything but
+   * white spaces is left to read.
+   */
+  void end();
+
+  [[noreturn]] void error(const std::string& what) const;
+
+protected:
+
+  inline void skip_whitespaces() noexcept
+  {
+    while (data_ != end_ && (*data_ == ' ' || *data_ == '\n' ||
+                             *data_ == '\r' || *data_ == '\t'))
+      ++data_;
+  }
+
+  /**
+   * @brief scan_number. Checks the syntax of a number.
+   * @return its end.
+   */
+  const char* scan_number(bool& integral) const;
+
+  void read_integer(std::int64_t& t);
+  void read_integer(std::uint64_t& t);
+
+  void read_floating(double& t);
+  void read_floating(float& t);
+
+  template <typename T>
+  void read_number(T& t, std::false_type /*floating_point*/)
+  {
+    using Wide = typename std::conditional<std::is_signed<T>::value,
+                                           std::int64_t, std::uint64_t>::type;
+    Wide wide;
+    read_integer(wide);
+
+    if (wide < Wide(std::numeric_limits<T>::lowest()) ||
+        wide > Wide(std::numeric_limits<T>::max()))
+      error("number out of range");
+
+    t = static_cast<T>(wide);
+  }
+
+  template <typename T>
+  void read_number(T& t, std::true_type /*floating_point*/)
+  {
+    typename std::conditional<std::is_same<T, float>::value, float, double>::type wide;
+    read_floating(wide);
+    t = static_cast<T>(wide);
+  }
+
+  const char* begin_;
+  const char* data_;
+  const char* end_;
+};
+
+/**
+ * @brief The Codec struct. How a T is written,
+ * specialized for each supported type with
+ *
+ *   static void encode(Writer&, const T&);
+ *   static void decode(Reader&, T&);
+ */
+template <typename T, typename Enable = void>
+struct Codec;
+
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_arithmetic<T>::value &&
+                                        !std::is_same<T, bool>::value>::type>
+{
+  static void encode(Writer& w, const T t) { w.write_number(t); }
+
+  static void decode(Reader& r, T& t) { r.read_number(t); }
+};
+
+template <>
+struct Codec<bool>
+{
+  static void encode(Writer& w, const bool b) { w.write_bool(b); }
+
+  static void decode(Reader& r, bool& b) { b = r.read_bool(); }
+};
+
+template <>
+struct Codec<std::string>
+{
+  static void encode(Writer& w, const std::string& s) { w.write_string(s); }
+
+  static void decode(Reader& r, std::string& s) { r.read_string(s); }
+};
+
+template <typename T, typename Alloc>
+struct Codec<std::vector<T, Alloc>>
+{
+  static void encode(Writer& w, const std::vector<T, Alloc>& v)
+  {
+    w.begin_array();
+    for (const T& e : v) Codec<T>::encode(w, e);
+    w.end_array();
+  }
+
+  static void decode(Reader& r, std::vector<T, Alloc>& v)
+  {
+    v.clear();
+
+    r.expect('[');
+
+    bool first = true;
+    while (r.more(']', first))
+    {
+      v.emplace_back();
+      Codec<T>::decode(r, v.back());
+    }
+  }
+};
+
+template <typename Alloc>
+struct Codec<std::vector<bool, Alloc>>
+{
+  static void encode(Writer& w, const std::vector<bool, Alloc>& v)
+  {
+    w.begin_array();
+    for (const bool e : v) w.write_bool(e);
+    w.end_array();
+  }
+
+  static void decode(Reader& r, std::vector<bool, Alloc>& v)
+  {
+    v.clear();
+
+    r.expect('[');
+
+    bool first = true;
+    while (r.more(']', first))
+      v.push_back(r.read_bool());
+  }
+};
+
+/**
+ * @brief The TypeCodec struct.
+ * Type-erased codec of a registered type.
+ */
+struct TypeCodec
+{
+  std::string name;
+
+  const std::type_info* type;
+
+  void (*encode)(Writer&, const Property&);
+
+  void (*decode)(Reader&, Property&);
+};
+
+/**
+ * @brief The Registry class.
+ * Process-wide table of the types that
+ * can be written in JSON. Thread-safe.
+ *
+ * Types exported with EXPORT_PROPERTY_JSON_TYPE are only
+ * queued during static initialization, their codecs are
+ * made on the first use of the registry.
+ */
+class Registry : public details::LazyRegistry<TypeCodec, &TypeCodec::name>
+{
+public:
+
+  static Registry& instance();
+
+  using LazyRegistry::add;
+
+  template <typename T>
+  bool add(const std::string& name);
+
+  /**
+   * @brief codec. The codec of T under a given name.
+   */
+  template <typename T>
+  static TypeCodec codec(const std::string& name);
+
+protected:
+
+  Registry() = default;
+};
+
+/**
+ * @brief The Registrar struct.
+ * Queues the registration of T at construction,
+ * see EXPORT_PROPERTY_JSON_TYPE.
+ */
+template <typename T>
+struct Registrar
+{
+  explicit Registrar(const char* name) noexcept :
+    pending_{name, &Registry::codec<T>, nullptr}
+  {
+    Registry::defer(pending_);
+  }
+
+  mutable Registry::Pending pending_;
+};
+
+/**
+ * @brief read_all. The content of a stream.
+ */
+std::string read_all(std::istream& is);
+
+} /* namespace json */
+
+struct Property::json_accessor
+{
+  template <typename T>
+  static void encode_value(json::Writer& w, const Property& p)
+  {
+    const T* value = p.get_if<T>();
+
+    if (value == nullptr)
+      throw PropertyException(std::string("Could not decode deferred ") +
+                              property_bag::name_of<T>());
+
+    json::Codec<T>::encode(w, *value);
+  }
+
+  template <typename T>
+  static void decode_value(json::Reader& r, Property& p)
+  {
+    T value;
+    json::Codec<T>::decode(r, value);
+    p.set_holder(std::move(value));
+  }
+
+  static void encode(json::Writer& w, const Property& p, const json::TypeCodec& codec)
+  {
+    w.begin_object();
+
+    w.key("type", 4);
+    w.write_string(codec.name);
+
+    if (!p.description_.empty())
+    {
+      w.key("description", 11);
+      w.write_string(p.description_);
+    }
+
+    if (p.is_modified())
+    {
+      w.key("modified", 8);
+      w.write_bool(true);
+    }
+
+    w.key("value", 5);
+    codec.encode(w, p);
+
+    w.end_object();
+  }
+
+  /**
+   * @brief decode. Members are read in any order,
+   * a value preceding its type is decoded once the
+   * type is known. Unknown members are skipped.
+   * @param key. Scratch string.
+   */
+  static void decode(json::Reader& r, Property& p, std::string& key)
+  {
+    const json::TypeCodec* codec = nullptr;
+
+    bool modified  = false;
+    bool has_value = false;
+    bool deferred  = false;
+    json::Reader value(nullptr, 0);
+
+    r.expect('{');
+
+    bool first = true;
+    while (r.more('}', first))
+    {
+      r.read_key(key);
+
+      if (key == "value")
+      {
+        if (codec != nullptr) codec->decode(r, p);
+        else value = r.skip_value();
+
+        deferred  = (codec == nullptr);
+        has_value = true;
+      }
+      else if (key == "type")
+      {
+        r.read_string(key);
+        codec = find(key);
+
+        if (codec == nullptr)
+          r.error("type '" + key + "' is not exported to JSON");
+      }
+      else if (key == "description")
+        r.read_string(p.description_);
+      else if (key == "modified")
+        modified = r.read_bool();
+      else
+        r.skip_value();
+    }
+
+    if (codec == nullptr) r.error("property without type");
+    if (!has_value)       r.error("property without value");
+
+    if (deferred)
+    {
+      codec->decode(value, p);
+      value.end();
+    }
+
+    p.flags_.reset();
+    p.flags_[modified? PROVIDED_VALUE : DEFAULT_VALUE] = true;
+  }
+
+  /**
+   * @brief find. The codec of a type name, the last
+   * one found being kept as types often repeat.
+   */
+  static const json::TypeCodec* find(const std::string& name)
+  {
+    static thread_local const json::TypeCodec* last = nullptr;
+
+    if (last == nullptr || last->name != name)
+    {
+      const json::TypeCodec* codec = json::Registry::instance().find(name);
+      if (codec != nullptr) last = codec;
+      return codec;
+    }
+
+    return last;
+  }
+};
+
+template <typename KeyType>
+struct AbstractPropertyBag<KeyType>::json_accessor
+{
+  static void encode(json::Writer& w, const AbstractPropertyBag& bag)
+  {
+    const json::Registry& registry = json::Registry::instance();
+
+    // Types often repeat
+    const json::TypeCodec* codec = nullptr;
+
+    w.begin_object();
+
+    w.key("name", 4);
+    json::Codec<KeyType>::encode(w, bag.name_);
+
+    w.key("handling", 8);
+    (bag.default_handling_ == RetrievalHandling::THROW)? w.write_string("THROW", 5) :
+                                                         w.write_string("QUIET", 5);
+
+    w.key("properties", 10);
+    w.begin_object();
+
+    for (const auto& property : bag.properties_)
+    {
+      if (codec == nullptr || *codec->type != property.second.type())
+        codec = registry.find(property.second.type());
+
+      if (codec == nullptr)
+      {
+        std::stringstream ss;
+        ss << "Property '" << property.first << "' of type "
+           << property.second.type_name()
+           << " is not exported to JSON.";
+        throw PropertyException(ss.str());
+      }
+
+      w.key(property.first);
+      Property::json_accessor::encode(w, property.second, *codec);
+    }
+
+    w.end_object();
+    w.end_object();
+  }
+
+  /**
+   * @brief decode. 'bag' is left untouched on error.
+   */
+  static void decode(json::Reader& r, AbstractPropertyBag& bag)
+  {
+    AbstractPropertyBag loaded;
+
+    read(r, loaded);
+
+    commit(loaded, bag);
+  }
+
+  /**
+   * @brief read. Decode into a freshly constructed bag.
+   */
+  static void read(json::Reader& r, AbstractPropertyBag& loaded)
+  {
+    std::string key;
+
+    r.expect('{');
+
+    bool first = true;
+    while (r.more('}', first))
+    {
+      r.read_key(key);
+
+      if (key == "properties")
+        decode_properties(r, loaded, key);
+      else if (key == "name")
+        json::Codec<KeyType>::decode(r, loaded.name_);
+      else if (key == "handling")
+      {
+        r.read_string(key);
+
+        if      (key == "QUIET") loaded.default_handling_ = RetrievalHandling::QUIET;
+        else if (key == "THROW") loaded.default_handling_ = RetrievalHandling::THROW;
+        else r.error("unknown retrieval handling '" + key + "'");
+      }
+      else
+        r.skip_value();
+    }
+  }
+
+  /**
+   * @brief commit. Replace the content of 'bag'
+   * with a fully decoded bag, leaving real-time mode.
+   */
+  static void commit(AbstractPropertyBag& loaded, AbstractPropertyBag& bag) noexcept
+  {
+    bag.properties_.swap(loaded.properties_);
+    bag.name_             = std::move(loaded.name_);
+    bag.default_handling_ = loaded.default_handling_;
+    bag.realtime_         = false;
+  }
+
+  static void decode_properties(json::Reader& r, AbstractPropertyBag& bag, std::string& scratch)
+  {
+    r.expect('{');
+
+    bool first = true;
+    while (r.more('}', first))
+    {
+      KeyType name;
+      r.read_key(name);
+
+      Property property;
+      Property::json_accessor::decode(r, property, scratch);
+
+      // Usually written in order
+      auto it = bag.properties_.end();
+      if (!bag.properties_.empty() &&
+          !bag.properties_.key_comp()(std::prev(it)->first, name))
+        it = bag.properties_.lower_bound(name);
+
+      if (it != bag.properties_.end() && !bag.properties_.key_comp()(name, it->first))
+        it->second = std::move(property);
+      else
+        bag.properties_.emplace_hint(it, std::move(name), std::move(property));
+    }
+  }
+};
+
+namespace json {
+
+template <typename T>
+TypeCodec Registry::codec(const std::string& name)
+{
+  return TypeCodec{name, &typeid(T),
+                   &Property::json_accessor::encode_value<T>,
+                   &Property::json_accessor::decode_value<T>};
+}
+
+template <typename T>
+bool Registry::add(const std::string& name)
+{
+  return add(codec<T>(name));
+}
+
+template <typename KeyType>
+struct Codec<AbstractPropertyBag<KeyType>>
+{
+  static void encode(Writer& w, const AbstractPropertyBag<KeyType>& bag)
+  {
+    AbstractPropertyBag<KeyType>::json_accessor::encode(w, bag);
+  }
+
+  static void decode(Reader& r, AbstractPropertyBag<KeyType>& bag)
+  {
+    AbstractPropertyBag<KeyType>::json_accessor::decode(r, bag);
+  }
+};
+
+} /* namespace json */
+
+/**
+ * @brief to_json. Write a bag in JSON, objects being
+ * indented by 'indent' spaces per level, 0 for none.
+ * Every held type must have been exported
+ * with EXPORT_PROPERTY_JSON_TYPE.
+ */
+template <typename KeyType>
+std::string to_json(const AbstractPropertyBag<KeyType>& bag, const int indent = 0)
+{
+  json::Writer writer(indent);
+  json::Codec<AbstractPropertyBag<KeyType>>::encode(writer, bag);
+  return writer.release();
+}
+
+/**
+ * @brief to_json. Stream a bag in JSON to 'os'
+ * through a fixed-size buffer.
+ */
+template <typename KeyType>
+void to_json(const AbstractPropertyBag<KeyType>& bag, std::ostream& os, const int indent = 0)
+{
+  json::Writer writer(os, indent);
+  json::Codec<AbstractPropertyBag<KeyType>>::encode(writer, bag);
+  writer.flush();
+}
+
+/**
+ * @brief from_json. Read a bag from JSON.
+ * Throws a PropertyException if the input is malformed,
+ * leaving 'bag' untouched.
+ */
+template <typename KeyType>
+void from_json(const char* data, const std::size_t size, AbstractPropertyBag<KeyType>& bag)
+{
+  json::Reader reader(data, size);
+
+  AbstractPropertyBag<KeyType> loaded;
+  AbstractPropertyBag<KeyType>::json_accessor::read(reader, loaded);
+
+  // Trailing input is an error too
+  reader.end();
+
+  AbstractPropertyBag<KeyType>::json_accessor::commit(loaded, bag);
+}
+
+template <typename KeyType>
+void from_json(const std::string& json, AbstractPropertyBag<KeyType>& bag)
+{
+  from_json(json.data(), json.size(), bag);
+}
+
+template <typename KeyType>
+void from_json(std::istream& is, AbstractPropertyBag<KeyType>& bag)
+{
+  const std::string json = json::read_all(is);
+  from_json(json.data(), json.size(), bag);
+}
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_JSON_FORMAT_H */
@@ -0,0 +1,145 @@
+/**
+ * \file lazy_registry.h
+ * \brief Process-wide tables of exported types,
+ * filled on first use.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_LAZY_REGISTRY_H
+#define PROPERTY_BAG_SERIALIZATION_LAZY_REGISTRY_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+namespace property_bag
+{
+namespace details
+{
+
+/**
+ * @brief The PendingList class. Lock-free list of the
+ * registrations queued during static initialization,
+ * run by a registry on its first use. Constant-initialized,
+ * it can be pushed to before any dynamic initialization.
+ * @tparam Node. Has a 'Node* next' member.
+ */
+template <typename Node>
+class PendingList
+{
+public:
+
+  constexpr PendingList() noexcept : head_(nullptr) { }
+
+  void push(Node& node) noexcept
+  {
+    node.next = head_.load(std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak(node.next, &node,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+  }
+
+  inline bool empty() const noexcept
+  {
+    return head_.load(std::memory_order_acquire) == nullptr;
+  }
+
+  /**
+   * @brief take. Empty the list.
+   * @return the nodes, in the order they were pushed.
+   */
+  Node* take() noexcept
+  {
+    Node* node = head_.exchange(nullptr, std::memory_order_acquire);
+
+    Node* ordered = nullptr;
+    while (node != nullptr)
+    {
+      Node* next = node->next;
+      node->next = ordered;
+      ordered    = node;
+      node       = next;
+    }
+
+    return ordered;
+  }
+
+private:
+
+  std::atomic<Node*> head_;
+};
+
+/**
+ * @brief The LazyRegistry class.
+ * Table of the entries of exported types, found by
+ * type or by name. Thread-safe.
+ *
+ * Registrations are only queued during static
+ * initialization and made on the first use.
+ *
+ * Member definitions are in lazy_registry.hpp, each
+ * registry explicitly instantiates it in a single
+ * translation unit.
+ *
+ * @tparam Entry. Has a 'const std::type_info* type' member.
+ * @tparam Name. The member of Entry naming its type.
+ */
+template <typename Entry, std::string Entry::* Name>
+class LazyRegistry
+{
+public:
+
+  /**
+   * @brief The Pending struct. A queued registration.
+   */
+  struct Pending
+  {
+    const char* name;
+    Entry (*make)(const std::string& name);
+    Pending* next;
+  };
+
+  /**
+   * @brief defer. Queue a registration.
+   * Lock-free, neither allocates nor throws.
+   */
+  static void defer(Pending& pending) noexcept;
+
+  /**
+   * @brief add. Register a type under its name.
+   * @return false if either the type or the
+   * name is already registered.
+   */
+  bool add(const Entry& entry);
+
+  /**
+   * @brief find. The entry of a type.
+   * @return nullptr if the type is not registered.
+   */
+  const Entry* find(const std::type_info& type) const;
+
+  const Entry* find(const std::string& name) const;
+
+protected:
+
+  LazyRegistry() = default;
+
+  // mutex_ held
+  bool insert(const Entry& entry) const;
+  void insert_pending() const;
+
+  mutable std::mutex mutex_;
+
+  // Filled on first use
+  mutable std::unordered_map<std::type_index, Entry>  by_type_;
+  mutable std::unordered_map<std::string, const Entry*> by_name_;
+
+  // Constant-initialized, pushed to during static initialization
+  static PendingList<Pending> pending_;
+};
+
+} // namespace details
+} // namespace property_bag
+
+#endif /* PROPERTY_BAG_SERIALIZATION_LAZY_REGISTRY_H */
@@ -0,0 +1,86 @@
+/**
+ * \file lazy_registry.hpp
+ * \brief Process-wide tables of exported types,
+ * filled on first use.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_LAZY_REGISTRY_HPP
+#define PROPERTY_BAG_SERIALIZATION_LAZY_REGISTRY_HPP
+
+#include <property_bag/serialization/lazy_registry.h>
+
+namespace property_bag
+{
+namespace details
+{
+
+template <typename Entry, std::string Entry::* Name>
+PendingList<typename LazyRegistry<Entry, Name>::Pending> LazyRegistry<Entry, Name>::pending_;
+
+template <typename Entry, std::string Entry::* Name>
+void LazyRegistry<Entry, Name>::defer(Pending& pending) noexcept
+{
+  pending_.push(pending);
+}
+
+template <typename Entry, std::string Entry::* Name>
+bool LazyRegistry<Entry, Name>::add(const Entry& entry)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  insert_pending();
+
+  return insert(entry);
+}
+
+template <typename Entry, std::string Entry::* Name>
+bool LazyRegistry<Entry, Name>::insert(const Entry& entry) const
+{
+  if (by_name_.count(entry.*Name) != 0) return false;
+
+  const auto inserted = by_type_.emplace(std::type_index(*entry.type), entry);
+
+  if (!inserted.second) return false;
+
+  by_name_.emplace(entry.*Name, &inserted.first->second);
+
+  return true;
+}
+
+template <typename Entry, std::string Entry::* Name>
+void LazyRegistry<Entry, Name>::insert_pending() const
+{
+  if (pending_.empty()) return;
+
+  for (Pending* pending = pending_.take(); pending != nullptr; pending = pending->next)
+    insert(pending->make(pending->name));
+}
+
+template <typename Entry, std::string Entry::* Name>
+const Entry* LazyRegistry<Entry, Name>::find(const std::type_info& type) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  insert_pending();
+
+  const auto it = by_type_.find(std::type_index(type));
+
+  return (it == by_type_.end())? nullptr : &it->second;
+}
+
+template <typename Entry, std::string Entry::* Name>
+const Entry* LazyRegistry<Entry, Name>::find(const std::string& name) const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  insert_pending();
+
+  const auto it = by_name_.find(name);
+
+  return (it == by_name_.end())? nullptr : it->second;
+}
+
+} // namespace details
+} // namespace property_bag
+
+#endif /* PROPERTY_BAG_SERIALIZATION_LAZY_REGISTRY_HPP */
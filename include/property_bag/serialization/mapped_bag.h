@@ -0,0 +1,211 @@
+/**
+ * \file mapped_bag.h
+ * \brief Read-only property bag backed by a memory-mapped file.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_MAPPED_BAG_H
+#define PROPERTY_BAG_SERIALIZATION_MAPPED_BAG_H
+
+#include <property_bag/serialization/wire_format.h>
+
+#include <list>
+#include <map>
+
+/*
+ * File layout, every number is little endian :
+ *
+ *  file   := header block* index
+ *  header := 'P' 'B' 'M' version:u8 index_offset:u64 index_size:u64
+ *            (padded to 64 bytes)
+ *  index  := name:string handling:varint num_entries:varint entry[num_entries]
+ *  entry  := name:string type_name:string flags:u8 description:string
+ *            scalar:u8 rows:varint cols:varint offset:varint size:varint
+ *
+ * Each value is a block aligned on 64 bytes. Values of
+ * types with a wire::RawLayout (arithmetic, std::vector
+ * of arithmetic, Eigen matrices) are written as is,
+ * 'scalar' identifying their scalar type, and can be read
+ * in place. Others are written in the wire format,
+ * 'scalar' is then zero.
+ */
+
+namespace property_bag {
+
+/**
+ * @brief The MappedPropertyBag class.
+ * A read-only bag whose values live in a memory-mapped
+ * file written by write_mapped(). Opening it only reads
+ * the index, the values are paged in on access and
+ * shared by all the processes mapping the same file.
+ *
+ * @note The mapping is little endian only.
+ */
+class MappedPropertyBag
+{
+public:
+
+  static constexpr std::size_t alignment = 64;
+
+  struct Entry
+  {
+    std::string   type_name;
+    std::string   description;
+    std::uint8_t  flags;
+    std::uint8_t  scalar;
+    std::uint64_t rows;
+    std::uint64_t cols;
+    std::uint64_t offset;
+    std::uint64_t size;
+
+    /**
+     * @brief is_raw. Whether the value can be read in place.
+     */
+    inline bool is_raw() const noexcept { return scalar != 0; }
+  };
+
+  /**
+   * @brief MappedPropertyBag. Map a file.
+   * Throws a PropertyException if the file can not
+   * be mapped or is malformed.
+   */
+  explicit MappedPropertyBag(const std::string& path);
+
+  ~MappedPropertyBag();
+
+  MappedPropertyBag(MappedPropertyBag&& rhs) noexcept;
+  MappedPropertyBag& operator=(MappedPropertyBag&& rhs) noexcept;
+
+  MappedPropertyBag(const MappedPropertyBag&)            = delete;
+  MappedPropertyBag& operator=(const MappedPropertyBag&) = delete;
+
+  /**
+   * @brief getBlock. In place access to a block of Scalar.
+   * @return a pointer in the mapping, nullptr if there is no
+   * such property or it is not a block of Scalar.
+   */
+  template <typename Scalar>
+  const Scalar* getBlock(const std::string& name,
+                         std::size_t& rows, std::size_t& cols) const noexcept
+  {
+    const Entry* entry = find(name);
+
+    if (entry == nullptr || entry->scalar != wire::scalar_id<Scalar>())
+      return nullptr;
+
+    rows = entry->rows;
+    cols = entry->cols;
+
+    return reinterpret_cast<const Scalar*>(data_ + entry->offset);
+  }
+
+  /**
+   * @brief get_if. In place access to an arithmetic value.
+   * @return a pointer in the mapping, nullptr if there is no
+   * such property or it does not hold a single T.
+   */
+  template <typename T>
+  const T* get_if(const std::string& name) const noexcept
+  {
+    static_assert(std::is_arithmetic<T>::value, "T must be arithmetic.");
+
+    std::size_t rows = 0, cols = 0;
+    const T* value = getBlock<T>(name, rows, cols);
+
+    return (rows == 1 && cols == 1)? value : nullptr;
+  }
+
+  /**
+   * @brief getProperty. Decode a property.
+   * Throws a PropertyException if there is no such
+   * property or its type is not exported.
+   */
+  Property getProperty(const std::string& name) const;
+
+  /**
+   * @brief getPropertyValue. Copy a value out of the mapping.
+   * @return false if there is no such property or
+   * it holds another type.
+   */
+  template <typename T>
+  bool getPropertyValue(const std::string& name, T& value) const
+  {
+    const Entry* entry = find(name);
+
+    if (entry == nullptr) return false;
+
+    const wire::TypeCodec* codec = wire::Registry::instance().find(entry->type_name);
+
+    if (codec == nullptr || *codec->type != typeid(T)) return false;
+
+    decode(*entry, value, wire::RawLayout<T>());
+
+    return true;
+  }
+
+  /**
+   * @brief toPropertyBag. Decode the whole bag.
+   */
+  PropertyBag toPropertyBag() const;
+
+  const Entry* find(const std::string& name) const noexcept;
+
+  bool exists(const std::string& name) const noexcept;
+
+  std::list<std::string> listProperties() const;
+
+  inline std::size_t size()  const noexcept { return entries_.size();  }
+  inline bool        empty() const noexcept { return entries_.empty(); }
+
+  inline const std::string& name() const noexcept { return name_; }
+
+  inline RetrievalHandling getRetrievalHandling() const noexcept
+  { return default_handling_; }
+
+protected:
+
+  template <typename T>
+  void decode(const Entry& entry, T& value, std::true_type /*has_raw_layout*/) const
+  {
+    if (!entry.is_raw())
+    {
+      decode(entry, value, std::false_type());
+      return;
+    }
+
+    wire::RawLayout<T>::load(view(entry), value);
+  }
+
+  template <typename T>
+  void decode(const Entry& entry, T& value, std::false_type /*has_raw_layout*/) const
+  {
+    wire::Reader reader(data_ + entry.offset, entry.size);
+    wire::Codec<T>::decode(reader, value);
+  }
+
+  wire::RawView view(const Entry& entry) const noexcept;
+
+  void unmap() noexcept;
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+
+  std::string name_;
+  RetrievalHandling default_handling_ = RetrievalHandling::QUIET;
+
+  std::map<std::string, Entry> entries_;
+};
+
+/**
+ * @brief write_mapped. Write a bag in a file
+ * that can be opened by MappedPropertyBag.
+ * Every held type must have been exported with
+ * EXPORT_PROPERTY_WIRE_TYPE. Nested bags are
+ * written in the wire format.
+ * The file is written aside then renamed over 'path',
+ * bags already mapped from 'path' are left valid.
+ */
+void write_mapped(const PropertyBag& bag, const std::string& path);
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_MAPPED_BAG_H */
@@ -0,0 +1,335 @@
+/**
+ * \file portable_binary_archive.h
+ * \brief Boost binary archives with a fixed byte order.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_PORTABLE_BINARY_ARCHIVE_H
+#define PROPERTY_BAG_SERIALIZATION_PORTABLE_BINARY_ARCHIVE_H
+
+#include <boost/archive/binary_oarchive_impl.hpp>
+#include <boost/archive/binary_iarchive_impl.hpp>
+#include <boost/archive/archive_exception.hpp>
+#include <boost/archive/detail/register_archive.hpp>
+#include <boost/serialization/array_optimization.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/mpl/bool.hpp>
+#include <property_bag/serialization/endian.h>
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+/*
+ * Inspired by boost/libs/serialization/example/portable_binary_*archive.
+ *
+ * Integers are written as a signed byte count followed
+ * by their significant bytes, little endian first.
+ * float and double are written as IEEE 754 in little endian.
+ * Contiguous arrays of fixed-size arithmetic types, Eigen
+ * data included, are written as one little endian block,
+ * as is on little endian hosts, swapped in bulk on others.
+ * 'long' is excluded from the block path as its
+ * size differs across platforms.
+ */
+
+namespace property_bag {
+namespace details {
+
+/**
+ * @brief is_portable_block. Whether arrays of T are
+ * written as a single fixed-width little endian block.
+ */
+template <typename T>
+using is_portable_block = std::integral_constant<bool,
+  std::is_arithmetic<T>::value &&
+  !std::is_same<T, long>::value &&
+  !std::is_same<T, unsigned long>::value &&
+  !std::is_same<T, long double>::value &&
+  !std::is_same<T, wchar_t>::value>;
+
+} /* namespace details */
+
+/**
+ * @brief The portable_binary_oarchive class.
+ * A binary archive readable on any architecture.
+ */
+class portable_binary_oarchive :
+    public boost::archive::binary_oarchive_impl<
+      portable_binary_oarchive, std::ostream::char_type, std::ostream::traits_type>
+{
+  using base = boost::archive::binary_oarchive_impl<
+      portable_binary_oarchive, std::ostream::char_type, std::ostream::traits_type>;
+
+  using primitive_base = boost::archive::basic_binary_oprimitive<
+      portable_binary_oarchive, std::ostream::char_type, std::ostream::traits_type>;
+
+  friend class boost::archive::detail::interface_oarchive<portable_binary_oarchive>;
+  friend class boost::archive::basic_binary_oarchive<portable_binary_oarchive>;
+  friend primitive_base;
+  friend class boost::archive::save_access;
+
+public:
+
+  portable_binary_oarchive(std::ostream& os, unsigned int flags = 0) :
+    base(os, flags)
+  {
+    init(flags);
+  }
+
+  portable_binary_oarchive(std::streambuf& sb, unsigned int flags = 0) :
+    base(sb, flags)
+  {
+    init(flags);
+  }
+
+  struct use_array_optimization
+  {
+    template <class T>
+    struct apply : boost::mpl::bool_<details::is_portable_block<T>::value> {};
+  };
+
+  template <class ValueType>
+  void save_array(boost::serialization::array_wrapper<ValueType> const& a,
+                  unsigned int /*version*/)
+  {
+    details::write_little_endian(a.address(), a.count(),
+      [this](const void* bytes, const std::size_t size) { this->save_binary(bytes, size); });
+  }
+
+protected:
+
+  using primitive_base::save;
+
+  void init(unsigned int flags)
+  {
+    // The native header records sizes and byte order,
+    // only keep the signature and library version.
+    if (0 != (flags & boost::archive::no_header)) return;
+
+    const std::string signature(boost::archive::BOOST_ARCHIVE_SIGNATURE());
+    *this << signature;
+
+    save_integer(boost::archive::BOOST_ARCHIVE_VERSION());
+  }
+
+  // Integers and archive internal types (class_id_type,
+  // collection_size_type...) which convert to integers.
+  template <class T>
+  void save(const T& t)
+  {
+    static_assert(!std::is_floating_point<T>::value,
+                  "long double is not portable.");
+
+    save_integer(static_cast<boost::intmax_t>(t));
+  }
+
+  void save(const bool t)          { save_byte(t); }
+  void save(const char t)          { save_byte(t); }
+  void save(const signed char t)   { save_byte(t); }
+  void save(const unsigned char t) { save_byte(t); }
+
+  void save(const float t)  { save_fixed<boost::uint32_t>(t); }
+  void save(const double t) { save_fixed<boost::uint64_t>(t); }
+
+  template <typename T>
+  void save_byte(const T t)
+  {
+    this->save_binary(&t, 1);
+  }
+
+  template <typename UInt, typename T>
+  void save_fixed(const T t)
+  {
+    static_assert(sizeof(UInt) == sizeof(T), "");
+
+    UInt u;
+    std::memcpy(&u, &t, sizeof(T));
+
+    unsigned char bytes[sizeof(T)];
+    for (std::size_t i=0; i<sizeof(T); ++i)
+      bytes[i] = static_cast<unsigned char>(u >> (8*i));
+
+    this->save_binary(bytes, sizeof(T));
+  }
+
+  void save_integer(const boost::intmax_t t)
+  {
+    const bool negative = t < 0;
+
+    boost::uintmax_t magnitude = negative ?
+          boost::uintmax_t(0) - boost::uintmax_t(t) : boost::uintmax_t(t);
+
+    unsigned char bytes[sizeof(boost::uintmax_t)];
+    signed char size = 0;
+
+    for (; magnitude != 0; magnitude >>= 8)
+      bytes[size++] = static_cast<unsigned char>(magnitude & 0xff);
+
+    if (negative) size = -size;
+
+    this->save_binary(&size, 1);
+    this->save_binary(bytes, negative ? -size : size);
+  }
+};
+
+/**
+ * @brief The portable_binary_iarchive class.
+ * Reads archives written by portable_binary_oarchive
+ * on any architecture.
+ */
+class portable_binary_iarchive :
+    public boost::archive::binary_iarchive_impl<
+      portable_binary_iarchive, std::istream::char_type, std::istream::traits_type>
+{
+  using base = boost::archive::binary_iarchive_impl<
+      portable_binary_iarchive, std::istream::char_type, std::istream::traits_type>;
+
+  using primitive_base = boost::archive::basic_binary_iprimitive<
+      portable_binary_iarchive, std::istream::char_type, std::istream::traits_type>;
+
+  friend class boost::archive::detail::interface_iarchive<portable_binary_iarchive>;
+  friend class boost::archive::basic_binary_iarchive<portable_binary_iarchive>;
+  friend primitive_base;
+  friend class boost::archive::load_access;
+
+public:
+
+  portable_binary_iarchive(std::istream& is, unsigned int flags = 0) :
+    base(is, flags)
+  {
+    init(flags);
+  }
+
+  portable_binary_iarchive(std::streambuf& sb, unsigned int flags = 0) :
+    base(sb, flags)
+  {
+    init(flags);
+  }
+
+  struct use_array_optimization
+  {
+    template <class T>
+    struct apply : boost::mpl::bool_<details::is_portable_block<T>::value> {};
+  };
+
+  template <class ValueType>
+  void load_array(boost::serialization::array_wrapper<ValueType>& a,
+                  unsigned int /*version*/)
+  {
+    this->load_binary(a.address(), a.count()*sizeof(ValueType));
+
+    details::from_little_endian(a.address(), a.count());
+  }
+
+protected:
+
+  using primitive_base::load;
+
+  void init(unsigned int flags)
+  {
+    if (0 != (flags & boost::archive::no_header)) return;
+
+    std::string signature;
+    *this >> signature;
+
+    if (signature != boost::archive::BOOST_ARCHIVE_SIGNATURE())
+      boost::serialization::throw_exception(
+          boost::archive::archive_exception(
+            boost::archive::archive_exception::invalid_signature));
+
+    boost::intmax_t version;
+    load_integer(version, sizeof(boost::serialization::library_version_type));
+
+    const boost::serialization::library_version_type
+        input_library_version(static_cast<unsigned int>(version));
+
+    if (boost::archive::BOOST_ARCHIVE_VERSION() < input_library_version)
+      boost::serialization::throw_exception(
+          boost::archive::archive_exception(
+            boost::archive::archive_exception::unsupported_version));
+
+    this->set_library_version(input_library_version);
+  }
+
+  template <class T>
+  void load(T& t)
+  {
+    static_assert(!std::is_floating_point<T>::value,
+                  "long double is not portable.");
+
+    boost::intmax_t l;
+    load_integer(l, sizeof(T));
+    t = T(l);
+  }
+
+  void load(boost::archive::class_id_type& t)
+  {
+    boost::intmax_t l;
+    load_integer(l, sizeof(t));
+    t = boost::archive::class_id_type(static_cast<int>(l));
+  }
+
+  void load(bool& t)          { load_byte(t); }
+  void load(char& t)          { load_byte(t); }
+  void load(signed char& t)   { load_byte(t); }
+  void load(unsigned char& t) { load_byte(t); }
+
+  void load(float& t)  { load_fixed<boost::uint32_t>(t); }
+  void load(double& t) { load_fixed<boost::uint64_t>(t); }
+
+  template <typename T>
+  void load_byte(T& t)
+  {
+    this->load_binary(&t, 1);
+  }
+
+  template <typename UInt, typename T>
+  void load_fixed(T& t)
+  {
+    unsigned char bytes[sizeof(T)];
+    this->load_binary(bytes, sizeof(T));
+
+    UInt u = 0;
+    for (std::size_t i=0; i<sizeof(T); ++i)
+      u |= UInt(bytes[i]) << (8*i);
+
+    std::memcpy(&t, &u, sizeof(T));
+  }
+
+  void load_integer(boost::intmax_t& t, const std::size_t max_size)
+  {
+    signed char size;
+    this->load_binary(&size, 1);
+
+    const bool negative = size < 0;
+    const std::size_t num_bytes = negative ? -size : size;
+
+    if (num_bytes > max_size)
+      boost::serialization::throw_exception(
+          boost::archive::archive_exception(
+            boost::archive::archive_exception::incompatible_native_format,
+            "integer too large for this platform"));
+
+    unsigned char bytes[sizeof(boost::uintmax_t)];
+    this->load_binary(bytes, num_bytes);
+
+    boost::uintmax_t magnitude = 0;
+    for (std::size_t i=0; i<num_bytes; ++i)
+      magnitude |= boost::uintmax_t(bytes[i]) << (8*i);
+
+    t = negative ? -boost::intmax_t(magnitude - 1) - 1 : boost::intmax_t(magnitude);
+  }
+};
+
+} /* namespace property_bag */
+
+// required by export
+BOOST_SERIALIZATION_REGISTER_ARCHIVE(property_bag::portable_binary_oarchive)
+BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION(property_bag::portable_binary_oarchive)
+
+BOOST_SERIALIZATION_REGISTER_ARCHIVE(property_bag::portable_binary_iarchive)
+BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION(property_bag::portable_binary_iarchive)
+
+#endif /* PROPERTY_BAG_SERIALIZATION_PORTABLE_BINARY_ARCHIVE_H */
@@ -9,6 +9,7 @@
 #define PROPERTY_BAG_BOOST_SERIALIZATION_PROPERTY_BAG_H
 
 #include <property_bag/serialization/property_boost_serialization.h>
+#include <property_bag/serialization/compression.h>
 #include <property_bag/property_bag.h>
 
 #include <boost/serialization/map.hpp>
@@ -27,6 +28,9 @@ struct AbstractPropertyBag<KeyType>::serialization_accessor
     ar & BOOST_SERIALIZATION_NVP(property_bag.name_);
     ar & BOOST_SERIALIZATION_NVP(property_bag.default_handling_);
     ar & BOOST_SERIALIZATION_NVP(property_bag.properties_);
+
+    // The loaded values are not unshared
+    if (Archive::is_loading::value) property_bag.realtime_ = false;
   }
 };
 
@@ -48,15 +52,168 @@ void serialize(
 } //namespace boost
 
 #include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
 
 namespace property_bag {
-template <typename KeyType>
+
+/**
+ * @brief to_stream. Serialize a bag to a stream,
+ * the archive is written as the bag is traversed.
+ * @tparam OArchive. The boost output archive, text by default.
+ */
+template <typename OArchive = boost::archive::text_oarchive, typename KeyType>
+void to_stream(const property_bag::AbstractPropertyBag<KeyType> &property_bag,
+               std::ostream &os)
+{
+  OArchive oa(os);
+  oa << boost::serialization::make_nvp("property_bag", property_bag);
+}
+
+/**
+ * @brief to_stream. Serialize a bag to a stream, compressed
+ * as it is written.
+ * @param level. 1 (fastest) to 9 (smallest).
+ * @tparam OArchive. The boost output archive, text by default.
+ */
+template <typename OArchive = boost::archive::text_oarchive, typename KeyType>
+void to_stream(const property_bag::AbstractPropertyBag<KeyType> &property_bag,
+               std::ostream &os, const Compression compression,
+               const int level = default_compression_level)
+{
+  CompressedOStream compressed(os, compression, level);
+  {
+    OArchive oa(compressed);
+    oa << boost::serialization::make_nvp("property_bag", property_bag);
+  }
+  compressed.close();
+}
+
+/**
+ * @brief from_stream. Deserialize a bag from a stream,
+ * decompressed if it is compressed.
+ * @tparam IArchive. The boost input archive, text by default.
+ */
+template <typename IArchive = boost::archive::text_iarchive, typename KeyType>
+void from_stream(std::istream &is,
+                 property_bag::AbstractPropertyBag<KeyType> &property_bag)
+{
+  if (details::may_be_compressed(is.peek()))
+  {
+    DecompressedIStream decompressed(is);
+    IArchive ia(decompressed);
+    ia >> boost::serialization::make_nvp("property_bag", property_bag);
+    return;
+  }
+
+  IArchive ia(is);
+  ia >> boost::serialization::make_nvp("property_bag", property_bag);
+}
+
+/**
+ * @brief to_str. Serialize a bag to a string.
+ * The archive is written in the returned string directly.
+ * @tparam OArchive. The boost output archive, text by default.
+ */
+template <typename OArchive = boost::archive::text_oarchive, typename KeyType>
 std::string to_str(const property_bag::AbstractPropertyBag<KeyType> &property_bag)
 {
-  std::stringstream ss;
-  boost::archive::text_oarchive oa(ss);
-  oa << property_bag;
-  return ss.str();
+  std::string str;
+  {
+    boost::iostreams::stream<boost::iostreams::back_insert_device<std::string>> os(str);
+    {
+      // Some archives write on destruction, e.g. the closing tag of xml
+      OArchive oa(os);
+      oa << boost::serialization::make_nvp("property_bag", property_bag);
+    }
+    os.flush();
+  }
+
+  return str;
+}
+
+/**
+ * @brief to_str. Serialize a bag to a compressed string.
+ * @param level. 1 (fastest) to 9 (smallest).
+ * @tparam OArchive. The boost output archive, text by default.
+ */
+template <typename OArchive = boost::archive::text_oarchive, typename KeyType>
+std::string to_str(const property_bag::AbstractPropertyBag<KeyType> &property_bag,
+                   const Compression compression,
+                   const int level = default_compression_level)
+{
+  std::string str;
+
+  boost::iostreams::stream<boost::iostreams::back_insert_device<std::string>> os(str);
+  to_stream<OArchive>(property_bag, os, compression, level);
+  os.flush();
+
+  return str;
+}
+
+/**
+ * @brief from_str. Deserialize a bag from a string, without copying it
+ * unless it is compressed.
+ * @tparam IArchive. The boost input archive, text by default.
+ */
+template <typename IArchive = boost::archive::text_iarchive, typename KeyType>
+void from_str(const std::string &str,
+              property_bag::AbstractPropertyBag<KeyType> &property_bag)
+{
+  if (detect_compression(str.data(), str.size()) != Compression::NONE)
+  {
+    const std::string decompressed = decompress(str);
+    boost::iostreams::stream<boost::iostreams::array_source> is(decompressed.data(),
+                                                                decompressed.size());
+    IArchive ia(is);
+    ia >> boost::serialization::make_nvp("property_bag", property_bag);
+    return;
+  }
+
+  boost::iostreams::stream<boost::iostreams::array_source> is(str.data(), str.size());
+  IArchive ia(is);
+  ia >> boost::serialization::make_nvp("property_bag", property_bag);
+}
+
+/**
+ * @brief to_bytes. Serialize a bag in a binary string.
+ * @tparam OArchive. The boost output archive, native binary by default.
+ * See also portable_binary_oarchive.
+ */
+template <typename OArchive = boost::archive::binary_oarchive, typename KeyType>
+std::string to_bytes(const property_bag::AbstractPropertyBag<KeyType> &property_bag)
+{
+  return to_str<OArchive>(property_bag);
+}
+
+/**
+ * @brief to_bytes. Serialize a bag in a compressed binary string.
+ * @tparam OArchive. The boost output archive, native binary by default.
+ */
+template <typename OArchive = boost::archive::binary_oarchive, typename KeyType>
+std::string to_bytes(const property_bag::AbstractPropertyBag<KeyType> &property_bag,
+                     const Compression compression,
+                     const int level = default_compression_level)
+{
+  return to_str<OArchive>(property_bag, compression, level);
+}
+
+/**
+ * @brief from_bytes. Deserialize a bag from a binary string,
+ * decompressed if it is compressed.
+ * @tparam IArchive. The boost input archive, native binary by default.
+ * See also portable_binary_iarchive.
+ */
+template <typename IArchive = boost::archive::binary_iarchive, typename KeyType>
+void from_bytes(const std::string &bytes,
+                property_bag::AbstractPropertyBag<KeyType> &property_bag)
+{
+  from_str<IArchive>(bytes, property_bag);
 }
 
 } /* namespace property_bag */
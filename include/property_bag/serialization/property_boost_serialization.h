@@ -18,22 +18,233 @@
 //#include <boost/archive/xml_oarchive.hpp>
 //#include <boost/archive/xml_iarchive.hpp>
 
-//#include <boost/archive/binary_oarchive.hpp>
-//#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+
+#include <property_bag/serialization/portable_binary_archive.h>
+#include <property_bag/serialization/bulk_layout.h>
 
 #include <boost/serialization/export.hpp>
+#include <boost/serialization/split_free.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/version.hpp>
+
+#include <boost/archive/archive_exception.hpp>
+#include <boost/archive/detail/archive_serializer_map.hpp>
+#include <boost/archive/detail/basic_pointer_iserializer.hpp>
+#include <boost/archive/detail/basic_pointer_oserializer.hpp>
 
 #include <property_bag/property.h>
+#include <property_bag/serialization/lazy_registry.h>
+
+#include <unordered_map>
+#include <vector>
 
+/**
+ * @brief Exports 'Type' to boost archives under 'Name'.
+ * Its archive id is registered on the first lookup, but
+ * the boost export is done at static initialization, as
+ * boost constructs its serialization singletons eagerly.
+ */
 #define EXPORT_PROPERTY_NAMED_TYPE(Type, Name) \
   BOOST_CLASS_EXPORT_GUID(property_bag::details::PlaceHolderImpl<Type>, \
-    "details_PlaceHolderImpl_"#Name);
+    "details_PlaceHolderImpl_"#Name); \
+  namespace { \
+  const property_bag::details::ArchiveTypeRegistrar<Type> \
+    property_bag_archive_type_##Name("details_PlaceHolderImpl_"#Name); \
+  }
 
 BOOST_SERIALIZATION_ASSUME_ABSTRACT(property_bag::details::PlaceHolder);
 
+// Version 1 refers to the held types by archive-wide ids
+BOOST_CLASS_VERSION(property_bag::details::Any, 1)
+
+namespace boost {
+namespace serialization {
+
+// Version 1 archives a std::vector of BulkLayout elements as one array
+template <typename T>
+struct version<property_bag::details::PlaceHolderImpl<T>>
+{
+  typedef mpl::int_<property_bag::details::is_bulk_vector<T>::value ? 1 : 0> type;
+  typedef mpl::integral_c_tag tag;
+  BOOST_STATIC_CONSTANT(int, value = version::type::value);
+};
+
+} /* namespace serialization */
+} /* namespace boost */
+
 namespace property_bag {
 namespace details {
 
+/**
+ * @brief The ArchiveType struct.
+ * A type exported with EXPORT_PROPERTY_NAMED_TYPE.
+ */
+struct ArchiveType
+{
+  std::string guid;
+
+  const std::type_info* type;
+
+  // Of PlaceHolderImpl<T>, to find its boost serializers
+  const boost::serialization::extended_type_info& (*type_info)();
+
+  PlaceHolderPtr (*make)();
+};
+
+/**
+ * @brief The ArchiveTypeRegistry class.
+ * Process-wide table of the exported types
+ * that are written by id in boost archives.
+ * Thread-safe.
+ *
+ * Registrations are only queued during static
+ * initialization and made on first use.
+ */
+class ArchiveTypeRegistry : public LazyRegistry<ArchiveType, &ArchiveType::guid>
+{
+public:
+
+  static ArchiveTypeRegistry& instance();
+
+  using LazyRegistry::add;
+
+  template <typename T>
+  bool add(const std::string& guid);
+
+  /**
+   * @brief type. The ArchiveType of T under a given guid.
+   */
+  template <typename T>
+  static ArchiveType type(const std::string& guid);
+
+protected:
+
+  ArchiveTypeRegistry() = default;
+};
+
+template <typename T>
+const boost::serialization::extended_type_info& archive_type_info()
+{
+  return boost::serialization::singleton<
+      typename boost::serialization::type_info_implementation<
+        PlaceHolderImpl<T>>::type>::get_const_instance();
+}
+
+template <typename T>
+PlaceHolderPtr make_placeholder()
+{
+  return make_ptr<PlaceHolderImpl<T>>();
+}
+
+template <typename T>
+ArchiveType ArchiveTypeRegistry::type(const std::string& guid)
+{
+  return ArchiveType{guid, &typeid(T), &archive_type_info<T>, &make_placeholder<T>};
+}
+
+template <typename T>
+bool ArchiveTypeRegistry::add(const std::string& guid)
+{
+  return add(type<T>(guid));
+}
+
+/**
+ * @brief The ArchiveTypeRegistrar struct.
+ * Queues the registration of T at construction,
+ * see EXPORT_PROPERTY_NAMED_TYPE.
+ */
+template <typename T>
+struct ArchiveTypeRegistrar
+{
+  explicit ArchiveTypeRegistrar(const char* guid) noexcept :
+    pending_{guid, &ArchiveTypeRegistry::type<T>, nullptr}
+  {
+    ArchiveTypeRegistry::defer(pending_);
+  }
+
+  mutable ArchiveTypeRegistry::Pending pending_;
+};
+
+/**
+ * @brief The ArchiveTypeIds struct.
+ * The ids given to the types written
+ * in an output archive.
+ */
+struct ArchiveTypeIds
+{
+  struct Entry
+  {
+    std::uint32_t id;
+
+    // nullptr if written by boost
+    const boost::archive::detail::basic_oserializer* serializer;
+  };
+
+  bool compact = true;
+
+  std::uint32_t next_id = 1;
+
+  std::unordered_map<const std::type_info*, Entry> entries;
+};
+
+/**
+ * @brief The ArchiveTypeTable struct.
+ * The types read from an input archive,
+ * indexed by id - 1.
+ */
+struct ArchiveTypeTable
+{
+  struct Entry
+  {
+    const ArchiveType* type;
+
+    const boost::archive::detail::basic_iserializer* serializer;
+
+    unsigned int version;
+  };
+
+  std::vector<Entry> entries;
+};
+
+// Keys of the archive helpers
+inline void* archive_type_ids_key()   { static char key; return &key; }
+inline void* archive_type_table_key() { static char key; return &key; }
+
+template <class Archive>
+void save_varint(Archive& ar, std::uint32_t value, const char* name)
+{
+  do
+  {
+    unsigned char byte = value & 0x7f;
+    value >>= 7;
+    if (value != 0) byte |= 0x80;
+
+    ar << boost::serialization::make_nvp(name, byte);
+  }
+  while (value != 0);
+}
+
+template <class Archive>
+std::uint32_t load_varint(Archive& ar, const char* name)
+{
+  std::uint32_t value = 0;
+
+  for (int shift=0; shift<32; shift+=7)
+  {
+    unsigned char byte;
+    ar >> boost::serialization::make_nvp(name, byte);
+
+    value |= std::uint32_t(byte & 0x7f) << shift;
+
+    if ((byte & 0x80) == 0) return value;
+  }
+
+  throw boost::archive::archive_exception(
+        boost::archive::archive_exception::input_stream_error);
+}
+
 template <typename T>
 struct PlaceHolderImpl<T>::serialization_accessor
 {
@@ -41,29 +252,204 @@ struct PlaceHolderImpl<T>::serialization_accessor
   static void serialize(
       Archive &ar,
       property_bag::details::PlaceHolderImpl<T> &p,
-      const unsigned int /*file_version*/)
+      const unsigned int file_version)
   {
-    ar & boost::serialization::make_nvp("property_bag::details::PlaceHolder",
+    ar & boost::serialization::make_nvp("PlaceHolder",
               boost::serialization::base_object<property_bag::details::PlaceHolder>(p));
 
-    ar & BOOST_SERIALIZATION_NVP(p.value_);
+    // A deferred value is decoded before being saved
+    if (!p.load())
+      throw PropertyException(std::string("Could not decode deferred ") +
+                              property_bag::name_of<T>());
+
+    serialize_value(ar, p.value_, file_version, is_bulk_vector<T>());
+  }
+
+  template <class Archive>
+  static void serialize_value(Archive &ar, T &value,
+                              const unsigned int /*file_version*/,
+                              std::false_type /*is_bulk_vector*/)
+  {
+    ar & boost::serialization::make_nvp("p.value_", value);
+  }
+
+  template <class Archive>
+  static void serialize_value(Archive &ar, T &value,
+                              const unsigned int file_version,
+                              std::true_type /*is_bulk_vector*/)
+  {
+    // Element by element
+    if (file_version == 0)
+      ar & boost::serialization::make_nvp("p.value_", value);
+    else
+      serialize_bulk(ar, value, typename Archive::is_saving());
+  }
+
+  template <class Archive>
+  static void serialize_bulk(Archive &ar, const T &value, boost::mpl::true_ /*is_saving*/)
+  {
+    save_bulk(ar, value);
+  }
+
+  template <class Archive>
+  static void serialize_bulk(Archive &ar, T &value, boost::mpl::false_ /*is_saving*/)
+  {
+    load_bulk(ar, value);
   }
 };
 
+/**
+ * @brief Any::serialization_accessor. The first value of a type
+ * written in an archive is preceded by a new id, the guid of the
+ * type and its version. Later values are only preceded by the id
+ * and are loaded through a table indexed by id, instead of the
+ * boost polymorphic pointers machinery.
+ * Types not exported with EXPORT_PROPERTY_NAMED_TYPE, or archives
+ * without compact ids, get the id 0 and a boost pointer.
+ * Values shared by several properties are written for each of them.
+ */
 struct Any::serialization_accessor
 {
   template <class Archive>
-  static void serialize(
+  static void save(
       Archive &ar,
-      Any &any,
+      const Any &any,
       const unsigned int /*file_version*/)
   {
-    ar & BOOST_SERIALIZATION_NVP(any.placeholder_);
+    ArchiveTypeIds& ids =
+        ar.template get_helper<ArchiveTypeIds>(archive_type_ids_key());
+
+    PlaceHolder* holder = any.placeholder_.get();
+
+    if (!ids.compact || holder == nullptr)
+    {
+      save_varint(ar, 0, "type_id");
+      ar << BOOST_SERIALIZATION_NVP(any.placeholder_);
+      return;
+    }
+
+    const std::type_info& type = holder->type();
+
+    auto it = ids.entries.find(&type);
+
+    if (it == ids.entries.end())
+    {
+      ArchiveTypeIds::Entry entry{0, nullptr};
+
+      const ArchiveType* archive_type = ArchiveTypeRegistry::instance().find(type);
+
+      const boost::archive::detail::basic_serializer* serializer = (archive_type == nullptr)?
+          nullptr : boost::archive::detail::archive_serializer_map<Archive>::find(
+                      archive_type->type_info());
+
+      if (serializer != nullptr)
+      {
+        entry.id = ids.next_id++;
+        entry.serializer = &static_cast<const boost::archive::detail::basic_pointer_oserializer*>(
+                              serializer)->get_basic_serializer();
+
+        save_varint(ar, entry.id, "type_id");
+
+        std::string guid = archive_type->guid;
+        ar << boost::serialization::make_nvp("type_guid", guid);
+        save_varint(ar, entry.serializer->version(), "type_version");
+
+        entry.serializer->save_object_data(ar, dynamic_cast<const void*>(holder));
+      }
+      else
+      {
+        save_varint(ar, 0, "type_id");
+        ar << BOOST_SERIALIZATION_NVP(any.placeholder_);
+      }
+
+      ids.entries.emplace(&type, entry);
+      return;
+    }
+
+    const ArchiveTypeIds::Entry& entry = it->second;
+
+    save_varint(ar, entry.id, "type_id");
+
+    if (entry.serializer != nullptr)
+      entry.serializer->save_object_data(ar, dynamic_cast<const void*>(holder));
+    else
+      ar << BOOST_SERIALIZATION_NVP(any.placeholder_);
+  }
+
+  template <class Archive>
+  static void load(
+      Archive &ar,
+      Any &any,
+      const unsigned int file_version)
+  {
+    const std::uint32_t id = (file_version == 0)? 0 : load_varint(ar, "type_id");
+
+    if (id == 0)
+    {
+      ar >> BOOST_SERIALIZATION_NVP(any.placeholder_);
+      return;
+    }
+
+    ArchiveTypeTable& table =
+        ar.template get_helper<ArchiveTypeTable>(archive_type_table_key());
+
+    if (id == table.entries.size() + 1)
+    {
+      std::string guid;
+      ar >> boost::serialization::make_nvp("type_guid", guid);
+      const unsigned int version = load_varint(ar, "type_version");
+
+      const ArchiveType* archive_type = ArchiveTypeRegistry::instance().find(guid);
+
+      const boost::archive::detail::basic_serializer* serializer = (archive_type == nullptr)?
+          nullptr : boost::archive::detail::archive_serializer_map<Archive>::find(
+                      archive_type->type_info());
+
+      if (serializer == nullptr)
+        throw boost::archive::archive_exception(
+              boost::archive::archive_exception::unregistered_class, guid.c_str());
+
+      const boost::archive::detail::basic_iserializer& iserializer =
+          static_cast<const boost::archive::detail::basic_pointer_iserializer*>(
+            serializer)->get_basic_serializer();
+
+      if (version > iserializer.version())
+        throw boost::archive::archive_exception(
+              boost::archive::archive_exception::unsupported_class_version, guid.c_str());
+
+      table.entries.push_back(ArchiveTypeTable::Entry{archive_type, &iserializer, version});
+    }
+    else if (id > table.entries.size())
+    {
+      throw boost::archive::archive_exception(
+            boost::archive::archive_exception::input_stream_error);
+    }
+
+    const ArchiveTypeTable::Entry& entry = table.entries[id - 1];
+
+    PlaceHolderPtr holder = entry.type->make();
+
+    entry.serializer->load_object_data(ar, dynamic_cast<void*>(holder.get()), entry.version);
+
+    any.placeholder_ = std::move(holder);
   }
 };
 
 } /* namespace details */
 
+/**
+ * @brief set_compact_type_ids. Whether the values written in
+ * an output archive refer to their type by a compact id (default)
+ * or through the boost polymorphic pointers, by their guid.
+ * To be set before anything is written.
+ */
+template <class OArchive>
+void set_compact_type_ids(OArchive& oa, const bool compact)
+{
+  oa.template get_helper<details::ArchiveTypeIds>(
+        details::archive_type_ids_key()).compact = compact;
+}
+
 struct Property::serialization_accessor
 {
   template <class Archive>
@@ -103,13 +489,31 @@ void serialize(
   property_bag::details::PlaceHolderImpl<T>::serialization_accessor::serialize(ar, pl, file_version);
 }
 
+template<class Archive>
+void save(
+    Archive &ar,
+    const property_bag::details::Any &any,
+    const unsigned int file_version)
+{
+  property_bag::details::Any::serialization_accessor::save(ar, any, file_version);
+}
+
+template<class Archive>
+void load(
+    Archive &ar,
+    property_bag::details::Any &any,
+    const unsigned int file_version)
+{
+  property_bag::details::Any::serialization_accessor::load(ar, any, file_version);
+}
+
 template<class Archive>
 void serialize(
     Archive &ar,
     property_bag::details::Any &any,
     const unsigned int file_version)
 {
-  property_bag::details::Any::serialization_accessor::serialize(ar, any, file_version);
+  boost::serialization::split_free(ar, any, file_version);
 }
 
 template<class Archive>
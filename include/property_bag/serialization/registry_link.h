@@ -0,0 +1,36 @@
+/**
+ * \file registry_link.h
+ * \brief Keeps a registry library linked to its users.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_REGISTRY_LINK_H
+#define PROPERTY_BAG_SERIALIZATION_REGISTRY_LINK_H
+
+/**
+ * @brief The Eigen and ROS types are registered by their
+ * own libraries (property_bag_eigen, property_bag_ros) that
+ * no user code calls into. Their headers refer to an anchor
+ * defined once by the library so that the linker keeps it,
+ * e.g. with --as-needed, and its types are registered.
+ *
+ * The reference is a constant weak symbol: no static initializer,
+ * and a single one per binary however many translation units
+ * include the header.
+ *
+ * PROPERTY_BAG_LINK_REGISTRY(Name) in the header,
+ * PROPERTY_BAG_DEFINE_REGISTRY(Name) in the library.
+ */
+#define PROPERTY_BAG_LINK_REGISTRY(Name)                            \
+  namespace property_bag { namespace details {                      \
+  extern const char Name##_registry_anchor;                         \
+  extern const char* const Name##_registry_link                     \
+    __attribute__((weak, used)) = &Name##_registry_anchor;          \
+  } }
+
+#define PROPERTY_BAG_DEFINE_REGISTRY(Name)                          \
+  namespace property_bag { namespace details {                      \
+  extern const char Name##_registry_anchor;                         \
+  const char Name##_registry_anchor = 0;                            \
+  } }
+
+#endif // PROPERTY_BAG_SERIALIZATION_REGISTRY_LINK_H
@@ -11,8 +11,14 @@
 #ifndef ROS_BOOST_SERIALIZATION
 #define ROS_BOOST_SERIALIZATION
 #include <ros/serialization.h>
+#include <boost/archive/archive_exception.hpp>
 #include <boost/serialization/split_free.hpp>
 #include <boost/serialization/array.hpp>
+#include <boost/serialization/nvp.hpp>
+#include <boost/serialization/throw_exception.hpp>
+#include <boost/serialization/version.hpp>
+#include <type_traits>
+#include <vector>
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <geometry_msgs/Point.h>
@@ -21,6 +27,131 @@
 #include <geometry_msgs/QuaternionStamped.h>
 #include <std_msgs/Time.h>
 #include <std_msgs/Duration.h>
+#include <property_bag/ros_type_names.h>
+#include <property_bag/serialization/registry_link.h>
+
+namespace property_bag {
+namespace details {
+
+/**
+ * @brief ros_scratch. A per-thread buffer of at least 'size'
+ * bytes, reused by every message so that (de)serializing
+ * one does not allocate once the buffer is large enough.
+ */
+inline uint8_t* ros_scratch(const std::size_t size)
+{
+  static thread_local std::vector<uint8_t> buffer;
+
+  if (buffer.size() < size) buffer.resize(size);
+
+  return buffer.data();
+}
+
+/**
+ * @brief ros_message_version. The boost serialization
+ * version of a message.
+ *  - 0 : the layout of ros::serialization::serializeMessage,
+ *        num_bytes start_offset buffer[num_bytes], the buffer
+ *        holding the message length on 4 bytes followed by
+ *        the message.
+ *  - 1 : fixed-size messages only, the message as a raw
+ *        block, its size being known from its type.
+ * Archives of version 0 are still read.
+ */
+template <typename Msg>
+struct ros_message_version :
+    std::integral_constant<int, ros::message_traits::IsFixedSize<Msg>::value? 1 : 0> {};
+
+template <class Archive, typename Msg>
+void save_ros_message(Archive & ar, const Msg & m, std::false_type /*fixed_size*/)
+{
+  const uint32_t length = ros::serialization::serializationLength(m);
+
+  size_t num_bytes = length + 4;
+  ptrdiff_t start_offset = 4;
+
+  uint8_t* buffer = ros_scratch(num_bytes);
+
+  ros::serialization::OStream stream(buffer, num_bytes);
+  stream.next(length);
+  ros::serialization::serialize(stream, m);
+
+  ar & BOOST_SERIALIZATION_NVP(num_bytes);
+  ar & BOOST_SERIALIZATION_NVP(start_offset);
+  ar & boost::serialization::make_nvp("buffer",
+        boost::serialization::make_array(buffer, num_bytes));
+}
+
+template <class Archive, typename Msg>
+void save_ros_message(Archive & ar, const Msg & m, std::true_type /*fixed_size*/)
+{
+  const uint32_t num_bytes = ros::serialization::serializationLength(m);
+
+  uint8_t* buffer = ros_scratch(num_bytes);
+
+  ros::serialization::OStream stream(buffer, num_bytes);
+  ros::serialization::serialize(stream, m);
+
+  ar & boost::serialization::make_nvp("buffer",
+        boost::serialization::make_array(buffer, num_bytes));
+}
+
+template <class Archive, typename Msg>
+void save_ros_message(Archive & ar, const Msg & m)
+{
+  save_ros_message(ar, m, std::integral_constant<bool,
+                   ros::message_traits::IsFixedSize<Msg>::value>());
+}
+
+template <class Archive, typename Msg>
+void load_ros_message(Archive & ar, Msg & m, std::false_type /*fixed_size*/)
+{
+  size_t num_bytes;
+  ar & BOOST_SERIALIZATION_NVP(num_bytes);
+
+  ptrdiff_t start_offset;
+  ar & BOOST_SERIALIZATION_NVP(start_offset);
+
+  if (start_offset < 0 || size_t(start_offset) > num_bytes)
+    boost::serialization::throw_exception(boost::archive::archive_exception(
+      boost::archive::archive_exception::input_stream_error));
+
+  uint8_t* buffer = ros_scratch(num_bytes);
+
+  ar & boost::serialization::make_nvp("buffer",
+        boost::serialization::make_array(buffer, num_bytes));
+
+  ros::serialization::IStream stream(buffer + start_offset, num_bytes - start_offset);
+  ros::serialization::deserialize(stream, m);
+}
+
+template <class Archive, typename Msg>
+void load_ros_message(Archive & ar, Msg & m, std::true_type /*fixed_size*/)
+{
+  // Any instance has the same length
+  const uint32_t num_bytes = ros::serialization::serializationLength(m);
+
+  uint8_t* buffer = ros_scratch(num_bytes);
+
+  ar & boost::serialization::make_nvp("buffer",
+        boost::serialization::make_array(buffer, num_bytes));
+
+  ros::serialization::IStream stream(buffer, num_bytes);
+  ros::serialization::deserialize(stream, m);
+}
+
+template <class Archive, typename Msg>
+void load_ros_message(Archive & ar, Msg & m, const unsigned int version)
+{
+  if (version == 0)
+    load_ros_message(ar, m, std::false_type());
+  else
+    load_ros_message(ar, m, std::integral_constant<bool,
+                     ros::message_traits::IsFixedSize<Msg>::value>());
+}
+
+} /* namespace details */
+} /* namespace property_bag */
 
 namespace boost{
 namespace serialization{
@@ -38,36 +169,24 @@ void serialize(Archive & ar, ros::Duration &d, const unsigned int version) {
 }
 
 #define ROS_BOOST_SERIALIZE_MSG(Msg) \
-template<class Archive>\
-void save(Archive & ar, const Msg &m, const unsigned int version)\
+template<>\
+struct version<Msg>\
 {\
-  ros::SerializedMessage sm = ros::serialization::serializeMessage(m);\
-  ar & boost::serialization::make_nvp("num_bytes", sm.num_bytes);\
-\
-  ptrdiff_t start_offset = sm.message_start - sm.buf.get();\
-  ar & BOOST_SERIALIZATION_NVP(start_offset);\
-\
-  ar & boost::serialization::make_nvp("buffer", \
-        boost::serialization::make_array(&sm.buf[0], sm.num_bytes) );\
+  typedef mpl::int_<property_bag::details::ros_message_version<Msg>::value> type;\
+  typedef mpl::integral_c_tag tag;\
+  BOOST_STATIC_CONSTANT(int, value = version::type::value);\
+};\
 \
+template<class Archive>\
+void save(Archive & ar, const Msg &m, const unsigned int /*version*/)\
+{\
+  property_bag::details::save_ros_message(ar, m);\
 }\
 \
 template<class Archive>\
 void load(Archive & ar, Msg &m, const unsigned int version)\
 {\
-  size_t num_bytes;\
-  ar & BOOST_SERIALIZATION_NVP(num_bytes);\
-\
-  ptrdiff_t start_offset;\
-  ar & BOOST_SERIALIZATION_NVP(start_offset);\
-\
-  ros::SerializedMessage sm(boost::shared_array<uint8_t>(new uint8_t[num_bytes]), num_bytes);\
-  sm.message_start = sm.buf.get() + start_offset;\
-\
-  ar & boost::serialization::make_nvp("buffer", \
-        boost::serialization::make_array(&sm.buf[0], sm.num_bytes) );\
-\
-  ros::serialization::deserializeMessage(sm, m);\
+  property_bag::details::load_ros_message(ar, m, version);\
 }\
 \
 template <class Archive>\
@@ -75,15 +194,13 @@ void serialize(Archive & ar, Msg &m, const unsigned int version) {\
   split_free(ar,m,version);\
 }
 
-ROS_BOOST_SERIALIZE_MSG(geometry_msgs::Pose)
-ROS_BOOST_SERIALIZE_MSG(geometry_msgs::PoseStamped)
-ROS_BOOST_SERIALIZE_MSG(geometry_msgs::Point)
-ROS_BOOST_SERIALIZE_MSG(geometry_msgs::PointStamped)
-ROS_BOOST_SERIALIZE_MSG(geometry_msgs::Quaternion)
-ROS_BOOST_SERIALIZE_MSG(geometry_msgs::QuaternionStamped)
-ROS_BOOST_SERIALIZE_MSG(std_msgs::Time)
-ROS_BOOST_SERIALIZE_MSG(std_msgs::Duration)
-
 } /* namespace serialization */
 } /* namespace boost */
+
+// Types registered in property_bag_ros
+PROPERTY_BAG_LINK_REGISTRY(ros_boost)
+
+// The supported messages, once the above is defined
+#include <property_bag/serialization/ros_message.h>
+
 #endif /* ROS_BOOST_SERIALIZATION */
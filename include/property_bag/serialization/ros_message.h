@@ -0,0 +1,74 @@
+/**
+ * \file ros_message.h
+ * \brief Registration of any ROS message as a property type.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_ROS_MESSAGE_H
+#define PROPERTY_BAG_SERIALIZATION_ROS_MESSAGE_H
+
+#include <property_bag/serialization/property_boost_serialization.h>
+#include <property_bag/serialization/ros_boost_serialization.h>
+#include <property_bag/serialization/ros_wire_format.h>
+
+namespace property_bag {
+namespace details {
+
+/**
+ * @brief The RosMessageExport struct. Does what
+ * BOOST_CLASS_EXPORT_IMPLEMENT does, but as an implicitly
+ * instantiated template it may be in several translation units.
+ */
+template <typename Msg>
+struct RosMessageExport
+{
+  using Initializer = boost::archive::detail::extra_detail::guid_initializer<PlaceHolderImpl<Msg>>;
+
+  static const Initializer& boost_export;
+};
+
+template <typename Msg>
+const typename RosMessageExport<Msg>::Initializer& RosMessageExport<Msg>::boost_export =
+  boost::serialization::singleton<Initializer>::get_mutable_instance().export_guid();
+
+} /* namespace details */
+} /* namespace property_bag */
+
+/**
+ * @brief Makes ROS message 'Msg' a property type, named
+ * after its C++ name and exported to boost and the wire
+ * format under 'Name'.
+ * Must be used in the global namespace, in a header included
+ * wherever Msg is stored in a property. Every translation unit
+ * including it exports Msg, the registries keep the first.
+ *
+ * Messages for which ros::message_traits::IsFixedSize
+ * holds are written as a raw block, without length.
+ *
+ * @example PROPERTY_BAG_ROS_MSG(geometry_msgs::Vector3, geometry_msgs__Vector3)
+ */
+#define PROPERTY_BAG_ROS_MSG(Msg, Name)                                           \
+  PROPERTY_BAG_TYPE_NAME(Msg, #Msg)                                               \
+  namespace boost { namespace serialization {                                     \
+  ROS_BOOST_SERIALIZE_MSG(Msg)                                                    \
+  } }                                                                             \
+  BOOST_CLASS_EXPORT_KEY2(property_bag::details::PlaceHolderImpl<Msg>,            \
+    "details_PlaceHolderImpl_"#Name)                                              \
+  namespace {                                                                     \
+  const void* const property_bag_ros_export_##Name =                              \
+    &property_bag::details::RosMessageExport<Msg>::boost_export;                  \
+  const property_bag::details::ArchiveTypeRegistrar<Msg>                          \
+    property_bag_archive_type_##Name("details_PlaceHolderImpl_"#Name);            \
+  }                                                                               \
+  EXPORT_PROPERTY_WIRE_TYPE(Msg, Name)
+
+// The supported messages
+PROPERTY_BAG_ROS_MSG(geometry_msgs::Pose, geometry_msgs__Pose)
+PROPERTY_BAG_ROS_MSG(geometry_msgs::PoseStamped, geometry_msgs__PoseStamped)
+PROPERTY_BAG_ROS_MSG(geometry_msgs::Point, geometry_msgs__Point)
+PROPERTY_BAG_ROS_MSG(geometry_msgs::PointStamped, geometry_msgs__PointStamped)
+PROPERTY_BAG_ROS_MSG(geometry_msgs::Quaternion, geometry_msgs__Quaternion)
+PROPERTY_BAG_ROS_MSG(geometry_msgs::QuaternionStamped, geometry_msgs__QuaternionStamped)
+PROPERTY_BAG_ROS_MSG(std_msgs::Time, std_msgs__Time)
+PROPERTY_BAG_ROS_MSG(std_msgs::Duration, std_msgs__Duration)
+
+#endif /* PROPERTY_BAG_SERIALIZATION_ROS_MESSAGE_H */
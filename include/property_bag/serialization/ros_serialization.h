@@ -0,0 +1,173 @@
+/**
+ * \file ros_serialization.h
+ * \brief ROS serialization of bags and properties,
+ * to be fields of a message.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_ROS_SERIALIZATION_H
+#define PROPERTY_BAG_SERIALIZATION_ROS_SERIALIZATION_H
+
+#include <property_bag/serialization/wire_format.h>
+
+#include <ros/serialization.h>
+
+/*
+ * Both are serialized as a uint8[], that is a uint32 size
+ * followed by as many bytes :
+ *
+ *  bag      := size:u32 bag:u8[size]
+ *  property := size:u32 type_name:string property:u8[size - ...]
+ *
+ * 'bag' being the output of to_wire() and 'property' as in the
+ * wire format (flags, description and value). A message field
+ * declared 'uint8[]' in a .msg file can thus be read as a bag
+ * by a hand-written message, and the other way around.
+ *
+ * Held types must have been exported to the wire format,
+ * see EXPORT_PROPERTY_WIRE_TYPE, a PropertyException is
+ * thrown otherwise, or if the input is malformed.
+ *
+ * @example
+ *
+ *   struct Stamped { std::string frame_id; property_bag::PropertyBag bag; };
+ *
+ *   namespace ros { namespace serialization {
+ *   template <> struct Serializer<Stamped>
+ *   {
+ *     template <typename Stream, typename T>
+ *     inline static void allInOne(Stream& stream, T m)
+ *     {
+ *       stream.next(m.frame_id);
+ *       stream.next(m.bag);
+ *     }
+ *     ROS_DECLARE_ALLINONE_SERIALIZER
+ *   };
+ *   } }
+ */
+
+namespace ros {
+namespace serialization {
+
+template <typename KeyType>
+struct Serializer<property_bag::AbstractPropertyBag<KeyType>>
+{
+  using Bag = property_bag::AbstractPropertyBag<KeyType>;
+
+  /**
+   * @brief write. Encode the bag straight in the stream,
+   * its size being written once it is known.
+   */
+  template <typename Stream>
+  inline static void write(Stream& stream, const Bag& bag)
+  {
+    std::uint8_t* size = stream.advance(sizeof(std::uint32_t));
+
+    const std::uint32_t written = property_bag::to_wire(
+          bag, reinterpret_cast<char*>(stream.getData()), stream.getLength());
+
+    stream.advance(written);
+    std::memcpy(size, &written, sizeof(written));
+  }
+
+  template <typename Stream>
+  inline static void read(Stream& stream, Bag& bag)
+  {
+    std::uint32_t size;
+    stream.next(size);
+
+    const char* data = reinterpret_cast<const char*>(stream.advance(size));
+    property_bag::from_wire(data, size, bag);
+  }
+
+  /**
+   * @brief serializedLength. Counts the bytes
+   * of the bag without encoding it.
+   */
+  inline static std::uint32_t serializedLength(const Bag& bag)
+  {
+    return sizeof(std::uint32_t) + property_bag::wire_size(bag);
+  }
+};
+
+template <>
+struct Serializer<property_bag::Property>
+{
+  using Property = property_bag::Property;
+
+  template <typename Stream>
+  inline static void write(Stream& stream, const Property& p)
+  {
+    const property_bag::wire::TypeCodec& codec = codec_of(p);
+
+    std::uint8_t* size = stream.advance(sizeof(std::uint32_t));
+
+    property_bag::wire::BufferWriter writer(
+          reinterpret_cast<char*>(stream.getData()), stream.getLength());
+
+    writer.write_string(codec.name);
+    Property::wire_accessor::encode(writer, p, codec);
+
+    const std::uint32_t written = writer.size();
+
+    stream.advance(written);
+    std::memcpy(size, &written, sizeof(written));
+  }
+
+  template <typename Stream>
+  inline static void read(Stream& stream, Property& p)
+  {
+    std::uint32_t size;
+    stream.next(size);
+
+    property_bag::wire::Reader reader(
+          reinterpret_cast<const char*>(stream.advance(size)), size);
+
+    std::string type_name;
+    reader.read_string(type_name);
+
+    const property_bag::wire::TypeCodec* codec =
+        property_bag::wire::Registry::instance().find(type_name);
+
+    if (codec == nullptr)
+      throw property_bag::PropertyException("Type '" + type_name +
+                                            "' is not exported to the wire format.");
+
+    Property loaded;
+    Property::wire_accessor::decode(reader, loaded, *codec);
+
+    if (reader.remaining() != 0)
+      throw property_bag::PropertyException("Wire format: property not fully decoded.");
+
+    p = std::move(loaded);
+  }
+
+  inline static std::uint32_t serializedLength(const Property& p)
+  {
+    const property_bag::wire::TypeCodec& codec = codec_of(p);
+
+    property_bag::wire::SizeCounter counter;
+    counter.write_string(codec.name);
+    Property::wire_accessor::encode(counter, p, codec);
+
+    return sizeof(std::uint32_t) + counter.size();
+  }
+
+protected:
+
+  static const property_bag::wire::TypeCodec& codec_of(const Property& p)
+  {
+    const property_bag::wire::TypeCodec* codec =
+        property_bag::wire::Registry::instance().find(p.type());
+
+    if (codec == nullptr)
+      throw property_bag::PropertyException(std::string("Property of type ") + p.type_name() +
+                                            " is not exported to the wire format.");
+
+    return *codec;
+  }
+};
+
+} /* namespace serialization */
+} /* namespace ros */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_ROS_SERIALIZATION_H */
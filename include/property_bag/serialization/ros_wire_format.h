@@ -0,0 +1,104 @@
+/**
+ * \file ros_wire_format.h
+ * \brief Wire format codecs for ROS types.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_ROS_WIRE_FORMAT_H
+#define PROPERTY_BAG_SERIALIZATION_ROS_WIRE_FORMAT_H
+
+#include <property_bag/serialization/wire_format.h>
+#include <property_bag/ros_type_names.h>
+#include <property_bag/serialization/registry_link.h>
+
+#include <ros/serialization.h>
+
+namespace property_bag {
+namespace wire {
+
+// The ROS serialization, message:u8[size], preceded by
+// size:varint unless the message is fixed-size
+template <typename T>
+struct Codec<T, typename std::enable_if<ros::message_traits::IsMessage<T>::value>::type>
+{
+  using fixed_size = std::integral_constant<bool, ros::message_traits::IsFixedSize<T>::value>;
+
+  // Writer or StreamWriter
+  template <class W>
+  static void encode(W& w, const T& m)
+  {
+    const std::uint32_t size = ros::serialization::serializationLength(m);
+    write_size(w, size, fixed_size());
+
+    ros::serialization::OStream stream(
+          reinterpret_cast<std::uint8_t*>(w.extend(size)), size);
+    ros::serialization::serialize(stream, m);
+  }
+
+  static void encode(SizeCounter& w, const T& m)
+  {
+    const std::uint32_t size = ros::serialization::serializationLength(m);
+    write_size(w, size, fixed_size());
+    w.write(nullptr, size);
+  }
+
+  static void decode(Reader& r, T& m)
+  {
+    const std::uint64_t size = read_size(r, m, fixed_size());
+    r.check_count(size, 1);
+
+    // IStream only reads the buffer
+    ros::serialization::IStream stream(
+          reinterpret_cast<std::uint8_t*>(const_cast<char*>(r.skip(size))), size);
+    ros::serialization::deserialize(stream, m);
+  }
+
+  template <class W>
+  static void write_size(W& w, const std::uint32_t size, std::false_type /*fixed_size*/)
+  {
+    w.write_varint(size);
+  }
+
+  template <class W>
+  static void write_size(W& /*w*/, const std::uint32_t /*size*/, std::true_type /*fixed_size*/) { }
+
+  static std::uint64_t read_size(Reader& r, const T& /*m*/, std::false_type /*fixed_size*/)
+  {
+    return r.read_varint();
+  }
+
+  // Any instance has the same length
+  static std::uint64_t read_size(Reader& /*r*/, const T& m, std::true_type /*fixed_size*/)
+  {
+    return ros::serialization::serializationLength(m);
+  }
+};
+
+// sec nsec
+template <typename T>
+struct Codec<T, typename std::enable_if<
+    std::is_same<T, ros::Time>::value || std::is_same<T, ros::Duration>::value>::type>
+{
+  template <class W>
+  static void encode(W& w, const T& t)
+  {
+    w.write_scalar(t.sec);
+    w.write_scalar(t.nsec);
+  }
+
+  static void decode(Reader& r, T& t)
+  {
+    t.sec  = r.read_scalar<decltype(t.sec)>();
+    t.nsec = r.read_scalar<decltype(t.nsec)>();
+  }
+};
+
+} /* namespace wire */
+} /* namespace property_bag */
+
+// Types registered in property_bag_ros
+PROPERTY_BAG_LINK_REGISTRY(ros_wire)
+
+// The supported messages, once the above is defined
+#include <property_bag/serialization/ros_message.h>
+
+#endif /* PROPERTY_BAG_SERIALIZATION_ROS_WIRE_FORMAT_H */
@@ -0,0 +1,1688 @@
+/**
+ * \file wire_format.h
+ * \brief A compact, versioned, binary format for property
+ * bags that does not depend on boost serialization.
+ */
+
+#ifndef PROPERTY_BAG_SERIALIZATION_WIRE_FORMAT_H
+#define PROPERTY_BAG_SERIALIZATION_WIRE_FORMAT_H
+
+#include <property_bag/property_bag.h>
+#include <property_bag/serialization/endian.h>
+#include <property_bag/serialization/lazy_registry.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iosfwd>
+#include <vector>
+
+/*
+ * Layout, every number is little endian :
+ *
+ *  file     := 'P' 'B' 'W' version:u8 bag
+ *  bag      := name:key handling:varint
+ *              num_types:varint type_name:string[num_types]
+ *              num_properties:varint property[num_properties]
+ *  property := name:key type:varint flags:u8 description:string
+ *              size:varint value:u8[size]
+ *  string   := size:varint char[size]
+ *
+ * 'type' indexes the type table of the bag, which holds the
+ * names given to EXPORT_PROPERTY_WIRE_TYPE.
+ * Arithmetic arrays and Eigen data are written as raw
+ * contiguous blocks and nested bags are written inline.
+ * The size of a value allows to skip it without decoding,
+ * which LoadMode::LAZY relies on.
+ */
+
+#define EXPORT_PROPERTY_WIRE_TYPE(Type, Name) \
+  namespace { \
+  const property_bag::wire::Registrar<Type> property_bag_wire_type_##Name(#Name); \
+  }
+
+namespace property_bag {
+namespace wire {
+
+constexpr char          magic[3]       = {'P', 'B', 'W'};
+constexpr std::uint8_t  format_version = 1;
+
+/**
+ * @brief The LoadMode enum.
+ */
+enum class LoadMode : std::size_t
+{
+  EAGER = 0, //< Every value is decoded at load.
+  LAZY       //< A value is decoded on its first access.
+};
+
+/**
+ * @brief Buffer. Bytes shared by lazily loaded values.
+ */
+using Buffer = shared_ptr<const std::string>;
+
+/**
+ * @brief parallel_for. Call task(i) for each i in [0, count)
+ * on up to 'num_threads' threads, the calling one included,
+ * 0 standing for std::thread::hardware_concurrency().
+ * Indices are handed out one at a time. The first exception
+ * thrown by a task is rethrown once every thread is done.
+ */
+void parallel_for(const std::size_t count, std::size_t num_threads,
+                  const std::function<void(std::size_t)>& task);
+
+/**
+ * @brief has_fixed_width. Whether T is written as is.
+ * @note 'long' keeps its native size, prefer the
+ * fixed width integer types for portable bags.
+ */
+template <typename T>
+using has_fixed_width = std::integral_constant<bool,
+  std::is_arithmetic<T>::value &&
+  !std::is_same<T, long double>::value &&
+  !std::is_same<T, wchar_t>::value>;
+
+/**
+ * @brief The BasicWriter class.
+ * Encoding primitives over Derived::write(const void*, std::size_t).
+ */
+template <typename Derived>
+class BasicWriter
+{
+public:
+
+  void write_varint(std::uint64_t v)
+  {
+    unsigned char bytes[10];
+    std::size_t size = 0;
+
+    do
+    {
+      bytes[size] = static_cast<unsigned char>(v & 0x7f);
+      v >>= 7;
+      if (v != 0) bytes[size] |= 0x80;
+      ++size;
+    }
+    while (v != 0);
+
+    derived().write(bytes, size);
+  }
+
+  template <typename T>
+  void write_scalar(T t)
+  {
+    static_assert(has_fixed_width<T>::value, "T is not of fixed width.");
+
+    if (!details::native_little_endian()) details::byte_swap(t);
+
+    derived().write(&t, sizeof(T));
+  }
+
+  /**
+   * @brief write_block. Write 'count' contiguous T at once.
+   */
+  template <typename T>
+  void write_block(const T* data, const std::size_t count)
+  {
+    static_assert(has_fixed_width<T>::value, "T is not of fixed width.");
+
+    details::write_little_endian(data, count,
+      [this](const void* bytes, const std::size_t size) { derived().write(bytes, size); });
+  }
+
+  void write_string(const std::string& s)
+  {
+    write_varint(s.size());
+    derived().write(s.data(), s.size());
+  }
+
+  /**
+   * @brief use_value_sizes. Take the size of each value to be
+   * written, nested ones included, from 'sizes', in order, as
+   * recorded by a SizeCounter, rather than counting it again.
+   * 'sizes' must outlive the encoding.
+   */
+  void use_value_sizes(const std::vector<std::size_t>* sizes) noexcept
+  {
+    value_sizes_ = sizes;
+    next_value_  = 0;
+  }
+
+  /**
+   * @brief next_value_size. The recorded size of the next value.
+   * @return false if none is recorded.
+   */
+  bool next_value_size(std::size_t& size) noexcept
+  {
+    if (value_sizes_ == nullptr || next_value_ >= value_sizes_->size())
+      return false;
+
+    size = (*value_sizes_)[next_value_++];
+    return true;
+  }
+
+protected:
+
+  Derived& derived() { return static_cast<Derived&>(*this); }
+
+  const std::vector<std::size_t>* value_sizes_ = nullptr;
+  std::size_t next_value_ = 0;
+};
+
+/**
+ * @brief The Writer class. Encodes in a growing buffer.
+ */
+class Writer : public BasicWriter<Writer>
+{
+public:
+
+  inline void write(const void* data, const std::size_t size)
+  {
+    buffer_.append(static_cast<const char*>(data), size);
+  }
+
+  /**
+   * @brief extend. Grow the buffer of 'size' bytes
+   * for a value to be encoded in place.
+   * @return a pointer to the new bytes.
+   */
+  inline char* extend(const std::size_t size)
+  {
+    const std::size_t offset = buffer_.size();
+    buffer_.resize(offset + size);
+    return &buffer_[offset];
+  }
+
+  inline void reserve(const std::size_t size) { buffer_.reserve(size); }
+
+  inline std::size_t size() const noexcept { return buffer_.size(); }
+
+  /**
+   * @brief release. Move the encoded bytes out.
+   */
+  inline std::string release() { return std::move(buffer_); }
+
+protected:
+
+  std::string buffer_;
+};
+
+/**
+ * @brief The SizeCounter class. Only counts the
+ * number of bytes an encoding would take.
+ */
+class SizeCounter : public BasicWriter<SizeCounter>
+{
+public:
+
+  SizeCounter() = default;
+
+  /**
+   * @brief SizeCounter. Also records in 'sizes' the size
+   * of each value, in the order they are written.
+   */
+  explicit SizeCounter(std::vector<std::size_t>* sizes) noexcept :
+    sizes_(sizes) { }
+
+  inline void write(const void* /*data*/, const std::size_t size) noexcept
+  {
+    size_ += size;
+  }
+
+  inline std::size_t size() const noexcept { return size_; }
+
+  /**
+   * @brief nested. A counter of its own, for a value,
+   * recording in the same sizes.
+   */
+  inline SizeCounter nested() const noexcept { return SizeCounter(sizes_); }
+
+  /**
+   * @brief open_value. Reserve the record of the size of a
+   * value, before its nested values are counted.
+   */
+  inline std::size_t open_value()
+  {
+    if (sizes_ == nullptr) return 0;
+
+    sizes_->push_back(0);
+    return sizes_->size() - 1;
+  }
+
+  inline void close_value(const std::size_t record, const std::size_t size) noexcept
+  {
+    if (sizes_ != nullptr) (*sizes_)[record] = size;
+  }
+
+protected:
+
+  std::size_t size_ = 0;
+
+  std::vector<std::size_t>* sizes_ = nullptr;
+};
+
+/**
+ * @brief The BufferWriter class. Encodes in a buffer it
+ * does not own, e.g. of wire_size() bytes.
+ * Throws a PropertyException past its end.
+ */
+class BufferWriter : public BasicWriter<BufferWriter>
+{
+public:
+
+  BufferWriter(char* data, const std::size_t size) :
+    begin_(data), data_(data), end_(data + size) { }
+
+  inline void write(const void* data, const std::size_t size)
+  {
+    std::memcpy(extend(size), data, size);
+  }
+
+  /**
+   * @brief extend. Skip 'size' bytes for a
+   * value to be encoded in place.
+   * @return a pointer to the skipped bytes.
+   */
+  inline char* extend(const std::size_t size)
+  {
+    if (size > std::size_t(end_ - data_))
+      throw PropertyException("Wire format: buffer overrun.");
+
+    char* data = data_;
+    data_ += size;
+    return data;
+  }
+
+  inline std::size_t size() const noexcept { return data_ - begin_; }
+
+protected:
+
+  char* begin_;
+  char* data_;
+  char* end_;
+};
+
+constexpr std::size_t default_stream_buffer_size = 64*1024;
+
+/**
+ * @brief The StreamWriter class. Encodes through a fixed-size
+ * buffer flushed to a std::ostream or a file descriptor.
+ * Blocks that do not fit the buffer bypass it.
+ * Throws a PropertyException if the output fails.
+ */
+class StreamWriter : public BasicWriter<StreamWriter>
+{
+public:
+
+  explicit StreamWriter(std::ostream& os,
+                        const std::size_t buffer_size = default_stream_buffer_size);
+
+  explicit StreamWriter(const int fd,
+                        const std::size_t buffer_size = default_stream_buffer_size);
+
+  /**
+   * @brief ~StreamWriter. Flushes, ignoring errors,
+   * call flush() to have them reported.
+   */
+  ~StreamWriter();
+
+  StreamWriter(const StreamWriter&)            = delete;
+  StreamWriter& operator=(const StreamWriter&) = delete;
+
+  void write(const void* data, const std::size_t size);
+
+  /**
+   * @brief extend. Reserve 'size' contiguous bytes in
+   * the buffer for a value to be encoded in place.
+   * The buffer grows if it is smaller than 'size'.
+   * @return a pointer to the reserved bytes.
+   */
+  char* extend(const std::size_t size);
+
+  void flush();
+
+  /**
+   * @brief size. Number of bytes written so far.
+   */
+  inline std::size_t size() const noexcept { return written_ + used_; }
+
+protected:
+
+  void sink(const char* data, std::size_t size);
+
+  std::ostream* os_ = nullptr;
+  int fd_ = -1;
+
+  std::vector<char> buffer_;
+  std::size_t used_    = 0;
+  std::size_t written_ = 0;
+};
+
+/**
+ * @brief The Reader class. Decodes a buffer it does not own.
+ * Throws a PropertyException on truncated or malformed inputs.
+ */
+class Reader
+{
+public:
+
+  Reader(const char* data, const std::size_t size) :
+    data_(data), end_(data + size) { }
+
+  /**
+   * @brief skip. Advance of 'size' bytes.
+   * @return a pointer to the skipped bytes.
+   */
+  const char* skip(const std::size_t size);
+
+  inline void read(void* out, const std::size_t size)
+  {
+    std::memcpy(out, skip(size), size);
+  }
+
+  std::uint64_t read_varint();
+
+  template <typename T>
+  T read_scalar()
+  {
+    static_assert(has_fixed_width<T>::value, "T is not of fixed width.");
+
+    T t;
+    read(&t, sizeof(T));
+
+    if (!details::native_little_endian()) details::byte_swap(t);
+
+    return t;
+  }
+
+  template <typename T>
+  void read_block(T* out, const std::size_t count)
+  {
+    static_assert(has_fixed_width<T>::value, "T is not of fixed width.");
+
+    check_count(count, sizeof(T));
+
+    read(out, count*sizeof(T));
+
+    details::from_little_endian(out, count);
+  }
+
+  void read_string(std::string& s);
+
+  /**
+   * @brief check_count. Throws if 'count' elements
+   * of 'size' bytes can not be left to read.
+   */
+  void check_count(const std::uint64_t count, const std::size_t size) const;
+
+  inline std::size_t remaining() const noexcept { return end_ - data_; }
+
+  inline const char* position() const noexcept { return data_; }
+
+protected:
+
+  const char* data_;
+  const char* end_;
+};
+
+/**
+ * @brief The StreamReader class. Decodes from a std::istream
+ * or a file descriptor through a fixed-size buffer.
+ * Throws a PropertyException on truncated inputs.
+ */
+class StreamReader
+{
+public:
+
+  explicit StreamReader(std::istream& is,
+                        const std::size_t buffer_size = default_stream_buffer_size);
+
+  explicit StreamReader(const int fd,
+                        const std::size_t buffer_size = default_stream_buffer_size);
+
+  StreamReader(const StreamReader&)            = delete;
+  StreamReader& operator=(const StreamReader&) = delete;
+
+  void read(void* out, std::size_t size);
+
+  /**
+   * @brief read_bytes. Read 'size' bytes in 'out'.
+   * 'out' grows as bytes are actually read so that
+   * a corrupted size does not allocate up front.
+   */
+  void read_bytes(std::string& out, const std::uint64_t size);
+
+  std::uint64_t read_varint();
+
+  template <typename T>
+  T read_scalar()
+  {
+    static_assert(has_fixed_width<T>::value, "T is not of fixed width.");
+
+    T t;
+    read(&t, sizeof(T));
+
+    if (!details::native_little_endian()) details::byte_swap(t);
+
+    return t;
+  }
+
+  inline void read_string(std::string& s) { read_bytes(s, read_varint()); }
+
+  /**
+   * @brief position. Number of bytes read so far.
+   */
+  inline std::size_t position() const noexcept { return consumed_ + begin_; }
+
+protected:
+
+  /**
+   * @brief fill. Refill the buffer.
+   * @return false at the end of the input.
+   */
+  bool fill();
+
+  std::istream* is_ = nullptr;
+  int fd_ = -1;
+
+  std::vector<char> buffer_;
+  std::size_t begin_    = 0;
+  std::size_t end_      = 0;
+  std::size_t consumed_ = 0;
+};
+
+/**
+ * @brief The Codec struct. How a T is encoded,
+ * specialized for each supported type with
+ *
+ *   template <class W> static void encode(W&, const T&);
+ *   static void decode(Reader&, T&);
+ */
+template <typename T, typename Enable = void>
+struct Codec;
+
+template <typename T>
+struct Codec<T, typename std::enable_if<has_fixed_width<T>::value>::type>
+{
+  template <class W>
+  static void encode(W& w, const T& t) { w.write_scalar(t); }
+
+  static void decode(Reader& r, T& t) { t = r.template read_scalar<T>(); }
+};
+
+template <>
+struct Codec<std::string>
+{
+  template <class W>
+  static void encode(W& w, const std::string& s) { w.write_string(s); }
+
+  static void decode(Reader& r, std::string& s) { r.read_string(s); }
+};
+
+template <typename T, typename Alloc>
+struct Codec<std::vector<T, Alloc>>
+{
+  template <class W>
+  static void encode(W& w, const std::vector<T, Alloc>& v)
+  {
+    w.write_varint(v.size());
+    encode(w, v, has_block<T>());
+  }
+
+  static void decode(Reader& r, std::vector<T, Alloc>& v)
+  {
+    const std::uint64_t size = r.read_varint();
+    decode(r, v, size, has_block<T>());
+  }
+
+protected:
+
+  template <typename U>
+  using has_block = std::integral_constant<bool,
+    has_fixed_width<U>::value && !std::is_same<U, bool>::value>;
+
+  template <class W>
+  static void encode(W& w, const std::vector<T, Alloc>& v, std::true_type)
+  {
+    w.write_block(v.data(), v.size());
+  }
+
+  template <class W>
+  static void encode(W& w, const std::vector<T, Alloc>& v, std::false_type)
+  {
+    for (const T& e : v) Codec<T>::encode(w, e);
+  }
+
+  static void decode(Reader& r, std::vector<T, Alloc>& v,
+                     const std::uint64_t size, std::true_type)
+  {
+    r.check_count(size, sizeof(T));
+    v.resize(size);
+    r.read_block(v.data(), size);
+  }
+
+  static void decode(Reader& r, std::vector<T, Alloc>& v,
+                     const std::uint64_t size, std::false_type)
+  {
+    // Every element takes at least a byte
+    r.check_count(size, 1);
+
+    v.clear();
+    v.reserve(size);
+
+    for (std::uint64_t i=0; i<size; ++i)
+    {
+      T e;
+      Codec<T>::decode(r, e);
+      v.push_back(std::move(e));
+    }
+  }
+};
+
+/**
+ * @brief scalar_id. Identifies an arithmetic type
+ * by its category and size.
+ */
+template <typename T>
+constexpr std::uint8_t scalar_id() noexcept
+{
+  return (std::is_same<T, bool>::value          ? 0x30 :
+          std::is_floating_point<T>::value      ? 0x20 :
+          std::is_signed<T>::value              ? 0x10 : 0x00) | sizeof(T);
+}
+
+/**
+ * @brief The RawView struct. A contiguous block of
+ * rows*cols arithmetic values, as laid out in memory.
+ */
+struct RawView
+{
+  std::uint8_t  scalar;
+  std::uint64_t rows;
+  std::uint64_t cols;
+  const void*   data;
+
+  inline std::size_t num_bytes() const noexcept
+  {
+    return rows * cols * (scalar & 0x0f);
+  }
+};
+
+/**
+ * @brief The RawLayout struct. Whether a T is a single
+ * block of arithmetic values, specialized with
+ *
+ *   static RawView view(const T&);
+ *   static void load(const RawView&, T&);
+ *
+ * Such values can be read in place from a mapped file.
+ */
+template <typename T, typename Enable = void>
+struct RawLayout : std::false_type { };
+
+template <typename T>
+struct RawLayout<T, typename std::enable_if<has_fixed_width<T>::value>::type>
+    : std::true_type
+{
+  static RawView view(const T& t)
+  {
+    return RawView{scalar_id<T>(), 1, 1, &t};
+  }
+
+  static void load(const RawView& v, T& t)
+  {
+    std::memcpy(&t, v.data, sizeof(T));
+  }
+};
+
+template <typename T, typename Alloc>
+struct RawLayout<std::vector<T, Alloc>, typename std::enable_if<
+    has_fixed_width<T>::value && !std::is_same<T, bool>::value>::type>
+    : std::true_type
+{
+  static RawView view(const std::vector<T, Alloc>& v)
+  {
+    return RawView{scalar_id<T>(), v.size(), 1, v.data()};
+  }
+
+  static void load(const RawView& r, std::vector<T, Alloc>& v)
+  {
+    const T* data = static_cast<const T*>(r.data);
+    v.assign(data, data + r.rows*r.cols);
+  }
+};
+
+/**
+ * @brief The TypeCodec struct.
+ * Type-erased codec of a registered type.
+ */
+struct TypeCodec
+{
+  std::string name;
+
+  const std::type_info* type;
+
+  void (*encode)(Writer&, const Property&);
+
+  void (*stream)(StreamWriter&, const Property&);
+
+  void (*place)(BufferWriter&, const Property&);
+
+  // Counts the bytes of the value
+  void (*size)(SizeCounter&, const Property&);
+
+  void (*decode)(Reader&, Property&);
+
+  // Leaves 'size' bytes of the buffer to be decoded on first access
+  void (*defer)(const Buffer&, const char*, std::size_t, Property&);
+
+  // Only set if the type has a RawLayout
+  RawView (*raw_view)(const Property&);
+
+  void (*decode_raw)(const RawView&, Property&);
+};
+
+/**
+ * @brief The Registry class.
+ * Process-wide table of the types that can be
+ * written in the wire format. Thread-safe.
+ *
+ * Types exported with EXPORT_PROPERTY_WIRE_TYPE are only
+ * queued during static initialization, their codecs are
+ * made on the first use of the registry.
+ */
+class Registry : public details::LazyRegistry<TypeCodec, &TypeCodec::name>
+{
+public:
+
+  static Registry& instance();
+
+  using LazyRegistry::add;
+
+  template <typename T>
+  bool add(const std::string& name);
+
+  /**
+   * @brief codec. The codec of T under a given name.
+   */
+  template <typename T>
+  static TypeCodec codec(const std::string& name);
+
+protected:
+
+  Registry() = default;
+};
+
+/**
+ * @brief The Registrar struct.
+ * Queues the registration of T at construction,
+ * see EXPORT_PROPERTY_WIRE_TYPE.
+ */
+template <typename T>
+struct Registrar
+{
+  explicit Registrar(const char* name) noexcept :
+    pending_{name, &Registry::codec<T>, nullptr}
+  {
+    Registry::defer(pending_);
+  }
+
+  mutable Registry::Pending pending_;
+};
+
+inline void encode_value(Writer& w, const TypeCodec& codec, const Property& p)
+{
+  codec.encode(w, p);
+}
+
+inline void encode_value(StreamWriter& w, const TypeCodec& codec, const Property& p)
+{
+  codec.stream(w, p);
+}
+
+inline void encode_value(BufferWriter& w, const TypeCodec& codec, const Property& p)
+{
+  codec.place(w, p);
+}
+
+inline void encode_value(SizeCounter& w, const TypeCodec& codec, const Property& p)
+{
+  codec.size(w, p);
+}
+
+/**
+ * @brief value_size. Number of bytes of the value of 'p'.
+ */
+inline std::size_t value_size(const TypeCodec& codec, const Property& p)
+{
+  SizeCounter counter;
+  codec.size(counter, p);
+  return counter.size();
+}
+
+} /* namespace wire */
+
+namespace details {
+
+template <typename T>
+struct PlaceHolderImpl<T>::wire_accessor
+{
+  static void decode(const char* data, std::size_t size, PlaceHolder& holder)
+  {
+    wire::Reader r(data, size);
+    wire::Codec<T>::decode(r, static_cast<PlaceHolderImpl<T>&>(holder).value_);
+
+    if (r.remaining() != 0)
+      throw PropertyException(std::string("Wire format: deferred ") +
+                              property_bag::name_of<T>() + " not fully decoded.");
+  }
+};
+
+struct Any::wire_accessor
+{
+  static void reset(Any& any, PlaceHolderPtr holder) noexcept
+  {
+    any.placeholder_ = std::move(holder);
+  }
+};
+
+} /* namespace details */
+
+struct Property::wire_accessor
+{
+  template <typename T>
+  static const T& value(const Property& p)
+  {
+    const T* value = p.get_if<T>();
+
+    if (value == nullptr)
+      throw PropertyException(std::string("Could not decode deferred ") +
+                              property_bag::name_of<T>());
+
+    return *value;
+  }
+
+  template <typename T, class W>
+  static void encode_value(W& w, const Property& p)
+  {
+    wire::Codec<T>::encode(w, value<T>(p));
+  }
+
+  template <typename T>
+  static void value_size(wire::SizeCounter& counter, const Property& p)
+  {
+    wire::Codec<T>::encode(counter, value<T>(p));
+  }
+
+  template <typename T>
+  static void decode_value(wire::Reader& r, Property& p)
+  {
+    T value;
+    wire::Codec<T>::decode(r, value);
+    p.set_holder(std::move(value));
+  }
+
+  template <typename T>
+  static void defer_value(const wire::Buffer& buffer, const char* data,
+                          std::size_t size, Property& p)
+  {
+    auto holder = make_ptr<details::PlaceHolderImpl<T>>();
+    holder->defer(&details::PlaceHolderImpl<T>::wire_accessor::decode, buffer, data, size);
+    details::Any::wire_accessor::reset(p.holder_, std::move(holder));
+  }
+
+  template <typename T>
+  static wire::RawView raw_view(const Property& p)
+  {
+    return wire::RawLayout<T>::view(value<T>(p));
+  }
+
+  template <typename T>
+  static void decode_raw(const wire::RawView& v, Property& p)
+  {
+    T value;
+    wire::RawLayout<T>::load(v, value);
+    p.set_holder(std::move(value));
+  }
+
+  static std::uint8_t flags(const Property& p) noexcept
+  {
+    return static_cast<std::uint8_t>(p.flags_.to_ulong());
+  }
+
+  static void set_flags(Property& p, const std::uint8_t flags) noexcept
+  {
+    p.flags_ = flags;
+  }
+
+  /**
+   * @brief encode. The size of the value is taken from the
+   * writer if recorded, see BasicWriter::use_value_sizes,
+   * counted otherwise.
+   */
+  template <class W>
+  static void encode(W& w, const Property& p, const wire::TypeCodec& codec)
+  {
+    w.write_scalar(flags(p));
+    w.write_string(p.description_);
+
+    std::size_t size;
+    if (!w.next_value_size(size)) size = wire::value_size(codec, p);
+
+    w.write_varint(size);
+    wire::encode_value(w, codec, p);
+  }
+
+  /**
+   * @brief encode. Count a property, its value
+   * once, recording its size if the counter does.
+   */
+  static void encode(wire::SizeCounter& w, const Property& p, const wire::TypeCodec& codec)
+  {
+    w.write_scalar(flags(p));
+    w.write_string(p.description_);
+
+    const std::size_t record = w.open_value();
+
+    wire::SizeCounter value = w.nested();
+    wire::encode_value(value, codec, p);
+
+    w.close_value(record, value.size());
+
+    w.write_varint(value.size());
+    w.write(nullptr, value.size());
+  }
+
+  /**
+   * @brief encode. Write a property whose value
+   * has already been encoded in 'value'.
+   */
+  template <class W>
+  static void encode(W& w, const Property& p, const std::string& value)
+  {
+    w.write_scalar(flags(p));
+    w.write_string(p.description_);
+    w.write_string(value);
+  }
+
+  /**
+   * @brief read_value. Read a property up to its value.
+   * @return a reader over the bytes of the value.
+   */
+  static wire::Reader read_value(wire::Reader& r, Property& p)
+  {
+    set_flags(p, r.read_scalar<std::uint8_t>());
+    r.read_string(p.description_);
+
+    const std::uint64_t size = r.read_varint();
+    r.check_count(size, 1);
+
+    return wire::Reader(r.skip(size), size);
+  }
+
+  /**
+   * @brief decode. If 'buffer' is set, 'r' reads it and
+   * the value is only decoded on its first access.
+   */
+  static void decode(wire::Reader& r, Property& p, const wire::TypeCodec& codec,
+                     const wire::Buffer& buffer = wire::Buffer())
+  {
+    wire::Reader value = read_value(r, p);
+
+    if (!empty(buffer))
+    {
+      codec.defer(buffer, value.position(), value.remaining(), p);
+      return;
+    }
+
+    decode_value(value, p, codec);
+  }
+
+  /**
+   * @brief decode. Read a property from a stream,
+   * its value being read in 'scratch' first.
+   */
+  static void decode(wire::StreamReader& r, Property& p, const wire::TypeCodec& codec,
+                     std::string& scratch)
+  {
+    set_flags(p, r.read_scalar<std::uint8_t>());
+    r.read_string(p.description_);
+    r.read_bytes(scratch, r.read_varint());
+
+    wire::Reader value(scratch.data(), scratch.size());
+    decode_value(value, p, codec);
+  }
+
+  static void decode_value(wire::Reader& value, Property& p, const wire::TypeCodec& codec)
+  {
+    codec.decode(value, p);
+
+    if (value.remaining() != 0)
+      throw PropertyException("Wire format: value of type '" +
+                              codec.name + "' not fully decoded.");
+  }
+};
+
+template <typename KeyType>
+struct AbstractPropertyBag<KeyType>::wire_accessor
+{
+  /**
+   * @brief type_table. The codecs of the types held by a bag
+   * and, for each of its properties, the index of its codec.
+   */
+  static void type_table(const AbstractPropertyBag& bag,
+                         std::vector<const wire::TypeCodec*>& types,
+                         std::vector<std::size_t>& type_indices)
+  {
+    type_indices.reserve(bag.size());
+
+    const wire::Registry& registry = wire::Registry::instance();
+
+    for (const auto& property : bag)
+    {
+      const wire::TypeCodec* codec = registry.find(property.second.type());
+
+      if (codec == nullptr)
+      {
+        std::stringstream ss;
+        ss << "Property '" << property.first << "' of type "
+           << property.second.type_name()
+           << " is not exported to the wire format.";
+        throw PropertyException(ss.str());
+      }
+
+      const auto it = std::find(types.begin(), types.end(), codec);
+      type_indices.push_back(it - types.begin());
+
+      if (it == types.end()) types.push_back(codec);
+    }
+  }
+
+  template <class W>
+  static void encode_header(W& w, const AbstractPropertyBag& bag,
+                            const std::vector<const wire::TypeCodec*>& types)
+  {
+    wire::Codec<KeyType>::encode(w, bag.name_);
+    w.write_varint(static_cast<std::size_t>(bag.default_handling_));
+
+    w.write_varint(types.size());
+    for (const wire::TypeCodec* codec : types)
+      w.write_string(codec->name);
+
+    w.write_varint(bag.size());
+  }
+
+  template <class W>
+  static void encode(W& w, const AbstractPropertyBag& bag)
+  {
+    std::vector<const wire::TypeCodec*> types;
+    std::vector<std::size_t> type_indices;
+    type_table(bag, types, type_indices);
+
+    encode_header(w, bag, types);
+
+    std::size_t i = 0;
+    for (const auto& property : bag)
+    {
+      const std::size_t type_index = type_indices[i++];
+
+      wire::Codec<KeyType>::encode(w, property.first);
+      w.write_varint(type_index);
+      Property::wire_accessor::encode(w, property.second, *types[type_index]);
+    }
+  }
+
+  /**
+   * @brief encode_parallel. Write the bytes of encode(),
+   * each value being first encoded in its own buffer
+   * by one of 'num_threads' threads.
+   */
+  static void encode_parallel(wire::Writer& w, const AbstractPropertyBag& bag,
+                              const std::size_t num_threads)
+  {
+    std::vector<const wire::TypeCodec*> types;
+    std::vector<std::size_t> type_indices;
+    type_table(bag, types, type_indices);
+
+    std::vector<const typename PropertyMap::value_type*> properties;
+    properties.reserve(bag.size());
+
+    for (const auto& property : bag)
+      properties.push_back(&property);
+
+    std::vector<std::string> values(properties.size());
+
+    // A value is counted once, the sizes of
+    // its nested values being recorded for its writer
+    wire::parallel_for(properties.size(), num_threads,
+      [&](const std::size_t i)
+      {
+        const wire::TypeCodec& codec = *types[type_indices[i]];
+
+        std::vector<std::size_t> sizes;
+        wire::SizeCounter counter(&sizes);
+        wire::encode_value(counter, codec, properties[i]->second);
+
+        wire::Writer value;
+        value.reserve(counter.size());
+        value.use_value_sizes(&sizes);
+        wire::encode_value(value, codec, properties[i]->second);
+        values[i] = value.release();
+      });
+
+    wire::SizeCounter counter;
+    encode_properties(counter, bag, types, type_indices, properties, values);
+
+    w.reserve(w.size() + counter.size());
+
+    encode_properties(w, bag, types, type_indices, properties, values);
+  }
+
+  /**
+   * @brief encode_properties. Write a bag
+   * whose values are encoded in 'values'.
+   */
+  template <class W>
+  static void encode_properties(W& w, const AbstractPropertyBag& bag,
+                                const std::vector<const wire::TypeCodec*>& types,
+                                const std::vector<std::size_t>& type_indices,
+                                const std::vector<const typename PropertyMap::value_type*>& properties,
+                                const std::vector<std::string>& values)
+  {
+    encode_header(w, bag, types);
+
+    for (std::size_t i=0; i<properties.size(); ++i)
+    {
+      wire::Codec<KeyType>::encode(w, properties[i]->first);
+      w.write_varint(type_indices[i]);
+      Property::wire_accessor::encode(w, properties[i]->second, values[i]);
+    }
+  }
+
+  /**
+   * @brief decode_header. Read the name, the retrieval
+   * handling and the type table of a bag.
+   * @return the number of properties of the bag.
+   */
+  static std::uint64_t decode_header(wire::Reader& r, AbstractPropertyBag& bag,
+                                     std::vector<std::string>& type_names,
+                                     std::vector<const wire::TypeCodec*>& types)
+  {
+    wire::Codec<KeyType>::decode(r, bag.name_);
+
+    const std::uint64_t handling = r.read_varint();
+    if (handling > static_cast<std::size_t>(RetrievalHandling::THROW))
+      throw PropertyException("Wire format: unknown retrieval handling.");
+
+    bag.default_handling_ = static_cast<RetrievalHandling>(handling);
+
+    const wire::Registry& registry = wire::Registry::instance();
+
+    const std::uint64_t num_types = r.read_varint();
+    r.check_count(num_types, 1);
+
+    type_names.resize(num_types);
+    types.resize(num_types);
+
+    for (std::size_t i=0; i<num_types; ++i)
+    {
+      r.read_string(type_names[i]);
+      types[i] = registry.find(type_names[i]);
+    }
+
+    const std::uint64_t num_properties = r.read_varint();
+    r.check_count(num_properties, 1);
+
+    return num_properties;
+  }
+
+  static const wire::TypeCodec& type_at(const std::uint64_t type_index,
+                                        const std::vector<std::string>& type_names,
+                                        const std::vector<const wire::TypeCodec*>& types)
+  {
+    if (type_index >= types.size())
+      throw PropertyException("Wire format: type index out of range.");
+
+    if (types[type_index] == nullptr)
+      throw PropertyException("Wire format: type '" + type_names[type_index] +
+                              "' is not exported to the wire format.");
+
+    return *types[type_index];
+  }
+
+  /**
+   * @brief decode. 'bag' is left untouched on error.
+   */
+  static void decode(wire::Reader& r, AbstractPropertyBag& bag,
+                     const wire::Buffer& buffer = wire::Buffer())
+  {
+    AbstractPropertyBag loaded;
+
+    std::vector<std::string> type_names;
+    std::vector<const wire::TypeCodec*> types;
+
+    const std::uint64_t num_properties = decode_header(r, loaded, type_names, types);
+
+    for (std::uint64_t i=0; i<num_properties; ++i)
+    {
+      KeyType name;
+      wire::Codec<KeyType>::decode(r, name);
+
+      const wire::TypeCodec& codec = type_at(r.read_varint(), type_names, types);
+
+      Property property;
+      Property::wire_accessor::decode(r, property, codec, buffer);
+
+      insert(loaded, name, std::move(property));
+    }
+
+    commit(loaded, bag);
+  }
+
+  /**
+   * @brief decode_parallel. Locate every value with a first
+   * pass that only reads their sizes, then decode them on
+   * 'num_threads' threads. 'bag' is left untouched on error.
+   */
+  static void decode_parallel(wire::Reader& r, AbstractPropertyBag& bag,
+                              const std::size_t num_threads)
+  {
+    struct Entry
+    {
+      KeyType                name;
+      Property               property;
+      const wire::TypeCodec* codec;
+      wire::Reader           value;
+    };
+
+    AbstractPropertyBag loaded;
+
+    std::vector<std::string> type_names;
+    std::vector<const wire::TypeCodec*> types;
+
+    const std::uint64_t num_properties = decode_header(r, loaded, type_names, types);
+
+    std::vector<Entry> entries;
+    entries.reserve(num_properties);
+
+    for (std::uint64_t i=0; i<num_properties; ++i)
+    {
+      KeyType name;
+      wire::Codec<KeyType>::decode(r, name);
+
+      const wire::TypeCodec& codec = type_at(r.read_varint(), type_names, types);
+
+      Property property;
+      const wire::Reader value = Property::wire_accessor::read_value(r, property);
+
+      entries.push_back(Entry{std::move(name), std::move(property), &codec, value});
+    }
+
+    wire::parallel_for(entries.size(), num_threads,
+      [&entries](const std::size_t i)
+      {
+        Entry& entry = entries[i];
+        Property::wire_accessor::decode_value(entry.value, entry.property, *entry.codec);
+      });
+
+    // Written in order
+    for (Entry& entry : entries)
+      loaded.properties_.emplace_hint(loaded.properties_.end(),
+                                      std::move(entry.name), std::move(entry.property));
+
+    commit(loaded, bag);
+  }
+
+  /**
+   * @brief commit. Replace the content of 'bag'
+   * with a fully decoded bag, leaving real-time mode.
+   */
+  static void commit(AbstractPropertyBag& loaded, AbstractPropertyBag& bag) noexcept
+  {
+    bag.properties_.swap(loaded.properties_);
+    bag.name_             = std::move(loaded.name_);
+    bag.default_handling_ = loaded.default_handling_;
+    bag.realtime_         = false;
+  }
+
+  /**
+   * @brief insert. Add a freshly decoded property, already
+   * newer than any checkpoint, or replace the existing one.
+   */
+  static void insert(AbstractPropertyBag& bag, const KeyType& name, Property&& property)
+  {
+    auto it = bag.properties_.lower_bound(name);
+
+    if (it != bag.properties_.end() && !bag.properties_.key_comp()(name, it->first))
+      it->second = std::move(property);
+    else
+      bag.properties_.emplace_hint(it, name, std::move(property));
+  }
+};
+
+namespace wire {
+
+template <typename T>
+void set_raw(TypeCodec& codec, std::true_type /*has_raw_layout*/)
+{
+  codec.raw_view   = &Property::wire_accessor::raw_view<T>;
+  codec.decode_raw = &Property::wire_accessor::decode_raw<T>;
+}
+
+template <typename T>
+void set_raw(TypeCodec& /*codec*/, std::false_type /*has_raw_layout*/) { }
+
+template <typename T>
+TypeCodec Registry::codec(const std::string& name)
+{
+  TypeCodec codec{name, &typeid(T),
+                  &Property::wire_accessor::encode_value<T, Writer>,
+                  &Property::wire_accessor::encode_value<T, StreamWriter>,
+                  &Property::wire_accessor::encode_value<T, BufferWriter>,
+                  &Property::wire_accessor::value_size<T>,
+                  &Property::wire_accessor::decode_value<T>,
+                  &Property::wire_accessor::defer_value<T>,
+                  nullptr, nullptr};
+
+  set_raw<T>(codec, RawLayout<T>());
+
+  return codec;
+}
+
+template <typename T>
+bool Registry::add(const std::string& name)
+{
+  return add(codec<T>(name));
+}
+
+template <typename KeyType>
+struct Codec<AbstractPropertyBag<KeyType>>
+{
+  template <class W>
+  static void encode(W& w, const AbstractPropertyBag<KeyType>& bag)
+  {
+    AbstractPropertyBag<KeyType>::wire_accessor::encode(w, bag);
+  }
+
+  static void decode(Reader& r, AbstractPropertyBag<KeyType>& bag)
+  {
+    AbstractPropertyBag<KeyType>::wire_accessor::decode(r, bag);
+  }
+};
+
+} /* namespace wire */
+
+namespace wire {
+
+/**
+ * @brief measure. Size of a bag in the wire format, recording
+ * the size of each of its values, nested ones included, in
+ * 'sizes' if not null, for the writers to use them.
+ */
+template <typename KeyType>
+std::size_t measure(const AbstractPropertyBag<KeyType>& bag, std::vector<std::size_t>* sizes)
+{
+  SizeCounter counter(sizes);
+  counter.write(magic, sizeof(magic));
+  counter.write_scalar(format_version);
+  Codec<AbstractPropertyBag<KeyType>>::encode(counter, bag);
+  return counter.size();
+}
+
+} /* namespace wire */
+
+/**
+ * @brief wire_size. Size of a bag in the wire format.
+ */
+template <typename KeyType>
+std::size_t wire_size(const AbstractPropertyBag<KeyType>& bag)
+{
+  return wire::measure(bag, nullptr);
+}
+
+/**
+ * @brief to_wire. Serialize a bag in the wire format.
+ * Every held type must have been exported
+ * with EXPORT_PROPERTY_WIRE_TYPE.
+ */
+template <typename KeyType>
+std::string to_wire(const AbstractPropertyBag<KeyType>& bag)
+{
+  std::vector<std::size_t> sizes;
+
+  wire::Writer writer;
+  writer.reserve(wire::measure(bag, &sizes));
+  writer.use_value_sizes(&sizes);
+
+  writer.write(wire::magic, sizeof(wire::magic));
+  writer.write_scalar(wire::format_version);
+  wire::Codec<AbstractPropertyBag<KeyType>>::encode(writer, bag);
+
+  return writer.release();
+}
+
+/**
+ * @brief to_wire. Serialize a bag in the wire format in
+ * 'data', of at least wire_size(bag) bytes.
+ * Throws a PropertyException if 'size' is too small.
+ * @return the number of bytes written.
+ */
+template <typename KeyType>
+std::size_t to_wire(const AbstractPropertyBag<KeyType>& bag, char* data, const std::size_t size)
+{
+  std::vector<std::size_t> sizes;
+  wire::measure(bag, &sizes);
+
+  wire::BufferWriter writer(data, size);
+  writer.use_value_sizes(&sizes);
+
+  writer.write(wire::magic, sizeof(wire::magic));
+  writer.write_scalar(wire::format_version);
+  wire::Codec<AbstractPropertyBag<KeyType>>::encode(writer, bag);
+
+  return writer.size();
+}
+
+/**
+ * @brief to_wire_parallel. Serialize a bag in the wire format,
+ * its values being encoded concurrently on 'num_threads'
+ * threads, 0 for as many as the hardware runs.
+ * The output is the one of to_wire() whatever
+ * the number of threads.
+ * @note Only the properties of 'bag' are distributed,
+ * a nested bag is encoded by a single thread.
+ */
+template <typename KeyType>
+std::string to_wire_parallel(const AbstractPropertyBag<KeyType>& bag,
+                             const std::size_t num_threads = 0)
+{
+  wire::Writer writer;
+
+  writer.write(wire::magic, sizeof(wire::magic));
+  writer.write_scalar(wire::format_version);
+  AbstractPropertyBag<KeyType>::wire_accessor::encode_parallel(writer, bag, num_threads);
+
+  return writer.release();
+}
+
+namespace wire {
+
+template <class R>
+void read_signature(R& reader)
+{
+  char magic[sizeof(wire::magic)];
+  reader.read(magic, sizeof(magic));
+
+  if (std::memcmp(magic, wire::magic, sizeof(magic)) != 0)
+    throw PropertyException("Wire format: invalid signature.");
+
+  const std::uint8_t version = reader.template read_scalar<std::uint8_t>();
+
+  if (version > format_version)
+    throw PropertyException("Wire format: unsupported version " +
+                            std::to_string(version) + ".");
+}
+
+template <typename KeyType>
+void load(Reader& reader, AbstractPropertyBag<KeyType>& bag, const Buffer& buffer)
+{
+  read_signature(reader);
+
+  AbstractPropertyBag<KeyType>::wire_accessor::decode(reader, bag, buffer);
+}
+
+inline void read_key(StreamReader& r, std::string& key)
+{
+  r.read_string(key);
+}
+
+template <typename KeyType>
+typename std::enable_if<has_fixed_width<KeyType>::value>::type
+read_key(StreamReader& r, KeyType& key)
+{
+  key = r.read_scalar<KeyType>();
+}
+
+/**
+ * @brief The BagInfo struct. What a streamed bag
+ * holds besides its properties.
+ */
+template <typename KeyType>
+struct BagInfo
+{
+  KeyType           name;
+  RetrievalHandling handling;
+  std::uint64_t     size;
+};
+
+/**
+ * @brief visit. Read a bag from a stream and call
+ * callback(const KeyType&, Property&&) for each of its
+ * properties, in order. Only one property is held at a time.
+ * Throws a PropertyException if the input is malformed.
+ */
+template <typename KeyType, typename Callback>
+BagInfo<KeyType> visit(StreamReader& r, Callback&& callback)
+{
+  read_signature(r);
+
+  BagInfo<KeyType> info;
+
+  read_key(r, info.name);
+
+  const std::uint64_t handling = r.read_varint();
+  if (handling > static_cast<std::size_t>(RetrievalHandling::THROW))
+    throw PropertyException("Wire format: unknown retrieval handling.");
+
+  info.handling = static_cast<RetrievalHandling>(handling);
+
+  const Registry& registry = Registry::instance();
+
+  const std::uint64_t num_types = r.read_varint();
+
+  std::vector<std::string> type_names;
+  std::vector<const TypeCodec*> types;
+
+  for (std::uint64_t i=0; i<num_types; ++i)
+  {
+    type_names.emplace_back();
+    r.read_string(type_names.back());
+    types.push_back(registry.find(type_names.back()));
+  }
+
+  info.size = r.read_varint();
+
+  // Reused by every value
+  std::string scratch;
+
+  for (std::uint64_t i=0; i<info.size; ++i)
+  {
+    KeyType name;
+    read_key(r, name);
+
+    const std::uint64_t type_index = r.read_varint();
+
+    if (type_index >= num_types)
+      throw PropertyException("Wire format: type index out of range.");
+
+    if (types[type_index] == nullptr)
+      throw PropertyException("Wire format: type '" + type_names[type_index] +
+                              "' is not exported to the wire format.");
+
+    Property property;
+    Property::wire_accessor::decode(r, property, *types[type_index], scratch);
+
+    callback(static_cast<const KeyType&>(name), std::move(property));
+  }
+
+  return info;
+}
+
+template <typename KeyType>
+void save(StreamWriter& writer, const AbstractPropertyBag<KeyType>& bag)
+{
+  std::vector<std::size_t> sizes;
+  measure(bag, &sizes);
+  writer.use_value_sizes(&sizes);
+
+  writer.write(wire::magic, sizeof(wire::magic));
+  writer.write_scalar(wire::format_version);
+  Codec<AbstractPropertyBag<KeyType>>::encode(writer, bag);
+  writer.flush();
+}
+
+template <typename KeyType>
+void load(StreamReader& reader, AbstractPropertyBag<KeyType>& bag)
+{
+  AbstractPropertyBag<KeyType> loaded;
+
+  const BagInfo<KeyType> info = visit<KeyType>(reader,
+    [&loaded](const KeyType& name, Property&& property)
+    {
+      AbstractPropertyBag<KeyType>::wire_accessor::insert(loaded, name, std::move(property));
+    });
+
+  loaded.setRetrievalHandling(info.handling);
+
+  bag = std::move(loaded);
+
+  // Not carried by the assignment
+  bag.name(info.name);
+}
+
+} /* namespace wire */
+
+/**
+ * @brief from_wire. Deserialize a bag from the wire format.
+ * Throws a PropertyException if the input is malformed,
+ * leaving 'bag' untouched.
+ *
+ * With LoadMode::LAZY, the bag structure is read but each
+ * value keeps its bytes and is decoded on its first access,
+ * once, whichever thread accesses it. The input is then
+ * copied, and held until every value is decoded.
+ * A malformed value is only reported on its access,
+ * get<T>() throws and get_if<T>() returns nullptr.
+ */
+template <typename KeyType>
+void from_wire(std::string&& bytes, AbstractPropertyBag<KeyType>& bag,
+               const wire::LoadMode mode = wire::LoadMode::EAGER)
+{
+  wire::Buffer buffer;
+
+  if (mode == wire::LoadMode::LAZY)
+    buffer = make_ptr<const std::string>(std::move(bytes));
+
+  const std::string& input = empty(buffer)? bytes : *buffer;
+
+  wire::Reader reader(input.data(), input.size());
+  wire::load(reader, bag, buffer);
+}
+
+template <typename KeyType>
+void from_wire(const char* data, const std::size_t size,
+               AbstractPropertyBag<KeyType>& bag,
+               const wire::LoadMode mode = wire::LoadMode::EAGER)
+{
+  if (mode == wire::LoadMode::LAZY)
+  {
+    from_wire(std::string(data, size), bag, mode);
+    return;
+  }
+
+  wire::Reader reader(data, size);
+  wire::load(reader, bag, wire::Buffer());
+}
+
+template <typename KeyType>
+void from_wire(const std::string& bytes, AbstractPropertyBag<KeyType>& bag,
+               const wire::LoadMode mode = wire::LoadMode::EAGER)
+{
+  from_wire(bytes.data(), bytes.size(), bag, mode);
+}
+
+/**
+ * @brief from_wire_parallel. Deserialize a bag from the wire
+ * format, its values being decoded concurrently on
+ * 'num_threads' threads, 0 for as many as the hardware runs.
+ * 'bag' is left untouched if the input is malformed.
+ */
+template <typename KeyType>
+void from_wire_parallel(const char* data, const std::size_t size,
+                        AbstractPropertyBag<KeyType>& bag,
+                        const std::size_t num_threads = 0)
+{
+  wire::Reader reader(data, size);
+  wire::read_signature(reader);
+
+  AbstractPropertyBag<KeyType>::wire_accessor::decode_parallel(reader, bag, num_threads);
+}
+
+template <typename KeyType>
+void from_wire_parallel(const std::string& bytes, AbstractPropertyBag<KeyType>& bag,
+                        const std::size_t num_threads = 0)
+{
+  from_wire_parallel(bytes.data(), bytes.size(), bag, num_threads);
+}
+
+/**
+ * @brief to_wire. Stream a bag in the wire format
+ * through a fixed-size buffer, nested bags and large
+ * values included, without encoding it in memory first.
+ * Throws a PropertyException if the output fails.
+ */
+template <typename KeyType>
+void to_wire(const AbstractPropertyBag<KeyType>& bag, std::ostream& os)
+{
+  wire::StreamWriter writer(os);
+  wire::save(writer, bag);
+}
+
+template <typename KeyType>
+void to_wire(const AbstractPropertyBag<KeyType>& bag, const int fd)
+{
+  wire::StreamWriter writer(fd);
+  wire::save(writer, bag);
+}
+
+/**
+ * @brief from_wire. Read a bag streamed in the wire format.
+ * 'bag' is left untouched if the input is malformed.
+ */
+template <typename KeyType>
+void from_wire(std::istream& is, AbstractPropertyBag<KeyType>& bag)
+{
+  wire::StreamReader reader(is);
+  wire::load(reader, bag);
+}
+
+template <typename KeyType>
+void from_wire(const int fd, AbstractPropertyBag<KeyType>& bag)
+{
+  wire::StreamReader reader(fd);
+  wire::load(reader, bag);
+}
+
+/**
+ * @brief visit_wire. Process a bag streamed in the wire
+ * format one property at a time, without materialising it,
+ * see wire::visit.
+ */
+template <typename KeyType = std::string, typename Callback>
+wire::BagInfo<KeyType> visit_wire(std::istream& is, Callback&& callback)
+{
+  wire::StreamReader reader(is);
+  return wire::visit<KeyType>(reader, std::forward<Callback>(callback));
+}
+
+template <typename KeyType = std::string, typename Callback>
+wire::BagInfo<KeyType> visit_wire(const int fd, Callback&& callback)
+{
+  wire::StreamReader reader(fd);
+  return wire::visit<KeyType>(reader, std::forward<Callback>(callback));
+}
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_SERIALIZATION_WIRE_FORMAT_H */
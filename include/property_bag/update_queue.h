@@ -0,0 +1,162 @@
+/**
+ * \file update_queue.h
+ * \brief Single-producer/single-consumer queue of
+ * property updates to apply to a real-time owned bag.
+ */
+
+#ifndef PROPERTY_BAG_UPDATE_QUEUE_H
+#define PROPERTY_BAG_UPDATE_QUEUE_H
+
+#include "property_bag/property_bag.h"
+
+#include <atomic>
+#include <vector>
+
+namespace property_bag
+{
+
+/**
+ * @brief The AbstractUpdateQueue class.
+ * A lock-free, bounded, single-producer/single-consumer
+ * queue of property updates.
+ *
+ * The producer (e.g. a ROS callback) allocates the new
+ * values and moves them in the queue with push().
+ * The consumer (the real-time loop owning the bag) applies
+ * them with drain(), which swaps the queued values with the
+ * ones held by the bag: it neither allocates nor frees.
+ * The replaced values are destroyed by the producer
+ * when it reuses their slot.
+ *
+ * @note drain() replaces the held values, references
+ * obtained through Property::get<T>() no longer refer to
+ * the bag value afterwards.
+ */
+template <typename KeyType = std::string>
+class AbstractUpdateQueue
+{
+  struct Update
+  {
+    KeyType  name;
+    Property value;
+  };
+
+public:
+
+  /**
+   * @brief AbstractUpdateQueue
+   * @param capacity. Maximum number of pending updates.
+   * @param max_per_drain. Maximum number of updates
+   * applied by a single call to drain().
+   */
+  explicit AbstractUpdateQueue(const std::size_t capacity,
+                               const std::size_t max_per_drain = std::size_t(-1)) :
+    updates_(capacity),
+    max_per_drain_(max_per_drain) { }
+
+  ~AbstractUpdateQueue() = default;
+
+  AbstractUpdateQueue(const AbstractUpdateQueue&)            = delete;
+  AbstractUpdateQueue& operator=(const AbstractUpdateQueue&) = delete;
+
+  /**
+   * @brief push. Producer side, queue an update of property 'name'.
+   * @return false if the queue is full, the update is dropped.
+   */
+  template <typename T>
+  bool push(const KeyType& name, T&& value)
+  {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail - head_.load(std::memory_order_acquire) == updates_.size())
+    {
+      overflows_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    Update& update = updates_[tail % updates_.size()];
+
+    // Whatever the slot was holding is released here,
+    // on the producer thread.
+    update.name  = name;
+    update.value = Property(std::forward<T>(value));
+
+    tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  /**
+   * @brief drain. Consumer side, apply at most 'max_per_drain'
+   * pending updates to 'bag'. Never allocates nor throws.
+   * Updates of unknown properties or of mismatching
+   * types are dropped and counted in rejected().
+   * @return the number of updates consumed.
+   */
+  std::size_t drain(AbstractPropertyBag<KeyType>& bag) noexcept
+  {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+
+    const std::size_t count = std::min(tail - head, max_per_drain_);
+
+    for (std::size_t i=0; i<count; ++i)
+    {
+      Update& update = updates_[(head + i) % updates_.size()];
+
+      if (bag.trySwapPropertyValue(update.name, update.value) != ErrorCode::OK)
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    head_.store(head + count, std::memory_order_release);
+
+    return count;
+  }
+
+  /**
+   * @brief size. Number of pending updates.
+   * Only a snapshot if called concurrently.
+   */
+  inline std::size_t size() const noexcept
+  {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  inline bool empty() const noexcept { return size() == 0; }
+
+  inline std::size_t capacity() const noexcept { return updates_.size(); }
+
+  /**
+   * @brief overflows. Number of updates
+   * refused by push() as the queue was full.
+   */
+  inline std::size_t overflows() const noexcept
+  { return overflows_.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief rejected. Number of updates dropped by drain(),
+   * the property did not exist or was of another type.
+   */
+  inline std::size_t rejected() const noexcept
+  { return rejected_.load(std::memory_order_relaxed); }
+
+private:
+
+  std::vector<Update> updates_;
+
+  const std::size_t max_per_drain_;
+
+  // Monotonic counters, slot is index % capacity.
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+
+  std::atomic<std::size_t> overflows_{0};
+  std::atomic<std::size_t> rejected_{0};
+};
+
+using UpdateQueue = AbstractUpdateQueue<std::string>;
+
+} //namespace property_bag
+
+#endif //PROPERTY_BAG_UPDATE_QUEUE_H
@@ -2,7 +2,10 @@
 #define _PROPERTY_BAG_UTILS_H_
 
 #include <typeinfo>
-#include <map>
+#include <type_traits>
+#include <string>
+#include <vector>
+#include <ostream>
 
 #ifdef __GNUG__
 #include <cstdlib>
@@ -40,76 +43,246 @@ inline std::string demangle(const char* name) { return name; }
 } //namespace property_bag
 #endif
 
-namespace
+namespace property_bag
 {
-class TypeMapper
+namespace details
 {
-  // <mangled_type, demangled_type>
-  typedef std::map<std::string, std::string> TypeMap;
+/**
+ * @brief name_of. The demangled name of a type.
+ * Names are demangled once and stored in a single
+ * process-wide cache. Lookups of an already cached
+ * name are lock-free and thread-safe.
+ * @param ti. The type_info of the type.
+ * @return the demangled type name.
+ */
+const std::string& name_of(const std::type_info& ti);
+} // namespace details
 
+/**
+ * @brief The string_view class.
+ * A non-owning, constexpr friendly, view over a
+ * sequence of characters. Minimal subset of the
+ * c++17 std::string_view.
+ */
+class string_view
+{
 public:
 
-  TypeMapper()          = default;
-  virtual ~TypeMapper() = default;
+  using size_type      = std::size_t;
+  using const_iterator = const char*;
+
+  static constexpr size_type npos = size_type(-1);
+
+  constexpr string_view() noexcept :
+    data_(nullptr), size_(0) { }
+
+  constexpr string_view(const char* data, size_type size) noexcept :
+    data_(data), size_(size) { }
+
+  string_view(const char* str) noexcept :
+    data_(str), size_(std::char_traits<char>::length(str)) { }
 
-  TypeMapper(TypeMapper&)      = delete;
-  void operator=(TypeMapper&)  = delete;
+  string_view(const std::string& str) noexcept :
+    data_(str.data()), size_(str.size()) { }
 
-  const std::string& lookup(const std::type_info& ti)
+  constexpr const char* data() const noexcept { return data_; }
+  constexpr size_type   size() const noexcept { return size_; }
+  constexpr bool       empty() const noexcept { return size_ == 0; }
+
+  constexpr const_iterator begin() const noexcept { return data_; }
+  constexpr const_iterator end()   const noexcept { return data_ + size_; }
+
+  constexpr char operator[](size_type pos) const { return data_[pos]; }
+
+  constexpr string_view substr(size_type pos, size_type count = npos) const
   {
-    return lookup(ti.name());
+    return string_view(data_ + pos, (count < size_ - pos) ? count : size_ - pos);
   }
 
-protected:
-
-  const std::string& lookup(const std::string& mangled)
+  /**
+   * @brief rfind. Position of the last occurrence of 'str'.
+   * @return the position or npos if not found.
+   */
+  constexpr size_type rfind(string_view str) const noexcept
   {
-    std::string mangled_tmp(mangled);
+    return (str.size_ > size_) ? npos : rfind(str, size_ - str.size_);
+  }
 
-    if (mangled_tmp == typeid(mangled).name())
-      mangled_tmp = "std::string";
+  constexpr bool equal(string_view other) const noexcept
+  {
+    return size_ == other.size_ && equal(data_, other.data_, size_);
+  }
 
-    TypeMap::iterator iter = type_map_.find(mangled_tmp);
+  std::string str() const { return std::string(data_, size_); }
 
-    if (iter != type_map_.end()) return iter->second;
+  operator std::string() const { return str(); }
 
-    std::string& registered = type_map_[mangled_tmp];
+private:
 
-    registered = property_bag::details::demangle(mangled_tmp.c_str());
+  static constexpr bool equal(const char* a, const char* b, size_type n) noexcept
+  {
+    return n == 0 || (*a == *b && equal(a + 1, b + 1, n - 1));
+  }
 
-    return registered;
+  constexpr size_type rfind(string_view str, size_type pos) const noexcept
+  {
+    return equal(data_ + pos, str.data_, str.size_) ? pos :
+             (pos == 0) ? npos : rfind(str, pos - 1);
   }
 
-  TypeMap type_map_;
+  const char* data_;
+  size_type   size_;
 };
 
-} // namespace
+constexpr bool operator==(string_view lhs, string_view rhs) noexcept
+{
+  return lhs.equal(rhs);
+}
+
+constexpr bool operator!=(string_view lhs, string_view rhs) noexcept
+{
+  return !lhs.equal(rhs);
+}
 
-namespace property_bag
+template <std::size_t N>
+constexpr bool operator==(string_view lhs, const char (&rhs)[N]) noexcept
 {
+  return lhs.equal(string_view(rhs, N - 1));
+}
+
+template <std::size_t N>
+constexpr bool operator==(const char (&lhs)[N], string_view rhs) noexcept
+{
+  return rhs.equal(string_view(lhs, N - 1));
+}
+
+template <std::size_t N>
+constexpr bool operator!=(string_view lhs, const char (&rhs)[N]) noexcept
+{
+  return !(lhs == rhs);
+}
+
+template <std::size_t N>
+constexpr bool operator!=(const char (&lhs)[N], string_view rhs) noexcept
+{
+  return !(lhs == rhs);
+}
+
+inline std::string operator+(const std::string& lhs, string_view rhs)
+{
+  return std::string(lhs).append(rhs.data(), rhs.size());
+}
+
+inline std::string operator+(string_view lhs, const std::string& rhs)
+{
+  return lhs.str() + rhs;
+}
+
+inline std::ostream& operator<<(std::ostream& os, string_view s)
+{
+  return os.write(s.data(), s.size());
+}
+
 namespace details
 {
-static TypeMapper type_mapper_inst;
 
-inline const std::string& name_of(const std::type_info& ti)
+#if defined(_MSC_VER)
+#define PROPERTY_BAG_PRETTY_FUNCTION __FUNCSIG__
+#else
+#define PROPERTY_BAG_PRETTY_FUNCTION __PRETTY_FUNCTION__
+#endif
+
+/**
+ * @brief The PrettyName struct.
+ * The compiler-generated signature of 'value()',
+ * which spells out the type T.
+ */
+template <typename T>
+struct PrettyName
 {
-  return type_mapper_inst.lookup(ti);
+  static constexpr string_view value() noexcept
+  {
+    return string_view(PROPERTY_BAG_PRETTY_FUNCTION,
+                       sizeof(PROPERTY_BAG_PRETTY_FUNCTION) - 1);
+  }
+};
+
+// The signature decorating a type name,
+// found by probing with a known type.
+constexpr std::size_t pretty_name_prefix() noexcept
+{
+  return PrettyName<int>::value().rfind(string_view("int", 3));
 }
+
+constexpr std::size_t pretty_name_suffix() noexcept
+{
+  return PrettyName<int>::value().size() - pretty_name_prefix() - 3;
+}
+
+/**
+ * @brief The TypeName struct.
+ * Provides the name of type T at compile time.
+ * Specialize it (see PROPERTY_BAG_TYPE_NAME) to
+ * give a stable, readable name to a type.
+ */
+template <typename T>
+struct TypeName
+{
+  static constexpr string_view value() noexcept
+  {
+    return PrettyName<T>::value().substr(pretty_name_prefix(),
+                                         PrettyName<T>::value().size() -
+                                         pretty_name_prefix() - pretty_name_suffix());
+  }
+};
+
 } // namespace details
 
+/**
+ * @brief name_of. The name of type T, computed at compile time.
+ * @return a view over a statically allocated name.
+ */
 template<typename T>
-inline const std::string& name_of()
+constexpr string_view name_of() noexcept
 {
-  static const std::string& name_cache = details::name_of(typeid(T));
-  return name_cache;
+  return details::TypeName<
+      typename std::remove_cv<typename std::remove_reference<T>::type>::type
+      >::value();
 }
 
 } // namespace property_bag
 
+/**
+ * @brief Gives type 'Type' the name 'Name'.
+ * Must be used in the global namespace, in the header
+ * declaring 'Type' or in a header included by every
+ * translation unit storing 'Type' in a property.
+ * Otherwise the name would depend on the included
+ * headers, e.g. eigen_type_names.h is included by
+ * every Eigen serialization header.
+ * 'Type' must not contain a top-level comma, use a typedef.
+ */
+#define PROPERTY_BAG_TYPE_NAME(Type, Name)                    \
+  namespace property_bag { namespace details {                \
+  template <> struct TypeName<Type>                           \
+  {                                                           \
+    static constexpr string_view value() noexcept             \
+    { return string_view(Name, sizeof(Name) - 1); }           \
+  };                                                          \
+  } }
+
+PROPERTY_BAG_TYPE_NAME(std::string, "std::string")
+PROPERTY_BAG_TYPE_NAME(std::vector<int>, "std::vector<int>")
+PROPERTY_BAG_TYPE_NAME(std::vector<float>, "std::vector<float>")
+PROPERTY_BAG_TYPE_NAME(std::vector<double>, "std::vector<double>")
+PROPERTY_BAG_TYPE_NAME(std::vector<std::string>, "std::vector<std::string>")
+
 namespace {
 
+// Type names are computed at compile time,
+// kept for backward compatibility.
 #define PROPERTY_BAG_REGISTER_NAME_OF(...) \
-  /*const std::string& dummy = */property_bag::name_of<__VA_ARGS__>();
+  /*property_bag::string_view dummy = */property_bag::name_of<__VA_ARGS__>();
 
 }
 
@@ -0,0 +1,62 @@
+/**
+ * \file xmlrpc.h
+ * \brief Conversion between ROS parameter trees and property bags.
+ */
+
+#ifndef PROPERTY_BAG_XMLRPC_H
+#define PROPERTY_BAG_XMLRPC_H
+
+#include "property_bag/property_bag.h"
+
+#include <xmlrpcpp/XmlRpcValue.h>
+
+/*
+ * Mapping between XmlRpcValue and Property types :
+ *
+ *  TypeBoolean                  <-> bool
+ *  TypeInt                      <-> int
+ *  TypeDouble                   <-> double
+ *  TypeString                   <-> std::string
+ *  TypeStruct                   <-> property_bag::PropertyBag
+ *  TypeArray of TypeInt         <-> std::vector<int>
+ *  TypeArray of TypeDouble
+ *    (TypeInt elements promoted) <-> std::vector<double>
+ *  TypeArray of TypeString      <-> std::vector<std::string>
+ *  TypeArray of TypeBoolean     <-> std::vector<bool>
+ *  TypeArray of TypeStruct      <-> std::vector<property_bag::PropertyBag>
+ *
+ * An empty array is read as a std::vector<double>.
+ * Other values (heterogeneous or nested arrays,
+ * TypeDateTime, TypeBase64) are rejected.
+ */
+
+namespace property_bag {
+
+/**
+ * @brief from_xmlrpc. Replaces the properties of a bag
+ * with a parameter tree, e.g. fetched at once by
+ * ros::NodeHandle::getParam("~", params).
+ * @param params. The tree, a TypeStruct.
+ * @param bag. Untouched if the tree can not be converted.
+ * @throw PropertyException if a value can not be converted.
+ */
+void from_xmlrpc(const XmlRpc::XmlRpcValue& params, PropertyBag& bag);
+
+/**
+ * @brief to_xmlrpc. Writes a bag as a parameter tree,
+ * e.g. to be set at once by ros::NodeHandle::setParam.
+ * @param bag. Holding the types listed above only.
+ * @param params. Replaced by a TypeStruct.
+ * @throw PropertyException if a property can not be converted.
+ */
+void to_xmlrpc(const PropertyBag& bag, XmlRpc::XmlRpcValue& params);
+
+/**
+ * @brief to_xmlrpc.
+ * @see to_xmlrpc(const PropertyBag&, XmlRpc::XmlRpcValue&)
+ */
+XmlRpc::XmlRpcValue to_xmlrpc(const PropertyBag& bag);
+
+} /* namespace property_bag */
+
+#endif /* PROPERTY_BAG_XMLRPC_H */
@@ -1,5 +1,7 @@
 #include "property_bag/property.h"
 
+#include <mutex>
+
 namespace property_bag
 {
 
@@ -17,6 +19,77 @@ const char* PropertyException::what() const throw()
 
 namespace details
 {
+namespace
+{
+std::atomic<std::uint64_t> revision_clock{0};
+}
+
+std::uint64_t next_revision() noexcept
+{
+  return revision_clock.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+std::uint64_t current_revision() noexcept
+{
+  return revision_clock.load(std::memory_order_relaxed);
+}
+
+struct PlaceHolder::Deferred
+{
+  Decoder decoder;
+
+  // Keeps the decoded bytes alive
+  shared_ptr<const std::string> buffer;
+
+  const char* data;
+  std::size_t size;
+
+  std::once_flag once;
+};
+
+PlaceHolder::PlaceHolder() :
+  deferred_(false)
+{
+  //
+}
+
+PlaceHolder::~PlaceHolder() = default;
+
+void PlaceHolder::defer(Decoder decoder, shared_ptr<const std::string> buffer,
+                        const char* data, std::size_t size)
+{
+  deferred_value_.reset(new Deferred());
+
+  deferred_value_->decoder = decoder;
+  deferred_value_->buffer  = std::move(buffer);
+  deferred_value_->data    = data;
+  deferred_value_->size    = size;
+
+  deferred_.store(true, std::memory_order_release);
+}
+
+bool PlaceHolder::load_deferred() const noexcept
+{
+  Deferred& deferred = *deferred_value_;
+
+  std::call_once(deferred.once, [this, &deferred]()
+  {
+    try
+    {
+      deferred.decoder(deferred.data, deferred.size, const_cast<PlaceHolder&>(*this));
+      deferred_.store(false, std::memory_order_release);
+    }
+    catch (...)
+    {
+      // Stays deferred, every access fails
+    }
+
+    deferred.buffer.reset();
+  });
+
+  return !deferred_.load(std::memory_order_acquire);
+}
+
 Any::Any(Any&& o)
 {
   placeholder_ = o.placeholder_;
@@ -30,11 +103,28 @@ Any& Any::operator=(Any&& o)
 
   return *this;
 }
+
+bool Any::unshare()
+{
+  if (empty()) return true;
+
+  // A deferred value is decoded now rather than on first access
+  if (unique()) return placeholder_->load();
+
+  PlaceHolderPtr copy = placeholder_->clone();
+
+  if (property_bag::empty(copy)) return false;
+
+  placeholder_ = copy;
+
+  return true;
+}
 }
 
 Property::Property() :
   description_(),
-  flags_()
+  flags_(),
+  revision_(details::next_revision())
 {
   set_holder<none>(none{});
 
@@ -44,7 +134,9 @@ Property::Property() :
 Property::Property(const Property& rhs) :
   holder_(rhs.holder_),
   description_(rhs.description_),
-  flags_(rhs.flags_)
+  flags_(rhs.flags_),
+  revision_(rhs.revision_),
+  changes_(rhs.changes_)
 {
   //
 }
@@ -52,7 +144,9 @@ Property::Property(const Property& rhs) :
 Property::Property(Property&& rhs) :
   holder_(std::move(rhs.holder_)),
   description_(std::move(rhs.description_)),
-  flags_(std::move(rhs.flags_))
+  flags_(std::move(rhs.flags_)),
+  revision_(rhs.revision_),
+  changes_(rhs.changes_)
 {
   //
 }
@@ -65,6 +159,8 @@ Property& Property::operator=(const Property& rhs)
   description_ = rhs.description_;
   flags_       = rhs.flags_;
 
+  touch();
+
   return *this;
 }
 
@@ -76,12 +172,14 @@ Property& Property::operator=(Property&& rhs)
   description_ = std::move(rhs.description_);
   flags_       = std::move(rhs.flags_);
 
+  touch();
+
   return *this;
 }
 
-std::string Property::type_name() const noexcept
+string_view Property::type_name() const noexcept
 {
-  return details::name_of(holder_.type());
+  return holder_.type_name();
 }
 
 const std::type_info& Property::type() const noexcept
@@ -92,6 +190,8 @@ const std::type_info& Property::type() const noexcept
 void Property::description(const std::string& description_str)
 {
   description_ = description_str;
+
+  touch();
 }
 
 std::string Property::description() const noexcept
@@ -99,6 +199,22 @@ std::string Property::description() const noexcept
   return description_;
 }
 
+ErrorCode Property::try_swap(Property& rhs) noexcept
+{
+  if (rhs.type() != type()) return ErrorCode::TYPE_MISMATCH;
+
+  holder_.swap(rhs.holder_);
+
+  update_flags();
+
+  return ErrorCode::OK;
+}
+
+bool Property::unshare()
+{
+  return holder_.unshare();
+}
+
 bool Property::is_same(const Property& rhs) const
 {
   return rhs.type() == type();
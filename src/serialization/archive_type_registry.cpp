@@ -0,0 +1,18 @@
+#include <property_bag/serialization/property_boost_serialization.h>
+#include <property_bag/serialization/lazy_registry.hpp>
+
+namespace property_bag {
+namespace details {
+
+ArchiveTypeRegistry& ArchiveTypeRegistry::instance()
+{
+  // Never destroyed, types may be looked up
+  // during the destruction of static objects.
+  static ArchiveTypeRegistry* instance = new ArchiveTypeRegistry();
+  return *instance;
+}
+
+template class LazyRegistry<ArchiveType, &ArchiveType::guid>;
+
+} /* namespace details */
+} /* namespace property_bag */
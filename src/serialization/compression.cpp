@@ -0,0 +1,246 @@
+#include <property_bag/serialization/compression.h>
+#include <property_bag/property.h>
+
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/bzip2.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <boost/iostreams/copy.hpp>
+
+#include <algorithm>
+
+namespace property_bag {
+
+namespace {
+
+// zlib and bzip2 stream headers
+constexpr std::size_t header_size = 4;
+
+using OutputBuffer = boost::iostreams::filtering_streambuf<boost::iostreams::output>;
+using InputBuffer  = boost::iostreams::filtering_streambuf<boost::iostreams::input>;
+
+void push_compressor(OutputBuffer& buffer, const Compression compression, const int level)
+{
+  if (level != default_compression_level && (level < 1 || level > 9))
+    throw PropertyException("Invalid compression level " + std::to_string(level) + ".");
+
+  switch (compression)
+  {
+  case Compression::NONE:
+    break;
+  case Compression::ZLIB:
+    buffer.push(boost::iostreams::zlib_compressor(boost::iostreams::zlib_params(
+      (level == default_compression_level)? boost::iostreams::zlib::default_compression : level)));
+    break;
+  case Compression::BZIP2:
+    buffer.push(boost::iostreams::bzip2_compressor(boost::iostreams::bzip2_params(
+      (level == default_compression_level)? boost::iostreams::bzip2::default_block_size : level)));
+    break;
+  default:
+    throw PropertyException("Unknown compression.");
+  }
+}
+
+void push_decompressor(InputBuffer& buffer, const Compression compression)
+{
+  switch (compression)
+  {
+  case Compression::ZLIB:
+    buffer.push(boost::iostreams::zlib_decompressor());
+    break;
+  case Compression::BZIP2:
+    buffer.push(boost::iostreams::bzip2_decompressor());
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief The PrefixedSource struct. Gives back the
+ * bytes read for detection, then reads the stream.
+ */
+struct PrefixedSource
+{
+  using char_type = char;
+  using category  = boost::iostreams::source_tag;
+
+  std::streamsize read(char* s, std::streamsize n)
+  {
+    std::streamsize count = 0;
+
+    if (consumed < prefix.size())
+    {
+      count = std::min<std::streamsize>(n, prefix.size() - consumed);
+      std::copy_n(prefix.data() + consumed, count, s);
+      consumed += count;
+    }
+
+    if (count < n)
+    {
+      is->read(s + count, n - count);
+      count += is->gcount();
+    }
+
+    return (count == 0)? -1 : count;
+  }
+
+  std::string    prefix;
+  std::size_t    consumed;
+  std::istream*  is;
+};
+
+} // namespace
+
+Compression detect_compression(const char* data, const std::size_t size) noexcept
+{
+  if (size < 2) return Compression::NONE;
+
+  const unsigned char cmf = data[0], flg = data[1];
+
+  // deflate, 32k window, valid check bits
+  if (cmf == 0x78 && (cmf*256 + flg) % 31 == 0)
+    return Compression::ZLIB;
+
+  if (size >= header_size && data[0] == 'B' && data[1] == 'Z' && data[2] == 'h' &&
+      data[3] >= '1' && data[3] <= '9')
+    return Compression::BZIP2;
+
+  return Compression::NONE;
+}
+
+std::string compress(const char* data, const std::size_t size,
+                     const Compression compression, const int level)
+{
+  std::string compressed;
+
+  try
+  {
+    OutputBuffer buffer;
+    push_compressor(buffer, compression, level);
+    buffer.push(boost::iostreams::back_inserter(compressed));
+
+    boost::iostreams::write(buffer, data, size);
+    buffer.reset();
+  }
+  catch (const PropertyException&)
+  {
+    throw;
+  }
+  catch (const std::exception& e)
+  {
+    throw PropertyException(std::string("Could not compress: ") + e.what());
+  }
+
+  return compressed;
+}
+
+std::string decompress(const char* data, const std::size_t size)
+{
+  const Compression compression = detect_compression(data, size);
+
+  if (compression == Compression::NONE)
+    return std::string(data, size);
+
+  std::string decompressed;
+
+  try
+  {
+    InputBuffer buffer;
+    push_decompressor(buffer, compression);
+    buffer.push(boost::iostreams::array_source(data, size));
+
+    boost::iostreams::copy(buffer, boost::iostreams::back_inserter(decompressed));
+  }
+  catch (const std::exception& e)
+  {
+    throw PropertyException(std::string("Could not decompress: ") + e.what());
+  }
+
+  return decompressed;
+}
+
+struct CompressedOStream::Impl
+{
+  OutputBuffer buffer;
+  bool closed = false;
+};
+
+CompressedOStream::CompressedOStream(std::ostream& os,
+                                     const Compression compression,
+                                     const int level) :
+  std::ostream(nullptr),
+  impl_(new Impl)
+{
+  push_compressor(impl_->buffer, compression, level);
+  impl_->buffer.push(os);
+
+  rdbuf(&impl_->buffer);
+}
+
+CompressedOStream::~CompressedOStream()
+{
+  try
+  {
+    close();
+  }
+  catch (...)
+  {
+    //
+  }
+}
+
+void CompressedOStream::close()
+{
+  if (impl_->closed) return;
+
+  impl_->closed = true;
+
+  try
+  {
+    flush();
+
+    // Writes the end of the compressed stream
+    impl_->buffer.reset();
+  }
+  catch (const std::exception& e)
+  {
+    setstate(std::ios_base::badbit);
+    throw PropertyException(std::string("Could not compress: ") + e.what());
+  }
+
+  if (!*this)
+    throw PropertyException("Could not compress: stream error.");
+}
+
+struct DecompressedIStream::Impl
+{
+  InputBuffer buffer;
+  Compression compression = Compression::NONE;
+};
+
+DecompressedIStream::DecompressedIStream(std::istream& is) :
+  std::istream(nullptr),
+  impl_(new Impl)
+{
+  std::string prefix(header_size, '\0');
+  is.read(&prefix[0], header_size);
+  prefix.resize(is.gcount());
+
+  impl_->compression = detect_compression(prefix.data(), prefix.size());
+
+  push_decompressor(impl_->buffer, impl_->compression);
+  impl_->buffer.push(PrefixedSource{std::move(prefix), 0, &is});
+
+  rdbuf(&impl_->buffer);
+}
+
+DecompressedIStream::~DecompressedIStream() = default;
+
+Compression DecompressedIStream::compression() const noexcept
+{
+  return impl_->compression;
+}
+
+} /* namespace property_bag */
@@ -12,4 +12,4 @@ EXPORT_PROPERTY_NAMED_TYPE(std::vector<Eigen::VectorXd>, std_vector_eigen_vector
 EXPORT_PROPERTY_NAMED_TYPE(std::vector<Eigen::Quaterniond>, std_vector_eigen_quaternion)
 EXPORT_PROPERTY_NAMED_TYPE(std::vector<Eigen::Isometry3d>, std_vector_eigen_isometry)
 
-
+PROPERTY_BAG_DEFINE_REGISTRY(eigen_boost)
@@ -0,0 +1,14 @@
+#include <property_bag/serialization/eigen_json_format.h>
+
+EXPORT_PROPERTY_JSON_TYPE(Eigen::Vector3d, eigen_vector3)
+EXPORT_PROPERTY_JSON_TYPE(Eigen::VectorXd, eigen_vectorxd)
+EXPORT_PROPERTY_JSON_TYPE(Eigen::Quaterniond, eigen_quaterniond)
+EXPORT_PROPERTY_JSON_TYPE(Eigen::Isometry3d, eigen_isometry_3d)
+EXPORT_PROPERTY_JSON_TYPE(Eigen::MatrixXd, eigen_matrixxd)
+
+EXPORT_PROPERTY_JSON_TYPE(std::vector<Eigen::Vector3d>, std_vector_eigen_vector3)
+EXPORT_PROPERTY_JSON_TYPE(std::vector<Eigen::VectorXd>, std_vector_eigen_vectorxd)
+EXPORT_PROPERTY_JSON_TYPE(std::vector<Eigen::Quaterniond>, std_vector_eigen_quaternion)
+EXPORT_PROPERTY_JSON_TYPE(std::vector<Eigen::Isometry3d>, std_vector_eigen_isometry)
+
+PROPERTY_BAG_DEFINE_REGISTRY(eigen_json)
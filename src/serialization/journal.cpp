@@ -0,0 +1,489 @@
+#include <property_bag/serialization/journal.h>
+
+#include <boost/crc.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace property_bag {
+
+namespace {
+
+constexpr char snapshot_magic[3] = {'P', 'B', 'S'};
+constexpr char journal_magic[3]  = {'P', 'B', 'J'};
+
+constexpr std::uint8_t journal_version = 1;
+
+constexpr std::size_t journal_header_size = sizeof(journal_magic) + 1 + sizeof(std::uint64_t);
+constexpr std::size_t record_header_size  = 2*sizeof(std::uint32_t);
+
+enum class RecordType : std::uint8_t
+{
+  PUT = 1,
+  REMOVE
+};
+
+std::uint32_t crc32(const char* data, const std::size_t size)
+{
+  boost::crc_32_type crc;
+  crc.process_bytes(data, size);
+  return crc.checksum();
+}
+
+void store_u32(char* out, std::uint32_t v)
+{
+  if (!details::native_little_endian()) details::byte_swap(v);
+  std::memcpy(out, &v, sizeof(v));
+}
+
+// Closes on destruction
+struct FileDescriptor
+{
+  explicit FileDescriptor(const int fd) : fd(fd) { }
+  ~FileDescriptor() { if (fd >= 0) ::close(fd); }
+
+  FileDescriptor(const FileDescriptor&)            = delete;
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+  int release() noexcept { const int released = fd; fd = -1; return released; }
+
+  int fd;
+};
+
+[[noreturn]] void fail(const std::string& what, const std::string& path)
+{
+  throw PropertyException("Journal: could not " + what + " '" + path + "'.");
+}
+
+/**
+ * @return false if there is no file at 'path'.
+ */
+bool read_file(const std::string& path, std::string& bytes)
+{
+  FileDescriptor file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+
+  if (file.fd < 0)
+  {
+    if (errno == ENOENT) return false;
+    fail("open", path);
+  }
+
+  struct stat st;
+  if (::fstat(file.fd, &st) != 0) fail("stat", path);
+
+  bytes.resize(st.st_size);
+
+  std::size_t done = 0;
+  while (done < bytes.size())
+  {
+    const ssize_t n = ::read(file.fd, &bytes[done], bytes.size() - done);
+
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) fail("read", path);
+
+    done += n;
+  }
+
+  return true;
+}
+
+void write_all(const int fd, const char* data, std::size_t size, const std::string& path)
+{
+  while (size > 0)
+  {
+    const ssize_t n = ::write(fd, data, size);
+
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) fail("write", path);
+
+    data += n;
+    size -= n;
+  }
+}
+
+void sync_data(const int fd, const std::string& path)
+{
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+  if (::fdatasync(fd) != 0) fail("sync", path);
+#else
+  if (::fsync(fd) != 0) fail("sync", path);
+#endif
+}
+
+// Makes the creation, removal and renaming of files durable
+void sync_directory(const std::string& path)
+{
+  const std::size_t slash = path.rfind('/');
+  const std::string directory = (slash == std::string::npos)? "." :
+                                (slash == 0)? "/" : path.substr(0, slash);
+
+  FileDescriptor dir(::open(directory.c_str(), O_RDONLY | O_CLOEXEC));
+  if (dir.fd < 0 || ::fsync(dir.fd) != 0) fail("sync", directory);
+}
+
+void write_snapshot(const std::string& path, const std::uint64_t generation,
+                    const PropertyBag& bag)
+{
+  const std::string bytes = to_wire(bag);
+
+  wire::Writer header;
+  header.write(snapshot_magic, sizeof(snapshot_magic));
+  header.write_scalar(journal_version);
+  header.write_scalar<std::uint64_t>(generation);
+  header.write_scalar<std::uint64_t>(bytes.size());
+  header.write_scalar(crc32(bytes.data(), bytes.size()));
+
+  const std::string head = header.release();
+
+  // Written aside then renamed, a crash leaves either snapshot whole
+  const std::string tmp = path + ".tmp";
+
+  {
+    FileDescriptor file(::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+    if (file.fd < 0) fail("create", tmp);
+
+    write_all(file.fd, head.data(), head.size(), tmp);
+    write_all(file.fd, bytes.data(), bytes.size(), tmp);
+
+    if (::fsync(file.fd) != 0) fail("sync", tmp);
+  }
+
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) fail("rename", tmp);
+
+  sync_directory(path);
+}
+
+/**
+ * @return the generation of the snapshot, 0 if there is none.
+ */
+std::uint64_t load_snapshot(const std::string& path, PropertyBag& bag)
+{
+  std::string bytes;
+  if (!read_file(path, bytes)) return 0;
+
+  wire::Reader r(bytes.data(), bytes.size());
+
+  char magic[sizeof(snapshot_magic)];
+  r.read(magic, sizeof(magic));
+
+  if (std::memcmp(magic, snapshot_magic, sizeof(magic)) != 0)
+    throw PropertyException("Journal: invalid snapshot signature '" + path + "'.");
+
+  if (r.read_scalar<std::uint8_t>() > journal_version)
+    throw PropertyException("Journal: unsupported snapshot version '" + path + "'.");
+
+  const std::uint64_t generation = r.read_scalar<std::uint64_t>();
+  const std::uint64_t size       = r.read_scalar<std::uint64_t>();
+  const std::uint32_t crc        = r.read_scalar<std::uint32_t>();
+
+  if (r.remaining() != size || crc32(r.position(), size) != crc)
+    throw PropertyException("Journal: corrupted snapshot '" + path + "'.");
+
+  // Values are decoded on their first access
+  bytes.erase(0, bytes.size() - size);
+  from_wire(std::move(bytes), bag, wire::LoadMode::LAZY);
+
+  return generation;
+}
+
+} // namespace
+
+constexpr std::size_t JournaledPropertyBag::default_compaction_threshold;
+
+JournaledPropertyBag::JournaledPropertyBag(const std::string& path,
+                                           const std::size_t compaction_threshold,
+                                           const bool sync) :
+  path_(path),
+  compaction_threshold_(compaction_threshold),
+  sync_(sync)
+{
+  recover();
+}
+
+JournaledPropertyBag::~JournaledPropertyBag()
+{
+  wait_compaction();
+
+  if (fd_ >= 0) ::close(fd_);
+}
+
+bool JournaledPropertyBag::removeProperty(const std::string& name)
+{
+  if (!bag_.removeProperty(name)) return false;
+
+  wire::Writer record;
+  record.extend(record_header_size);
+  record.write_scalar(static_cast<std::uint8_t>(RecordType::REMOVE));
+  record.write_string(name);
+
+  append(record);
+  return true;
+}
+
+void JournaledPropertyBag::compact()
+{
+  wait_compaction();
+
+  std::exception_ptr error;
+
+  // Reported once, the next call compacts
+  std::swap(error, failed_compaction_);
+  if (error) std::rethrow_exception(error);
+
+  start_compaction();
+  wait_compaction();
+
+  std::swap(error, failed_compaction_);
+  if (error) std::rethrow_exception(error);
+}
+
+void JournaledPropertyBag::sync()
+{
+  sync_data(fd_, journal_path(generation_));
+}
+
+void JournaledPropertyBag::check_exported(const std::type_info& type) const
+{
+  if (wire::Registry::instance().find(type) == nullptr)
+    throw PropertyException(std::string("Journal: type ") + details::demangle(type.name()) +
+                            " is not exported to the wire format.");
+}
+
+void JournaledPropertyBag::append_put(const std::string& name)
+{
+  const Property& property = bag_.getProperty(name);
+
+  const wire::TypeCodec* codec = wire::Registry::instance().find(property.type());
+  if (codec == nullptr) check_exported(property.type());
+
+  wire::Writer record;
+  record.extend(record_header_size);
+  record.write_scalar(static_cast<std::uint8_t>(RecordType::PUT));
+  record.write_string(name);
+  record.write_string(codec->name);
+  Property::wire_accessor::encode(record, property, *codec);
+
+  append(record);
+}
+
+void JournaledPropertyBag::append(wire::Writer& record)
+{
+  std::string bytes = record.release();
+
+  const std::size_t size = bytes.size() - record_header_size;
+
+  if (size > std::numeric_limits<std::uint32_t>::max())
+    throw PropertyException("Journal: record of " + std::to_string(size) + " bytes too large.");
+
+  store_u32(&bytes[0], static_cast<std::uint32_t>(size));
+  store_u32(&bytes[sizeof(std::uint32_t)], crc32(bytes.data() + record_header_size, size));
+
+  try
+  {
+    write_all(fd_, bytes.data(), bytes.size(), journal_path(generation_));
+
+    if (sync_) sync();
+  }
+  catch (const PropertyException&)
+  {
+    // Records appended later must not follow a partial one
+    if (::ftruncate(fd_, journal_size_) != 0) { }
+    throw;
+  }
+
+  journal_size_ += bytes.size();
+
+  if (journal_size_ < compaction_threshold_ || compacting_) return;
+
+  try
+  {
+    start_compaction();
+  }
+  catch (const PropertyException&)
+  {
+    // Tried again on the next record
+  }
+}
+
+void JournaledPropertyBag::recover()
+{
+  // Left by a crash while writing a snapshot
+  ::unlink((path_ + ".tmp").c_str());
+
+  const std::uint64_t snapshot = load_snapshot(path_, bag_);
+
+  // Compacted in the snapshot, left by a crash before their removal
+  for (std::uint64_t g = snapshot; g-- > 0 && ::unlink(journal_path(g).c_str()) == 0; ) { }
+
+  std::uint64_t generation = snapshot;
+  std::size_t size = 0;
+
+  std::string bytes;
+  for (std::uint64_t g = snapshot; read_file(journal_path(g), bytes); ++g)
+  {
+    generation = g;
+    size = replay(bytes, g);
+  }
+
+  snapshot_generation_ = snapshot;
+
+  open_journal(generation, size);
+}
+
+std::size_t JournaledPropertyBag::replay(const std::string& journal,
+                                         const std::uint64_t generation)
+{
+  // Crashed while creating it
+  if (journal.size() < journal_header_size) return 0;
+
+  wire::Reader r(journal.data(), journal.size());
+
+  char magic[sizeof(journal_magic)];
+  r.read(magic, sizeof(magic));
+
+  if (std::memcmp(magic, journal_magic, sizeof(magic)) != 0 ||
+      r.read_scalar<std::uint8_t>() > journal_version ||
+      r.read_scalar<std::uint64_t>() != generation)
+    throw PropertyException("Journal: invalid journal header '" +
+                            journal_path(generation) + "'.");
+
+  const wire::Registry& registry = wire::Registry::instance();
+
+  std::string name, type_name;
+
+  while (r.remaining() >= record_header_size)
+  {
+    const std::uint32_t size = r.read_scalar<std::uint32_t>();
+    const std::uint32_t crc  = r.read_scalar<std::uint32_t>();
+
+    // Torn or corrupted, the end of the journal
+    if (r.remaining() < size || crc32(r.position(), size) != crc)
+      return r.position() - record_header_size - journal.data();
+
+    wire::Reader payload(r.skip(size), size);
+
+    const RecordType type = static_cast<RecordType>(payload.read_scalar<std::uint8_t>());
+    payload.read_string(name);
+
+    switch (type)
+    {
+    case RecordType::PUT:
+    {
+      payload.read_string(type_name);
+
+      const wire::TypeCodec* codec = registry.find(type_name);
+      if (codec == nullptr)
+        throw PropertyException("Journal: type '" + type_name +
+                                "' is not exported to the wire format.");
+
+      Property property;
+      Property::wire_accessor::decode(payload, property, *codec);
+
+      PropertyBag::wire_accessor::insert(bag_, name, std::move(property));
+      break;
+    }
+    case RecordType::REMOVE:
+      bag_.removeProperty(name);
+      break;
+    default:
+      throw PropertyException("Journal: unknown record in '" +
+                              journal_path(generation) + "'.");
+    }
+  }
+
+  return r.position() - journal.data();
+}
+
+void JournaledPropertyBag::open_journal(const std::uint64_t generation, std::size_t size)
+{
+  const std::string path = journal_path(generation);
+
+  FileDescriptor file(::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644));
+  if (file.fd < 0) fail("open", path);
+
+  // Drops what follows the last valid record
+  if (::ftruncate(file.fd, size) != 0) fail("truncate", path);
+
+  if (size == 0)
+  {
+    wire::Writer header;
+    header.write(journal_magic, sizeof(journal_magic));
+    header.write_scalar(journal_version);
+    header.write_scalar(generation);
+
+    const std::string bytes = header.release();
+    write_all(file.fd, bytes.data(), bytes.size(), path);
+
+    size = bytes.size();
+
+    if (sync_)
+    {
+      sync_data(file.fd, path);
+      sync_directory(path);
+    }
+  }
+
+  if (fd_ >= 0) ::close(fd_);
+
+  fd_ = file.release();
+  journal_size_ = size;
+  generation_ = generation;
+}
+
+void JournaledPropertyBag::start_compaction()
+{
+  // Done, but not joined yet
+  wait_compaction();
+
+  // Changes from now on are appended to the next journal
+  open_journal(generation_ + 1, 0);
+
+  // Values shared with bag_ until it changes them
+  PropertyBag snapshot(bag_);
+  snapshot.name(bag_.name());
+
+  compacting_ = true;
+
+  compaction_ = std::thread([this](const std::uint64_t generation, const PropertyBag& snapshot)
+    {
+      try
+      {
+        write_snapshot(path_, generation, snapshot);
+
+        for (std::uint64_t g = snapshot_generation_; g < generation; ++g)
+          ::unlink(journal_path(g).c_str());
+
+        snapshot_generation_ = generation;
+      }
+      catch (...)
+      {
+        compaction_error_ = std::current_exception();
+      }
+
+      compacting_ = false;
+    },
+    generation_, std::move(snapshot));
+}
+
+void JournaledPropertyBag::wait_compaction()
+{
+  if (compaction_.joinable()) compaction_.join();
+
+  // The first error is kept until reported
+  if (compaction_error_ && !failed_compaction_)
+    failed_compaction_ = compaction_error_;
+
+  compaction_error_ = nullptr;
+}
+
+std::string JournaledPropertyBag::journal_path(const std::uint64_t generation) const
+{
+  return path_ + "." + std::to_string(generation) + ".journal";
+}
+
+} /* namespace property_bag */
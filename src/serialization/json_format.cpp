@@ -0,0 +1,772 @@
+#include <property_bag/serialization/json_format.h>
+#include <property_bag/serialization/lazy_registry.hpp>
+
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace property_bag {
+namespace json {
+
+namespace {
+
+inline bool is_digit(const char c) noexcept
+{
+  return c >= '0' && c <= '9';
+}
+
+/**
+ * @brief replace_point. printf and strtod follow the
+ * decimal point of the locale, JSON always uses a '.'.
+ */
+void replace_point(char* buffer, const std::size_t size,
+                   const bool to_json) noexcept
+{
+  const char point = std::localeconv()->decimal_point[0];
+
+  if (point == '.') return;
+
+  const char from = to_json? point : '.';
+  const char to   = to_json? '.' : point;
+
+  for (std::size_t i=0; i<size; ++i)
+    if (buffer[i] == from) buffer[i] = to;
+}
+
+inline double parse(const char* s, double) { return std::strtod(s, nullptr); }
+inline float  parse(const char* s, float)  { return std::strtof(s, nullptr); }
+
+// Exactly representable powers of ten
+constexpr double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                            1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                            1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+template <typename T> struct FastPath;
+
+template <> struct FastPath<double>
+{
+  static constexpr std::uint64_t max_mantissa = std::uint64_t(1) << 53;
+  static constexpr int max_exponent = 22;
+};
+
+template <> struct FastPath<float>
+{
+  static constexpr std::uint64_t max_mantissa = std::uint64_t(1) << 24;
+  static constexpr int max_exponent = 10;
+};
+
+/**
+ * @brief parse_floating. Reads [begin, end), a valid JSON number.
+ * A mantissa and a power of ten both exactly representable
+ * give the correctly rounded value with a single operation,
+ * other numbers go through strtod/strtof.
+ */
+template <typename T>
+T parse_floating(const char* begin, const char* end)
+{
+  const char* p = begin;
+
+  const bool negative = (*p == '-');
+  if (negative) ++p;
+
+  std::uint64_t mantissa = 0;
+  int digits   = 0;
+  int exponent = 0;
+  bool exact   = true;
+
+  for (; p != end && is_digit(*p); ++p)
+  {
+    if (digits < 19)
+    {
+      mantissa = mantissa*10 + (*p - '0');
+      if (mantissa != 0) ++digits;
+    }
+    else
+    {
+      ++exponent;
+      exact &= (*p == '0');
+    }
+  }
+
+  if (p != end && *p == '.')
+  {
+    for (++p; p != end && is_digit(*p); ++p)
+    {
+      if (digits < 19)
+      {
+        mantissa = mantissa*10 + (*p - '0');
+        if (mantissa != 0) ++digits;
+        --exponent;
+      }
+      else
+        exact &= (*p == '0');
+    }
+  }
+
+  if (p != end && (*p == 'e' || *p == 'E'))
+  {
+    ++p;
+
+    const bool negative_exponent = (*p == '-');
+    if (*p == '-' || *p == '+') ++p;
+
+    int e = 0;
+    for (; p != end && is_digit(*p); ++p)
+      if (e < 100000) e = e*10 + (*p - '0');
+
+    exponent += negative_exponent? -e : e;
+  }
+
+  if (mantissa == 0)
+    return negative? -T(0) : T(0);
+
+  if (exact && mantissa <= FastPath<T>::max_mantissa &&
+      exponent >= -FastPath<T>::max_exponent && exponent <= FastPath<T>::max_exponent)
+  {
+    T value = static_cast<T>(mantissa);
+    value = (exponent < 0)? value / static_cast<T>(pow10[-exponent]) :
+                            value * static_cast<T>(pow10[exponent]);
+    return negative? -value : value;
+  }
+
+  // strtod needs a terminated string
+  std::string number(begin, end);
+  replace_point(&number[0], number.size(), false);
+
+  return parse(number.c_str(), T());
+}
+
+template <typename T>
+std::size_t format_floating(char* buffer, const T t) noexcept
+{
+  // Integral values, e.g. gains and sizes, written as such
+  if (t == std::trunc(t) && std::fabs(t) < T(1e15))
+  {
+    std::size_t size = 0;
+    if (std::signbit(t)) buffer[size++] = '-';
+
+    size += format_number(buffer + size, static_cast<std::uint64_t>(std::fabs(t)));
+    buffer[size++] = '.';
+    buffer[size++] = '0';
+
+    return size;
+  }
+
+  // Fewest digits first, the longest form always reads back
+  int size = std::snprintf(buffer, 32, "%.*g", std::numeric_limits<T>::digits10, double(t));
+  replace_point(buffer, size, true);
+
+  // Mostly on the fast path of the parser
+  if (parse_floating<T>(buffer, buffer + size) != t)
+  {
+    size = std::snprintf(buffer, 32, "%.*g", std::numeric_limits<T>::max_digits10, double(t));
+    replace_point(buffer, size, true);
+  }
+
+  return size;
+}
+
+void append_utf8(std::string& s, const std::uint32_t code_point)
+{
+  if (code_point < 0x80)
+  {
+    s.push_back(static_cast<char>(code_point));
+  }
+  else if (code_point < 0x800)
+  {
+    s.push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+    s.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+  else if (code_point < 0x10000)
+  {
+    s.push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+    s.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    s.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+  else
+  {
+    s.push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+    s.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+    s.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+    s.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+  }
+}
+
+} // namespace
+
+std::size_t format_number(char* buffer, const std::uint64_t t) noexcept
+{
+  char digits[20];
+  std::size_t size = 0;
+
+  std::uint64_t v = t;
+  do
+  {
+    digits[size++] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  }
+  while (v != 0);
+
+  for (std::size_t i=0; i<size; ++i)
+    buffer[i] = digits[size - 1 - i];
+
+  return size;
+}
+
+std::size_t format_number(char* buffer, const std::int64_t t) noexcept
+{
+  if (t >= 0) return format_number(buffer, static_cast<std::uint64_t>(t));
+
+  buffer[0] = '-';
+  return 1 + format_number(buffer + 1, ~static_cast<std::uint64_t>(t) + 1);
+}
+
+std::size_t format_number(char* buffer, const double t) noexcept
+{
+  return format_floating(buffer, t);
+}
+
+std::size_t format_number(char* buffer, const float t) noexcept
+{
+  return format_floating(buffer, t);
+}
+
+Writer::Writer(const int indent) :
+  indent_(indent)
+{
+  //
+}
+
+Writer::Writer(std::ostream& os, const int indent, const std::size_t buffer_size) :
+  os_(&os),
+  buffer_size_(buffer_size),
+  indent_(indent)
+{
+  buffer_.reserve(buffer_size);
+}
+
+Writer::~Writer()
+{
+  try
+  {
+    flush();
+  }
+  catch (...)
+  {
+    //
+  }
+}
+
+void Writer::flush()
+{
+  if (os_ == nullptr || buffer_.empty()) return;
+
+  os_->write(buffer_.data(), buffer_.size());
+  buffer_.clear();
+
+  if (!*os_)
+    throw PropertyException("JSON: could not write the output.");
+}
+
+void Writer::separate()
+{
+  if (os_ != nullptr && buffer_.size() >= buffer_size_) flush();
+
+  if (after_key_)
+  {
+    after_key_ = false;
+    return;
+  }
+
+  if (!first_) put(',');
+  first_ = false;
+
+  if (indent_ > 0 && !scopes_.empty() && scopes_.back()) newline();
+}
+
+void Writer::open(const char c, const bool object)
+{
+  separate();
+  put(c);
+
+  scopes_.push_back(object);
+  first_ = true;
+}
+
+void Writer::close(const char c)
+{
+  const bool object = scopes_.back();
+  scopes_.pop_back();
+
+  if (indent_ > 0 && object && !first_) newline();
+
+  put(c);
+  first_ = false;
+}
+
+void Writer::newline()
+{
+  put('\n');
+  buffer_.append(indent_ * scopes_.size(), ' ');
+}
+
+void Writer::key(const char* data, const std::size_t size)
+{
+  separate();
+  write_escaped(data, size);
+
+  put(':');
+  if (indent_ > 0) put(' ');
+
+  after_key_ = true;
+}
+
+void Writer::write_null()
+{
+  separate();
+  append("null", 4);
+}
+
+void Writer::write_bool(const bool b)
+{
+  separate();
+  b? append("true", 4) : append("false", 5);
+}
+
+void Writer::write_string(const char* data, const std::size_t size)
+{
+  separate();
+  write_escaped(data, size);
+}
+
+void Writer::write_escaped(const char* data, const std::size_t size)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  put('"');
+
+  const char* run = data;
+  const char* end = data + size;
+
+  for (const char* p = data; p != end; ++p)
+  {
+    const unsigned char c = static_cast<unsigned char>(*p);
+
+    if (c != '"' && c != '\\' && c >= 0x20) continue;
+
+    append(run, p - run);
+    run = p + 1;
+
+    switch (c)
+    {
+    case '"':  append("\\\"", 2); break;
+    case '\\': append("\\\\", 2); break;
+    case '\n': append("\\n", 2);  break;
+    case '\t': append("\\t", 2);  break;
+    case '\r': append("\\r", 2);  break;
+    case '\b': append("\\b", 2);  break;
+    case '\f': append("\\f", 2);  break;
+    default:
+    {
+      const char u[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0x0f]};
+      append(u, sizeof(u));
+    }
+    }
+  }
+
+  append(run, end - run);
+
+  put('"');
+}
+
+void Reader::error(const std::string& what) const
+{
+  throw PropertyException("JSON: " + what + " at offset " +
+                          std::to_string(data_ - begin_) + ".");
+}
+
+void Reader::expect(const char c)
+{
+  if (peek() != c || data_ == end_)
+    error(std::string("expected '") + c + "'");
+
+  ++data_;
+}
+
+bool Reader::more(const char close, bool& first)
+{
+  const char c = peek();
+
+  if (c == close && data_ != end_)
+  {
+    ++data_;
+    return false;
+  }
+
+  if (!first)
+  {
+    if (c != ',') error(std::string("expected ',' or '") + close + "'");
+    ++data_;
+  }
+
+  first = false;
+
+  return true;
+}
+
+void Reader::read_null()
+{
+  skip_whitespaces();
+
+  if (end_ - data_ < 4 || std::memcmp(data_, "null", 4) != 0)
+    error("expected null");
+
+  data_ += 4;
+}
+
+bool Reader::read_bool()
+{
+  skip_whitespaces();
+
+  if (end_ - data_ >= 4 && std::memcmp(data_, "true", 4) == 0)
+  {
+    data_ += 4;
+    return true;
+  }
+
+  if (end_ - data_ >= 5 && std::memcmp(data_, "false", 5) == 0)
+  {
+    data_ += 5;
+    return false;
+  }
+
+  error("expected a boolean");
+}
+
+const char* Reader::scan_number(bool& integral) const
+{
+  const char* p = data_;
+
+  if (p != end_ && *p == '-') ++p;
+
+  if (p == end_ || !is_digit(*p)) error("expected a number");
+
+  if (*p == '0') ++p;
+  else while (p != end_ && is_digit(*p)) ++p;
+
+  integral = true;
+
+  if (p != end_ && *p == '.')
+  {
+    integral = false;
+
+    if (++p == end_ || !is_digit(*p)) error("invalid number");
+    while (p != end_ && is_digit(*p)) ++p;
+  }
+
+  if (p != end_ && (*p == 'e' || *p == 'E'))
+  {
+    integral = false;
+
+    if (++p != end_ && (*p == '-' || *p == '+')) ++p;
+
+    if (p == end_ || !is_digit(*p)) error("invalid number");
+    while (p != end_ && is_digit(*p)) ++p;
+  }
+
+  return p;
+}
+
+void Reader::read_integer(std::uint64_t& t)
+{
+  skip_whitespaces();
+
+  bool integral;
+  const char* end = scan_number(integral);
+
+  if (!integral) error("expected an integer");
+
+  const bool negative = (*data_ == '-');
+
+  std::uint64_t value = 0;
+  for (const char* p = data_ + negative; p != end; ++p)
+  {
+    const unsigned digit = *p - '0';
+
+    if (value > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+      error("number out of range");
+
+    value = value*10 + digit;
+  }
+
+  if (negative && value != 0) error("number out of range");
+
+  t = value;
+  data_ = end;
+}
+
+void Reader::read_integer(std::int64_t& t)
+{
+  skip_whitespaces();
+
+  const bool negative = (data_ != end_ && *data_ == '-');
+  if (negative) ++data_;
+
+  if (negative && (data_ == end_ || !is_digit(*data_))) error("expected a number");
+
+  std::uint64_t value;
+  read_integer(value);
+
+  const std::uint64_t max = std::uint64_t(std::numeric_limits<std::int64_t>::max()) + negative;
+
+  if (value > max)
+  {
+    --data_;
+    error("number out of range");
+  }
+
+  t = negative? static_cast<std::int64_t>(~value + 1) : static_cast<std::int64_t>(value);
+}
+
+void Reader::read_floating(double& t)
+{
+  skip_whitespaces();
+
+  if (data_ != end_ && *data_ == '"')
+  {
+    std::string s;
+    read_string(s);
+
+    if      (s == "NaN")       t =  std::numeric_limits<double>::quiet_NaN();
+    else if (s == "Infinity")  t =  std::numeric_limits<double>::infinity();
+    else if (s == "-Infinity") t = -std::numeric_limits<double>::infinity();
+    else error("expected a number");
+
+    return;
+  }
+
+  bool integral;
+  const char* end = scan_number(integral);
+
+  t = parse_floating<double>(data_, end);
+  data_ = end;
+}
+
+void Reader::read_floating(float& t)
+{
+  skip_whitespaces();
+
+  if (data_ != end_ && *data_ == '"')
+  {
+    double d;
+    read_floating(d);
+    t = static_cast<float>(d);
+    return;
+  }
+
+  bool integral;
+  const char* end = scan_number(integral);
+
+  t = parse_floating<float>(data_, end);
+  data_ = end;
+}
+
+void Reader::read_string(std::string& s)
+{
+  expect('"');
+
+  // Most strings hold no escape
+  const char* run = data_;
+  while (data_ != end_ && *data_ != '"' && *data_ != '\\' &&
+         static_cast<unsigned char>(*data_) >= 0x20)
+    ++data_;
+
+  s.assign(run, data_ - run);
+
+  while (true)
+  {
+    if (data_ == end_) error("unterminated string");
+
+    const char c = *data_;
+
+    if (c == '"')
+    {
+      ++data_;
+      return;
+    }
+
+    if (static_cast<unsigned char>(c) < 0x20) error("control character in string");
+
+    if (c != '\\')
+    {
+      run = data_;
+      while (data_ != end_ && *data_ != '"' && *data_ != '\\' &&
+             static_cast<unsigned char>(*data_) >= 0x20)
+        ++data_;
+
+      s.append(run, data_ - run);
+      continue;
+    }
+
+    if (++data_ == end_) error("unterminated string");
+
+    switch (*data_++)
+    {
+    case '"':  s.push_back('"');  break;
+    case '\\': s.push_back('\\'); break;
+    case '/':  s.push_back('/');  break;
+    case 'b':  s.push_back('\b'); break;
+    case 'f':  s.push_back('\f'); break;
+    case 'n':  s.push_back('\n'); break;
+    case 'r':  s.push_back('\r'); break;
+    case 't':  s.push_back('\t'); break;
+    case 'u':
+    {
+      const auto hex4 = [this]()
+      {
+        if (end_ - data_ < 4) error("invalid unicode escape");
+
+        std::uint32_t v = 0;
+        for (int i=0; i<4; ++i, ++data_)
+        {
+          const char h = *data_;
+          v <<= 4;
+          if      (h >= '0' && h <= '9') v |= h - '0';
+          else if (h >= 'a' && h <= 'f') v |= h - 'a' + 10;
+          else if (h >= 'A' && h <= 'F') v |= h - 'A' + 10;
+          else error("invalid unicode escape");
+        }
+        return v;
+      };
+
+      std::uint32_t code_point = hex4();
+
+      // Surrogate pair
+      if (code_point >= 0xd800 && code_point <= 0xdbff)
+      {
+        if (end_ - data_ < 2 || data_[0] != '\\' || data_[1] != 'u')
+          error("invalid unicode escape");
+
+        data_ += 2;
+
+        const std::uint32_t low = hex4();
+        if (low < 0xdc00 || low > 0xdfff) error("invalid unicode escape");
+
+        code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+      }
+      else if (code_point >= 0xdc00 && code_point <= 0xdfff)
+        error("invalid unicode escape");
+
+      append_utf8(s, code_point);
+      break;
+    }
+    default:
+      --data_;
+      error("invalid escape");
+    }
+  }
+}
+
+Reader Reader::skip_value()
+{
+  skip_whitespaces();
+
+  const char* begin = data_;
+
+  const auto skip_string = [this]()
+  {
+    for (++data_; data_ != end_ && *data_ != '"'; ++data_)
+      if (*data_ == '\\' && ++data_ == end_) break;
+
+    if (data_ == end_) error("unterminated string");
+    ++data_;
+  };
+
+  switch (peek())
+  {
+  case '"':
+    skip_string();
+    break;
+  case '{':
+  case '[':
+  {
+    std::size_t depth = 0;
+    do
+    {
+      if (data_ == end_) error("unterminated value");
+
+      switch (*data_)
+      {
+      case '"': skip_string(); continue;
+      case '{':
+      case '[': ++depth; break;
+      case '}':
+      case ']': --depth; break;
+      default: break;
+      }
+
+      ++data_;
+    }
+    while (depth != 0);
+    break;
+  }
+  case 't':
+  case 'f':
+    read_bool();
+    break;
+  case 'n':
+    read_null();
+    break;
+  default:
+  {
+    bool integral;
+    data_ = scan_number(integral);
+  }
+  }
+
+  Reader value(begin, data_ - begin);
+  value.begin_ = begin_;
+
+  return value;
+}
+
+void Reader::end()
+{
+  skip_whitespaces();
+
+  if (data_ != end_) error("unexpected trailing characters");
+}
+
+std::string read_all(std::istream& is)
+{
+  std::string json;
+
+  char chunk[64*1024];
+  while (is.read(chunk, sizeof(chunk)) || is.gcount() > 0)
+    json.append(chunk, is.gcount());
+
+  if (is.bad())
+    throw PropertyException("JSON: could not read the input.");
+
+  return json;
+}
+
+Registry& Registry::instance()
+{
+  // Never destroyed, codecs may be looked up
+  // during the destruction of static objects.
+  static Registry* instance = new Registry();
+  return *instance;
+}
+
+} /* namespace json */
+
+namespace details {
+
+template class LazyRegistry<json::TypeCodec, &json::TypeCodec::name>;
+
+} /* namespace details */
+} /* namespace property_bag */
@@ -0,0 +1,12 @@
+#include <property_bag/serialization/json_format.h>
+
+EXPORT_PROPERTY_JSON_TYPE(bool, bool)
+EXPORT_PROPERTY_JSON_TYPE(int, int)
+EXPORT_PROPERTY_JSON_TYPE(float, float)
+EXPORT_PROPERTY_JSON_TYPE(double, double)
+EXPORT_PROPERTY_JSON_TYPE(std::string, std__string)
+EXPORT_PROPERTY_JSON_TYPE(property_bag::PropertyBag, PropertyBag)
+
+EXPORT_PROPERTY_JSON_TYPE(std::vector<int>, std_vector_int)
+EXPORT_PROPERTY_JSON_TYPE(std::vector<double>, std_vector_double)
+EXPORT_PROPERTY_JSON_TYPE(std::vector<std::string>, std_vector_string)
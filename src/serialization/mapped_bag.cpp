@@ -0,0 +1,368 @@
+#include <property_bag/serialization/mapped_bag.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace property_bag {
+
+namespace {
+
+constexpr char         mapped_magic[3] = {'P', 'B', 'M'};
+constexpr std::uint8_t mapped_version  = 1;
+
+constexpr std::size_t header_size = sizeof(mapped_magic) + 1 + 2*sizeof(std::uint64_t);
+
+void check_little_endian()
+{
+  if (!details::native_little_endian())
+    throw PropertyException("Mapped bags are only supported on little endian hosts.");
+}
+
+std::size_t padding(const std::size_t offset)
+{
+  return (MappedPropertyBag::alignment - offset % MappedPropertyBag::alignment) %
+          MappedPropertyBag::alignment;
+}
+
+// Removed unless committed
+struct TemporaryPath
+{
+  ~TemporaryPath() { if (!committed) ::unlink(path.c_str()); }
+
+  std::string path;
+  bool committed = false;
+};
+
+void sync_file(const std::string& path)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+
+  const bool synced = (fd >= 0) && (::fsync(fd) == 0);
+
+  if (fd >= 0) ::close(fd);
+
+  if (!synced)
+    throw PropertyException("Could not sync '" + path + "'.");
+}
+
+} // namespace
+
+constexpr std::size_t MappedPropertyBag::alignment;
+
+MappedPropertyBag::MappedPropertyBag(const std::string& path)
+{
+  check_little_endian();
+
+  const int fd = ::open(path.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    throw PropertyException("Could not open mapped bag '" + path + "'.");
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || std::size_t(st.st_size) < alignment)
+  {
+    ::close(fd);
+    throw PropertyException("Invalid mapped bag '" + path + "'.");
+  }
+
+  size_ = st.st_size;
+
+  void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+
+  // The mapping outlives the descriptor
+  ::close(fd);
+
+  if (addr == MAP_FAILED)
+    throw PropertyException("Could not map bag '" + path + "'.");
+
+  data_ = static_cast<const char*>(addr);
+
+  try
+  {
+    wire::Reader header(data_, header_size);
+
+    char magic[sizeof(mapped_magic)];
+    header.read(magic, sizeof(magic));
+
+    if (std::memcmp(magic, mapped_magic, sizeof(magic)) != 0)
+      throw PropertyException("Mapped bag: invalid signature.");
+
+    if (header.read_scalar<std::uint8_t>() > mapped_version)
+      throw PropertyException("Mapped bag: unsupported version.");
+
+    const std::uint64_t index_offset = header.read_scalar<std::uint64_t>();
+    const std::uint64_t index_size   = header.read_scalar<std::uint64_t>();
+
+    if (index_offset > size_ || index_size > size_ - index_offset)
+      throw PropertyException("Mapped bag: index out of range.");
+
+    wire::Reader index(data_ + index_offset, index_size);
+
+    index.read_string(name_);
+
+    const std::uint64_t handling = index.read_varint();
+    if (handling > static_cast<std::size_t>(RetrievalHandling::THROW))
+      throw PropertyException("Mapped bag: unknown retrieval handling.");
+
+    default_handling_ = static_cast<RetrievalHandling>(handling);
+
+    const std::uint64_t num_entries = index.read_varint();
+    index.check_count(num_entries, 1);
+
+    for (std::uint64_t i=0; i<num_entries; ++i)
+    {
+      std::string name;
+      Entry entry;
+
+      index.read_string(name);
+      index.read_string(entry.type_name);
+      entry.flags = index.read_scalar<std::uint8_t>();
+      index.read_string(entry.description);
+      entry.scalar = index.read_scalar<std::uint8_t>();
+      entry.rows   = index.read_varint();
+      entry.cols   = index.read_varint();
+      entry.offset = index.read_varint();
+      entry.size   = index.read_varint();
+
+      if (entry.offset % alignment != 0 || entry.offset > index_offset ||
+          entry.size > index_offset - entry.offset)
+        throw PropertyException("Mapped bag: value '" + name + "' out of range.");
+
+      const std::size_t scalar_size = entry.scalar & 0x0f;
+
+      if (entry.is_raw() &&
+          (scalar_size == 0 ||
+           (entry.cols != 0 && entry.rows > entry.size / scalar_size / entry.cols) ||
+           entry.rows * entry.cols * scalar_size != entry.size))
+        throw PropertyException("Mapped bag: value '" + name + "' of invalid size.");
+
+      entries_.emplace(std::move(name), std::move(entry));
+    }
+  }
+  catch (...)
+  {
+    unmap();
+    throw;
+  }
+}
+
+MappedPropertyBag::~MappedPropertyBag()
+{
+  unmap();
+}
+
+MappedPropertyBag::MappedPropertyBag(MappedPropertyBag&& rhs) noexcept :
+  data_(rhs.data_),
+  size_(rhs.size_),
+  name_(std::move(rhs.name_)),
+  default_handling_(rhs.default_handling_),
+  entries_(std::move(rhs.entries_))
+{
+  rhs.data_ = nullptr;
+  rhs.size_ = 0;
+}
+
+MappedPropertyBag& MappedPropertyBag::operator=(MappedPropertyBag&& rhs) noexcept
+{
+  if (this == &rhs) return *this;
+
+  unmap();
+
+  data_             = rhs.data_;
+  size_             = rhs.size_;
+  name_             = std::move(rhs.name_);
+  default_handling_ = rhs.default_handling_;
+  entries_          = std::move(rhs.entries_);
+
+  rhs.data_ = nullptr;
+  rhs.size_ = 0;
+
+  return *this;
+}
+
+void MappedPropertyBag::unmap() noexcept
+{
+  if (data_ != nullptr)
+    ::munmap(const_cast<char*>(data_), size_);
+
+  data_ = nullptr;
+  size_ = 0;
+}
+
+const MappedPropertyBag::Entry* MappedPropertyBag::find(const std::string& name) const noexcept
+{
+  const auto it = entries_.find(name);
+  return (it == entries_.end())? nullptr : &it->second;
+}
+
+bool MappedPropertyBag::exists(const std::string& name) const noexcept
+{
+  return find(name) != nullptr;
+}
+
+std::list<std::string> MappedPropertyBag::listProperties() const
+{
+  std::list<std::string> names;
+  for (const auto& entry : entries_)
+    names.push_back(entry.first);
+  return names;
+}
+
+wire::RawView MappedPropertyBag::view(const Entry& entry) const noexcept
+{
+  return wire::RawView{entry.scalar, entry.rows, entry.cols, data_ + entry.offset};
+}
+
+Property MappedPropertyBag::getProperty(const std::string& name) const
+{
+  const Entry* entry = find(name);
+
+  if (entry == nullptr)
+    throw PropertyException("named '" + name + "' not found in mapped bag.");
+
+  const wire::TypeCodec* codec = wire::Registry::instance().find(entry->type_name);
+
+  if (codec == nullptr)
+    throw PropertyException("Mapped bag: type '" + entry->type_name +
+                            "' is not exported to the wire format.");
+
+  Property property;
+
+  if (!entry->is_raw())
+  {
+    wire::Reader reader(data_ + entry->offset, entry->size);
+    codec->decode(reader, property);
+  }
+  else if (codec->decode_raw != nullptr)
+  {
+    codec->decode_raw(view(*entry), property);
+  }
+  else
+  {
+    throw PropertyException("Mapped bag: type '" + entry->type_name +
+                            "' has no raw layout.");
+  }
+
+  Property::wire_accessor::set_flags(property, entry->flags);
+  property.description(entry->description);
+
+  return property;
+}
+
+PropertyBag MappedPropertyBag::toPropertyBag() const
+{
+  PropertyBag bag;
+
+  bag.name(name_);
+  bag.setRetrievalHandling(default_handling_);
+
+  for (const auto& entry : entries_)
+    PropertyBag::wire_accessor::insert(bag, entry.first, getProperty(entry.first));
+
+  return bag;
+}
+
+void write_mapped(const PropertyBag& bag, const std::string& path)
+{
+  check_little_endian();
+
+  // Written aside then renamed, processes that
+  // have 'path' mapped keep reading the old file
+  TemporaryPath tmp;
+  tmp.path = path + ".tmp";
+
+  std::ofstream file(tmp.path, std::ios::binary | std::ios::trunc);
+
+  if (!file)
+    throw PropertyException("Could not open '" + tmp.path + "' for writing.");
+
+  const char zeros[MappedPropertyBag::alignment] = {};
+
+  // The header is written last
+  file.write(zeros, MappedPropertyBag::alignment);
+
+  std::uint64_t offset = MappedPropertyBag::alignment;
+
+  wire::Writer index;
+  index.write_string(bag.name());
+  index.write_varint(static_cast<std::size_t>(bag.getRetrievalHandling()));
+  index.write_varint(bag.size());
+
+  const wire::Registry& registry = wire::Registry::instance();
+
+  for (const auto& property : bag)
+  {
+    const wire::TypeCodec* codec = registry.find(property.second.type());
+
+    if (codec == nullptr)
+      throw PropertyException("Property '" + property.first + "' of type " +
+                              property.second.type_name() +
+                              " is not exported to the wire format.");
+
+    wire::RawView view{0, 0, 0, nullptr};
+    std::string encoded;
+
+    if (codec->raw_view != nullptr)
+    {
+      view = codec->raw_view(property.second);
+      file.write(static_cast<const char*>(view.data), view.num_bytes());
+    }
+    else
+    {
+      wire::Writer writer;
+      codec->encode(writer, property.second);
+      encoded = writer.release();
+      file.write(encoded.data(), encoded.size());
+    }
+
+    const std::uint64_t size = (view.scalar != 0)? view.num_bytes() : encoded.size();
+
+    index.write_string(property.first);
+    index.write_string(codec->name);
+    index.write_scalar(Property::wire_accessor::flags(property.second));
+    index.write_string(property.second.description());
+    index.write_scalar(view.scalar);
+    index.write_varint(view.rows);
+    index.write_varint(view.cols);
+    index.write_varint(offset);
+    index.write_varint(size);
+
+    offset += size;
+
+    const std::size_t pad = padding(offset);
+    file.write(zeros, pad);
+    offset += pad;
+  }
+
+  const std::string index_bytes = index.release();
+  file.write(index_bytes.data(), index_bytes.size());
+
+  wire::Writer header;
+  header.write(mapped_magic, sizeof(mapped_magic));
+  header.write_scalar(mapped_version);
+  header.write_scalar(offset);
+  header.write_scalar(std::uint64_t(index_bytes.size()));
+
+  const std::string header_bytes = header.release();
+
+  file.seekp(0);
+  file.write(header_bytes.data(), header_bytes.size());
+  file.close();
+
+  if (!file)
+    throw PropertyException("Could not write '" + tmp.path + "'.");
+
+  sync_file(tmp.path);
+
+  if (std::rename(tmp.path.c_str(), path.c_str()) != 0)
+    throw PropertyException("Could not rename '" + tmp.path + "' to '" + path + "'.");
+
+  tmp.committed = true;
+}
+
+} /* namespace property_bag */
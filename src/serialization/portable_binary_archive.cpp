@@ -0,0 +1,32 @@
+#include <property_bag/serialization/portable_binary_archive.h>
+
+#include <boost/archive/detail/archive_serializer_map.hpp>
+
+#include <boost/archive/impl/archive_serializer_map.ipp>
+#include <boost/archive/impl/basic_binary_oprimitive.ipp>
+#include <boost/archive/impl/basic_binary_oarchive.ipp>
+#include <boost/archive/impl/basic_binary_iprimitive.ipp>
+#include <boost/archive/impl/basic_binary_iarchive.ipp>
+
+// Explicit instantiations, as done by the boost
+// serialization library for its own archives.
+
+namespace boost {
+namespace archive {
+
+template class detail::archive_serializer_map<property_bag::portable_binary_oarchive>;
+template class basic_binary_oprimitive<
+  property_bag::portable_binary_oarchive, std::ostream::char_type, std::ostream::traits_type>;
+template class basic_binary_oarchive<property_bag::portable_binary_oarchive>;
+template class binary_oarchive_impl<
+  property_bag::portable_binary_oarchive, std::ostream::char_type, std::ostream::traits_type>;
+
+template class detail::archive_serializer_map<property_bag::portable_binary_iarchive>;
+template class basic_binary_iprimitive<
+  property_bag::portable_binary_iarchive, std::istream::char_type, std::istream::traits_type>;
+template class basic_binary_iarchive<property_bag::portable_binary_iarchive>;
+template class binary_iarchive_impl<
+  property_bag::portable_binary_iarchive, std::istream::char_type, std::istream::traits_type>;
+
+} // namespace archive
+} // namespace boost
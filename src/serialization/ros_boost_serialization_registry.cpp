@@ -1,13 +1,7 @@
 #include <property_bag/serialization/property_boost_serialization.h>
 #include <property_bag/serialization/ros_boost_serialization.h>
 
-EXPORT_PROPERTY_NAMED_TYPE(geometry_msgs::Pose, geometry_msgs__Pose)
-EXPORT_PROPERTY_NAMED_TYPE(geometry_msgs::PoseStamped, geometry_msgs__PoseStamped)
-EXPORT_PROPERTY_NAMED_TYPE(geometry_msgs::Point, geometry_msgs__Point)
-EXPORT_PROPERTY_NAMED_TYPE(geometry_msgs::PointStamped, geometry_msgs__PointStamped)
-EXPORT_PROPERTY_NAMED_TYPE(geometry_msgs::Quaternion, geometry_msgs__Quaternion)
-EXPORT_PROPERTY_NAMED_TYPE(geometry_msgs::QuaternionStamped, geometry_msgs__QuaternionStamped)
-EXPORT_PROPERTY_NAMED_TYPE(std_msgs::Time, std_msgs__Time)
-EXPORT_PROPERTY_NAMED_TYPE(std_msgs::Duration, std_msgs__Duration)
 EXPORT_PROPERTY_NAMED_TYPE(ros::Time, ros__Time)
 EXPORT_PROPERTY_NAMED_TYPE(ros::Duration, ros__Duration)
+
+PROPERTY_BAG_DEFINE_REGISTRY(ros_boost)
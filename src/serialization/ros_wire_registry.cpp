@@ -0,0 +1,6 @@
+#include <property_bag/serialization/ros_wire_format.h>
+
+EXPORT_PROPERTY_WIRE_TYPE(ros::Time, ros__Time)
+EXPORT_PROPERTY_WIRE_TYPE(ros::Duration, ros__Duration)
+
+PROPERTY_BAG_DEFINE_REGISTRY(ros_wire)
@@ -0,0 +1,304 @@
+#include <property_bag/serialization/wire_format.h>
+#include <property_bag/serialization/lazy_registry.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <exception>
+#include <istream>
+#include <ostream>
+#include <system_error>
+#include <thread>
+
+#include <unistd.h>
+
+namespace property_bag {
+namespace wire {
+
+void parallel_for(const std::size_t count, std::size_t num_threads,
+                  const std::function<void(std::size_t)>& task)
+{
+  if (count == 0) return;
+
+  if (num_threads == 0)
+    num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+  num_threads = std::min(num_threads, count);
+
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> failed(false);
+
+  std::mutex mutex;
+  std::exception_ptr error;
+
+  const auto work = [&]()
+  {
+    for (std::size_t i = next++; i < count && !failed; i = next++)
+    {
+      try
+      {
+        task(i);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) error = std::current_exception();
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads - 1);
+
+  try
+  {
+    for (std::size_t t=1; t<num_threads; ++t)
+      threads.emplace_back(work);
+  }
+  catch (const std::system_error&)
+  {
+    // Carry on with the threads we got
+  }
+
+  work();
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  if (error) std::rethrow_exception(error);
+}
+
+const char* Reader::skip(const std::size_t size)
+{
+  if (size > remaining())
+    throw PropertyException("Wire format: unexpected end of input.");
+
+  const char* data = data_;
+  data_ += size;
+  return data;
+}
+
+std::uint64_t Reader::read_varint()
+{
+  std::uint64_t v = 0;
+
+  for (unsigned int shift = 0; shift < 64; shift += 7)
+  {
+    const unsigned char byte = static_cast<unsigned char>(*skip(1));
+
+    v |= std::uint64_t(byte & 0x7f) << shift;
+
+    if ((byte & 0x80) == 0) return v;
+  }
+
+  throw PropertyException("Wire format: malformed varint.");
+}
+
+void Reader::read_string(std::string& s)
+{
+  const std::uint64_t size = read_varint();
+  check_count(size, 1);
+  s.assign(skip(size), size);
+}
+
+void Reader::check_count(const std::uint64_t count, const std::size_t size) const
+{
+  if (size != 0 && count > remaining() / size)
+    throw PropertyException("Wire format: unexpected end of input.");
+}
+
+StreamWriter::StreamWriter(std::ostream& os, const std::size_t buffer_size) :
+  os_(&os),
+  buffer_(std::max(buffer_size, std::size_t(16)))
+{
+  //
+}
+
+StreamWriter::StreamWriter(const int fd, const std::size_t buffer_size) :
+  fd_(fd),
+  buffer_(std::max(buffer_size, std::size_t(16)))
+{
+  //
+}
+
+StreamWriter::~StreamWriter()
+{
+  try
+  {
+    flush();
+  }
+  catch (...)
+  {
+    //
+  }
+}
+
+void StreamWriter::write(const void* data, const std::size_t size)
+{
+  if (size > buffer_.size() - used_) flush();
+
+  if (size >= buffer_.size())
+  {
+    sink(static_cast<const char*>(data), size);
+    return;
+  }
+
+  std::memcpy(buffer_.data() + used_, data, size);
+  used_ += size;
+}
+
+char* StreamWriter::extend(const std::size_t size)
+{
+  if (size > buffer_.size() - used_) flush();
+
+  if (size > buffer_.size()) buffer_.resize(size);
+
+  char* data = buffer_.data() + used_;
+  used_ += size;
+  return data;
+}
+
+void StreamWriter::flush()
+{
+  const std::size_t size = used_;
+  used_ = 0;
+
+  sink(buffer_.data(), size);
+
+  if (os_ != nullptr && !os_->flush())
+    throw PropertyException("Wire format: could not write to stream.");
+}
+
+void StreamWriter::sink(const char* data, std::size_t size)
+{
+  written_ += size;
+
+  if (os_ != nullptr)
+  {
+    if (!os_->write(data, size))
+      throw PropertyException("Wire format: could not write to stream.");
+    return;
+  }
+
+  while (size > 0)
+  {
+    const ssize_t n = ::write(fd_, data, size);
+
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      throw PropertyException("Wire format: could not write to file descriptor.");
+    }
+
+    data += n;
+    size -= n;
+  }
+}
+
+StreamReader::StreamReader(std::istream& is, const std::size_t buffer_size) :
+  is_(&is),
+  buffer_(std::max(buffer_size, std::size_t(16)))
+{
+  //
+}
+
+StreamReader::StreamReader(const int fd, const std::size_t buffer_size) :
+  fd_(fd),
+  buffer_(std::max(buffer_size, std::size_t(16)))
+{
+  //
+}
+
+bool StreamReader::fill()
+{
+  consumed_ += end_;
+  begin_ = end_ = 0;
+
+  if (is_ != nullptr)
+  {
+    is_->read(buffer_.data(), buffer_.size());
+    end_ = is_->gcount();
+    return end_ != 0;
+  }
+
+  while (true)
+  {
+    const ssize_t n = ::read(fd_, buffer_.data(), buffer_.size());
+
+    if (n < 0)
+    {
+      if (errno == EINTR) continue;
+      throw PropertyException("Wire format: could not read file descriptor.");
+    }
+
+    end_ = n;
+    return end_ != 0;
+  }
+}
+
+void StreamReader::read(void* out, std::size_t size)
+{
+  char* dst = static_cast<char*>(out);
+
+  while (size > 0)
+  {
+    if (begin_ == end_ && !fill())
+      throw PropertyException("Wire format: unexpected end of input.");
+
+    const std::size_t n = std::min(size, end_ - begin_);
+
+    std::memcpy(dst, buffer_.data() + begin_, n);
+
+    begin_ += n;
+    dst    += n;
+    size   -= n;
+  }
+}
+
+void StreamReader::read_bytes(std::string& out, const std::uint64_t size)
+{
+  out.clear();
+
+  while (out.size() < size)
+  {
+    const std::size_t offset = out.size();
+    const std::size_t n = std::min<std::uint64_t>(size - offset, buffer_.size());
+
+    out.resize(offset + n);
+    read(&out[offset], n);
+  }
+}
+
+std::uint64_t StreamReader::read_varint()
+{
+  std::uint64_t v = 0;
+
+  for (unsigned int shift = 0; shift < 64; shift += 7)
+  {
+    unsigned char byte;
+    read(&byte, 1);
+
+    v |= std::uint64_t(byte & 0x7f) << shift;
+
+    if ((byte & 0x80) == 0) return v;
+  }
+
+  throw PropertyException("Wire format: malformed varint.");
+}
+
+Registry& Registry::instance()
+{
+  // Never destroyed, codecs may be looked up
+  // during the destruction of static objects.
+  static Registry* instance = new Registry();
+  return *instance;
+}
+
+} /* namespace wire */
+
+namespace details {
+
+template class LazyRegistry<wire::TypeCodec, &wire::TypeCodec::name>;
+
+} /* namespace details */
+} /* namespace property_bag */
@@ -0,0 +1,125 @@
+#include "property_bag/utils.h"
+
+#include <array>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+/**
+ * @brief The TypeMapper class.
+ * A process-wide <type_info, demangled name> cache.
+ *
+ * Entries are kept in a fixed number of buckets, each one
+ * being an insert-only singly linked list. Readers only
+ * ever follow 'acquire' loaded pointers, thus a lookup of
+ * an already registered type never locks. Writers push
+ * at the head of a bucket with a CAS. Entries are never
+ * removed so that returned references stay valid.
+ */
+class TypeMapper
+{
+  struct Entry
+  {
+    Entry(const std::type_info& ti, std::string&& name) :
+      type(&ti),
+      demangled(std::move(name)),
+      next(nullptr) { }
+
+    const std::type_info* type;
+    const std::string demangled;
+    Entry* next;
+  };
+
+  using Bucket = std::atomic<Entry*>;
+
+  static constexpr std::size_t num_buckets = 256;
+
+public:
+
+  TypeMapper()
+  {
+    for (auto& bucket : buckets_)
+      bucket.store(nullptr, std::memory_order_relaxed);
+  }
+
+  ~TypeMapper() = default;
+
+  TypeMapper(TypeMapper&)      = delete;
+  void operator=(TypeMapper&)  = delete;
+
+  const std::string& lookup(const std::type_info& ti)
+  {
+    Bucket& bucket = buckets_[ti.hash_code() % num_buckets];
+
+    Entry* head = bucket.load(std::memory_order_acquire);
+
+    const Entry* found = find(head, nullptr, ti);
+    if (found != nullptr) return found->demangled;
+
+    std::unique_ptr<Entry> entry(new Entry(ti, demangle(ti)));
+    entry->next = head;
+
+    // On failure entry->next is reloaded with the current head,
+    // only the entries pushed in the meantime need to be checked.
+    while (!bucket.compare_exchange_weak(entry->next, entry.get(),
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire))
+    {
+      found = find(entry->next, head, ti);
+      if (found != nullptr) return found->demangled;
+
+      head = entry->next;
+    }
+
+    return entry.release()->demangled;
+  }
+
+protected:
+
+  static const Entry* find(const Entry* from, const Entry* until,
+                           const std::type_info& ti)
+  {
+    for (; from != until; from = from->next)
+      if (*from->type == ti) return from;
+
+    return nullptr;
+  }
+
+  static std::string demangle(const std::type_info& ti)
+  {
+    if (ti == typeid(std::string)) return "std::string";
+
+    return property_bag::details::demangle(ti.name());
+  }
+
+  std::array<Bucket, num_buckets> buckets_;
+};
+
+constexpr std::size_t TypeMapper::num_buckets;
+
+TypeMapper& type_mapper_inst()
+{
+  // Intentionally leaked, names may be
+  // requested during static destruction.
+  static TypeMapper* inst = new TypeMapper();
+  return *inst;
+}
+
+} // namespace
+
+namespace property_bag
+{
+
+constexpr string_view::size_type string_view::npos;
+
+namespace details
+{
+
+const std::string& name_of(const std::type_info& ti)
+{
+  return type_mapper_inst().lookup(ti);
+}
+
+} // namespace details
+} // namespace property_bag
@@ -0,0 +1,231 @@
+#include <property_bag/xmlrpc.h>
+
+namespace property_bag {
+
+namespace {
+
+using XmlRpc::XmlRpcValue;
+
+// The accessors of XmlRpcValue are not const on every distribution
+XmlRpcValue& as_mutable(const XmlRpcValue& value)
+{
+  return const_cast<XmlRpcValue&>(value);
+}
+
+std::string child_path(const std::string& path, const std::string& key)
+{
+  return path.empty()? key : path + "/" + key;
+}
+
+[[noreturn]] void unsupported(const std::string& path, const std::string& what)
+{
+  throw PropertyException("Could not convert parameter '" + path + "', " + what + ".");
+}
+
+void read_struct(XmlRpcValue& params, const std::string& path, PropertyBag& bag);
+
+template <typename T>
+std::vector<T> read_array(XmlRpcValue& array)
+{
+  std::vector<T> values;
+  values.reserve(array.size());
+
+  for (int i=0; i<array.size(); ++i)
+    values.push_back(static_cast<T&>(array[i]));
+
+  return values;
+}
+
+std::vector<double> read_numeric_array(XmlRpcValue& array)
+{
+  std::vector<double> values;
+  values.reserve(array.size());
+
+  for (int i=0; i<array.size(); ++i)
+  {
+    XmlRpcValue& value = array[i];
+    values.push_back(value.getType() == XmlRpcValue::TypeInt ?
+                       static_cast<int&>(value) : static_cast<double&>(value));
+  }
+
+  return values;
+}
+
+std::vector<PropertyBag> read_struct_array(XmlRpcValue& array, const std::string& path)
+{
+  std::vector<PropertyBag> bags(array.size());
+
+  for (int i=0; i<array.size(); ++i)
+    read_struct(array[i], child_path(path, std::to_string(i)), bags[i]);
+
+  return bags;
+}
+
+void add_array(XmlRpcValue& array, const std::string& key,
+               const std::string& path, PropertyBag& bag)
+{
+  if (array.size() == 0)
+  {
+    bag.addProperty(key, std::vector<double>());
+    return;
+  }
+
+  // The type of the elements, TypeDouble if numbers are mixed
+  XmlRpcValue::Type type = array[0].getType();
+  for (int i=1; i<array.size(); ++i)
+  {
+    const XmlRpcValue::Type element = array[i].getType();
+
+    if (element == type) continue;
+
+    const bool numbers = (type == XmlRpcValue::TypeInt || type == XmlRpcValue::TypeDouble) &&
+                         (element == XmlRpcValue::TypeInt || element == XmlRpcValue::TypeDouble);
+    if (!numbers)
+      unsupported(child_path(path, key), "heterogeneous array");
+
+    type = XmlRpcValue::TypeDouble;
+  }
+
+  switch (type)
+  {
+  case XmlRpcValue::TypeBoolean:
+    bag.addProperty(key, read_array<bool>(array));
+    break;
+  case XmlRpcValue::TypeInt:
+    bag.addProperty(key, read_array<int>(array));
+    break;
+  case XmlRpcValue::TypeDouble:
+    bag.addProperty(key, read_numeric_array(array));
+    break;
+  case XmlRpcValue::TypeString:
+    bag.addProperty(key, read_array<std::string>(array));
+    break;
+  case XmlRpcValue::TypeStruct:
+    bag.addProperty(key, read_struct_array(array, child_path(path, key)));
+    break;
+  default:
+    unsupported(child_path(path, key), "unsupported array element type");
+  }
+}
+
+void add_value(XmlRpcValue& value, const std::string& key,
+               const std::string& path, PropertyBag& bag)
+{
+  switch (value.getType())
+  {
+  case XmlRpcValue::TypeBoolean:
+    bag.addProperty(key, bool(static_cast<bool&>(value)));
+    break;
+  case XmlRpcValue::TypeInt:
+    bag.addProperty(key, int(static_cast<int&>(value)));
+    break;
+  case XmlRpcValue::TypeDouble:
+    bag.addProperty(key, double(static_cast<double&>(value)));
+    break;
+  case XmlRpcValue::TypeString:
+    bag.addProperty(key, std::string(static_cast<std::string&>(value)));
+    break;
+  case XmlRpcValue::TypeArray:
+    add_array(value, key, path, bag);
+    break;
+  case XmlRpcValue::TypeStruct:
+  {
+    PropertyBag nested;
+    read_struct(value, child_path(path, key), nested);
+    bag.addProperty(key, std::move(nested));
+    break;
+  }
+  default:
+    unsupported(child_path(path, key), "unsupported type");
+  }
+}
+
+void read_struct(XmlRpcValue& params, const std::string& path, PropertyBag& bag)
+{
+  if (params.getType() != XmlRpcValue::TypeStruct)
+    unsupported(path, "expected a struct");
+
+  for (auto& member : params)
+    add_value(member.second, member.first, path, bag);
+}
+
+void write_struct(const PropertyBag& bag, const std::string& path, XmlRpcValue& params);
+
+template <typename T>
+void write_array(const std::vector<T>& values, XmlRpcValue& array)
+{
+  array.setSize(int(values.size()));
+
+  for (std::size_t i=0; i<values.size(); ++i)
+    array[int(i)] = XmlRpcValue(T(values[i]));
+}
+
+void write_value(const Property& property, const std::string& key,
+                 const std::string& path, XmlRpcValue& value)
+{
+  if (const bool* v = property.get_if<bool>())
+    value = XmlRpcValue(*v);
+  else if (const int* v = property.get_if<int>())
+    value = XmlRpcValue(*v);
+  else if (const double* v = property.get_if<double>())
+    value = XmlRpcValue(*v);
+  else if (const std::string* v = property.get_if<std::string>())
+    value = XmlRpcValue(*v);
+  else if (const PropertyBag* v = property.get_if<PropertyBag>())
+    write_struct(*v, child_path(path, key), value);
+  else if (const std::vector<double>* v = property.get_if<std::vector<double>>())
+    write_array(*v, value);
+  else if (const std::vector<int>* v = property.get_if<std::vector<int>>())
+    write_array(*v, value);
+  else if (const std::vector<std::string>* v = property.get_if<std::vector<std::string>>())
+    write_array(*v, value);
+  else if (const std::vector<bool>* v = property.get_if<std::vector<bool>>())
+    write_array(*v, value);
+  else if (const std::vector<PropertyBag>* v = property.get_if<std::vector<PropertyBag>>())
+  {
+    value.setSize(int(v->size()));
+
+    const std::string array_path = child_path(path, key);
+    for (std::size_t i=0; i<v->size(); ++i)
+      write_struct((*v)[i], child_path(array_path, std::to_string(i)), value[int(i)]);
+  }
+  else
+    unsupported(child_path(path, key), "unsupported type " + property.type_name());
+}
+
+void write_struct(const PropertyBag& bag, const std::string& path, XmlRpcValue& params)
+{
+  params = XmlRpcValue();
+  params.begin(); // makes it an empty struct
+
+  for (const auto& property : bag)
+    write_value(property.second, property.first, path, params[property.first]);
+}
+
+} // namespace
+
+void from_xmlrpc(const XmlRpc::XmlRpcValue& params, PropertyBag& bag)
+{
+  if (params.getType() != XmlRpc::XmlRpcValue::TypeStruct)
+    throw PropertyException("Could not convert parameters, expected a struct.");
+
+  PropertyBag loaded;
+  read_struct(as_mutable(params), "", loaded);
+
+  loaded.setRetrievalHandling(bag.getRetrievalHandling());
+  bag = std::move(loaded);
+}
+
+void to_xmlrpc(const PropertyBag& bag, XmlRpc::XmlRpcValue& params)
+{
+  write_struct(bag, "", params);
+}
+
+XmlRpc::XmlRpcValue to_xmlrpc(const PropertyBag& bag)
+{
+  XmlRpc::XmlRpcValue params;
+  to_xmlrpc(bag, params);
+  return params;
+}
+
+} /* namespace property_bag */
@@ -0,0 +1,202 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/property_bag_boost_serialization.h"
+#include "property_bag/serialization/eigen_boost_serialization.h"
+#include "property_bag/serialization/eigen_wire_format.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+// Many keys, descriptions and small values
+property_bag::PropertyBag make_configuration_bag()
+{
+  property_bag::PropertyBag bag;
+  bag.name("robot_configuration");
+
+  const std::vector<std::string> joints = {"arm_left", "arm_right", "head", "torso", "wheel"};
+
+  for (int i=0; i<400; ++i)
+  {
+    const std::string joint = joints[i % joints.size()] + "_" + std::to_string(i/joints.size()+1) + "_joint";
+
+    bag.addPropertiesWithDoc(joint + "/controller/gains/p", 100. + i%7, "Proportional gain of the " + joint + " position controller",
+                             joint + "/controller/gains/d", 0.5, "Derivative gain of the " + joint + " position controller",
+                             joint + "/limits/max_velocity", 2.5, "Maximum velocity of the " + joint + " in rad/s",
+                             joint + "/enabled", true, "Whether " + joint + " is enabled",
+                             joint + "/frame_id", joint + "_link", "The frame attached to " + joint);
+  }
+
+  return bag;
+}
+
+// Smooth numeric arrays
+property_bag::PropertyBag make_calibration_bag()
+{
+  property_bag::PropertyBag bag;
+  bag.name("camera_calibration");
+
+  for (int c=0; c<2; ++c)
+  {
+    Eigen::VectorXd lut(5000);
+    for (int i=0; i<lut.size(); ++i)
+      lut[i] = std::round(std::sin(i*1e-3 + c) * 1e4) * 1e-4;
+
+    bag.addProperty("camera_" + std::to_string(c) + "/distortion_lut", lut,
+                    "Radial distortion look-up table");
+    bag.addProperty("camera_" + std::to_string(c) + "/offsets",
+                    std::vector<double>(1000, c * 0.125),
+                    "Per-column offsets");
+  }
+
+  return bag;
+}
+
+} // namespace
+
+TEST(CompressionTest, RoundTrip)
+{
+  const property_bag::PropertyBag bag = make_configuration_bag();
+
+  const std::string text = property_bag::to_str(bag);
+
+  for (const property_bag::Compression compression : {property_bag::Compression::NONE,
+                                                      property_bag::Compression::ZLIB,
+                                                      property_bag::Compression::BZIP2})
+  {
+    for (const int level : {1, property_bag::default_compression_level, 9})
+    {
+      const std::string compressed_text = property_bag::to_str(bag, compression, level);
+      const std::string compressed_bytes = property_bag::to_bytes(bag, compression, level);
+
+      EXPECT_EQ(property_bag::detect_compression(compressed_text.data(), compressed_text.size()),
+                compression);
+
+      if (compression != property_bag::Compression::NONE)
+      {
+        EXPECT_LT(compressed_text.size(), text.size() / 4);
+      }
+
+      // Format detected
+      property_bag::PropertyBag loaded;
+      ASSERT_NO_THROW(property_bag::from_str(compressed_text, loaded));
+      EXPECT_EQ(loaded.name(), "robot_configuration");
+      EXPECT_EQ(loaded.size(), bag.size());
+      EXPECT_EQ(property_bag::to_str(loaded), text);
+
+      loaded = property_bag::PropertyBag();
+      ASSERT_NO_THROW(property_bag::from_bytes(compressed_bytes, loaded));
+      EXPECT_EQ(property_bag::to_str(loaded), text);
+
+      // Streamed
+      std::stringstream ss;
+      property_bag::to_stream<boost::archive::binary_oarchive>(bag, ss, compression, level);
+
+      loaded = property_bag::PropertyBag();
+      ASSERT_NO_THROW(property_bag::from_stream<boost::archive::binary_iarchive>(ss, loaded));
+      EXPECT_EQ(property_bag::to_str(loaded), text);
+    }
+  }
+
+  // Uncompressed inputs are still read
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_str(text, loaded));
+  EXPECT_EQ(loaded.size(), bag.size());
+
+  EXPECT_EQ(property_bag::decompress(text), text);
+
+  PRINTF("All good at CompressionTest::RoundTrip !\n");
+}
+
+TEST(CompressionTest, WireFormat)
+{
+  const property_bag::PropertyBag bag = make_calibration_bag();
+
+  const std::string wire = property_bag::to_wire(bag);
+
+  // In memory
+  const std::string compressed = property_bag::compress(wire, property_bag::Compression::ZLIB);
+  EXPECT_LT(compressed.size(), wire.size());
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_wire(property_bag::decompress(compressed), loaded));
+  EXPECT_EQ(property_bag::to_wire(loaded), wire);
+
+  // Streamed
+  std::stringstream ss;
+  {
+    property_bag::CompressedOStream os(ss, property_bag::Compression::BZIP2);
+    property_bag::to_wire(bag, os);
+    ASSERT_NO_THROW(os.close());
+  }
+
+  property_bag::DecompressedIStream is(ss);
+  EXPECT_EQ(is.compression(), property_bag::Compression::BZIP2);
+
+  loaded = property_bag::PropertyBag();
+  ASSERT_NO_THROW(property_bag::from_wire(is, loaded));
+  EXPECT_EQ(property_bag::to_wire(loaded), wire);
+
+  // Not compressed, passed through
+  std::stringstream plain(wire);
+  property_bag::DecompressedIStream plain_is(plain);
+  EXPECT_EQ(plain_is.compression(), property_bag::Compression::NONE);
+
+  loaded = property_bag::PropertyBag();
+  ASSERT_NO_THROW(property_bag::from_wire(plain_is, loaded));
+  EXPECT_EQ(property_bag::to_wire(loaded), wire);
+
+  PRINTF("All good at CompressionTest::WireFormat !\n");
+}
+
+TEST(CompressionTest, Errors)
+{
+  const property_bag::PropertyBag bag("my_int", 5, "my_string", std::string(1000, 's'));
+
+  EXPECT_THROW(property_bag::to_str(bag, property_bag::Compression::ZLIB, 10),
+               property_bag::PropertyException);
+  EXPECT_THROW(property_bag::compress("abc", property_bag::Compression::BZIP2, 0),
+               property_bag::PropertyException);
+
+  for (const property_bag::Compression compression : {property_bag::Compression::ZLIB,
+                                                      property_bag::Compression::BZIP2})
+  {
+    std::string corrupted = property_bag::to_bytes(bag, compression);
+    corrupted.resize(corrupted.size() / 2);
+
+    EXPECT_THROW(property_bag::decompress(corrupted), property_bag::PropertyException);
+
+    property_bag::PropertyBag loaded;
+    EXPECT_ANY_THROW(property_bag::from_bytes(corrupted, loaded));
+  }
+
+  PRINTF("All good at CompressionTest::Errors !\n");
+}
+
+TEST(CompressionTest, Ratio)
+{
+  const property_bag::PropertyBag configuration = make_configuration_bag();
+  const property_bag::PropertyBag calibration   = make_calibration_bag();
+
+  for (const property_bag::PropertyBag* bag : {&configuration, &calibration})
+  {
+    const std::string binary = property_bag::to_bytes(*bag);
+    const std::string wire   = property_bag::to_wire(*bag);
+
+    for (const property_bag::Compression compression : {property_bag::Compression::ZLIB,
+                                                        property_bag::Compression::BZIP2})
+    {
+      EXPECT_LT(property_bag::compress(binary, compression).size(), binary.size() / 2) << bag->name();
+      EXPECT_LT(property_bag::compress(wire, compression).size(), wire.size() / 2) << bag->name();
+    }
+  }
+
+  PRINTF("All good at CompressionTest::Ratio !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,300 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/delta_boost_serialization.h"
+
+#include <boost/archive/xml_oarchive.hpp>
+#include <boost/archive/xml_iarchive.hpp>
+
+EXPORT_PROPERTY_NAMED_TYPE(test::Dummy, test__Dummy);
+
+namespace {
+
+property_bag::PropertyBag make_bag(const int size)
+{
+  property_bag::PropertyBag bag;
+  bag.name("robot_configuration");
+
+  for (int i=0; i<size; ++i)
+    bag.addProperty("joint_" + std::to_string(i) + "/gain", 100. + i,
+                    "Proportional gain of joint " + std::to_string(i));
+
+  return bag;
+}
+
+// Same keys, descriptions and values
+void expect_same(const property_bag::PropertyBag& lhs, const property_bag::PropertyBag& rhs)
+{
+  ASSERT_EQ(lhs.listProperties(), rhs.listProperties());
+  EXPECT_EQ(lhs.name(), rhs.name());
+  EXPECT_EQ(lhs.getRetrievalHandling(), rhs.getRetrievalHandling());
+
+  for (const auto& property : lhs)
+  {
+    const property_bag::Property& other = rhs.getProperty(property.first);
+
+    EXPECT_EQ(property.second.type(), other.type());
+    EXPECT_EQ(property.second.description(), other.description());
+    EXPECT_EQ(property.second.is_modified(), other.is_modified());
+
+    if (property.second.is_same<double>())
+    {
+      EXPECT_EQ(property.second.get<double>(), other.get<double>());
+    }
+  }
+}
+
+} // namespace
+
+TEST(DeltaTest, Revision)
+{
+  property_bag::Property property(5, "my_int_doc");
+
+  std::uint64_t revision = property.revision();
+  std::uint64_t changes  = property.changes();
+  EXPECT_LE(revision, property_bag::details::current_revision());
+
+  // Copies keep them
+  property_bag::Property copy(property);
+  EXPECT_EQ(copy.revision(), revision);
+  EXPECT_EQ(copy.changes(), changes);
+
+  const property_bag::Property& const_property = property;
+  EXPECT_EQ(const_property.get<int>(), 5);
+  EXPECT_NE(const_property.get_if<int>(), nullptr);
+  EXPECT_EQ(property.revision(), revision);
+  EXPECT_EQ(property.changes(), changes);
+
+  property_bag::Property other(9);
+
+  // Updated in place, the clock is left alone
+  const std::uint64_t clock = property_bag::details::current_revision();
+
+  property.set(6);
+  EXPECT_GT(property.changes(), changes);
+  changes = property.changes();
+
+  EXPECT_EQ(property.try_set(7), property_bag::ErrorCode::OK);
+  EXPECT_GT(property.changes(), changes);
+  changes = property.changes();
+
+  EXPECT_EQ(property.try_set(7.), property_bag::ErrorCode::TYPE_MISMATCH);
+  EXPECT_EQ(property.changes(), changes);
+
+  EXPECT_EQ(property.try_swap(other), property_bag::ErrorCode::OK);
+  EXPECT_GT(property.changes(), changes);
+  changes = property.changes();
+
+  // Possibly modified in place
+  property.get<int>() = 8;
+  EXPECT_GT(property.changes(), changes);
+  changes = property.changes();
+
+  EXPECT_NE(property.get_if<int>(), nullptr);
+  EXPECT_GT(property.changes(), changes);
+  changes = property.changes();
+
+  EXPECT_EQ(property.get_if<double>(), nullptr);
+  EXPECT_EQ(property.changes(), changes);
+
+  EXPECT_EQ(property.revision(), revision);
+  EXPECT_EQ(property_bag::details::current_revision(), clock);
+
+  // Replaced
+  property.description("another_doc");
+  EXPECT_GT(property.revision(), revision);
+  revision = property.revision();
+
+  property.touch();
+  EXPECT_GT(property.revision(), revision);
+  revision = property.revision();
+
+  copy = property;
+  EXPECT_GT(copy.revision(), revision);
+
+  PRINTF("All good at DeltaTest::Revision !\n");
+}
+
+TEST(DeltaTest, ChangesSinceCheckpoint)
+{
+  property_bag::PropertyBag bag = make_bag(10);
+
+  property_bag::PropertyBagCheckpoint checkpoint;
+
+  // Everything against an empty checkpoint
+  property_bag::PropertyBagDelta delta = property_bag::make_delta(bag, checkpoint);
+  EXPECT_EQ(delta.changed.size(), bag.size());
+  EXPECT_TRUE(delta.removed.empty());
+  EXPECT_EQ(delta.changed.name(), "robot_configuration");
+  EXPECT_EQ(checkpoint.keys().size(), bag.size());
+
+  // Nothing since
+  EXPECT_TRUE(property_bag::make_delta(bag, checkpoint).empty());
+
+  // Reads are not changes
+  double value = 0;
+  EXPECT_TRUE(bag.getPropertyValue("joint_3/gain", value));
+  EXPECT_EQ(bag.tryGetPropertyValue("joint_4/gain", value), property_bag::ErrorCode::OK);
+  EXPECT_TRUE(property_bag::make_delta(bag, checkpoint).empty());
+
+  EXPECT_TRUE(bag.updateProperty("joint_3/gain", 0.5));
+
+  // Values shared with the delta are unshared
+  ASSERT_TRUE(bag.enterRealTime());
+  EXPECT_EQ(bag.tryUpdateProperty("joint_7/gain", 0.25), property_bag::ErrorCode::OK);
+  bag.exitRealTime();
+
+  EXPECT_TRUE(bag.removeProperty("joint_5/gain"));
+  EXPECT_TRUE(bag.addProperty("joint_10/gain", 1., "Proportional gain of joint 10"));
+
+  delta = property_bag::make_delta(bag, checkpoint);
+  EXPECT_EQ(delta.changed.listProperties(),
+            (std::list<std::string>{"joint_10/gain", "joint_3/gain", "joint_7/gain"}));
+  EXPECT_EQ(delta.removed, std::vector<std::string>{"joint_5/gain"});
+  EXPECT_EQ(checkpoint.keys().size(), bag.size());
+
+  EXPECT_TRUE(property_bag::make_delta(bag, checkpoint).empty());
+
+  // A key removed then added back is changed
+  bag.removeProperty("joint_1/gain");
+  bag.addProperty("joint_1/gain", 2.);
+
+  delta = property_bag::make_delta(bag, checkpoint);
+  EXPECT_EQ(delta.changed.listProperties(), std::list<std::string>{"joint_1/gain"});
+  EXPECT_TRUE(delta.removed.empty());
+
+  // Or appended back from an older copy
+  const property_bag::PropertyBag older = bag;
+
+  bag.getProperty("joint_2/gain") = property_bag::Property(3.);
+  EXPECT_EQ(property_bag::make_delta(bag, checkpoint).changed.size(), 1);
+
+  bag.removeProperty("joint_2/gain");
+  ASSERT_TRUE(bag.append(older));
+
+  delta = property_bag::make_delta(bag, checkpoint);
+  EXPECT_EQ(delta.changed.listProperties(), std::list<std::string>{"joint_2/gain"});
+  EXPECT_EQ(delta.changed.getProperty("joint_2/gain").get<double>(), 102.);
+
+  // Assigned the same properties
+  bag = older;
+
+  delta = property_bag::make_delta(bag, checkpoint);
+  EXPECT_EQ(delta.changed.size(), bag.size());
+  EXPECT_TRUE(property_bag::make_delta(bag, checkpoint).empty());
+
+  // Replaced wholesale
+  bag = make_bag(3);
+
+  delta = property_bag::make_delta(bag, checkpoint);
+  EXPECT_EQ(delta.changed.size(), 3);
+  EXPECT_EQ(delta.removed.size(), 7);
+
+  PRINTF("All good at DeltaTest::ChangesSinceCheckpoint !\n");
+}
+
+TEST(DeltaTest, ApplyInPlace)
+{
+  property_bag::PropertyBag bag = make_bag(100);
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+
+  property_bag::PropertyBagCheckpoint checkpoint;
+
+  property_bag::PropertyBag replica;
+
+  // Full sync first
+  ASSERT_TRUE(property_bag::apply_delta(property_bag::to_delta(bag, checkpoint), replica));
+  expect_same(bag, replica);
+
+  for (int n=0; n<5; ++n)
+  {
+    bag.updateProperty("joint_" + std::to_string(n*10) + "/gain", -1. * n);
+    bag.removeProperty("joint_" + std::to_string(n*10 + 1) + "/gain");
+    bag.addProperty("extra_" + std::to_string(n), n + 0.5, "Extra");
+    bag.getProperty("joint_" + std::to_string(n*10 + 2) + "/gain").description("New doc");
+
+    const std::string bytes = property_bag::to_delta(bag, checkpoint);
+    ASSERT_TRUE(property_bag::apply_delta(bytes, replica));
+    expect_same(bag, replica);
+  }
+
+  // Text archives too
+  bag.updateProperty("joint_99/gain", 99.5);
+  ASSERT_TRUE(property_bag::apply_delta<boost::archive::text_iarchive>(
+                property_bag::to_delta<boost::archive::text_oarchive>(bag, checkpoint), replica));
+  expect_same(bag, replica);
+
+  // Refused in real-time mode
+  bag.updateProperty("joint_98/gain", 98.5);
+  const std::string bytes = property_bag::to_delta(bag, checkpoint);
+
+  ASSERT_TRUE(replica.enterRealTime());
+  EXPECT_FALSE(property_bag::apply_delta(bytes, replica));
+  replica.exitRealTime();
+
+  EXPECT_TRUE(property_bag::apply_delta(bytes, replica));
+  expect_same(bag, replica);
+
+  // Corrupted, untouched
+  property_bag::PropertyBag copy = replica;
+  copy.name(replica.name());
+  EXPECT_ANY_THROW(property_bag::apply_delta(bytes.substr(0, bytes.size()/2), replica));
+  expect_same(copy, replica);
+
+  PRINTF("All good at DeltaTest::ApplyInPlace !\n");
+}
+
+// Written once the archive is closed
+TEST(DeltaTest, Xml)
+{
+  property_bag::PropertyBag bag;
+  bag.addProperties("a", test::Dummy{1, 0.5, "a"}, "b", test::Dummy{2, 1.5, "b"});
+
+  property_bag::PropertyBagCheckpoint checkpoint;
+
+  property_bag::PropertyBag replica;
+
+  ASSERT_TRUE(property_bag::apply_delta<boost::archive::xml_iarchive>(
+                property_bag::to_delta<boost::archive::xml_oarchive>(bag, checkpoint), replica));
+  ASSERT_EQ(bag.listProperties(), replica.listProperties());
+
+  bag.updateProperty("b", test::Dummy{3, 2.5, "c"});
+  bag.removeProperty("a");
+
+  const std::string xml = property_bag::to_delta<boost::archive::xml_oarchive>(bag, checkpoint);
+  EXPECT_NE(std::string::npos, xml.rfind("</boost_serialization>"));
+
+  ASSERT_TRUE(property_bag::apply_delta<boost::archive::xml_iarchive>(xml, replica));
+  ASSERT_EQ(bag.listProperties(), replica.listProperties());
+  EXPECT_EQ(test::Dummy(3, 2.5, "c"), replica.getProperty("b").get<test::Dummy>());
+
+  PRINTF("All good at DeltaTest::Xml !\n");
+}
+
+TEST(DeltaTest, SparseChanges)
+{
+  property_bag::PropertyBag bag = make_bag(5000);
+
+  property_bag::PropertyBagCheckpoint checkpoint(bag);
+
+  for (int i=0; i<10; ++i)
+    bag.updateProperty("joint_" + std::to_string(i * 499) + "/gain", 0.5 * i);
+
+  const std::string full  = property_bag::to_bytes(bag);
+  const std::string delta = property_bag::to_delta(bag, checkpoint);
+
+  EXPECT_LT(delta.size() * 100, full.size());
+
+  property_bag::PropertyBag loaded;
+  property_bag::apply_delta(delta, loaded);
+  EXPECT_EQ(loaded.size(), 10);
+
+  EXPECT_TRUE(property_bag::make_delta(bag, checkpoint).empty());
+
+  PRINTF("All good at DeltaTest::SparseChanges !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
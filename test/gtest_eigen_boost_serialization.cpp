@@ -4,6 +4,25 @@
 
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+
+#include <random>
+
+namespace {
+
+// Bytes taken by 'n' values in a binary archive,
+// the type information being written only once.
+template <typename T>
+std::size_t binary_size(const T& t, const int n)
+{
+  std::stringstream ss;
+  boost::archive::binary_oarchive oa(ss, boost::archive::no_header);
+  for (int i=0; i<n; ++i) oa << t;
+  return ss.str().size();
+}
+
+} // namespace
 
 TEST(EigenSerializationTest, EigenMatrixBoostSerialization)
 {
@@ -128,70 +147,122 @@ TEST(EigenSerializationTest, EigenTripletBoostSerialization)
   PRINTF("All good at EigenSerializationTest::EigenTripletBoostSerialization !\n");
 }
 
-///@todo missing == operator
-//TEST(EigenSerializationTest, EigenSparseMatrixBoostSerialization)
-//{
-//  std::stringstream ss;
+template <typename Sparse>
+Sparse randomSparse(const int rows, const int cols)
+{
+  std::default_random_engine gen;
+  std::uniform_real_distribution<double> dist(0.0,1.0);
+
+  std::vector<Eigen::Triplet<typename Sparse::Scalar>> triplets;
+  for(int i=0;i<rows;++i)
+    for(int j=0;j<cols;++j)
+    {
+      const double v_ij=dist(gen);
+      if(v_ij < 0.1)
+        triplets.emplace_back(i, j, typename Sparse::Scalar(v_ij*100));
+    }
+
+  Sparse m(rows, cols);
+  m.setFromTriplets(triplets.begin(), triplets.end());
+  return m;
+}
 
-//  int rows=100;
-//  int cols=100;
+template <typename Sparse>
+bool sameSparse(const Sparse& a, const Sparse& b)
+{
+  return a.rows() == b.rows() && a.cols() == b.cols() &&
+         a.nonZeros() == b.nonZeros() &&
+         Eigen::MatrixXd(a.template cast<double>()) == Eigen::MatrixXd(b.template cast<double>());
+}
 
-//  Eigen::SparseMatrix<double> mat_double(rows, cols);
-//  Eigen::SparseMatrix<float> mat_float(rows, cols);
-//  Eigen::SparseMatrix<int> mat_int(rows, cols);
+TEST(EigenSerializationTest, EigenSparseMatrixBoostSerialization)
+{
+  const auto mat_double = randomSparse<Eigen::SparseMatrix<double>>(100, 80);
+  const auto mat_float  = randomSparse<Eigen::SparseMatrix<float, Eigen::RowMajor>>(80, 100);
+  const auto mat_int    = randomSparse<Eigen::SparseMatrix<int>>(50, 50);
 
-//  std::default_random_engine gen;
-//  std::uniform_real_distribution<double> dist(0.0,1.0);
+  Eigen::SparseMatrix<double> uncompressed = mat_double;
+  uncompressed.insert(99, 0) = 42;
+  ASSERT_FALSE(uncompressed.isCompressed());
 
-//  std::vector<Eigen::Triplet<double>> triplet_double;
-//  std::vector<Eigen::Triplet<float>> triplet_float;
-//  std::vector<Eigen::Triplet<int>> triplet_int;
-//  for(int i=0;i<rows;++i)
-//    for(int j=0;j<cols;++j)
-//    {
-//      auto v_ij=dist(gen); //generate random number
-//      if(v_ij < 0.1)
-//      {
-//        triplet_double.push_back(T(i,j,v_ij)); //if larger than treshold, insert it
-//        triplet_float.push_back(T(i,j,v_ij)); //if larger than treshold, insert it
-//        triplet_int.push_back(T(i,j,v_ij)); //if larger than treshold, insert it
-//      }
-//    }
+  const Eigen::SparseMatrix<double> empty(10, 10);
 
-//  mat_double.setFromTriplets(triplet_double.begin(), triplet_double.end());
-//  mat_float.setFromTriplets(triplet_float.begin(), triplet_float.end());
-//  mat_int.setFromTriplets(triplet_int.begin(), triplet_int.end());
+  std::stringstream text, binary;
+  {
+    boost::archive::text_oarchive   ta(text);
+    boost::archive::binary_oarchive ba(binary);
 
-//  {
-//    boost::archive::text_oarchive oa(ss);
+    ASSERT_NO_THROW(ta << mat_double << mat_float << mat_int << uncompressed << empty);
+    ASSERT_NO_THROW(ba << mat_double << mat_float << mat_int << uncompressed << empty);
+  }
 
-//    ASSERT_NO_THROW(oa << mat_double);
+  PRINTF("EigenSerializationTest::EigenSparseMatrixBoostSerialization Saved !\n");
 
-//    ASSERT_NO_THROW(oa << mat_float);
+  boost::archive::text_iarchive   ta(text);
+  boost::archive::binary_iarchive ba(binary);
 
-//    ASSERT_NO_THROW(oa << mat_int);
-//  }
+  for (int n=0; n<2; ++n)
+  {
+    Eigen::SparseMatrix<double> mat_double_loaded, uncompressed_loaded, empty_loaded;
+    Eigen::SparseMatrix<float, Eigen::RowMajor> mat_float_loaded;
+    Eigen::SparseMatrix<int> mat_int_loaded;
+
+    if (n == 0)
+      ASSERT_NO_THROW(ta >> mat_double_loaded >> mat_float_loaded >> mat_int_loaded
+                         >> uncompressed_loaded >> empty_loaded);
+    else
+      ASSERT_NO_THROW(ba >> mat_double_loaded >> mat_float_loaded >> mat_int_loaded
+                         >> uncompressed_loaded >> empty_loaded);
+
+    EXPECT_TRUE(sameSparse(mat_double, mat_double_loaded));
+    EXPECT_TRUE(sameSparse(mat_float, mat_float_loaded));
+    EXPECT_TRUE(sameSparse(mat_int, mat_int_loaded));
+    EXPECT_TRUE(sameSparse(uncompressed, uncompressed_loaded));
+    EXPECT_TRUE(sameSparse(empty, empty_loaded));
+    EXPECT_TRUE(mat_double_loaded.isCompressed());
+  }
 
-//  PRINTF("EigenSerializationTest::EigenSparseMatrixBoostSerialization Saved !\n");
+  // Corrupted storage
+  std::stringstream corrupted;
+  {
+    boost::archive::binary_oarchive ba(corrupted);
+    ba << mat_int;
+  }
+  std::string bytes = corrupted.str();
+  // The last inner index is just before the values
+  const std::size_t last_inner = bytes.size() - mat_int.nonZeros()*sizeof(int) - sizeof(int);
+  const int out_of_range = 1000;
+  std::memcpy(&bytes[last_inner], &out_of_range, sizeof(int));
+
+  std::stringstream corrupted_in(bytes);
+  boost::archive::binary_iarchive ia(corrupted_in);
+  Eigen::SparseMatrix<int> mat_int_loaded;
+  EXPECT_THROW(ia >> mat_int_loaded, boost::archive::archive_exception);
+
+  PRINTF("All good at EigenSerializationTest::EigenSparseMatrixBoostSerialization !\n");
+}
+
+TEST(EigenSerializationTest, EigenSparseMatrixVersion0BoostSerialization)
+{
+  // Written by the version 0, triplets based, serialization
+  std::stringstream ss("22 serialization::archive 18 0 0 3 4 0 0 3 0 0 0 0 1 1.50000000000000000e+00 2 1 -2.00000000000000000e+00 1 3 4.00000000000000000e+00 0 0 3 2 0 0 2 0 0 0 0 2 5.000000000e+00 1 0 3.000000000e+00\n");
 
-//  {
-//    boost::archive::text_iarchive ia(ss);
+  boost::archive::text_iarchive ia(ss);
 
-//    Eigen::SparseMatrix<double> mat_double_loaded;
-//    ASSERT_NO_THROW(ia >> mat_double_loaded);
-//    ASSERT_EQ(mat_double, mat_double_loaded);
+  Eigen::SparseMatrix<double> m;
+  Eigen::SparseMatrix<float, Eigen::RowMajor> r;
+  ASSERT_NO_THROW(ia >> m >> r);
 
-//    Eigen::SparseMatrix<float> mat_float_loaded;
-//    ASSERT_NO_THROW(ia >> mat_float_loaded);
-//    ASSERT_EQ(mat_float, mat_float_loaded);
+  Eigen::MatrixXd m_expected = Eigen::MatrixXd::Zero(3, 4);
+  m_expected(0, 1) = 1.5; m_expected(2, 1) = -2; m_expected(1, 3) = 4;
+  EXPECT_EQ(Eigen::MatrixXd(m), m_expected);
 
-//    Eigen::SparseMatrix<int> mat_int_loaded;
-//    ASSERT_NO_THROW(ia >> mat_int_loaded);
-//    ASSERT_EQ(mat_int, mat_int_loaded);
-//  }
+  Eigen::MatrixXf r_expected = Eigen::MatrixXf::Zero(2, 3);
+  r_expected(1, 0) = 3; r_expected(0, 2) = 5;
+  EXPECT_EQ(Eigen::MatrixXf(r), r_expected);
 
-//  PRINTF("All good at EigenSerializationTest::EigenSparseMatrixBoostSerialization !\n");
-//}
+  PRINTF("All good at EigenSerializationTest::EigenSparseMatrixVersion0BoostSerialization !\n");
+}
 
 TEST(EigenSerializationTest, EigenQuaternionBoostSerialization)
 {
@@ -309,6 +380,125 @@ TEST(EigenSerializationTest, EigenTransformBoostSerialization)
   PRINTF("All good at EigenSerializationTest::EigenTransformBoostSerialization !\n");
 }
 
+namespace {
+
+struct FixedSizeValues
+{
+  Eigen::Isometry3d   iso3d;
+  Eigen::Affine2f     aff2f;
+  Eigen::Projective3d proj3d;
+  Eigen::Vector3d     vec3d;
+  Eigen::Matrix3f     mat3f;
+  Eigen::Quaterniond  quat;
+  Eigen::MatrixXd     matxd;
+
+  template <class Archive>
+  void serialize(Archive& ar, const unsigned int /*version*/)
+  {
+    ar & iso3d & aff2f & proj3d & vec3d & mat3f & quat & matxd;
+  }
+
+  void expectApprox(const FixedSizeValues& o) const
+  {
+    EXPECT_TRUE(iso3d.isApprox(o.iso3d));
+    EXPECT_EQ(iso3d.matrix().row(3), Eigen::RowVector4d(0, 0, 0, 1));
+    EXPECT_TRUE(aff2f.isApprox(o.aff2f));
+    EXPECT_TRUE(proj3d.isApprox(o.proj3d));
+    EXPECT_TRUE(vec3d.isApprox(o.vec3d));
+    EXPECT_TRUE(mat3f.isApprox(o.mat3f));
+    EXPECT_TRUE(quat.isApprox(o.quat));
+    EXPECT_TRUE(matxd.isApprox(o.matxd));
+  }
+};
+
+template <class OArchive, class IArchive>
+void roundTrip(const FixedSizeValues& values)
+{
+  std::stringstream ss;
+  {
+    OArchive oa(ss);
+    ASSERT_NO_THROW(oa << values);
+  }
+
+  FixedSizeValues loaded;
+  IArchive ia(ss);
+  ASSERT_NO_THROW(ia >> loaded);
+
+  loaded.expectApprox(values);
+}
+
+} // namespace
+
+TEST(EigenSerializationTest, EigenCompactFixedSizeBoostSerialization)
+{
+  FixedSizeValues values;
+
+  values.iso3d = Eigen::Isometry3d::Identity();
+  values.iso3d.translate(Eigen::Vector3d(1, 2, 3));
+  values.iso3d.rotate(Eigen::AngleAxisd(0.5, Eigen::Vector3d(1, 1, 0).normalized()));
+
+  values.aff2f = Eigen::Affine2f::Identity();
+  values.aff2f.translate(Eigen::Vector2f(4, 5));
+  values.aff2f.rotate(0.3f);
+
+  values.proj3d.matrix() = Eigen::Matrix4d::Random();
+
+  values.vec3d = Eigen::Vector3d(1, 2, 3);
+  values.mat3f = Eigen::Matrix3f::Random();
+  values.quat  = Eigen::Quaterniond(Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitZ()));
+  values.matxd = Eigen::MatrixXd::Random(4, 7);
+
+  // No dimensions, only the data
+  EXPECT_EQ(binary_size(values.vec3d,  2) - binary_size(values.vec3d,  1), 3*sizeof(double));
+  EXPECT_EQ(binary_size(values.mat3f,  2) - binary_size(values.mat3f,  1), 9*sizeof(float));
+  EXPECT_EQ(binary_size(values.quat,   2) - binary_size(values.quat,   1), 4*sizeof(double));
+  EXPECT_EQ(binary_size(values.iso3d,  2) - binary_size(values.iso3d,  1), 12*sizeof(double));
+  EXPECT_EQ(binary_size(values.aff2f,  2) - binary_size(values.aff2f,  1), 6*sizeof(float));
+  EXPECT_EQ(binary_size(values.proj3d, 2) - binary_size(values.proj3d, 1), 16*sizeof(double));
+  EXPECT_EQ(binary_size(values.matxd,  2) - binary_size(values.matxd,  1),
+            2*sizeof(int) + 28*sizeof(double));
+
+  roundTrip<boost::archive::text_oarchive, boost::archive::text_iarchive>(values);
+  roundTrip<boost::archive::binary_oarchive, boost::archive::binary_iarchive>(values);
+
+  PRINTF("All good at EigenSerializationTest::EigenCompactFixedSizeBoostSerialization !\n");
+}
+
+TEST(EigenSerializationTest, EigenVersion0BoostSerialization)
+{
+  // Written by the version 0 serialization of
+  // Vector3d, MatrixXd(2,3), Quaterniond, Isometry3d and Affine2f
+  std::stringstream ss("22 serialization::archive 18 0 0 3 1 1.00000000000000000e+00 2.00000000000000000e+00 3.00000000000000000e+00 0 0 2 3 1.00000000000000000e+00 4.00000000000000000e+00 2.00000000000000000e+00 5.00000000000000000e+00 3.00000000000000000e+00 6.00000000000000000e+00 0 0 5.00000000000000000e-01 5.00000000000000000e-01 -5.00000000000000000e-01 5.00000000000000000e-01 0 0 4 4 0.00000000000000000e+00 1.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 -1.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 1.00000000000000000e+00 0.00000000000000000e+00 1.00000000000000000e+00 2.00000000000000000e+00 3.00000000000000000e+00 1.00000000000000000e+00 0 0 3 3 1.000000000e+00 0.000000000e+00 0.000000000e+00 0.000000000e+00 1.000000000e+00 0.000000000e+00 4.000000000e+00 5.000000000e+00 1.000000000e+00\n");
+
+  boost::archive::text_iarchive ia(ss);
+
+  Eigen::Vector3d v;
+  Eigen::MatrixXd m;
+  Eigen::Quaterniond q;
+  Eigen::Isometry3d t;
+  Eigen::Affine2f a;
+
+  ASSERT_NO_THROW(ia >> v >> m >> q >> t >> a);
+
+  EXPECT_EQ(v, Eigen::Vector3d(1, 2, 3));
+
+  Eigen::MatrixXd m_expected(2, 3);
+  m_expected << 1, 2, 3, 4, 5, 6;
+  EXPECT_EQ(m, m_expected);
+
+  EXPECT_EQ(q.coeffs(), Eigen::Quaterniond(0.5, 0.5, -0.5, 0.5).coeffs());
+
+  Eigen::Matrix3d linear;
+  linear << 0, -1, 0, 1, 0, 0, 0, 0, 1;
+  EXPECT_EQ(t.linear(), linear);
+  EXPECT_EQ(t.translation(), Eigen::Vector3d(1, 2, 3));
+
+  EXPECT_EQ(a.translation(), Eigen::Vector2f(4, 5));
+  EXPECT_EQ(a.linear(), Eigen::Matrix2f::Identity());
+
+  PRINTF("All good at EigenSerializationTest::EigenVersion0BoostSerialization !\n");
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,287 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/journal.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct TemporaryDirectory
+{
+  TemporaryDirectory()
+  {
+    char name[] = "/tmp/property_bag_XXXXXX";
+    path = ::mkdtemp(name);
+  }
+
+  ~TemporaryDirectory()
+  {
+    for (const std::string& file : files())
+      std::remove((path + "/" + file).c_str());
+
+    ::rmdir(path.c_str());
+  }
+
+  std::vector<std::string> files() const
+  {
+    std::vector<std::string> names;
+
+    DIR* dir = ::opendir(path.c_str());
+    while (dirent* entry = ::readdir(dir))
+    {
+      const std::string name = entry->d_name;
+      if (name != "." && name != "..") names.push_back(name);
+    }
+    ::closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+  std::string path;
+};
+
+std::size_t file_size(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  return file.tellg();
+}
+
+template <typename T>
+T value_of(const property_bag::PropertyBag& bag, const std::string& key)
+{
+  T value = T();
+  EXPECT_TRUE(bag.getPropertyValue(key, value)) << key;
+  return value;
+}
+
+} // namespace
+
+TEST(JournalTest, Recovery)
+{
+  TemporaryDirectory dir;
+  const std::string path = dir.path + "/bag";
+
+  {
+    property_bag::JournaledPropertyBag journaled(path);
+
+    EXPECT_TRUE(journaled.bag().empty());
+
+    EXPECT_TRUE(journaled.addProperty("my_int", 5, "my_int_doc"));
+    EXPECT_TRUE(journaled.addProperty("my_double", 0.5));
+    EXPECT_TRUE(journaled.addProperty("my_string", std::string("left")));
+    EXPECT_TRUE(journaled.addProperty("my_vector", std::vector<double>{1, 2, 3}));
+    EXPECT_TRUE(journaled.addProperty("my_bag", property_bag::PropertyBag("nested", 3)));
+
+    EXPECT_FALSE(journaled.addProperty("my_int", 6));
+    EXPECT_TRUE(journaled.updateProperty("my_int", 42));
+    EXPECT_TRUE(journaled.updateProperty("my_double", 2.5));
+    EXPECT_FALSE(journaled.updateProperty("unknown", 2.5));
+    EXPECT_TRUE(journaled.removeProperty("my_string"));
+    EXPECT_FALSE(journaled.removeProperty("my_string"));
+
+    // Not exported to the wire format
+    EXPECT_THROW(journaled.addProperty("my_unsigned", 5u), property_bag::PropertyException);
+    EXPECT_FALSE(journaled.bag().exists("my_unsigned"));
+
+    EXPECT_EQ(0, journaled.generation());
+  }
+
+  property_bag::JournaledPropertyBag journaled(path);
+  const property_bag::PropertyBag& bag = journaled.bag();
+
+  EXPECT_EQ(4, bag.size());
+  EXPECT_EQ(42, value_of<int>(bag, "my_int"));
+  EXPECT_EQ("my_int_doc", bag.getProperty("my_int").description());
+  EXPECT_EQ(2.5, value_of<double>(bag, "my_double"));
+  EXPECT_FALSE(bag.exists("my_string"));
+  EXPECT_EQ(std::vector<double>({1, 2, 3}), value_of<std::vector<double>>(bag, "my_vector"));
+  EXPECT_EQ(3, value_of<int>(value_of<property_bag::PropertyBag>(bag, "my_bag"), "nested"));
+
+  // Appended after the replayed records
+  EXPECT_TRUE(journaled.updateProperty("my_int", 7));
+  {
+    property_bag::JournaledPropertyBag reopened(path);
+    EXPECT_EQ(7, value_of<int>(reopened.bag(), "my_int"));
+  }
+
+  PRINTF("All good at JournalTest::Recovery !\n");
+}
+
+TEST(JournalTest, TornRecord)
+{
+  TemporaryDirectory dir;
+  const std::string path = dir.path + "/bag";
+  const std::string journal = path + ".0.journal";
+
+  {
+    property_bag::JournaledPropertyBag journaled(path);
+    journaled.addProperty("my_int", 1);
+    journaled.addProperty("my_string", std::string("before"));
+    journaled.updateProperty("my_int", 2);
+  }
+
+  // Crashed while appending the last record
+  const std::size_t size = file_size(journal);
+  ASSERT_EQ(0, ::truncate(journal.c_str(), size - 3));
+
+  {
+    property_bag::JournaledPropertyBag journaled(path);
+    EXPECT_EQ(1, value_of<int>(journaled.bag(), "my_int"));
+    EXPECT_EQ("before", value_of<std::string>(journaled.bag(), "my_string"));
+
+    // The torn record is dropped, not followed
+    journaled.updateProperty("my_int", 3);
+  }
+
+  {
+    property_bag::JournaledPropertyBag journaled(path);
+    EXPECT_EQ(3, value_of<int>(journaled.bag(), "my_int"));
+  }
+
+  // A corrupted byte in the last record
+  {
+    std::fstream file(journal, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-1, std::ios::end);
+    file.put('\x7f');
+  }
+
+  {
+    property_bag::JournaledPropertyBag journaled(path);
+    EXPECT_EQ(1, value_of<int>(journaled.bag(), "my_int"));
+  }
+
+  PRINTF("All good at JournalTest::TornRecord !\n");
+}
+
+TEST(JournalTest, Compaction)
+{
+  TemporaryDirectory dir;
+  const std::string path = dir.path + "/bag";
+
+  {
+    property_bag::JournaledPropertyBag journaled(path, 4096);
+
+    for (int i=0; i<100; ++i)
+      journaled.addProperty("joint_" + std::to_string(i) + "/gain", double(i), "A gain");
+
+    for (int i=0; i<5000; ++i)
+      journaled.updateProperty("joint_" + std::to_string(i%100) + "/gain", double(i));
+
+    EXPECT_LT(0, journaled.generation());
+  }
+
+  // The snapshot and the current journal only
+  const std::vector<std::string> files = dir.files();
+  ASSERT_EQ(2, files.size());
+  EXPECT_EQ("bag", files[0]);
+
+  {
+    property_bag::JournaledPropertyBag journaled(path, 4096);
+    const property_bag::PropertyBag& bag = journaled.bag();
+
+    EXPECT_EQ(100, bag.size());
+    for (int i=0; i<100; ++i)
+    {
+      const std::string key = "joint_" + std::to_string(i) + "/gain";
+      EXPECT_EQ(4900. + i, value_of<double>(bag, key));
+      EXPECT_EQ("A gain", bag.getProperty(key).description());
+    }
+
+    journaled.removeProperty("joint_0/gain");
+    journaled.compact();
+    EXPECT_EQ(2, dir.files().size());
+  }
+
+  {
+    property_bag::JournaledPropertyBag journaled(path);
+    EXPECT_EQ(99, journaled.bag().size());
+    EXPECT_FALSE(journaled.bag().exists("joint_0/gain"));
+  }
+
+  // A corrupted snapshot is reported
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-1, std::ios::end);
+    file.put('\x7f');
+  }
+
+  EXPECT_THROW(property_bag::JournaledPropertyBag journaled(path), property_bag::PropertyException);
+
+  PRINTF("All good at JournalTest::Compaction !\n");
+}
+
+TEST(JournalTest, BackgroundCompactionError)
+{
+  TemporaryDirectory dir;
+  const std::string path = dir.path + "/bag";
+
+  property_bag::JournaledPropertyBag journaled(path, 256);
+
+  // The snapshot can not be written aside
+  ASSERT_EQ(0, ::mkdir((path + ".tmp").c_str(), 0755));
+
+  for (int i=0; i<100; ++i)
+    journaled.addProperty("joint_" + std::to_string(i) + "/gain", double(i));
+
+  // Started again once the first one failed
+  for (int i=0; journaled.generation() < 2; ++i)
+    journaled.updateProperty("joint_" + std::to_string(i%100) + "/gain", double(i));
+
+  // Would now succeed, the previous error is reported first
+  ASSERT_EQ(0, ::rmdir((path + ".tmp").c_str()));
+
+  EXPECT_THROW(journaled.compact(), property_bag::PropertyException);
+
+  // Reported once
+  EXPECT_NO_THROW(journaled.compact());
+
+  property_bag::JournaledPropertyBag reopened(path);
+  EXPECT_EQ(100, reopened.bag().size());
+
+  PRINTF("All good at JournalTest::BackgroundCompactionError !\n");
+}
+
+TEST(JournalTest, WriteAmplification)
+{
+  TemporaryDirectory dir;
+  const std::string path = dir.path + "/bag";
+
+  {
+    property_bag::JournaledPropertyBag journaled(path);
+
+    for (int i=0; i<1000; ++i)
+      journaled.addProperty("joint_" + std::to_string(i) + "/gain", double(i));
+    journaled.addProperty("calibration", std::vector<double>(100000, 1.));
+
+    journaled.compact();
+
+    const std::size_t before = journaled.journalSize();
+
+    for (int i=0; i<2000; ++i)
+      journaled.updateProperty("joint_" + std::to_string(i%1000) + "/gain", i * 0.5);
+
+    const double per_update = double(journaled.journalSize() - before) / 2000;
+
+    // Its key, type name and value, not the bag
+    EXPECT_GT(64, per_update);
+  }
+
+  property_bag::JournaledPropertyBag journaled(path);
+
+  EXPECT_EQ(1001, journaled.bag().size());
+  EXPECT_EQ(1999 * 0.5, value_of<double>(journaled.bag(), "joint_999/gain"));
+
+  PRINTF("All good at JournalTest::WriteAmplification !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,305 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/json_format.h"
+#include "property_bag/serialization/eigen_json_format.h"
+#include "property_bag/serialization/property_bag_boost_serialization.h"
+#include "property_bag/serialization/eigen_boost_serialization.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+property_bag::PropertyBag make_bag()
+{
+  property_bag::PropertyBag nested("my_int", 3, "my_string", std::string("nested"));
+  nested.name("nested_bag");
+
+  property_bag::PropertyBag bag;
+  bag.name("my_bag");
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+
+  bag.addPropertiesWithDoc("my_bool", true, "my_bool_doc",
+                           "my_int", -5, "my_int_doc",
+                           "my_float", 0.1f, "",
+                           "my_double", 0.1, "my \"quoted\"\tdoc\n",
+                           "my_string", std::string("caf\xc3\xa9 \\ \x01 \xf0\x9f\xa4\x96"), "",
+                           "my_vector_int", std::vector<int>{1, -2, 3}, "",
+                           "my_vector_double", std::vector<double>{1., 2.5, -1e-300, 1e300}, "",
+                           "my_vector_string", std::vector<std::string>{"a", "", "c"}, "",
+                           "my_bag", nested, "A nested bag",
+                           "my_vector3", Eigen::Vector3d(1, 2.5, -3), "",
+                           "my_vectorx", Eigen::VectorXd::LinSpaced(7, 0, 1).eval(), "",
+                           "my_matrix", Eigen::MatrixXd::Identity(3, 4).eval(), "",
+                           "my_quaternion", Eigen::Quaterniond(0.5, -0.5, 0.5, -0.5), "",
+                           "my_isometry", Eigen::Isometry3d(Eigen::Translation3d(1, 2, 3)), "",
+                           "my_empty", std::vector<double>(), "");
+
+  bag.updateProperty("my_int", 42);
+
+  return bag;
+}
+
+template <typename T>
+bool same_bits(const T& lhs, const T& rhs)
+{
+  return std::memcmp(&lhs, &rhs, sizeof(T)) == 0;
+}
+
+} // namespace
+
+TEST(JsonFormatTest, RoundTrip)
+{
+  const property_bag::PropertyBag bag = make_bag();
+
+  for (const int indent : {0, 2})
+  {
+    const std::string json = property_bag::to_json(bag, indent);
+
+    property_bag::PropertyBag loaded;
+    ASSERT_NO_THROW(property_bag::from_json(json, loaded)) << json;
+
+    EXPECT_EQ(loaded.name(), "my_bag");
+    EXPECT_EQ(loaded.getRetrievalHandling(), property_bag::RetrievalHandling::THROW);
+    ASSERT_EQ(loaded.listProperties(), bag.listProperties());
+
+    for (const auto& property : bag)
+    {
+      const property_bag::Property& other = loaded.getProperty(property.first);
+      EXPECT_EQ(property.second.type(), other.type()) << property.first;
+      EXPECT_EQ(property.second.description(), other.description()) << property.first;
+      EXPECT_EQ(property.second.is_modified(), other.is_modified()) << property.first;
+    }
+
+    EXPECT_EQ(loaded.getProperty("my_int").get<int>(), 42);
+    EXPECT_EQ(loaded.getProperty("my_float").get<float>(), 0.1f);
+    EXPECT_EQ(loaded.getProperty("my_double").get<double>(), 0.1);
+    EXPECT_EQ(loaded.getProperty("my_string").get<std::string>(),
+              bag.getProperty("my_string").get<std::string>());
+    EXPECT_EQ(loaded.getProperty("my_vector_double").get<std::vector<double>>(),
+              bag.getProperty("my_vector_double").get<std::vector<double>>());
+    EXPECT_EQ(loaded.getProperty("my_vectorx").get<Eigen::VectorXd>(),
+              bag.getProperty("my_vectorx").get<Eigen::VectorXd>());
+    EXPECT_EQ(loaded.getProperty("my_matrix").get<Eigen::MatrixXd>(),
+              bag.getProperty("my_matrix").get<Eigen::MatrixXd>());
+    EXPECT_EQ(loaded.getProperty("my_quaternion").get<Eigen::Quaterniond>().coeffs(),
+              bag.getProperty("my_quaternion").get<Eigen::Quaterniond>().coeffs());
+    EXPECT_EQ(loaded.getProperty("my_isometry").get<Eigen::Isometry3d>().matrix(),
+              bag.getProperty("my_isometry").get<Eigen::Isometry3d>().matrix());
+
+    const property_bag::PropertyBag& nested = loaded.getProperty("my_bag").get<property_bag::PropertyBag>();
+    EXPECT_EQ(nested.name(), bag.getProperty("my_bag").get<property_bag::PropertyBag>().name());
+    EXPECT_EQ(nested.getProperty("my_string").get<std::string>(), "nested");
+
+    // Same JSON
+    EXPECT_EQ(property_bag::to_json(loaded, indent), json);
+  }
+
+  PRINTF("All good at JsonFormatTest::RoundTrip !\n");
+}
+
+TEST(JsonFormatTest, ExactNumbers)
+{
+  const std::vector<double> doubles = {0., -0., 0.1, 1./3., -2.5, 100., 1e15, 123456789012345678.,
+                                       std::numeric_limits<double>::max(),
+                                       std::numeric_limits<double>::lowest(),
+                                       std::numeric_limits<double>::min(),
+                                       std::numeric_limits<double>::denorm_min(),
+                                       std::numeric_limits<double>::epsilon(),
+                                       std::numeric_limits<double>::infinity(),
+                                       -std::numeric_limits<double>::infinity(),
+                                       std::numeric_limits<double>::quiet_NaN()};
+
+  const std::vector<float> floats = {0.f, -0.f, 0.1f, 1.f/3.f, 16777216.f, 3.4e38f, 1e-45f,
+                                     std::numeric_limits<float>::min()};
+
+  property_bag::PropertyBag bag("my_doubles", doubles);
+
+  for (std::size_t i=0; i<floats.size(); ++i)
+    bag.addProperty("my_float_" + std::to_string(i), floats[i]);
+
+  // Random bits
+  std::vector<double> random(10000);
+  std::uint64_t state = 42;
+  for (double& d : random)
+  {
+    do
+    {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      std::memcpy(&d, &state, sizeof(d));
+    }
+    while (!std::isfinite(d));
+  }
+  bag.addProperty("my_random", random);
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_json(property_bag::to_json(bag), loaded));
+
+  const auto& loaded_doubles = loaded.getProperty("my_doubles").get<std::vector<double>>();
+  ASSERT_EQ(loaded_doubles.size(), doubles.size());
+
+  for (std::size_t i=0; i<doubles.size(); ++i)
+  {
+    EXPECT_TRUE(same_bits(loaded_doubles[i], doubles[i])) << i << " " << doubles[i];
+  }
+
+  for (std::size_t i=0; i<floats.size(); ++i)
+  {
+    EXPECT_TRUE(same_bits(loaded.getProperty("my_float_" + std::to_string(i)).get<float>(),
+                          floats[i])) << floats[i];
+  }
+
+  EXPECT_TRUE(loaded.getProperty("my_random").get<std::vector<double>>() == random);
+
+  // Fewest digits
+  EXPECT_EQ(property_bag::to_json(property_bag::PropertyBag("d", 0.1, "f", 0.1f, "i", 100.)),
+            "{\"name\":\"\",\"handling\":\"QUIET\",\"properties\":{"
+            "\"d\":{\"type\":\"double\",\"value\":0.1},"
+            "\"f\":{\"type\":\"float\",\"value\":0.1},"
+            "\"i\":{\"type\":\"double\",\"value\":100.0}}}");
+
+  PRINTF("All good at JsonFormatTest::ExactNumbers !\n");
+}
+
+TEST(JsonFormatTest, Readable)
+{
+  property_bag::PropertyBag bag;
+  bag.name("robot");
+  bag.addPropertiesWithDoc("gain", 0.5, "Proportional gain",
+                           "joints", std::vector<std::string>{"a", "b"}, "");
+
+  EXPECT_EQ(property_bag::to_json(bag, 2),
+            "{\n"
+            "  \"name\": \"robot\",\n"
+            "  \"handling\": \"QUIET\",\n"
+            "  \"properties\": {\n"
+            "    \"gain\": {\n"
+            "      \"type\": \"double\",\n"
+            "      \"description\": \"Proportional gain\",\n"
+            "      \"value\": 0.5\n"
+            "    },\n"
+            "    \"joints\": {\n"
+            "      \"type\": \"std_vector_string\",\n"
+            "      \"value\": [\"a\",\"b\"]\n"
+            "    }\n"
+            "  }\n"
+            "}");
+
+  PRINTF("All good at JsonFormatTest::Readable !\n");
+}
+
+TEST(JsonFormatTest, HandWritten)
+{
+  // Any member order, value before its type, unknown members, escapes
+  const std::string json = R"(
+    {
+      "comment" : {"written": ["by", "hand", 1, null, true]},
+      "properties" : {
+        "b" : { "value" : [[1, 2], [3, 4.5e0]], "type" : "eigen_matrixxd" },
+        "a" : { "value" : "é🤖\/\"", "type" : "std__string", "modified" : true },
+        "c" : { "type" : "int", "value" : -2147483648 },
+        "d" : { "type" : "std_vector_double", "value" : [ "NaN", "-Infinity", 1E2, -0.0 ] }
+      },
+      "name" : "hand"
+    }
+  )";
+
+  property_bag::PropertyBag bag;
+  ASSERT_NO_THROW(property_bag::from_json(json, bag));
+
+  EXPECT_EQ(bag.name(), "hand");
+  EXPECT_EQ(bag.listProperties(), (std::list<std::string>{"a", "b", "c", "d"}));
+
+  EXPECT_EQ(bag.getProperty("a").get<std::string>(), "\xc3\xa9\xf0\x9f\xa4\x96/\"");
+  EXPECT_TRUE(bag.getProperty("a").is_modified());
+  EXPECT_FALSE(bag.getProperty("b").is_modified());
+
+  Eigen::MatrixXd m(2, 2);
+  m << 1, 2, 3, 4.5;
+  EXPECT_EQ(bag.getProperty("b").get<Eigen::MatrixXd>(), m);
+
+  EXPECT_EQ(bag.getProperty("c").get<int>(), std::numeric_limits<int>::min());
+
+  const auto& d = bag.getProperty("d").get<std::vector<double>>();
+  ASSERT_EQ(d.size(), 4);
+  EXPECT_TRUE(std::isnan(d[0]));
+  EXPECT_EQ(d[1], -std::numeric_limits<double>::infinity());
+  EXPECT_EQ(d[2], 100.);
+  EXPECT_TRUE(std::signbit(d[3]));
+
+  PRINTF("All good at JsonFormatTest::HandWritten !\n");
+}
+
+TEST(JsonFormatTest, Errors)
+{
+  const property_bag::PropertyBag bag = make_bag();
+  const std::string json = property_bag::to_json(bag);
+
+  const std::vector<std::string> malformed = {
+    "",
+    "[]",
+    json.substr(0, json.size() / 2),
+    json + "x",
+    R"({"properties":{"a":{"type":"int","value":2147483648}}})",
+    R"({"properties":{"a":{"type":"int","value":1.5}}})",
+    R"({"properties":{"a":{"type":"int","value":01}}})",
+    R"({"properties":{"a":{"type":"int"}}})",
+    R"({"properties":{"a":{"value":1}}})",
+    R"({"properties":{"a":{"type":"unknown","value":1}}})",
+    R"({"properties":{"a":{"type":"std_vector_int","value":[1,]}}})",
+    R"({"properties":{"a":{"type":"std__string","value":"\x"}}})",
+    R"({"properties":{"a":{"type":"std__string","value":"\ud800"}}})",
+    R"({"properties":{"a":{"type":"eigen_vector3","value":[1,2]}}})",
+    R"({"properties":{"a":{"type":"eigen_matrixxd","value":[[1,2],[3]]}}})",
+    R"({"handling":"LOUD"})",
+    "{\"name\":\"a\nb\"}",
+  };
+
+  for (const std::string& input : malformed)
+  {
+    property_bag::PropertyBag loaded = bag;
+    loaded.name(bag.name());
+    EXPECT_THROW(property_bag::from_json(input, loaded), property_bag::PropertyException) << input;
+
+    // Untouched
+    EXPECT_EQ(property_bag::to_json(loaded), json);
+  }
+
+  // Trailing input, of a bag that differs from the loaded one
+  property_bag::PropertyBag loaded("a", 1);
+  EXPECT_THROW(property_bag::from_json(property_bag::to_json(property_bag::PropertyBag("b", 2)) +
+                                       " garbage", loaded),
+               property_bag::PropertyException);
+  EXPECT_TRUE(loaded.exists("a"));
+  EXPECT_FALSE(loaded.exists("b"));
+
+  // Not exported
+  property_bag::PropertyBag unexported("my_long_double", 1.L);
+  EXPECT_THROW(property_bag::to_json(unexported), property_bag::PropertyException);
+
+  PRINTF("All good at JsonFormatTest::Errors !\n");
+}
+
+TEST(JsonFormatTest, Streams)
+{
+  const property_bag::PropertyBag bag = make_bag();
+
+  std::stringstream ss;
+  property_bag::to_json(bag, ss, 4);
+
+  EXPECT_EQ(ss.str(), property_bag::to_json(bag, 4));
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_json(ss, loaded));
+  EXPECT_EQ(property_bag::to_json(loaded), property_bag::to_json(bag));
+
+  PRINTF("All good at JsonFormatTest::Streams !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,216 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/eigen_mapped_bag.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <unistd.h>
+
+namespace {
+
+struct TemporaryFile
+{
+  TemporaryFile()
+  {
+    char name[] = "/tmp/property_bag_XXXXXX";
+    ::close(::mkstemp(name));
+    path = name;
+  }
+
+  ~TemporaryFile() { std::remove(path.c_str()); }
+
+  std::string path;
+};
+
+} // namespace
+
+TEST(MappedBagTest, InPlaceAccess)
+{
+  TemporaryFile file;
+
+  const Eigen::MatrixXd matrix = Eigen::MatrixXd::Random(30, 20);
+  const Eigen::Vector3d vector3(1, 2, 3);
+  const Eigen::Quaterniond quaternion(Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitZ()));
+
+  property_bag::PropertyBag nested("nested_int", -42);
+
+  property_bag::PropertyBag bag;
+  bag.name("robot_model");
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+
+  bag.addPropertiesWithDoc("my_int", 5, "my_int_doc",
+                           "my_double", 6.28, "my_double_doc",
+                           "my_matrix", matrix, "my_matrix_doc");
+
+  bag.addProperties("my_vector3", vector3,
+                    "my_lut", std::vector<double>(1000, 0.5),
+                    "my_string", std::string("a string"),
+                    "my_quaternion", quaternion,
+                    "my_bag", nested);
+
+  bag.updateProperty("my_int", 6);
+
+  ASSERT_NO_THROW(property_bag::write_mapped(bag, file.path));
+
+  property_bag::MappedPropertyBag mapped(file.path);
+
+  ASSERT_EQ(mapped.size(), bag.size());
+  ASSERT_EQ(mapped.name(), "robot_model");
+  ASSERT_EQ(mapped.getRetrievalHandling(), property_bag::RetrievalHandling::THROW);
+  ASSERT_EQ(mapped.listProperties(), bag.listProperties());
+  ASSERT_TRUE(mapped.exists("my_matrix"));
+  ASSERT_FALSE(mapped.exists("not_there"));
+
+  // In place, aligned, reads
+  const int* my_int = mapped.get_if<int>("my_int");
+  ASSERT_NE(my_int, nullptr);
+  EXPECT_EQ(*my_int, 6);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(my_int) % property_bag::MappedPropertyBag::alignment, 0);
+
+  EXPECT_EQ(mapped.get_if<double>("my_int"), nullptr);
+  EXPECT_EQ(mapped.get_if<double>("my_matrix"), nullptr);
+  EXPECT_EQ(mapped.get_if<double>("my_string"), nullptr);
+
+  const auto map = property_bag::getMap<Eigen::MatrixXd>(mapped, "my_matrix");
+  EXPECT_EQ(map, matrix);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(map.data()) % property_bag::MappedPropertyBag::alignment, 0);
+
+  // Same pages on every access
+  EXPECT_EQ(property_bag::getMap<Eigen::MatrixXd>(mapped, "my_matrix").data(), map.data());
+
+  EXPECT_EQ(property_bag::getMap<Eigen::Vector3d>(mapped, "my_vector3"), vector3);
+  EXPECT_EQ(property_bag::getMap<Eigen::VectorXd>(mapped, "my_lut").size(), 1000);
+
+  EXPECT_THROW(property_bag::getMap<Eigen::Matrix3d>(mapped, "my_matrix"),
+               property_bag::PropertyException);
+  EXPECT_THROW(property_bag::getMap<Eigen::MatrixXf>(mapped, "my_matrix"),
+               property_bag::PropertyException);
+  EXPECT_THROW(property_bag::getMap<Eigen::MatrixXd>(mapped, "my_string"),
+               property_bag::PropertyException);
+
+  // Copies
+  Eigen::MatrixXd matrix_copy;
+  EXPECT_TRUE(mapped.getPropertyValue("my_matrix", matrix_copy));
+  EXPECT_EQ(matrix_copy, matrix);
+
+  std::string string_copy;
+  EXPECT_TRUE(mapped.getPropertyValue("my_string", string_copy));
+  EXPECT_EQ(string_copy, "a string");
+
+  int int_copy = 0;
+  EXPECT_FALSE(mapped.getPropertyValue("my_string", int_copy));
+  EXPECT_FALSE(mapped.getPropertyValue("not_there", int_copy));
+
+  const property_bag::Property property = mapped.getProperty("my_double");
+  EXPECT_EQ(property.get<double>(), 6.28);
+  EXPECT_EQ(property.description(), "my_double_doc");
+  EXPECT_TRUE(property.is_default());
+  EXPECT_TRUE(mapped.getProperty("my_int").is_modified());
+
+  EXPECT_EQ(mapped.getProperty("my_quaternion").get<Eigen::Quaterniond>().coeffs(),
+            quaternion.coeffs());
+
+  EXPECT_THROW(mapped.getProperty("not_there"), property_bag::PropertyException);
+
+  // Back to a regular bag
+  property_bag::PropertyBag copy = mapped.toPropertyBag();
+  ASSERT_EQ(copy.size(), bag.size());
+  EXPECT_EQ(copy.name(), "robot_model");
+  EXPECT_EQ(copy.getProperty("my_matrix").get<Eigen::MatrixXd>(), matrix);
+  EXPECT_EQ(copy.getProperty("my_lut").get<std::vector<double>>(), std::vector<double>(1000, 0.5));
+  EXPECT_EQ(copy.getProperty("my_bag").get<property_bag::PropertyBag>()
+              .getProperty("nested_int").get<int>(), -42);
+
+  // Outlives a move
+  property_bag::MappedPropertyBag moved(std::move(mapped));
+  EXPECT_EQ(property_bag::getMap<Eigen::MatrixXd>(moved, "my_matrix"), matrix);
+
+  PRINTF("All good at MappedBagTest::InPlaceAccess !\n");
+}
+
+TEST(MappedBagTest, MalformedFiles)
+{
+  TemporaryFile file;
+
+  EXPECT_THROW(property_bag::MappedPropertyBag mapped(file.path), property_bag::PropertyException);
+
+  property_bag::PropertyBag bag("my_matrix", Eigen::MatrixXd(Eigen::MatrixXd::Ones(10, 10)));
+  property_bag::write_mapped(bag, file.path);
+
+  std::string bytes;
+  {
+    std::ifstream in(file.path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+
+  const auto write = [&](const std::string& content)
+  {
+    std::ofstream out(file.path, std::ios::binary | std::ios::trunc);
+    out.write(content.data(), content.size());
+  };
+
+  // Truncated index
+  write(bytes.substr(0, bytes.size() - 1));
+  EXPECT_THROW(property_bag::MappedPropertyBag mapped(file.path), property_bag::PropertyException);
+
+  // Wrong signature
+  std::string wrong = bytes;
+  wrong[0] = 'X';
+  write(wrong);
+  EXPECT_THROW(property_bag::MappedPropertyBag mapped(file.path), property_bag::PropertyException);
+
+  write(bytes);
+  EXPECT_NO_THROW(property_bag::MappedPropertyBag mapped(file.path));
+
+  // Not exported
+  property_bag::PropertyBag unknown("my_char", 'c');
+  EXPECT_THROW(property_bag::write_mapped(unknown, file.path), property_bag::PropertyException);
+
+  PRINTF("All good at MappedBagTest::MalformedFiles !\n");
+}
+
+// Other processes keep the old file mapped
+TEST(MappedBagTest, RewriteWhileMapped)
+{
+  TemporaryFile file;
+
+  const std::vector<double> lut(100000, 0.5);
+
+  property_bag::write_mapped(property_bag::PropertyBag("my_lut", lut), file.path);
+
+  property_bag::MappedPropertyBag mapped(file.path);
+
+  std::size_t rows = 0, cols = 0;
+  const double* block = mapped.getBlock<double>("my_lut", rows, cols);
+  ASSERT_NE(nullptr, block);
+  ASSERT_EQ(lut.size(), rows * cols);
+
+  // Shorter, would truncate the mapped pages if written in place
+  property_bag::write_mapped(property_bag::PropertyBag("my_int", 5), file.path);
+
+  EXPECT_EQ(0.5, block[0]);
+  EXPECT_EQ(0.5, block[lut.size() - 1]);
+
+  property_bag::MappedPropertyBag rewritten(file.path);
+  int value = 0;
+  EXPECT_TRUE(rewritten.getPropertyValue("my_int", value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(rewritten.exists("my_lut"));
+
+  EXPECT_NE(0, ::access((file.path + ".tmp").c_str(), F_OK));
+
+  // A failed write leaves the file as it was
+  property_bag::PropertyBag unknown("my_char", 'c');
+  EXPECT_THROW(property_bag::write_mapped(unknown, file.path), property_bag::PropertyException);
+  EXPECT_NO_THROW(property_bag::MappedPropertyBag mapped(file.path));
+  EXPECT_NE(0, ::access((file.path + ".tmp").c_str(), F_OK));
+
+  PRINTF("All good at MappedBagTest::RewriteWhileMapped !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -3,6 +3,12 @@
 #include "property_bag/serialization/property_bag_boost_serialization.h"
 #include "property_bag/serialization/eigen_boost_serialization.h"
 
+#include <boost/archive/xml_oarchive.hpp>
+#include <boost/archive/xml_iarchive.hpp>
+
+#include <cstring>
+#include <sstream>
+
 EXPORT_PROPERTY_NAMED_TYPE(test::Dummy, test__Dummy);
 
 TEST(PropertySerializationTest, PropertyBagSerialization)
@@ -82,7 +88,6 @@ TEST(PropertySerializationTest, PropertyBagToStr)
 {
   std::string string;
   std::stringstream ss;
-  boost::archive::text_oarchive oa(ss);
 
   property_bag::PropertyBag bag;
 
@@ -93,7 +98,10 @@ TEST(PropertySerializationTest, PropertyBagToStr)
                            "my_dummy", test::Dummy{2, 6.28, "ok"}, "my_dummy_doc");
   bag.addProperty("eigen_vector", eigen_vector);
 
-  ASSERT_NO_THROW(oa << bag);
+  {
+    boost::archive::text_oarchive oa(ss);
+    ASSERT_NO_THROW(oa << bag);
+  }
   string = ss.str();
 
   ASSERT_EQ(property_bag::to_str(bag),  string);
@@ -101,6 +109,396 @@ TEST(PropertySerializationTest, PropertyBagToStr)
   PRINTF("All good at PropertyBagTest::PropertyBagToStr !\n");
 }
 
+// The xml archive closes its root tag on destruction
+TEST(PropertySerializationTest, PropertyBagToStrXml)
+{
+  property_bag::PropertyBag bag;
+  bag.name("test");
+  bag.addPropertiesWithDoc("my_dummy", test::Dummy{2, 6.28, "ok"}, "my_dummy_doc",
+                           "my_other_dummy", test::Dummy{3, 1.5, "other"}, "");
+
+  const std::string string = property_bag::to_str<boost::archive::xml_oarchive>(bag);
+
+  const std::string closing = "</boost_serialization>";
+  ASSERT_NE(std::string::npos, string.rfind(closing));
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_str<boost::archive::xml_iarchive>(string, loaded));
+
+  EXPECT_EQ(bag.name(), loaded.name());
+  ASSERT_EQ(bag.listProperties(), loaded.listProperties());
+  EXPECT_EQ(test::Dummy(2, 6.28, "ok"), loaded.getProperty("my_dummy").get<test::Dummy>());
+  EXPECT_EQ(test::Dummy(3, 1.5, "other"), loaded.getProperty("my_other_dummy").get<test::Dummy>());
+  EXPECT_EQ("my_dummy_doc", loaded.getProperty("my_dummy").description());
+
+  PRINTF("All good at PropertyBagTest::PropertyBagToStrXml !\n");
+}
+
+template <typename OArchive, typename IArchive>
+struct ArchivePair
+{
+  using oarchive = OArchive;
+  using iarchive = IArchive;
+};
+
+template <typename T>
+class PropertyBagArchiveTest : public ::testing::Test { };
+
+using ArchiveTypes = ::testing::Types<
+  ArchivePair<boost::archive::text_oarchive, boost::archive::text_iarchive>,
+  ArchivePair<boost::archive::binary_oarchive, boost::archive::binary_iarchive>,
+  ArchivePair<property_bag::portable_binary_oarchive, property_bag::portable_binary_iarchive>>;
+
+TYPED_TEST_CASE(PropertyBagArchiveTest, ArchiveTypes);
+
+// Every type exported in boost_serialization_registry.cpp
+// and eigen_boost_serialization_registry.cpp
+TYPED_TEST(PropertyBagArchiveTest, RegisteredTypesRoundTrip)
+{
+  using OArchive = typename TypeParam::oarchive;
+  using IArchive = typename TypeParam::iarchive;
+
+  const Eigen::Vector3d vector3(1.1, -2.2, 3.3);
+  const Eigen::VectorXd vectorx = Eigen::VectorXd::LinSpaced(50, -1., 1.);
+  const Eigen::Quaterniond quaternion(Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitZ()));
+
+  Eigen::Isometry3d isometry = Eigen::Isometry3d::Identity();
+  isometry.translate(vector3);
+  isometry.rotate(quaternion);
+
+  property_bag::PropertyBag nested("nested_int", -42,
+                                   "nested_double", 1e-300);
+
+  property_bag::PropertyBag bag("my_bool", true,
+                                "my_int", -123456,
+                                "my_float", 3.5f,
+                                "my_double", 6.283185307179586,
+                                "my_string", std::string("this is a string"),
+                                "my_bag", nested);
+
+  bag.addPropertiesWithDoc("my_vector_int", std::vector<int>{-1, 0, 1, 1<<30}, "my_vector_int_doc",
+                           "my_vector_double", std::vector<double>{-0.5, 0., 1e300}, "my_vector_double_doc",
+                           "my_vector_string", std::vector<std::string>{"a", "", "bc"}, "my_vector_string_doc");
+
+  bag.addProperties("my_vector3", vector3,
+                    "my_vectorx", vectorx,
+                    "my_quaternion", quaternion,
+                    "my_isometry", isometry,
+                    "my_vector_vector3", std::vector<Eigen::Vector3d>(3, vector3),
+                    "my_vector_vectorx", std::vector<Eigen::VectorXd>(2, vectorx),
+                    "my_vector_quaternion", std::vector<Eigen::Quaterniond>(2, quaternion),
+                    "my_vector_isometry", std::vector<Eigen::Isometry3d>(2, isometry));
+
+  bag.name("registered");
+
+  std::string bytes;
+  ASSERT_NO_THROW(bytes = property_bag::to_str<OArchive>(bag));
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_str<IArchive>(bytes, loaded));
+
+  ASSERT_EQ(loaded.name(), "registered");
+  ASSERT_EQ(loaded.size(), bag.size());
+
+  EXPECT_EQ(loaded.getProperty("my_bool").get<bool>(), true);
+  EXPECT_EQ(loaded.getProperty("my_int").get<int>(), -123456);
+  EXPECT_EQ(loaded.getProperty("my_float").get<float>(), 3.5f);
+  EXPECT_EQ(loaded.getProperty("my_string").get<std::string>(), "this is a string");
+
+  auto loaded_nested = loaded.getProperty("my_bag").get<property_bag::PropertyBag>();
+  EXPECT_EQ(loaded_nested.getProperty("nested_int").get<int>(), -42);
+
+  EXPECT_EQ(loaded.getProperty("my_vector_int").get<std::vector<int>>(),
+            bag.getProperty("my_vector_int").get<std::vector<int>>());
+  EXPECT_EQ(loaded.getProperty("my_vector_string").get<std::vector<std::string>>(),
+            bag.getProperty("my_vector_string").get<std::vector<std::string>>());
+  EXPECT_EQ(loaded.getProperty("my_vector_string").description(), "my_vector_string_doc");
+
+  EXPECT_EQ(loaded.getProperty("my_vector3").get<Eigen::Vector3d>(), vector3);
+  EXPECT_EQ(loaded.getProperty("my_vector_vector3").get<std::vector<Eigen::Vector3d>>().size(), 3);
+  EXPECT_EQ(loaded.getProperty("my_vector_vectorx").get<std::vector<Eigen::VectorXd>>().size(), 2);
+  EXPECT_EQ(loaded.getProperty("my_vector_quaternion").get<std::vector<Eigen::Quaterniond>>().size(), 2);
+  EXPECT_EQ(loaded.getProperty("my_vector_isometry").get<std::vector<Eigen::Isometry3d>>().size(), 2);
+
+  // The text archive rounds floating points
+  const double tolerance = std::is_same<OArchive, boost::archive::text_oarchive>::value ? 1e-12 : 0;
+
+  EXPECT_NEAR(loaded.getProperty("my_double").get<double>(), 6.283185307179586, tolerance);
+  EXPECT_NEAR(loaded_nested.getProperty("nested_double").get<double>(), 1e-300, tolerance);
+
+  EXPECT_TRUE(loaded.getProperty("my_vectorx").get<Eigen::VectorXd>().isApprox(vectorx, tolerance));
+  EXPECT_TRUE(loaded.getProperty("my_quaternion").get<Eigen::Quaterniond>().coeffs().isApprox(
+                quaternion.coeffs(), tolerance));
+  EXPECT_TRUE(loaded.getProperty("my_isometry").get<Eigen::Isometry3d>().matrix().isApprox(
+                isometry.matrix(), tolerance));
+
+  PRINTF("All good at PropertyBagArchiveTest::RegisteredTypesRoundTrip !\n");
+}
+
+TEST(PropertySerializationTest, PropertyBagToBytes)
+{
+  property_bag::PropertyBag bag("my_int", 5,
+                                "my_vector", Eigen::VectorXd(Eigen::VectorXd::Random(100)));
+
+  const std::string bytes = property_bag::to_bytes(bag);
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_bytes(bytes, loaded));
+
+  ASSERT_EQ(loaded.getProperty("my_int").get<int>(), 5);
+  ASSERT_EQ(loaded.getProperty("my_vector").get<Eigen::VectorXd>(),
+            bag.getProperty("my_vector").get<Eigen::VectorXd>());
+
+  const std::string portable_bytes =
+      property_bag::to_bytes<property_bag::portable_binary_oarchive>(bag);
+
+  property_bag::PropertyBag portable_loaded;
+  ASSERT_NO_THROW(property_bag::from_bytes<property_bag::portable_binary_iarchive>(
+                    portable_bytes, portable_loaded));
+
+  ASSERT_EQ(portable_loaded.getProperty("my_vector").get<Eigen::VectorXd>(),
+            bag.getProperty("my_vector").get<Eigen::VectorXd>());
+
+  // Binary archives are not interchangeable
+  property_bag::PropertyBag wrong;
+  ASSERT_ANY_THROW(property_bag::from_bytes(portable_bytes, wrong));
+
+  PRINTF("All good at PropertySerializationTest::PropertyBagToBytes !\n");
+}
+
+// Written with or without compact type ids
+template <typename OArchive>
+std::string to_str_with_type_ids(const property_bag::PropertyBag& bag, const bool compact)
+{
+  std::stringstream ss;
+  {
+    OArchive oa(ss);
+    property_bag::set_compact_type_ids(oa, compact);
+    oa << bag;
+  }
+  return ss.str();
+}
+
+TYPED_TEST(PropertyBagArchiveTest, CompactTypeIds)
+{
+  using OArchive = typename TypeParam::oarchive;
+  using IArchive = typename TypeParam::iarchive;
+
+  property_bag::PropertyBag nested("nested_int", 3, "nested_dummy", test::Dummy{1, 2.5, "nested"});
+
+  property_bag::PropertyBag bag;
+  for (int i=0; i<20; ++i)
+    bag.addProperties("int_" + std::to_string(i), i,
+                      "double_" + std::to_string(i), i * 0.5,
+                      "string_" + std::to_string(i), std::to_string(i));
+
+  bag.addProperties("my_bag", nested, "my_dummy", test::Dummy{2, 6.28, "ok"});
+
+  const std::string compact = to_str_with_type_ids<OArchive>(bag, true);
+  const std::string guids   = to_str_with_type_ids<OArchive>(bag, false);
+
+  EXPECT_LT(compact.size(), guids.size());
+
+  for (const std::string* bytes : {&compact, &guids})
+  {
+    property_bag::PropertyBag loaded;
+    ASSERT_NO_THROW(property_bag::from_str<IArchive>(*bytes, loaded));
+
+    ASSERT_EQ(loaded.size(), bag.size());
+    EXPECT_EQ(loaded.getProperty("int_7").get<int>(), 7);
+    EXPECT_EQ(loaded.getProperty("double_7").get<double>(), 3.5);
+    EXPECT_EQ(loaded.getProperty("string_7").get<std::string>(), "7");
+    EXPECT_EQ(loaded.getProperty("my_dummy").get<test::Dummy>(), (test::Dummy{2, 6.28, "ok"}));
+
+    const auto& loaded_nested = loaded.getProperty("my_bag").get<property_bag::PropertyBag>();
+    EXPECT_EQ(loaded_nested.getProperty("nested_int").get<int>(), 3);
+    EXPECT_EQ(loaded_nested.getProperty("nested_dummy").get<test::Dummy>(),
+              (test::Dummy{1, 2.5, "nested"}));
+  }
+
+  // A type unknown to the reader
+  std::string unknown = compact;
+  const std::size_t guid = unknown.find("details_PlaceHolderImpl_int");
+  ASSERT_NE(guid, std::string::npos);
+  unknown[guid + 24] = 'x';
+
+  property_bag::PropertyBag loaded;
+  EXPECT_THROW(property_bag::from_str<IArchive>(unknown, loaded),
+               boost::archive::archive_exception);
+
+  PRINTF("All good at PropertyBagArchiveTest::CompactTypeIds !\n");
+}
+
+// Written as a single array of scalars, over several chunks for isometries
+TYPED_TEST(PropertyBagArchiveTest, BulkVectors)
+{
+  using OArchive = typename TypeParam::oarchive;
+  using IArchive = typename TypeParam::iarchive;
+
+  std::vector<Eigen::Vector3d> points(2501);
+  std::vector<Eigen::Quaterniond> orientations(points.size());
+  std::vector<Eigen::Isometry3d> poses(points.size());
+
+  for (std::size_t i=0; i<points.size(); ++i)
+  {
+    points[i] = Eigen::Vector3d::Random();
+    orientations[i] = Eigen::Quaterniond(Eigen::AngleAxisd(i * 0.001, Eigen::Vector3d::UnitZ()));
+    poses[i] = Eigen::Translation3d(points[i]) * orientations[i];
+  }
+
+  property_bag::PropertyBag bag("points", points,
+                                "orientations", orientations,
+                                "poses", poses,
+                                "empty", std::vector<Eigen::Vector3d>());
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_str<IArchive>(property_bag::to_str<OArchive>(bag), loaded));
+
+  const auto& loaded_points = loaded.getProperty("points").get<std::vector<Eigen::Vector3d>>();
+  const auto& loaded_orientations =
+      loaded.getProperty("orientations").get<std::vector<Eigen::Quaterniond>>();
+  const auto& loaded_poses = loaded.getProperty("poses").get<std::vector<Eigen::Isometry3d>>();
+
+  ASSERT_EQ(loaded_points.size(), points.size());
+  ASSERT_EQ(loaded_orientations.size(), points.size());
+  ASSERT_EQ(loaded_poses.size(), points.size());
+  EXPECT_TRUE(loaded.getProperty("empty").get<std::vector<Eigen::Vector3d>>().empty());
+
+  const double tolerance = std::is_same<OArchive, boost::archive::text_oarchive>::value ? 1e-12 : 0;
+
+  for (std::size_t i=0; i<points.size(); ++i)
+  {
+    ASSERT_TRUE(loaded_points[i].isApprox(points[i], tolerance)) << i;
+    ASSERT_TRUE(loaded_orientations[i].coeffs().isApprox(orientations[i].coeffs(), tolerance)) << i;
+    ASSERT_TRUE(loaded_poses[i].matrix().isApprox(poses[i].matrix(), tolerance)) << i;
+    ASSERT_EQ(loaded_poses[i].matrix().row(3), Eigen::RowVector4d(0, 0, 0, 1)) << i;
+  }
+
+  PRINTF("All good at PropertyBagArchiveTest::BulkVectors !\n");
+}
+
+// Written before the type ids
+TEST(PropertySerializationTest, LegacyArchive)
+{
+  const std::string legacy =
+    "22 serialization::archive 18 0 0 6 legacy 0 0 0 4 0 0 0 6 my_bag 0 0 0 0 0 1 6 35 "
+    "details_PlaceHolderImpl_PropertyBag 1 0\n"
+    "0 0 0 0  0 1 0 13 nested_double 8 30 details_PlaceHolderImpl_double 1 0\n"
+    "1 5.00000000000000000e-01 0  0 0 3 010 0  3 010 6 my_int 10 27 details_PlaceHolderImpl_int 1 0\n"
+    "2 7 10 my_int_doc 3 100 12 my_other_int 10\n"
+    "3 6 16 my_other_int_doc 3 010 9 my_string 11 35 details_PlaceHolderImpl_std__string 1 0\n"
+    "4 3 str 0  3 010";
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_str(legacy, loaded));
+
+  ASSERT_EQ(loaded.size(), 4);
+  EXPECT_EQ(loaded.name(), "legacy");
+  EXPECT_EQ(loaded.getProperty("my_int").get<int>(), 7);
+  EXPECT_TRUE(loaded.getProperty("my_int").is_modified());
+  EXPECT_EQ(loaded.getProperty("my_other_int").get<int>(), 6);
+  EXPECT_EQ(loaded.getProperty("my_other_int").description(), "my_other_int_doc");
+  EXPECT_EQ(loaded.getProperty("my_string").get<std::string>(), "str");
+  EXPECT_EQ(loaded.getProperty("my_bag").get<property_bag::PropertyBag>()
+              .getProperty("nested_double").get<double>(), 0.5);
+
+  PRINTF("All good at PropertySerializationTest::LegacyArchive !\n");
+}
+
+// Vectors of Eigen types written element by element
+TEST(PropertySerializationTest, LegacyBulkVectors)
+{
+  const std::string legacy =
+    "22 serialization::archive 18 0 0 0  0 0 0 3 0 0 0 12 orientations 0 0 0 1 1 51 "
+    "details_PlaceHolderImpl_std_vector_eigen_quaternion 0 0 0 0 0 2 1 0 1 "
+    "0.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 1.00000000000000000e+00 "
+    "5.00000000000000000e-01 -5.00000000000000000e-01 5.00000000000000000e-01 5.00000000000000000e-01 "
+    "0  0 0 3 010 6 points 2 48 details_PlaceHolderImpl_std_vector_eigen_vector3 0 0 0 2 1 0 1 "
+    "1.00000000000000000e+00 2.00000000000000000e+00 3.00000000000000000e+00 "
+    "-4.00000000000000000e+00 5.50000000000000000e+00 6.00000000000000000e+00 "
+    "0  3 010 5 poses 3 49 details_PlaceHolderImpl_std_vector_eigen_isometry 0 0 0 1 1 0 1 "
+    "1.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 "
+    "1.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 0.00000000000000000e+00 "
+    "1.00000000000000000e+00 1.00000000000000000e+00 2.00000000000000000e+00 3.00000000000000000e+00 "
+    "0  3 010";
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_str(legacy, loaded));
+
+  ASSERT_EQ(loaded.size(), 3);
+
+  const auto& points = loaded.getProperty("points").get<std::vector<Eigen::Vector3d>>();
+  ASSERT_EQ(points.size(), 2);
+  EXPECT_EQ(points[0], Eigen::Vector3d(1, 2, 3));
+  EXPECT_EQ(points[1], Eigen::Vector3d(-4, 5.5, 6));
+
+  const auto& orientations = loaded.getProperty("orientations").get<std::vector<Eigen::Quaterniond>>();
+  ASSERT_EQ(orientations.size(), 2);
+  EXPECT_EQ(orientations[0].coeffs(), Eigen::Quaterniond(1, 0, 0, 0).coeffs());
+  EXPECT_EQ(orientations[1].coeffs(), Eigen::Quaterniond(0.5, 0.5, -0.5, 0.5).coeffs());
+
+  const auto& poses = loaded.getProperty("poses").get<std::vector<Eigen::Isometry3d>>();
+  ASSERT_EQ(poses.size(), 1);
+  EXPECT_EQ(poses[0].matrix(), Eigen::Isometry3d(Eigen::Translation3d(1, 2, 3)).matrix());
+
+  PRINTF("All good at PropertySerializationTest::LegacyBulkVectors !\n");
+}
+
+template <typename T>
+void expectByteSwapped(const std::vector<T>& values)
+{
+  std::vector<T> swapped(values.size());
+  property_bag::details::byte_swap_block(values.data(), swapped.data(), values.size());
+
+  for (std::size_t i=0; i<values.size(); ++i)
+  {
+    T expected = values[i];
+    property_bag::details::byte_swap(expected);
+    ASSERT_EQ(0, std::memcmp(&expected, &swapped[i], sizeof(T))) << i;
+  }
+
+  // In place, twice
+  property_bag::details::byte_swap_block(swapped.data(), swapped.size());
+  ASSERT_EQ(0, std::memcmp(values.data(), swapped.data(), values.size()*sizeof(T)));
+}
+
+TEST(PropertySerializationTest, ByteSwap)
+{
+  EXPECT_EQ(0x3412, property_bag::details::byte_swap_value(std::uint16_t(0x1234)));
+  EXPECT_EQ(0x78563412u, property_bag::details::byte_swap_value(std::uint32_t(0x12345678u)));
+  EXPECT_EQ(0xefcdab8967452301ull,
+            property_bag::details::byte_swap_value(std::uint64_t(0x0123456789abcdefull)));
+
+  // Not a multiple of any vector width
+  expectByteSwapped(std::vector<std::int16_t>{1, -2, 300, -4000, 5, 6, 7});
+  expectByteSwapped(std::vector<std::int32_t>{1, -2, 1<<30, -4000, 5, 6, 7, 8, 9});
+  expectByteSwapped(std::vector<float>{0.5f, -1.f, 3e30f, 1e-30f, 5.f});
+  expectByteSwapped(std::vector<double>{0.5, -1., 3e300, 1e-300, 5., 6., 7.});
+
+  const std::vector<char> chars{'a', 'b', 'c'};
+  std::vector<char> copied(chars.size());
+  property_bag::details::byte_swap_block(chars.data(), copied.data(), chars.size());
+  EXPECT_EQ(chars, copied);
+
+  // Written as little endian, whatever the host
+  const std::vector<std::uint32_t> values{0x01020304u, 0x05060708u};
+  std::string bytes;
+  property_bag::details::write_little_endian(values.data(), values.size(),
+    [&bytes](const void* data, const std::size_t size)
+    {
+      bytes.append(static_cast<const char*>(data), size);
+    });
+
+  EXPECT_EQ(std::string("\x04\x03\x02\x01\x08\x07\x06\x05", 8), bytes);
+
+  std::vector<std::uint32_t> loaded(2);
+  std::memcpy(loaded.data(), bytes.data(), bytes.size());
+  property_bag::details::from_little_endian(loaded.data(), loaded.size());
+  EXPECT_EQ(values, loaded);
+
+  PRINTF("All good at PropertySerializationTest::ByteSwap !\n");
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,308 @@
+#include "utils_gtest.h"
+#include "utils_realtime_gtest.h"
+
+#include "property_bag/property_bag.h"
+#include "property_bag/serialization/wire_format.h"
+#include "property_bag/serialization/json_format.h"
+#include "property_bag/serialization/property_bag_boost_serialization.h"
+
+#include <Eigen/Dense>
+
+TEST(PropertyBagRealTimeTest, MallocHooks)
+{
+#ifndef PROPERTY_BAG_HAS_MALLOC_HOOKS
+  PRINTF("malloc hooks unavailable, skipping.\n");
+  return;
+#endif
+
+  // Make sure the harness does catch allocations
+  test::RealTimeSection section;
+  std::string* s = new std::string("not real-time, that's a long string");
+  delete s;
+
+  EXPECT_GE(section.stop(), 2);
+
+  PRINTF("All good at PropertyBagRealTimeTest::MallocHooks !\n");
+}
+
+TEST(PropertyBagRealTimeTest, AnyAssignInPlace)
+{
+  property_bag::details::Any any(5);
+
+  {
+    test::RealTimeSection section;
+    any = 6;
+    EXPECT_EQ(section.stop(), 0);
+  }
+
+  ASSERT_EQ(property_bag::details::anycast<int>(any), 6);
+
+  // Shared with a copy, copy-on-write
+  property_bag::details::Any copy(any);
+
+  ASSERT_FALSE(any.unique());
+  ASSERT_FALSE(any.assign<int>(7));
+
+  any = 7;
+
+  ASSERT_EQ(property_bag::details::anycast<int>(any), 7);
+  ASSERT_EQ(property_bag::details::anycast<int>(copy), 6);
+
+  PRINTF("All good at PropertyBagRealTimeTest::AnyAssignInPlace !\n");
+}
+
+TEST(PropertyBagRealTimeTest, RealTimeReadWrite)
+{
+  const std::string my_int("my_int"),
+                    my_double("my_double"),
+                    my_vector("my_vector"),
+                    my_string("my_string"),
+                    not_there("not_there");
+
+  property_bag::PropertyBag bag(my_int, 1,
+                                my_double, 2.,
+                                my_vector, Eigen::Vector3d(1,2,3),
+                                my_string, std::string("a string"));
+
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+
+  // Values shared with this copy get unshared
+  property_bag::PropertyBag copy(bag);
+
+  ASSERT_TRUE(bag.enterRealTime());
+  ASSERT_TRUE(bag.isRealTime());
+
+  int i = 0;
+  double d = 0;
+  Eigen::Vector3d v = Eigen::Vector3d::Zero();
+
+  bool got_int, got_double, got_vector, got_missing, got_mismatch;
+  bool updated_int, updated_double, updated_vector, updated_mismatch, updated_missing;
+  bool added, removed, appended;
+  property_bag::ErrorCode ec_missing, ec_mismatch, ec_update_mismatch;
+
+  std::size_t calls = 0;
+  {
+    test::RealTimeSection section;
+
+    for (int n=0; n<100; ++n)
+    {
+      updated_int    = bag.updateProperty(my_int, n);
+      updated_double = bag.updateProperty(my_double, double(n));
+      updated_vector = bag.updateProperty(my_vector, Eigen::Vector3d(n,n,n));
+
+      got_int    = bag.getPropertyValue(my_int, i);
+      got_double = bag.getPropertyValue(my_double, d);
+      got_vector = bag.getPropertyValue(my_vector, v);
+    }
+
+    // Would throw outside real-time mode
+    got_missing  = bag.getPropertyValue(not_there, i);
+    got_mismatch = bag.getPropertyValue(my_int, d);
+
+    updated_mismatch = bag.updateProperty(my_int, 5.);
+    updated_missing  = bag.updateProperty(not_there, 5);
+
+    ec_missing         = bag.tryGetPropertyValue(not_there, i);
+    ec_mismatch        = bag.tryGetPropertyValue(my_string, i);
+    ec_update_mismatch = bag.tryUpdateProperty(my_int, 5.f);
+
+    // Forbidden
+    added    = bag.addProperty(not_there, 5);
+    removed  = bag.removeProperty(my_int);
+    appended = bag.append(copy);
+
+    calls = section.stop();
+  }
+
+  EXPECT_EQ(calls, 0);
+
+  EXPECT_TRUE(updated_int);
+  EXPECT_TRUE(updated_double);
+  EXPECT_TRUE(updated_vector);
+  EXPECT_TRUE(got_int);
+  EXPECT_TRUE(got_double);
+  EXPECT_TRUE(got_vector);
+
+  EXPECT_EQ(i, 99);
+  EXPECT_EQ(d, 99.);
+  EXPECT_EQ(v, Eigen::Vector3d(99,99,99));
+
+  EXPECT_FALSE(got_missing);
+  EXPECT_FALSE(got_mismatch);
+  EXPECT_FALSE(updated_mismatch);
+  EXPECT_FALSE(updated_missing);
+
+  EXPECT_EQ(ec_missing, property_bag::ErrorCode::NOT_FOUND);
+  EXPECT_EQ(ec_mismatch, property_bag::ErrorCode::TYPE_MISMATCH);
+  EXPECT_EQ(ec_update_mismatch, property_bag::ErrorCode::TYPE_MISMATCH);
+
+  EXPECT_FALSE(added);
+  EXPECT_FALSE(removed);
+  EXPECT_FALSE(appended);
+  EXPECT_EQ(bag.size(), 4);
+
+  EXPECT_TRUE(bag.getProperty(my_int).is_modified());
+
+  // The copy is left untouched
+  int copy_i = 0;
+  ASSERT_TRUE(copy.getPropertyValue(my_int, copy_i));
+  EXPECT_EQ(copy_i, 1);
+
+  bag.exitRealTime();
+
+  ASSERT_FALSE(bag.isRealTime());
+  ASSERT_THROW(bag.getPropertyValue(not_there, i), property_bag::PropertyException);
+  ASSERT_TRUE(bag.addProperty(not_there, 5));
+
+  PRINTF("All good at PropertyBagRealTimeTest::RealTimeReadWrite !\n");
+}
+
+TEST(PropertyBagRealTimeTest, SharedValueNotRealTimeSafe)
+{
+  property_bag::PropertyBag bag("my_int", 1);
+
+  ASSERT_TRUE(bag.enterRealTime());
+
+  // Sharing after entering real-time mode
+  property_bag::PropertyBag copy(bag);
+
+  ASSERT_EQ(bag.tryUpdateProperty(std::string("my_int"), 2),
+            property_bag::ErrorCode::NOT_REALTIME_SAFE);
+
+  int i = 0;
+  ASSERT_TRUE(copy.getPropertyValue("my_int", i));
+  ASSERT_EQ(i, 1);
+
+  PRINTF("All good at PropertyBagRealTimeTest::SharedValueNotRealTimeSafe !\n");
+}
+
+// Deferred values are decoded on entering real-time mode
+TEST(PropertyBagRealTimeTest, LazilyLoaded)
+{
+  const std::string my_int("my_int"),
+                    my_string("my_string"),
+                    my_vector("my_vector");
+
+  const std::string bytes = property_bag::to_wire(
+        property_bag::PropertyBag(my_int, 1,
+                                  my_string, std::string("a string"),
+                                  my_vector, std::vector<double>(100, 0.5)));
+
+  property_bag::PropertyBag bag;
+  property_bag::from_wire(bytes, bag, property_bag::wire::LoadMode::LAZY);
+
+  ASSERT_TRUE(bag.enterRealTime());
+
+  int i = 0;
+  std::string s(32, ' ');
+  std::vector<double> v(100);
+
+  bool got_int, got_string, got_vector, updated_int, updated_vector;
+
+  std::size_t calls = 0;
+  {
+    test::RealTimeSection section;
+
+    got_int        = bag.getPropertyValue(my_int, i);
+    got_string     = bag.getPropertyValue(my_string, s);
+    got_vector     = bag.getPropertyValue(my_vector, v);
+    updated_int    = bag.updateProperty(my_int, 2);
+    updated_vector = bag.updateProperty(my_vector, v);
+
+    calls = section.stop();
+  }
+
+  EXPECT_EQ(calls, 0);
+
+  EXPECT_TRUE(got_int);
+  EXPECT_TRUE(got_string);
+  EXPECT_TRUE(got_vector);
+  EXPECT_TRUE(updated_int);
+  EXPECT_TRUE(updated_vector);
+
+  EXPECT_EQ(i, 1);
+  EXPECT_EQ(s, "a string");
+  EXPECT_EQ(v, std::vector<double>(100, 0.5));
+
+  bag.exitRealTime();
+
+  // A value that can not be decoded
+  std::string corrupted = bytes;
+  const std::size_t string_at = corrupted.find("a string");
+  ASSERT_NE(string_at, std::string::npos);
+  corrupted[string_at - 1] = 0x7f;
+
+  property_bag::PropertyBag lazy;
+  property_bag::from_wire(corrupted, lazy, property_bag::wire::LoadMode::LAZY);
+
+  EXPECT_FALSE(lazy.enterRealTime());
+  EXPECT_FALSE(lazy.isRealTime());
+
+  PRINTF("All good at PropertyBagRealTimeTest::LazilyLoaded !\n");
+}
+
+// Left out of real-time mode if any value stays shared
+TEST(PropertyBagRealTimeTest, EnterRealTimeFailure)
+{
+  property_bag::PropertyBag bag("my_int", 1);
+  bag.addProperty("my_pointer", std::unique_ptr<int>(new int(2)));
+
+  // Can not be deep-copied
+  property_bag::PropertyBag copy(bag);
+
+  ASSERT_FALSE(bag.enterRealTime());
+  EXPECT_FALSE(bag.isRealTime());
+
+  EXPECT_TRUE(bag.addProperty("my_double", 3.));
+
+  // Once no longer shared
+  copy = property_bag::PropertyBag();
+
+  ASSERT_TRUE(bag.enterRealTime());
+  EXPECT_TRUE(bag.isRealTime());
+
+  PRINTF("All good at PropertyBagRealTimeTest::EnterRealTimeFailure !\n");
+}
+
+// Replacing the whole bag leaves real-time mode
+TEST(PropertyBagRealTimeTest, WholesaleReplacement)
+{
+  const property_bag::PropertyBag source("my_int", 1, "my_double", 2.);
+
+  property_bag::PropertyBag bag;
+
+  ASSERT_TRUE(bag.enterRealTime());
+  bag = source;
+  EXPECT_FALSE(bag.isRealTime());
+
+  ASSERT_TRUE(bag.enterRealTime());
+  bag = property_bag::PropertyBag(source);
+  EXPECT_FALSE(bag.isRealTime());
+
+  ASSERT_TRUE(bag.enterRealTime());
+  property_bag::from_wire(property_bag::to_wire(source), bag);
+  EXPECT_FALSE(bag.isRealTime());
+
+  ASSERT_TRUE(bag.enterRealTime());
+  property_bag::from_json(property_bag::to_json(source), bag);
+  EXPECT_FALSE(bag.isRealTime());
+
+  ASSERT_TRUE(bag.enterRealTime());
+  property_bag::from_str(property_bag::to_str(source), bag);
+  EXPECT_FALSE(bag.isRealTime());
+
+  // A failed load leaves the bag untouched
+  ASSERT_TRUE(bag.enterRealTime());
+  ASSERT_THROW(property_bag::from_wire(std::string("garbage"), bag),
+               property_bag::PropertyException);
+  EXPECT_TRUE(bag.isRealTime());
+
+  PRINTF("All good at PropertyBagRealTimeTest::WholesaleReplacement !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -40,6 +40,63 @@ TEST(PropertySerializationTest, PropertyBoostSerialization)
   PRINTF("All good at PropertyTest::PropertySerializationBin !\n");
 }
 
+template <typename OArchive, typename IArchive>
+struct ArchivePair
+{
+  using oarchive = OArchive;
+  using iarchive = IArchive;
+};
+
+template <typename T>
+class PropertyArchiveTest : public ::testing::Test { };
+
+using ArchiveTypes = ::testing::Types<
+  ArchivePair<boost::archive::text_oarchive, boost::archive::text_iarchive>,
+  ArchivePair<boost::archive::binary_oarchive, boost::archive::binary_iarchive>,
+  ArchivePair<property_bag::portable_binary_oarchive, property_bag::portable_binary_iarchive>>;
+
+TYPED_TEST_CASE(PropertyArchiveTest, ArchiveTypes);
+
+TYPED_TEST(PropertyArchiveTest, PropertyRoundTrip)
+{
+  std::stringstream ss;
+
+  {
+    typename TypeParam::oarchive oa(ss);
+
+    property_bag::Property property(test::Dummy(2, 6.28, "ok"), "my_dummy_description");
+    ASSERT_NO_THROW(oa << property);
+
+    property_bag::Property property_int(-5, "my_int_description");
+    property_int.set(-123456789);
+    ASSERT_NO_THROW(oa << property_int);
+
+    property_bag::Property property_double(3.14159, "my_double_description");
+    ASSERT_NO_THROW(oa << property_double);
+  }
+
+  {
+    typename TypeParam::iarchive ia(ss);
+
+    property_bag::Property property;
+    ASSERT_NO_THROW(ia >> property);
+    ASSERT_EQ(property.get<test::Dummy>(), test::Dummy(2, 6.28, "ok"));
+    ASSERT_EQ(property.description(), "my_dummy_description");
+
+    property_bag::Property property_int;
+    ASSERT_NO_THROW(ia >> property_int);
+    ASSERT_EQ(property_int.get<int>(), -123456789);
+    ASSERT_EQ(property_int.description(), "my_int_description");
+    ASSERT_TRUE(property_int.is_modified());
+
+    property_bag::Property property_double;
+    ASSERT_NO_THROW(ia >> property_double);
+    ASSERT_EQ(property_double.get<double>(), 3.14159);
+  }
+
+  PRINTF("All good at PropertyArchiveTest::PropertyRoundTrip !\n");
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -2,12 +2,35 @@
 
 #include "property_bag/serialization/ros_boost_serialization.h"
 
+#include "property_bag/serialization/property_boost_serialization.h"
+#include "property_bag/serialization/ros_wire_format.h"
+#include "property_bag/serialization/ros_message.h"
+#include "property_bag/serialization/property_bag_boost_serialization.h"
+
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
 #include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/Polygon.h>
+#include <geometry_msgs/Vector3.h>
+
+#include <boost/serialization/split_member.hpp>
+
+// Not part of the supported messages
+PROPERTY_BAG_ROS_MSG(geometry_msgs::Vector3, geometry_msgs__Vector3)
+PROPERTY_BAG_ROS_MSG(geometry_msgs::Polygon, geometry_msgs__Polygon)
 
 template <typename T>
-void deserializeAndCompare(T &expected, boost::archive::text_iarchive &archive)
+std::string to_string(const T& m)
+{
+  std::stringstream ss;
+  ss << m;
+  return ss.str();
+}
+
+template <typename T, typename IArchive>
+void deserializeAndCompare(T &expected, IArchive &archive)
 {
   T actual;
   ASSERT_NO_THROW(archive >> actual);
@@ -17,7 +40,8 @@ void deserializeAndCompare(T &expected, boost::archive::text_iarchive &archive)
   EXPECT_EQ(expected_ss.str(), actual_ss.str());
 }
 
-TEST(RosSerializationTest, Test)
+template <typename OArchive, typename IArchive>
+void serializeAndCompare()
 {
   std::stringstream ss;
 
@@ -45,7 +69,7 @@ TEST(RosSerializationTest, Test)
   duration_msg.data = duration;
 
   {
-    boost::archive::text_oarchive oa(ss);
+    OArchive oa(ss);
 
     ASSERT_NO_THROW(oa << pose_stamped);
 
@@ -70,7 +94,7 @@ TEST(RosSerializationTest, Test)
 
   {
     geometry_msgs::PoseStamped pose_stamped_saved;
-    boost::archive::text_iarchive ia(ss);
+    IArchive ia(ss);
 
     deserializeAndCompare(pose_stamped, ia);
     deserializeAndCompare(point_stamped, ia);
@@ -85,6 +109,225 @@ TEST(RosSerializationTest, Test)
   }
 }
 
+TEST(RosSerializationTest, Test)
+{
+  serializeAndCompare<boost::archive::text_oarchive,
+                      boost::archive::text_iarchive>();
+}
+
+TEST(RosSerializationTest, Binary)
+{
+  serializeAndCompare<boost::archive::binary_oarchive,
+                      boost::archive::binary_iarchive>();
+}
+
+TEST(RosSerializationTest, PortableBinary)
+{
+  serializeAndCompare<property_bag::portable_binary_oarchive,
+                      property_bag::portable_binary_iarchive>();
+}
+
+TEST(RosSerializationTest, WireFormat)
+{
+  geometry_msgs::PoseStamped pose_stamped;
+  pose_stamped.header.frame_id = "foo";
+  pose_stamped.header.stamp = ros::Time(1234, 5678);
+  pose_stamped.pose.position.x = 1.0;
+  pose_stamped.pose.orientation.w = 1.0;
+
+  std_msgs::Duration duration_msg;
+  duration_msg.data = ros::Duration(12314, 123123);
+
+  property_bag::PropertyBag bag("pose_stamped", pose_stamped,
+                                "point", pose_stamped.pose.position,
+                                "duration_msg", duration_msg,
+                                "time", ros::Time(3333, 11231),
+                                "duration", ros::Duration(-5, 10));
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_wire(property_bag::to_wire(bag), loaded));
+
+  EXPECT_EQ(to_string(loaded.getProperty("pose_stamped").get<geometry_msgs::PoseStamped>()),
+            to_string(pose_stamped));
+
+  EXPECT_EQ(loaded.getProperty("point").get<geometry_msgs::Point>().x,
+            pose_stamped.pose.position.x);
+  EXPECT_EQ(loaded.getProperty("duration_msg").get<std_msgs::Duration>().data,
+            duration_msg.data);
+  EXPECT_EQ(loaded.getProperty("time").get<ros::Time>(), ros::Time(3333, 11231));
+  EXPECT_EQ(loaded.getProperty("duration").get<ros::Duration>(), ros::Duration(-5, 10));
+}
+
+namespace {
+
+/**
+ * @brief Legacy. The version 0 serialization of
+ * a message, allocating a buffer for each.
+ */
+template <typename Msg>
+struct Legacy
+{
+  Msg& m;
+
+  template<class Archive>
+  void save(Archive & ar, const unsigned int /*version*/) const
+  {
+    ros::SerializedMessage serialized_msg = ros::serialization::serializeMessage(m);
+    size_t num_bytes = serialized_msg.num_bytes;
+    ptrdiff_t start_offset = serialized_msg.message_start - serialized_msg.buf.get();
+    ar & BOOST_SERIALIZATION_NVP(num_bytes);
+    ar & BOOST_SERIALIZATION_NVP(start_offset);
+    ar & boost::serialization::make_nvp("buffer",
+          boost::serialization::make_array(serialized_msg.buf.get(), num_bytes));
+  }
+
+  template<class Archive>
+  void load(Archive & ar, const unsigned int /*version*/)
+  {
+    ros::SerializedMessage serialized_msg;
+    ar & boost::serialization::make_nvp("num_bytes", serialized_msg.num_bytes);
+    ptrdiff_t start_offset;
+    ar & BOOST_SERIALIZATION_NVP(start_offset);
+    serialized_msg.buf.reset(new uint8_t[serialized_msg.num_bytes]);
+    ar & boost::serialization::make_nvp("buffer",
+          boost::serialization::make_array(serialized_msg.buf.get(), serialized_msg.num_bytes));
+    serialized_msg.message_start = serialized_msg.buf.get() + start_offset;
+    ros::serialization::deserializeMessage(serialized_msg, m);
+  }
+
+  BOOST_SERIALIZATION_SPLIT_MEMBER()
+};
+
+} // namespace
+
+TEST(RosSerializationTest, LegacyCompatible)
+{
+  geometry_msgs::PoseStamped pose_stamped;
+  pose_stamped.header.frame_id = "foo";
+  pose_stamped.header.stamp = ros::Time(1234, 5678);
+  pose_stamped.pose.position.z = -3.0;
+  pose_stamped.pose.orientation.w = 1.0;
+
+  std::stringstream legacy_ss, current_ss;
+  {
+    boost::archive::binary_oarchive oa(legacy_ss, boost::archive::no_header);
+    const Legacy<geometry_msgs::PoseStamped> legacy{pose_stamped};
+    oa << legacy;
+  }
+  {
+    boost::archive::binary_oarchive oa(current_ss, boost::archive::no_header);
+    oa << pose_stamped;
+  }
+
+  // Same bytes
+  EXPECT_EQ(legacy_ss.str(), current_ss.str());
+
+  {
+    boost::archive::binary_iarchive ia(legacy_ss, boost::archive::no_header);
+    deserializeAndCompare(pose_stamped, ia);
+  }
+
+  // Offset past the buffer
+  std::stringstream corrupted_ss;
+  {
+    boost::archive::binary_oarchive oa(corrupted_ss, boost::archive::no_header);
+    size_t num_bytes = 4;
+    ptrdiff_t start_offset = 8;
+    uint8_t buffer[4] = {};
+    oa << num_bytes << start_offset
+       << boost::serialization::make_array(buffer, num_bytes);
+  }
+  {
+    boost::archive::binary_iarchive ia(corrupted_ss, boost::archive::no_header);
+    geometry_msgs::PoseStamped loaded;
+    EXPECT_THROW(ia >> loaded, boost::archive::archive_exception);
+  }
+
+  PRINTF("All good at RosSerializationTest::LegacyCompatible !\n");
+}
+
+TEST(RosSerializationTest, GenericMessage)
+{
+  geometry_msgs::Vector3 vector3;
+  vector3.x = 1.0;
+  vector3.y = -2.0;
+  vector3.z = 3.0;
+
+  geometry_msgs::Polygon polygon;
+  polygon.points.resize(3);
+  polygon.points[2].z = 5.f;
+
+  ASSERT_TRUE(ros::message_traits::IsFixedSize<geometry_msgs::Vector3>::value);
+  ASSERT_FALSE(ros::message_traits::IsFixedSize<geometry_msgs::Polygon>::value);
+
+  EXPECT_EQ(property_bag::name_of<geometry_msgs::Vector3>(), "geometry_msgs::Vector3");
+
+  property_bag::PropertyBag bag("vector3", vector3,
+                                "polygon", polygon);
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_bytes(property_bag::to_bytes(bag), loaded));
+
+  EXPECT_EQ(to_string(loaded.getProperty("vector3").get<geometry_msgs::Vector3>()),
+            to_string(vector3));
+  EXPECT_EQ(to_string(loaded.getProperty("polygon").get<geometry_msgs::Polygon>()),
+            to_string(polygon));
+
+  loaded = property_bag::PropertyBag();
+  ASSERT_NO_THROW(property_bag::from_wire(property_bag::to_wire(bag), loaded));
+
+  EXPECT_EQ(to_string(loaded.getProperty("vector3").get<geometry_msgs::Vector3>()),
+            to_string(vector3));
+  EXPECT_EQ(to_string(loaded.getProperty("polygon").get<geometry_msgs::Polygon>()),
+            to_string(polygon));
+
+  // Fixed-size messages are written without any length
+  std::stringstream legacy_ss, raw_ss;
+  {
+    boost::archive::binary_oarchive oa(legacy_ss, boost::archive::no_header);
+    const Legacy<geometry_msgs::Vector3> legacy{vector3};
+    oa << legacy;
+  }
+  {
+    boost::archive::binary_oarchive oa(raw_ss, boost::archive::no_header);
+    oa << vector3;
+  }
+
+  EXPECT_EQ(legacy_ss.str().size() - raw_ss.str().size(),
+            sizeof(size_t) + sizeof(ptrdiff_t) + sizeof(uint32_t));
+
+  property_bag::wire::Writer raw_w, sized_w;
+  property_bag::wire::Codec<geometry_msgs::Vector3>::encode(raw_w, vector3);
+  property_bag::wire::Codec<geometry_msgs::Polygon>::encode(sized_w, polygon);
+
+  EXPECT_EQ(raw_w.size(), ros::serialization::serializationLength(vector3));
+  EXPECT_EQ(sized_w.size(), ros::serialization::serializationLength(polygon) + 1);
+
+  PRINTF("All good at RosSerializationTest::GenericMessage !\n");
+}
+
+TEST(RosSerializationTest, FixedSizeVersion0)
+{
+  geometry_msgs::Point point;
+  point.x = 4.0;
+  point.z = -1.0;
+
+  std::stringstream ss;
+  {
+    // Written as version 0
+    boost::archive::binary_oarchive oa(ss);
+    const Legacy<geometry_msgs::Point> legacy{point};
+    oa << legacy;
+  }
+
+  {
+    boost::archive::binary_iarchive ia(ss);
+    deserializeAndCompare(point, ia);
+  }
+
+  PRINTF("All good at RosSerializationTest::FixedSizeVersion0 !\n");
+}
+
 int main(int argc, char **argv)
 {
   testing::InitGoogleTest(&argc, argv);
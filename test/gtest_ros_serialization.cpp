@@ -0,0 +1,166 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/ros_serialization.h"
+#include "property_bag/serialization/property_bag_boost_serialization.h"
+
+namespace test {
+
+// A hand-written message holding a bag
+struct BagStamped
+{
+  std::uint32_t seq = 0;
+  std::string frame_id;
+  property_bag::PropertyBag bag;
+  property_bag::Property property;
+};
+
+} // namespace test
+
+namespace ros {
+namespace serialization {
+
+template <>
+struct Serializer<test::BagStamped>
+{
+  template <typename Stream, typename T>
+  inline static void allInOne(Stream& stream, T m)
+  {
+    stream.next(m.seq);
+    stream.next(m.frame_id);
+    stream.next(m.bag);
+    stream.next(m.property);
+  }
+
+  ROS_DECLARE_ALLINONE_SERIALIZER
+};
+
+} /* namespace serialization */
+} /* namespace ros */
+
+namespace {
+
+template <typename T>
+std::vector<std::uint8_t> serialize(const T& t)
+{
+  std::vector<std::uint8_t> buffer(ros::serialization::serializationLength(t));
+
+  ros::serialization::OStream stream(buffer.data(), buffer.size());
+  ros::serialization::serialize(stream, t);
+
+  EXPECT_EQ(0, stream.getLength());
+
+  return buffer;
+}
+
+template <typename T>
+void deserialize(std::vector<std::uint8_t>& buffer, T& t)
+{
+  ros::serialization::IStream stream(buffer.data(), buffer.size());
+  ros::serialization::deserialize(stream, t);
+
+  EXPECT_EQ(0, stream.getLength());
+}
+
+template <typename T>
+T value_of(const property_bag::PropertyBag& bag, const std::string& key)
+{
+  T value = T();
+  EXPECT_TRUE(bag.getPropertyValue(key, value)) << key;
+  return value;
+}
+
+} // namespace
+
+TEST(RosSerializationTest, MessageField)
+{
+  test::BagStamped message;
+  message.seq = 42;
+  message.frame_id = "base_link";
+
+  message.bag.name("params");
+  message.bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+  message.bag.addPropertiesWithDoc("my_int", 5, "my_int_doc",
+                                   "my_double", 0.5, "",
+                                   "my_string", std::string("str"), "",
+                                   "my_vector", std::vector<double>{1, 2, 3}, "",
+                                   "my_bag", property_bag::PropertyBag("nested", 3), "");
+
+  message.property = property_bag::Property(std::string("a property"), "its doc");
+
+  std::vector<std::uint8_t> buffer = serialize(message);
+
+  test::BagStamped loaded;
+  deserialize(buffer, loaded);
+
+  EXPECT_EQ(42, loaded.seq);
+  EXPECT_EQ("base_link", loaded.frame_id);
+
+  EXPECT_EQ("params", loaded.bag.name());
+  EXPECT_EQ(property_bag::RetrievalHandling::THROW, loaded.bag.getRetrievalHandling());
+  EXPECT_EQ(message.bag.listProperties(), loaded.bag.listProperties());
+  EXPECT_EQ(5, value_of<int>(loaded.bag, "my_int"));
+  EXPECT_EQ("my_int_doc", loaded.bag.getProperty("my_int").description());
+  EXPECT_EQ("str", value_of<std::string>(loaded.bag, "my_string"));
+  EXPECT_EQ(std::vector<double>({1, 2, 3}), value_of<std::vector<double>>(loaded.bag, "my_vector"));
+  EXPECT_EQ(3, value_of<int>(value_of<property_bag::PropertyBag>(loaded.bag, "my_bag"), "nested"));
+
+  EXPECT_EQ("a property", loaded.property.get<std::string>());
+  EXPECT_EQ("its doc", loaded.property.description());
+
+  PRINTF("All good at RosSerializationTest::MessageField !\n");
+}
+
+// The layout of a uint8[] field holding to_wire()
+TEST(RosSerializationTest, Layout)
+{
+  const property_bag::PropertyBag bag("my_int", 5, "my_string", std::string("str"));
+
+  const std::vector<std::uint8_t> buffer = serialize(bag);
+  const std::string wire = property_bag::to_wire(bag);
+
+  ASSERT_EQ(4 + wire.size(), buffer.size());
+
+  std::uint32_t size;
+  std::memcpy(&size, buffer.data(), sizeof(size));
+
+  EXPECT_EQ(wire.size(), size);
+  EXPECT_EQ(wire, std::string(buffer.begin() + 4, buffer.end()));
+
+  PRINTF("All good at RosSerializationTest::Layout !\n");
+}
+
+TEST(RosSerializationTest, Errors)
+{
+  property_bag::PropertyBag bag("my_int", 5, "my_string", std::string("str"));
+
+  std::vector<std::uint8_t> buffer = serialize(bag);
+
+  // Truncated
+  std::vector<std::uint8_t> truncated(buffer.begin(), buffer.end() - 1);
+
+  property_bag::PropertyBag loaded;
+  EXPECT_THROW(deserialize(truncated, loaded), ros::serialization::StreamOverrunException);
+
+  // A stream shorter than announced
+  std::vector<std::uint8_t> small(buffer.size() - 1);
+  ros::serialization::OStream stream(small.data(), small.size());
+  EXPECT_THROW(ros::serialization::serialize(stream, bag), property_bag::PropertyException);
+
+  // Corrupted
+  buffer[4] = 'X';
+  EXPECT_THROW(deserialize(buffer, loaded), property_bag::PropertyException);
+
+  // Not exported to the wire format
+  bag.addProperty("my_unsigned", 5u);
+  EXPECT_THROW(ros::serialization::serializationLength(bag), property_bag::PropertyException);
+  EXPECT_THROW(ros::serialization::serializationLength(bag.getProperty("my_unsigned")),
+               property_bag::PropertyException);
+
+  PRINTF("All good at RosSerializationTest::Errors !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,172 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/property_boost_serialization.h"
+#include "property_bag/serialization/wire_format.h"
+
+#include <chrono>
+
+#include <dlfcn.h>
+#include <link.h>
+
+namespace {
+
+using clock = std::chrono::steady_clock;
+
+double milliseconds(const clock::time_point& start)
+{
+  return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+}
+
+/**
+ * @brief registry_setup. Time of the first lookup
+ * in both registries, which registers the pending types.
+ */
+double registry_setup(const std::string& wire_name, const std::string& archive_guid)
+{
+  const auto start = clock::now();
+
+  const bool found = property_bag::wire::Registry::instance().find(wire_name) != nullptr &&
+      property_bag::details::ArchiveTypeRegistry::instance().find(archive_guid) != nullptr;
+
+  const double time = milliseconds(start);
+
+  EXPECT_TRUE(found) << wire_name;
+
+  return time;
+}
+
+/**
+ * @brief load. dlopen a registry library and time it.
+ * It is never closed, the registries refer to it.
+ * @return false if not found.
+ */
+bool load(const char* library, double& time)
+{
+  const auto start = clock::now();
+
+  void* handle = dlopen(library, RTLD_NOW | RTLD_GLOBAL);
+
+  time = milliseconds(start);
+
+  if (handle == nullptr)
+    TEST_COUT << "Could not load " << library << ": " << dlerror();
+
+  return handle != nullptr;
+}
+
+/**
+ * @brief load_isolated. dlopen a library in a new link map,
+ * where it is loaded and initialized again although this test
+ * is linked to it. Its dependencies are loaded beforehand,
+ * only the load of the library itself is timed.
+ * @return false if not found.
+ */
+bool load_isolated(const char* library, double& time)
+{
+  // Finds the dependencies
+  void* probe = dlmopen(LM_ID_NEWLM, library, RTLD_NOW | RTLD_LOCAL);
+
+  if (probe == nullptr)
+  {
+    TEST_COUT << "Could not load " << library << ": " << dlerror();
+    return false;
+  }
+
+  link_map* map = nullptr;
+  dlinfo(probe, RTLD_DI_LINKMAP, &map);
+
+  Lmid_t namespace_id = LM_ID_NEWLM;
+
+  for (link_map* dependency = map->l_next; dependency != nullptr; dependency = dependency->l_next)
+  {
+    if (dependency->l_name[0] == '\0') continue;
+
+    void* handle = dlmopen(namespace_id, dependency->l_name, RTLD_NOW | RTLD_LOCAL);
+
+    if (handle != nullptr && namespace_id == LM_ID_NEWLM)
+      dlinfo(handle, RTLD_DI_LMID, &namespace_id);
+  }
+
+  const auto start = clock::now();
+
+  void* handle = dlmopen(namespace_id, library, RTLD_NOW | RTLD_LOCAL);
+
+  time = milliseconds(start);
+
+  if (handle == nullptr)
+    TEST_COUT << "Could not load " << library << ": " << dlerror();
+
+  return handle != nullptr;
+}
+
+} // namespace
+
+TEST(StartupTest, CoreLibrary)
+{
+#ifdef PROPERTY_BAG_LIBRARY
+  double load_time = 0;
+  EXPECT_TRUE(load_isolated(PROPERTY_BAG_LIBRARY, load_time));
+
+  // Mostly the boost serializers of the core types,
+  // which boost constructs at load time
+  TEST_COUT << "property_bag - load: " << load_time << " ms";
+#endif
+
+  PRINTF("All good at StartupTest::CoreLibrary !\n");
+}
+
+TEST(StartupTest, CoreRegistries)
+{
+  // Only the core types
+  EXPECT_EQ(property_bag::wire::Registry::instance().find("eigen_vector3"), nullptr);
+
+  const double setup = registry_setup("std__string", "details_PlaceHolderImpl_std__string");
+
+  // Registered once
+  const double lookup = registry_setup("std__string", "details_PlaceHolderImpl_std__string");
+
+  TEST_COUT << "core - registry setup: " << setup << " ms, then lookup: " << lookup << " ms";
+
+  PRINTF("All good at StartupTest::CoreRegistries !\n");
+}
+
+TEST(StartupTest, RegistryLibraries)
+{
+  struct Target
+  {
+    const char* name;
+    const char* library;
+    const char* wire_name;
+  };
+
+  const std::vector<Target> targets = {
+#ifdef PROPERTY_BAG_EIGEN_LIBRARY
+    {"property_bag_eigen", PROPERTY_BAG_EIGEN_LIBRARY, "eigen_vector3"},
+#endif
+#ifdef PROPERTY_BAG_ROS_LIBRARY
+    {"property_bag_ros", PROPERTY_BAG_ROS_LIBRARY, "geometry_msgs__Pose"},
+#endif
+  };
+
+  for (const Target& target : targets)
+  {
+    EXPECT_EQ(property_bag::wire::Registry::instance().find(target.wire_name), nullptr);
+
+    double load_time = 0;
+    if (!load(target.library, load_time)) continue;
+
+    const double setup = registry_setup(target.wire_name,
+                                        std::string("details_PlaceHolderImpl_") + target.wire_name);
+
+    TEST_COUT << target.name << " - load: " << load_time
+              << " ms, registry setup: " << setup << " ms";
+  }
+
+  PRINTF("All good at StartupTest::RegistryLibraries !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,139 @@
+#include "utils_gtest.h"
+#include "utils_realtime_gtest.h"
+
+#include "property_bag/update_queue.h"
+
+#include <Eigen/Dense>
+
+#include <thread>
+
+TEST(UpdateQueueTest, PushDrain)
+{
+  const std::string my_int("my_int"),
+                    my_double("my_double"),
+                    my_matrix("my_matrix"),
+                    not_there("not_there");
+
+  property_bag::PropertyBag bag(my_int, 1,
+                                my_double, 2.,
+                                my_matrix, Eigen::MatrixXd(Eigen::MatrixXd::Zero(10, 10)));
+
+  ASSERT_TRUE(bag.enterRealTime());
+
+  property_bag::UpdateQueue queue(4, 2);
+
+  ASSERT_EQ(queue.capacity(), 4);
+  ASSERT_TRUE(queue.empty());
+
+  ASSERT_TRUE(queue.push(my_int, 5));
+  ASSERT_TRUE(queue.push(my_matrix, Eigen::MatrixXd(Eigen::MatrixXd::Ones(20, 20))));
+  ASSERT_TRUE(queue.push(my_double, 5)); // wrong type
+  ASSERT_TRUE(queue.push(not_there, 5.));
+
+  // Overflow is reported to the producer
+  ASSERT_FALSE(queue.push(my_int, 6));
+  ASSERT_EQ(queue.overflows(), 1);
+  ASSERT_EQ(queue.size(), 4);
+
+  std::size_t first, second, third, calls;
+  {
+    test::RealTimeSection section;
+
+    // Bounded work per drain
+    first  = queue.drain(bag);
+    second = queue.drain(bag);
+    third  = queue.drain(bag);
+
+    calls = section.stop();
+  }
+
+  EXPECT_EQ(calls, 0);
+
+  EXPECT_EQ(first,  2);
+  EXPECT_EQ(second, 2);
+  EXPECT_EQ(third,  0);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(queue.rejected(), 2);
+
+  EXPECT_EQ(bag.getProperty(my_int).get<int>(), 5);
+  EXPECT_EQ(bag.getProperty(my_double).get<double>(), 2.);
+  EXPECT_EQ(bag.getProperty(my_matrix).get<Eigen::MatrixXd>(),
+            Eigen::MatrixXd(Eigen::MatrixXd::Ones(20, 20)));
+
+  EXPECT_TRUE(bag.getProperty(my_int).is_modified());
+  EXPECT_FALSE(bag.getProperty(my_double).is_modified());
+
+  ASSERT_TRUE(queue.push(my_int, 6));
+
+  PRINTF("All good at UpdateQueueTest::PushDrain !\n");
+}
+
+TEST(UpdateQueueTest, ProducerConsumer)
+{
+  const std::string my_int("my_int"), my_vector("my_vector");
+
+  property_bag::PropertyBag bag(my_int, -1,
+                                my_vector, std::vector<double>(100, -1.));
+
+  ASSERT_TRUE(bag.enterRealTime());
+
+  property_bag::UpdateQueue queue(16, 4);
+
+  const int num_updates = 10000;
+
+  std::atomic<bool> done{false};
+
+  std::thread producer([&]()
+  {
+    for (int n=0; n<num_updates; ++n)
+    {
+      while (!queue.push(my_int, n))
+        std::this_thread::yield();
+
+      while (!queue.push(my_vector, std::vector<double>(100, n)))
+        std::this_thread::yield();
+    }
+
+    done = true;
+  });
+
+  std::size_t consumed = 0, calls = 0;
+  int last = -1;
+  bool in_order = true;
+
+  {
+    test::RealTimeSection section;
+
+    while (!done || !queue.empty())
+    {
+      consumed += queue.drain(bag);
+
+      int current = 0;
+      bag.getPropertyValue(my_int, current);
+
+      in_order &= (current >= last);
+      last = current;
+    }
+
+    calls = section.stop();
+  }
+
+  producer.join();
+
+  EXPECT_EQ(calls, 0);
+  EXPECT_TRUE(in_order);
+  EXPECT_EQ(consumed, 2*num_updates);
+  EXPECT_EQ(queue.rejected(), 0);
+
+  EXPECT_EQ(bag.getProperty(my_int).get<int>(), num_updates-1);
+  EXPECT_EQ(bag.getProperty(my_vector).get<std::vector<double>>(),
+            std::vector<double>(100, num_updates-1));
+
+  PRINTF("All good at UpdateQueueTest::ProducerConsumer !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
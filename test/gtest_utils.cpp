@@ -0,0 +1,124 @@
+#include "utils_gtest.h"
+
+#include "property_bag/property_bag.h"
+#include "property_bag/eigen_type_names.h"
+
+#include <thread>
+#include <vector>
+
+namespace
+{
+template <int N> struct Tag { };
+
+template <int N>
+struct TypeList
+{
+  static void fill(std::vector<const std::type_info*>& types)
+  {
+    types.push_back(&typeid(Tag<N>));
+    TypeList<N-1>::fill(types);
+  }
+};
+
+template <>
+struct TypeList<0>
+{
+  static void fill(std::vector<const std::type_info*>& types)
+  {
+    types.push_back(&typeid(Tag<0>));
+  }
+};
+} // namespace
+
+TEST(UtilsTest, NameOf)
+{
+  EXPECT_EQ(property_bag::details::name_of(typeid(std::string)), "std::string");
+
+#ifdef __GNUG__
+  EXPECT_EQ(property_bag::details::name_of(typeid(int)), "int");
+  EXPECT_EQ(property_bag::details::name_of(typeid(test::Dummy)), "test::Dummy");
+#endif
+
+  // Same type, same cached name.
+  EXPECT_EQ(&property_bag::details::name_of(typeid(int)),
+            &property_bag::details::name_of(typeid(int)));
+
+  PRINTF("All good at UtilsTest::NameOf !\n");
+}
+
+TEST(UtilsTest, CompileTimeNameOf)
+{
+  static_assert(property_bag::name_of<int>() == "int", "");
+  static_assert(property_bag::name_of<const int&>() == "int", "");
+  static_assert(property_bag::name_of<std::string>() == "std::string", "");
+  static_assert(property_bag::name_of<test::Dummy>() == "test::Dummy", "");
+
+  EXPECT_EQ(property_bag::name_of<std::vector<std::string>>(), "std::vector<std::string>");
+  EXPECT_EQ(property_bag::name_of<property_bag::PropertyBag>(), "property_bag::PropertyBag");
+  EXPECT_EQ(property_bag::name_of<property_bag::Property::none>(), "property_bag::Property::none");
+
+  EXPECT_EQ(property_bag::name_of<Eigen::Vector3d>(), "Eigen::Vector3d");
+  EXPECT_EQ(property_bag::name_of<Eigen::Isometry3d>(), "Eigen::Isometry3d");
+  EXPECT_EQ(property_bag::name_of<std::vector<Eigen::Quaterniond>>(), "std::vector<Eigen::Quaterniond>");
+
+  property_bag::Property property(Eigen::MatrixXd(Eigen::MatrixXd::Identity(2, 2)));
+  EXPECT_EQ(property.type_name(), "Eigen::MatrixXd");
+
+  property_bag::string_view view = property_bag::name_of<double>();
+  EXPECT_EQ(std::string("double"), std::string(view));
+  EXPECT_EQ("a " + view, "a double");
+
+  PRINTF("All good at UtilsTest::CompileTimeNameOf !\n");
+}
+
+TEST(UtilsTest, NameOfMultiThreaded)
+{
+  std::vector<const std::type_info*> types;
+  TypeList<127>::fill(types);
+
+  const std::size_t num_threads = 8;
+
+  // Name addresses seen by each thread, per type.
+  std::vector<std::vector<const std::string*>> seen(
+        num_threads, std::vector<const std::string*>(types.size(), nullptr));
+
+  std::vector<std::thread> threads;
+  for (std::size_t t=0; t<num_threads; ++t)
+  {
+    threads.emplace_back([t, &types, &seen]()
+    {
+      property_bag::Property property(t);
+
+      for (int n=0; n<50; ++n)
+      {
+        // Each thread walks the types in a different order
+        for (std::size_t i=0; i<types.size(); ++i)
+        {
+          const std::size_t j = (i + t*types.size()/num_threads) % types.size();
+          seen[t][j] = &property_bag::details::name_of(*types[j]);
+        }
+
+        UNUSED(property.type_name());
+      }
+    });
+  }
+
+  for (auto& thread : threads) thread.join();
+
+  for (std::size_t i=0; i<types.size(); ++i)
+  {
+    ASSERT_NE(seen[0][i], nullptr);
+    EXPECT_NE(seen[0][i]->find("Tag"), std::string::npos);
+
+    for (std::size_t t=1; t<num_threads; ++t)
+      EXPECT_EQ(seen[0][i], seen[t][i]);
+  }
+
+  PRINTF("All good at UtilsTest::NameOfMultiThreaded !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
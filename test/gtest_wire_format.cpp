@@ -0,0 +1,678 @@
+#include "utils_gtest.h"
+
+#include "property_bag/serialization/eigen_wire_format.h"
+
+#include "property_bag/serialization/property_bag_boost_serialization.h"
+#include "property_bag/serialization/eigen_boost_serialization.h"
+
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace test {
+
+// Counts how often it is sized and written
+struct Counted
+{
+  int value;
+
+  static int sized;
+  static int written;
+};
+
+} // namespace test
+
+namespace property_bag {
+namespace wire {
+
+template <>
+struct Codec<test::Dummy>
+{
+  template <class W>
+  static void encode(W& w, const test::Dummy& d)
+  {
+    w.write_scalar(d.a_);
+    w.write_scalar(d.b_);
+    w.write_string(d.s_);
+  }
+
+  static void decode(Reader& r, test::Dummy& d)
+  {
+    d.a_ = r.read_scalar<int>();
+    d.b_ = r.read_scalar<float>();
+    r.read_string(d.s_);
+  }
+};
+
+template <>
+struct Codec<test::Counted>
+{
+  template <class W>
+  static void encode(W& w, const test::Counted& c)
+  {
+    ++(std::is_same<W, SizeCounter>::value ? test::Counted::sized : test::Counted::written);
+    w.write_scalar(c.value);
+  }
+
+  static void decode(Reader& r, test::Counted& c)
+  {
+    c.value = r.read_scalar<int>();
+  }
+};
+
+} /* namespace wire */
+} /* namespace property_bag */
+
+EXPORT_PROPERTY_WIRE_TYPE(test::Dummy, test__Dummy)
+EXPORT_PROPERTY_WIRE_TYPE(test::Counted, test__Counted)
+
+int test::Counted::sized   = 0;
+int test::Counted::written = 0;
+
+namespace {
+
+// Counts what is written
+class CountingBuffer : public std::streambuf
+{
+public:
+
+  std::size_t size = 0;
+  std::size_t largest_write = 0;
+
+protected:
+
+  std::streamsize xsputn(const char* /*s*/, std::streamsize n) override
+  {
+    size += n;
+    largest_write = std::max(largest_write, std::size_t(n));
+    return n;
+  }
+
+  int_type overflow(int_type c) override
+  {
+    if (!traits_type::eq_int_type(c, traits_type::eof()))
+    {
+      char ch = traits_type::to_char_type(c);
+      xsputn(&ch, 1);
+    }
+    return traits_type::not_eof(c);
+  }
+};
+
+} // namespace
+
+TEST(WireFormatTest, Varint)
+{
+  const std::vector<std::uint64_t> values = {0, 1, 127, 128, 300, 16383, 16384,
+                                             std::uint64_t(1) << 35,
+                                             std::numeric_limits<std::uint64_t>::max()};
+
+  property_bag::wire::Writer writer;
+  for (const auto v : values) writer.write_varint(v);
+
+  const std::string bytes = writer.release();
+
+  // 1 + 1 + 1 + 2 + 2 + 2 + 3 + 6 + 10
+  ASSERT_EQ(bytes.size(), 28);
+
+  property_bag::wire::Reader reader(bytes.data(), bytes.size());
+  for (const auto v : values) ASSERT_EQ(reader.read_varint(), v);
+
+  ASSERT_EQ(reader.remaining(), 0);
+  ASSERT_THROW(reader.read_varint(), property_bag::PropertyException);
+
+  PRINTF("All good at WireFormatTest::Varint !\n");
+}
+
+TEST(WireFormatTest, RegisteredTypesRoundTrip)
+{
+  const Eigen::Vector3d vector3(1.1, -2.2, 3.3);
+  const Eigen::VectorXd vectorx = Eigen::VectorXd::LinSpaced(50, -1., 1.);
+  const Eigen::Quaterniond quaternion(Eigen::AngleAxisd(0.3, Eigen::Vector3d::UnitZ()));
+
+  Eigen::Isometry3d isometry = Eigen::Isometry3d::Identity();
+  isometry.translate(vector3);
+  isometry.rotate(quaternion);
+
+  property_bag::PropertyBag nested("nested_int", -42,
+                                   "nested_double", 1e-300);
+
+  property_bag::PropertyBag bag("my_bool", true,
+                                "my_int", -123456,
+                                "my_float", 3.5f,
+                                "my_double", 6.283185307179586,
+                                "my_string", std::string("this is a string"),
+                                "my_bag", nested);
+
+  bag.addPropertiesWithDoc("my_vector_int", std::vector<int>{-1, 0, 1, 1<<30}, "my_vector_int_doc",
+                           "my_vector_double", std::vector<double>{-0.5, 0., 1e300}, "my_vector_double_doc",
+                           "my_vector_string", std::vector<std::string>{"a", "", "bc"}, "my_vector_string_doc",
+                           "my_dummy", test::Dummy{2, 6.28f, "ok"}, "my_dummy_doc");
+
+  bag.addProperties("my_vector3", vector3,
+                    "my_vectorx", vectorx,
+                    "my_quaternion", quaternion,
+                    "my_isometry", isometry,
+                    "my_vector_vector3", std::vector<Eigen::Vector3d>(3, vector3),
+                    "my_vector_vectorx", std::vector<Eigen::VectorXd>(2, vectorx),
+                    "my_vector_quaternion", std::vector<Eigen::Quaterniond>(2, quaternion),
+                    "my_vector_isometry", std::vector<Eigen::Isometry3d>(2, isometry));
+
+  bag.name("registered");
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+  bag.updateProperty("my_int", 7);
+
+  std::string bytes;
+  ASSERT_NO_THROW(bytes = property_bag::to_wire(bag));
+
+  ASSERT_EQ(bytes.size(), property_bag::wire_size(bag));
+
+  // In a buffer of wire_size() bytes
+  std::string placed(bytes.size(), '\0');
+  ASSERT_EQ(bytes.size(), property_bag::to_wire(bag, &placed[0], placed.size()));
+  ASSERT_EQ(bytes, placed);
+  ASSERT_THROW(property_bag::to_wire(bag, &placed[0], placed.size() - 1),
+               property_bag::PropertyException);
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_wire(bytes, loaded));
+
+  ASSERT_EQ(loaded.name(), "registered");
+  ASSERT_EQ(loaded.size(), bag.size());
+  ASSERT_EQ(loaded.getRetrievalHandling(), property_bag::RetrievalHandling::THROW);
+
+  EXPECT_EQ(loaded.getProperty("my_bool").get<bool>(), true);
+  EXPECT_EQ(loaded.getProperty("my_int").get<int>(), 7);
+  EXPECT_TRUE(loaded.getProperty("my_int").is_modified());
+  EXPECT_TRUE(loaded.getProperty("my_bool").is_default());
+  EXPECT_EQ(loaded.getProperty("my_float").get<float>(), 3.5f);
+  EXPECT_EQ(loaded.getProperty("my_double").get<double>(), 6.283185307179586);
+  EXPECT_EQ(loaded.getProperty("my_string").get<std::string>(), "this is a string");
+
+  const auto& loaded_nested = loaded.getProperty("my_bag").get<property_bag::PropertyBag>();
+  EXPECT_EQ(loaded_nested.getProperty("nested_int").get<int>(), -42);
+  EXPECT_EQ(loaded_nested.getProperty("nested_double").get<double>(), 1e-300);
+
+  EXPECT_EQ(loaded.getProperty("my_vector_int").get<std::vector<int>>(),
+            bag.getProperty("my_vector_int").get<std::vector<int>>());
+  EXPECT_EQ(loaded.getProperty("my_vector_double").get<std::vector<double>>(),
+            bag.getProperty("my_vector_double").get<std::vector<double>>());
+  EXPECT_EQ(loaded.getProperty("my_vector_string").get<std::vector<std::string>>(),
+            bag.getProperty("my_vector_string").get<std::vector<std::string>>());
+  EXPECT_EQ(loaded.getProperty("my_vector_string").description(), "my_vector_string_doc");
+  EXPECT_EQ(loaded.getProperty("my_dummy").get<test::Dummy>(), test::Dummy(2, 6.28f, "ok"));
+
+  EXPECT_EQ(loaded.getProperty("my_vector3").get<Eigen::Vector3d>(), vector3);
+  EXPECT_EQ(loaded.getProperty("my_vectorx").get<Eigen::VectorXd>(), vectorx);
+  EXPECT_EQ(loaded.getProperty("my_quaternion").get<Eigen::Quaterniond>().coeffs(),
+            quaternion.coeffs());
+  EXPECT_EQ(loaded.getProperty("my_isometry").get<Eigen::Isometry3d>().matrix(),
+            isometry.matrix());
+
+  const auto& vectors = loaded.getProperty("my_vector_vectorx").get<std::vector<Eigen::VectorXd>>();
+  ASSERT_EQ(vectors.size(), 2);
+  EXPECT_EQ(vectors[1], vectorx);
+
+  const auto& isometries = loaded.getProperty("my_vector_isometry").get<std::vector<Eigen::Isometry3d>>();
+  ASSERT_EQ(isometries.size(), 2);
+  EXPECT_EQ(isometries[1].matrix(), isometry.matrix());
+
+  EXPECT_EQ(loaded.getProperty("my_vector_vector3").get<std::vector<Eigen::Vector3d>>().size(), 3);
+  EXPECT_EQ(loaded.getProperty("my_vector_quaternion").get<std::vector<Eigen::Quaterniond>>().size(), 2);
+
+  PRINTF("All good at WireFormatTest::RegisteredTypesRoundTrip !\n");
+}
+
+TEST(WireFormatTest, MalformedInputs)
+{
+  property_bag::PropertyBag bag("my_int", 5,
+                                "my_vector", std::vector<double>(10, 1.));
+
+  const std::string bytes = property_bag::to_wire(bag);
+
+  property_bag::PropertyBag loaded("keep", 1);
+  loaded.name("kept");
+
+  // Truncated at every possible position,
+  // the bag is left untouched
+  for (std::size_t size=0; size<bytes.size(); ++size)
+  {
+    ASSERT_THROW(property_bag::from_wire(bytes.data(), size, loaded),
+                 property_bag::PropertyException) << "size " << size;
+
+    ASSERT_EQ(1u, loaded.size()) << "size " << size;
+    ASSERT_TRUE(loaded.exists("keep")) << "size " << size;
+    ASSERT_EQ("kept", loaded.name()) << "size " << size;
+  }
+
+  std::string wrong = bytes;
+  wrong[0] = 'X';
+  ASSERT_THROW(property_bag::from_wire(wrong, loaded), property_bag::PropertyException);
+
+  wrong = bytes;
+  wrong[3] = property_bag::wire::format_version + 1;
+  ASSERT_THROW(property_bag::from_wire(wrong, loaded), property_bag::PropertyException);
+
+  // Not exported
+  property_bag::PropertyBag unknown("my_char", 'c');
+  ASSERT_THROW(property_bag::to_wire(unknown), property_bag::PropertyException);
+
+  ASSERT_NO_THROW(property_bag::from_wire(bytes, loaded));
+  ASSERT_EQ(loaded.getProperty("my_int").get<int>(), 5);
+
+  PRINTF("All good at WireFormatTest::MalformedInputs !\n");
+}
+
+TEST(WireFormatTest, Size)
+{
+  // Mimics a calibration bag
+  property_bag::PropertyBag bag;
+  for (int i=0; i<10; ++i)
+    bag.addProperty("vector_" + std::to_string(i),
+                    Eigen::VectorXd(Eigen::VectorXd::Random(10000)));
+
+  bag.addProperty("samples", std::vector<double>(50000, 0.1));
+
+  // Many small properties
+  property_bag::PropertyBag small;
+  for (int i=0; i<1000; ++i)
+  {
+    small.addProperty("int_" + std::to_string(i), i);
+    small.addProperty("double_" + std::to_string(i), double(i));
+    small.addProperty("vector3_" + std::to_string(i), Eigen::Vector3d(i, i, i));
+  }
+
+  for (const property_bag::PropertyBag* b : {&bag, &small})
+    EXPECT_LT(property_bag::to_wire(*b).size(), property_bag::to_bytes(*b).size());
+
+  PRINTF("All good at WireFormatTest::Size !\n");
+}
+
+TEST(WireFormatTest, LazyLoad)
+{
+  property_bag::PropertyBag nested("nested_int", -42);
+
+  property_bag::PropertyBag bag;
+  bag.name("config");
+
+  bag.addPropertiesWithDoc("my_int", 5, "my_int_doc",
+                           "my_matrix", Eigen::MatrixXd(Eigen::MatrixXd::Random(4, 3)), "my_matrix_doc",
+                           "my_dummy", test::Dummy{2, 6.28f, "ok"}, "my_dummy_doc");
+
+  bag.addProperties("my_string", std::string("a string"),
+                    "my_vector", std::vector<double>(100, 0.5),
+                    "my_bag", nested);
+
+  bag.updateProperty("my_int", 6);
+
+  const std::string bytes = property_bag::to_wire(bag);
+
+  property_bag::PropertyBag loaded;
+  property_bag::from_wire(bytes, loaded, property_bag::wire::LoadMode::LAZY);
+
+  // Known without decoding
+  ASSERT_EQ(loaded.name(), "config");
+  ASSERT_EQ(loaded.listProperties(), bag.listProperties());
+  EXPECT_TRUE(loaded.getProperty("my_matrix").is_same<Eigen::MatrixXd>());
+  EXPECT_EQ(loaded.getProperty("my_matrix").description(), "my_matrix_doc");
+  EXPECT_TRUE(loaded.getProperty("my_int").is_modified());
+
+  // Decoded on access
+  EXPECT_EQ(loaded.getProperty("my_int").get<int>(), 6);
+  EXPECT_EQ(*loaded.getProperty("my_string").get_if<std::string>(), "a string");
+  EXPECT_EQ(loaded.getProperty("my_dummy").get<test::Dummy>(), test::Dummy(2, 6.28f, "ok"));
+  EXPECT_EQ(loaded.getProperty("my_bag").get<property_bag::PropertyBag>()
+              .getProperty("nested_int").get<int>(), -42);
+
+  std::vector<double> vector;
+  EXPECT_TRUE(loaded.getPropertyValue("my_vector", vector));
+  EXPECT_EQ(vector, std::vector<double>(100, 0.5));
+
+  // Copies share the decoding
+  property_bag::PropertyBag copy = loaded;
+  EXPECT_EQ(&copy.getProperty("my_vector").get<std::vector<double>>(),
+            &loaded.getProperty("my_vector").get<std::vector<double>>());
+
+  // Decoded once whichever thread first accesses it
+  std::vector<const Eigen::MatrixXd*> seen(8, nullptr);
+  std::vector<std::thread> threads;
+  for (std::size_t i=0; i<seen.size(); ++i)
+    threads.emplace_back([&loaded, &seen, i]()
+    {
+      seen[i] = &loaded.getProperty("my_matrix").get<Eigen::MatrixXd>();
+    });
+
+  for (auto& thread : threads) thread.join();
+
+  for (const Eigen::MatrixXd* matrix : seen)
+  {
+    ASSERT_EQ(matrix, seen.front());
+    EXPECT_EQ(*matrix, bag.getProperty("my_matrix").get<Eigen::MatrixXd>());
+  }
+
+  // Undecoded values are saved as well
+  property_bag::PropertyBag other;
+  property_bag::from_wire(bytes, other, property_bag::wire::LoadMode::LAZY);
+  EXPECT_EQ(property_bag::to_wire(other), bytes);
+
+  other = property_bag::PropertyBag();
+  property_bag::from_wire(bytes, other, property_bag::wire::LoadMode::LAZY);
+  other.removeProperty("my_dummy");
+  other.removeProperty("my_matrix");
+  property_bag::PropertyBag from_boost;
+  property_bag::from_bytes(property_bag::to_bytes(other), from_boost);
+  EXPECT_EQ(from_boost.getProperty("my_int").get<int>(), 6);
+
+  // Updating a value not read yet
+  other = property_bag::PropertyBag();
+  property_bag::from_wire(bytes, other, property_bag::wire::LoadMode::LAZY);
+  EXPECT_EQ(other.getProperty("my_int").try_set(7), property_bag::ErrorCode::OK);
+  EXPECT_EQ(other.getProperty("my_int").get<int>(), 7);
+
+  PRINTF("All good at WireFormatTest::LazyLoad !\n");
+}
+
+TEST(WireFormatTest, LazyLoadMalformedValue)
+{
+  property_bag::PropertyBag bag("my_int", 5,
+                                "my_vector", std::vector<double>(10, 1.));
+
+  std::string bytes = property_bag::to_wire(bag);
+
+  // Corrupt the element count of 'my_vector', the last value
+  const std::size_t count = bytes.size() - 10*sizeof(double) - 1;
+  ASSERT_EQ(bytes[count], 10);
+  bytes[count] = 11;
+
+  property_bag::PropertyBag loaded;
+  ASSERT_THROW(property_bag::from_wire(bytes, loaded), property_bag::PropertyException);
+
+  ASSERT_NO_THROW(property_bag::from_wire(bytes, loaded, property_bag::wire::LoadMode::LAZY));
+
+  EXPECT_EQ(loaded.getProperty("my_int").get<int>(), 5);
+
+  EXPECT_THROW(loaded.getProperty("my_vector").get<std::vector<double>>(),
+               property_bag::PropertyException);
+  EXPECT_EQ(loaded.getProperty("my_vector").get_if<std::vector<double>>(), nullptr);
+
+  std::vector<double> vector;
+  EXPECT_FALSE(loaded.getPropertyValue("my_vector", vector));
+
+  EXPECT_THROW(property_bag::to_wire(loaded), property_bag::PropertyException);
+
+  // Truncated structure is still reported at load
+  for (std::size_t size=0; size<bytes.size(); ++size)
+    ASSERT_THROW(property_bag::from_wire(bytes.data(), size, loaded,
+                                         property_bag::wire::LoadMode::LAZY),
+                 property_bag::PropertyException) << "size " << size;
+
+  PRINTF("All good at WireFormatTest::LazyLoadMalformedValue !\n");
+}
+
+// Each value is sized once, however deep
+TEST(WireFormatTest, DeeplyNested)
+{
+  const int depth = 24;
+
+  property_bag::PropertyBag bag("counted", test::Counted{depth - 1});
+  for (int i=depth-2; i>=0; --i)
+  {
+    property_bag::PropertyBag parent("counted", test::Counted{i}, "child", bag);
+    bag = std::move(parent);
+  }
+
+  test::Counted::sized = test::Counted::written = 0;
+
+  const std::string bytes = property_bag::to_wire(bag);
+
+  EXPECT_EQ(depth, test::Counted::sized);
+  EXPECT_EQ(depth, test::Counted::written);
+
+  test::Counted::sized = 0;
+  EXPECT_EQ(bytes.size(), property_bag::wire_size(bag));
+  EXPECT_EQ(depth, test::Counted::sized);
+
+  // Same bytes, whatever the writer
+  std::string placed(bytes.size(), '\0');
+  property_bag::to_wire(bag, &placed[0], placed.size());
+  EXPECT_EQ(bytes, placed);
+
+  std::stringstream streamed;
+  property_bag::to_wire(bag, streamed);
+  EXPECT_EQ(bytes, streamed.str());
+
+  property_bag::PropertyBag loaded;
+  ASSERT_NO_THROW(property_bag::from_wire(bytes, loaded));
+
+  const property_bag::PropertyBag* level = &loaded;
+  for (int i=0; i<depth; ++i)
+  {
+    ASSERT_EQ(i, level->getProperty("counted").get<test::Counted>().value);
+    if (i + 1 < depth) level = &level->getProperty("child").get<property_bag::PropertyBag>();
+  }
+
+  PRINTF("All good at WireFormatTest::DeeplyNested !\n");
+}
+
+TEST(WireFormatTest, Streaming)
+{
+  property_bag::PropertyBag nested("nested_int", -42,
+                                   "nested_vector", std::vector<double>(50000, 0.25));
+
+  property_bag::PropertyBag bag;
+  bag.name("config");
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+
+  bag.addPropertiesWithDoc("my_int", 5, "my_int_doc",
+                           "my_matrix", Eigen::MatrixXd(Eigen::MatrixXd::Random(40, 30)), "my_matrix_doc",
+                           "my_dummy", test::Dummy{2, 6.28f, "ok"}, "my_dummy_doc");
+
+  bag.addProperties("my_string", std::string(100000, 's'),
+                    "my_bag", nested);
+
+  const std::string bytes = property_bag::to_wire(bag);
+
+  // Same bytes as in memory
+  std::ostringstream os;
+  property_bag::to_wire(bag, os);
+  ASSERT_EQ(os.str(), bytes);
+
+  // Whatever the buffer size
+  for (const std::size_t buffer_size : {1, 16, 100, 4096})
+  {
+    std::ostringstream small_os;
+    {
+      property_bag::wire::StreamWriter writer(small_os, buffer_size);
+      property_bag::wire::save(writer, bag);
+      EXPECT_EQ(writer.size(), bytes.size());
+    }
+    ASSERT_EQ(small_os.str(), bytes) << "buffer " << buffer_size;
+
+    std::istringstream is(bytes);
+    property_bag::wire::StreamReader reader(is, buffer_size);
+
+    property_bag::PropertyBag loaded;
+    property_bag::wire::load(reader, loaded);
+
+    EXPECT_EQ(reader.position(), bytes.size());
+    EXPECT_EQ(loaded.name(), "config");
+    EXPECT_EQ(loaded.getRetrievalHandling(), property_bag::RetrievalHandling::THROW);
+    EXPECT_EQ(loaded.listProperties(), bag.listProperties());
+    EXPECT_EQ(loaded.getProperty("my_string").get<std::string>(), std::string(100000, 's'));
+    EXPECT_EQ(loaded.getProperty("my_bag").get<property_bag::PropertyBag>()
+                .getProperty("nested_vector").get<std::vector<double>>().size(), 50000);
+  }
+
+  // Through a file descriptor
+  {
+    char name[] = "/tmp/property_bag_XXXXXX";
+    const int fd = ::mkstemp(name);
+    ASSERT_GE(fd, 0);
+
+    property_bag::to_wire(bag, fd);
+    ASSERT_EQ(::lseek(fd, 0, SEEK_SET), 0);
+
+    property_bag::PropertyBag loaded;
+    property_bag::from_wire(fd, loaded);
+
+    ::close(fd);
+    std::remove(name);
+
+    EXPECT_EQ(loaded.getProperty("my_matrix").get<Eigen::MatrixXd>(),
+              bag.getProperty("my_matrix").get<Eigen::MatrixXd>());
+    EXPECT_EQ(loaded.getProperty("my_dummy").get<test::Dummy>(), test::Dummy(2, 6.28f, "ok"));
+  }
+
+  // One property at a time
+  std::istringstream is(bytes);
+
+  std::list<std::string> visited;
+  const auto info = property_bag::visit_wire(is,
+    [&visited](const std::string& name, property_bag::Property&& property)
+    {
+      visited.push_back(name);
+
+      if (name == "my_int")
+      {
+        EXPECT_EQ(property.get<int>(), 5);
+        EXPECT_EQ(property.description(), "my_int_doc");
+      }
+    });
+
+  EXPECT_EQ(visited, bag.listProperties());
+  EXPECT_EQ(info.name, "config");
+  EXPECT_EQ(info.handling, property_bag::RetrievalHandling::THROW);
+  EXPECT_EQ(info.size, bag.size());
+
+  // Truncated streams, the bag is left untouched
+  for (const std::size_t size : {std::size_t(0), std::size_t(3), std::size_t(10),
+                                 bytes.size()/2, bytes.size()-1})
+  {
+    std::istringstream truncated(bytes.substr(0, size));
+
+    property_bag::PropertyBag loaded("untouched", 1);
+    ASSERT_THROW(property_bag::from_wire(truncated, loaded),
+                 property_bag::PropertyException) << "size " << size;
+    EXPECT_EQ(loaded.size(), 1);
+  }
+
+  // A corrupted size does not allocate it up front
+  {
+    property_bag::wire::Writer writer;
+    writer.write(property_bag::wire::magic, sizeof(property_bag::wire::magic));
+    writer.write_scalar(property_bag::wire::format_version);
+    writer.write_varint(std::uint64_t(1) << 60);
+
+    std::istringstream corrupted(writer.release());
+
+    property_bag::PropertyBag loaded;
+    ASSERT_THROW(property_bag::from_wire(corrupted, loaded), property_bag::PropertyException);
+  }
+
+  PRINTF("All good at WireFormatTest::Streaming !\n");
+}
+
+TEST(WireFormatTest, StreamingLargestWrite)
+{
+  // ~50MB
+  property_bag::PropertyBag bag;
+  for (int i=0; i<6; ++i)
+  {
+    property_bag::PropertyBag nested("samples", std::vector<double>(500000, double(i)),
+                                     "matrix", Eigen::MatrixXd(Eigen::MatrixXd::Constant(500, 500, i)));
+
+    bag.addProperty("nested_" + std::to_string(i), nested);
+  }
+
+  CountingBuffer streamed;
+  std::ostream os(&streamed);
+
+  property_bag::to_wire(bag, os);
+
+  ASSERT_EQ(streamed.size, property_bag::wire_size(bag));
+
+  // Never buffers more than a value block or the stream buffer
+  EXPECT_LE(streamed.largest_write, 500000*sizeof(double));
+
+  PRINTF("All good at WireFormatTest::StreamingLargestWrite !\n");
+}
+
+TEST(WireFormatTest, Parallel)
+{
+  property_bag::PropertyBag nested("nested_int", -42,
+                                   "nested_matrix", Eigen::MatrixXd(Eigen::MatrixXd::Random(4, 4)));
+  nested.name("nested");
+
+  property_bag::PropertyBag bag;
+  bag.name("parallel");
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+
+  for (int i=0; i<200; ++i)
+  {
+    bag.addProperty("matrix_" + std::to_string(i),
+                    Eigen::MatrixXd(Eigen::MatrixXd::Random(10, i%7+1)), "doc");
+    bag.addProperty("string_" + std::to_string(i), std::string(i, 'x'));
+    bag.addProperty("dummy_" + std::to_string(i), test::Dummy{i, i*0.5f, "dummy"});
+  }
+  bag.addProperty("nested", nested);
+  bag.addProperty("deep", property_bag::PropertyBag("deep_nested", nested));
+  bag.updateProperty("string_3", std::string("modified"));
+
+  const std::string bytes = property_bag::to_wire(bag);
+
+  // Same output whatever the number of threads
+  for (std::size_t threads : {1, 2, 3, 8, 16})
+    ASSERT_EQ(property_bag::to_wire_parallel(bag, threads), bytes) << threads << " threads";
+
+  ASSERT_EQ(property_bag::to_wire_parallel(bag), bytes);
+
+  for (std::size_t threads : {0, 1, 4})
+  {
+    property_bag::PropertyBag loaded;
+    ASSERT_NO_THROW(property_bag::from_wire_parallel(bytes, loaded, threads));
+
+    ASSERT_EQ(loaded.size(), bag.size());
+    EXPECT_EQ(loaded.name(), "parallel");
+    EXPECT_EQ(loaded.getRetrievalHandling(), property_bag::RetrievalHandling::THROW);
+    EXPECT_EQ(loaded.listProperties(), bag.listProperties());
+    EXPECT_EQ(loaded.getProperty("matrix_12").get<Eigen::MatrixXd>(),
+              bag.getProperty("matrix_12").get<Eigen::MatrixXd>());
+    EXPECT_EQ(loaded.getProperty("matrix_12").description(), "doc");
+    EXPECT_EQ(loaded.getProperty("string_3").get<std::string>(), "modified");
+    EXPECT_TRUE(loaded.getProperty("string_3").is_modified());
+    EXPECT_EQ(loaded.getProperty("nested").get<property_bag::PropertyBag>()
+                .getProperty("nested_int").get<int>(), -42);
+
+    EXPECT_EQ(property_bag::to_wire(loaded), bytes);
+  }
+
+  // Not exported
+  property_bag::PropertyBag unknown("my_char", 'c');
+  ASSERT_THROW(property_bag::to_wire_parallel(unknown, 4), property_bag::PropertyException);
+
+  // Malformed value, reported whichever thread decodes it
+  std::string wrong = property_bag::to_wire(property_bag::PropertyBag("my_int", 5,
+                                                                      "my_string", std::string("abc")));
+  wrong[wrong.size()-4] = 10; // size of the string, past its value
+
+  property_bag::PropertyBag untouched("untouched", 1);
+  ASSERT_THROW(property_bag::from_wire_parallel(wrong, untouched, 2),
+               property_bag::PropertyException);
+  ASSERT_EQ(untouched.size(), 1);
+  ASSERT_TRUE(untouched.exists("untouched"));
+
+  // Truncated
+  for (std::size_t size=0; size<bytes.size(); size+=97)
+    ASSERT_THROW(property_bag::from_wire_parallel(bytes.data(), size, untouched, 2),
+                 property_bag::PropertyException) << "size " << size;
+
+  PRINTF("All good at WireFormatTest::Parallel !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
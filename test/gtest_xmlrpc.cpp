@@ -0,0 +1,161 @@
+#include "utils_gtest.h"
+
+#include "property_bag/xmlrpc.h"
+
+namespace {
+
+// As loaded from a yaml file by roslaunch
+XmlRpc::XmlRpcValue make_params()
+{
+  XmlRpc::XmlRpcValue params;
+
+  params["rate"] = XmlRpc::XmlRpcValue(50.);
+  params["use_sim_time"] = XmlRpc::XmlRpcValue(false);
+  params["robot"]["name"] = XmlRpc::XmlRpcValue(std::string("tiago"));
+  params["robot"]["joints"] = XmlRpc::XmlRpcValue(7);
+
+  XmlRpc::XmlRpcValue& limits = params["robot"]["limits"];
+  limits[0] = XmlRpc::XmlRpcValue(-1.5);
+  limits[1] = XmlRpc::XmlRpcValue(2); // written '2' in yaml
+  limits[2] = XmlRpc::XmlRpcValue(0.5);
+
+  XmlRpc::XmlRpcValue& ids = params["ids"];
+  ids[0] = XmlRpc::XmlRpcValue(3);
+  ids[1] = XmlRpc::XmlRpcValue(-4);
+
+  XmlRpc::XmlRpcValue& frames = params["frames"];
+  frames[0] = XmlRpc::XmlRpcValue(std::string("base_link"));
+  frames[1] = XmlRpc::XmlRpcValue(std::string("odom"));
+
+  XmlRpc::XmlRpcValue& flags = params["flags"];
+  flags[0] = XmlRpc::XmlRpcValue(true);
+  flags[1] = XmlRpc::XmlRpcValue(false);
+
+  XmlRpc::XmlRpcValue& sensors = params["sensors"];
+  sensors[0]["type"] = XmlRpc::XmlRpcValue(std::string("laser"));
+  sensors[0]["range"] = XmlRpc::XmlRpcValue(25.);
+  sensors[1]["type"] = XmlRpc::XmlRpcValue(std::string("sonar"));
+  sensors[1]["range"] = XmlRpc::XmlRpcValue(3.);
+
+  params["empty"].setSize(0);
+  params["nothing"].begin(); // an empty struct
+
+  return params;
+}
+
+template <typename T>
+T value_of(const property_bag::PropertyBag& bag, const std::string& key)
+{
+  T value = T();
+  EXPECT_TRUE(bag.getPropertyValue(key, value)) << key;
+  return value;
+}
+
+} // namespace
+
+TEST(XmlRpcTest, FromXmlRpc)
+{
+  const XmlRpc::XmlRpcValue params = make_params();
+
+  property_bag::PropertyBag bag;
+  bag.name("params");
+  bag.setRetrievalHandling(property_bag::RetrievalHandling::THROW);
+
+  property_bag::from_xmlrpc(params, bag);
+
+  EXPECT_EQ("params", bag.name());
+  EXPECT_EQ(property_bag::RetrievalHandling::THROW, bag.getRetrievalHandling());
+  EXPECT_EQ(9, bag.size());
+
+  EXPECT_EQ(50., value_of<double>(bag, "rate"));
+  EXPECT_FALSE(value_of<bool>(bag, "use_sim_time"));
+  EXPECT_EQ(std::vector<int>({3, -4}), value_of<std::vector<int>>(bag, "ids"));
+  EXPECT_EQ(std::vector<std::string>({"base_link", "odom"}),
+            value_of<std::vector<std::string>>(bag, "frames"));
+  EXPECT_EQ(std::vector<bool>({true, false}), value_of<std::vector<bool>>(bag, "flags"));
+  EXPECT_TRUE(value_of<std::vector<double>>(bag, "empty").empty());
+  EXPECT_TRUE(value_of<property_bag::PropertyBag>(bag, "nothing").empty());
+
+  const auto robot = value_of<property_bag::PropertyBag>(bag, "robot");
+  EXPECT_EQ(3, robot.size());
+  EXPECT_EQ("tiago", value_of<std::string>(robot, "name"));
+  EXPECT_EQ(7, value_of<int>(robot, "joints"));
+  // Integers promoted among doubles
+  EXPECT_EQ(std::vector<double>({-1.5, 2., 0.5}), value_of<std::vector<double>>(robot, "limits"));
+
+  const auto sensors = value_of<std::vector<property_bag::PropertyBag>>(bag, "sensors");
+  ASSERT_EQ(2, sensors.size());
+  EXPECT_EQ("sonar", value_of<std::string>(sensors[1], "type"));
+  EXPECT_EQ(3., value_of<double>(sensors[1], "range"));
+
+  PRINTF("All good at XmlRpcTest::FromXmlRpc !\n");
+}
+
+TEST(XmlRpcTest, RoundTrip)
+{
+  const XmlRpc::XmlRpcValue params = make_params();
+
+  property_bag::PropertyBag bag;
+  property_bag::from_xmlrpc(params, bag);
+
+  XmlRpc::XmlRpcValue written = property_bag::to_xmlrpc(bag);
+  ASSERT_EQ(XmlRpc::XmlRpcValue::TypeStruct, written.getType());
+  EXPECT_EQ(9, written.size());
+
+  EXPECT_EQ(XmlRpc::XmlRpcValue::TypeDouble, written["robot"]["limits"][1].getType());
+  EXPECT_EQ(2., static_cast<double&>(written["robot"]["limits"][1]));
+  EXPECT_EQ("laser", static_cast<std::string&>(written["sensors"][0]["type"]));
+  EXPECT_EQ(XmlRpc::XmlRpcValue::TypeArray, written["empty"].getType());
+  EXPECT_EQ(XmlRpc::XmlRpcValue::TypeStruct, written["nothing"].getType());
+  EXPECT_EQ(0, written["nothing"].size());
+
+  property_bag::PropertyBag loaded;
+  property_bag::from_xmlrpc(written, loaded);
+
+  EXPECT_EQ(bag.listProperties(), loaded.listProperties());
+  EXPECT_EQ(value_of<std::vector<bool>>(bag, "flags"),
+            value_of<std::vector<bool>>(loaded, "flags"));
+  EXPECT_EQ(value_of<std::vector<double>>(value_of<property_bag::PropertyBag>(bag, "robot"), "limits"),
+            value_of<std::vector<double>>(value_of<property_bag::PropertyBag>(loaded, "robot"), "limits"));
+
+  PRINTF("All good at XmlRpcTest::RoundTrip !\n");
+}
+
+TEST(XmlRpcTest, Errors)
+{
+  property_bag::PropertyBag bag("kept", 1);
+
+  // Not a struct
+  EXPECT_THROW(property_bag::from_xmlrpc(XmlRpc::XmlRpcValue(1), bag),
+               property_bag::PropertyException);
+
+  // Heterogeneous array, the bag is untouched
+  XmlRpc::XmlRpcValue params = make_params();
+  params["robot"]["mixed"][0] = XmlRpc::XmlRpcValue(1);
+  params["robot"]["mixed"][1] = XmlRpc::XmlRpcValue(std::string("one"));
+
+  try
+  {
+    property_bag::from_xmlrpc(params, bag);
+    FAIL() << "Expected a PropertyException";
+  }
+  catch (const property_bag::PropertyException& e)
+  {
+    EXPECT_NE(std::string::npos, std::string(e.what()).find("robot/mixed")) << e.what();
+  }
+
+  EXPECT_EQ(1, bag.size());
+  EXPECT_TRUE(bag.exists("kept"));
+
+  // No parameter type for floats
+  bag.addProperty("my_float", 0.5f);
+  EXPECT_THROW(property_bag::to_xmlrpc(bag), property_bag::PropertyException);
+
+  PRINTF("All good at XmlRpcTest::Errors !\n");
+}
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
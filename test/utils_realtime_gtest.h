@@ -0,0 +1,127 @@
+/**
+ * \file utils_realtime_gtest.h
+ * \brief malloc/free hooks to detect allocations
+ * in a real-time section.
+ */
+
+#ifndef PROPERTY_BAG_UTILS_REALTIME_TESTING_H
+#define PROPERTY_BAG_UTILS_REALTIME_TESTING_H
+
+#include <atomic>
+#include <cstddef>
+
+// Only include in a single translation unit per executable,
+// it replaces the global malloc/calloc/realloc/free.
+// Disabled under sanitizers, which intercept them already.
+
+#if defined(__GLIBC__) && \
+    !defined(__SANITIZE_THREAD__) && !defined(__SANITIZE_ADDRESS__)
+
+extern "C"
+{
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t num, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+void  __libc_free(void* ptr);
+}
+
+namespace test
+{
+namespace realtime
+{
+// Whether the calling thread is in a real-time section.
+inline bool& in_section()
+{
+  static thread_local bool in_section = false;
+  return in_section;
+}
+
+inline std::atomic<std::size_t>& num_calls()
+{
+  static std::atomic<std::size_t> num_calls{0};
+  return num_calls;
+}
+
+inline void record()
+{
+  if (in_section()) num_calls().fetch_add(1, std::memory_order_relaxed);
+}
+} // namespace realtime
+} // namespace test
+
+extern "C"
+{
+void* malloc(std::size_t size)
+{
+  test::realtime::record();
+  return __libc_malloc(size);
+}
+
+void* calloc(std::size_t num, std::size_t size)
+{
+  test::realtime::record();
+  return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, std::size_t size)
+{
+  test::realtime::record();
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+  if (ptr != nullptr) test::realtime::record();
+  __libc_free(ptr);
+}
+}
+
+#define PROPERTY_BAG_HAS_MALLOC_HOOKS 1
+
+#endif // __GLIBC__ && !__SANITIZE_*__
+
+namespace test
+{
+/**
+ * @brief The RealTimeSection class.
+ * RAII scope counting the calls to malloc/free
+ * made by the current thread.
+ */
+class RealTimeSection
+{
+public:
+
+  RealTimeSection()
+  {
+#ifdef PROPERTY_BAG_HAS_MALLOC_HOOKS
+    start_ = realtime::num_calls().load();
+    realtime::in_section() = true;
+#endif
+  }
+
+  ~RealTimeSection() { stop(); }
+
+  /**
+   * @brief stop. Exit the section.
+   * @return the number of malloc/free calls in the section.
+   */
+  std::size_t stop()
+  {
+#ifdef PROPERTY_BAG_HAS_MALLOC_HOOKS
+    if (realtime::in_section())
+    {
+      realtime::in_section() = false;
+      calls_ = realtime::num_calls().load() - start_;
+    }
+#endif
+    return calls_;
+  }
+
+private:
+
+  std::size_t start_ = 0;
+  std::size_t calls_ = 0;
+};
+} // namespace test
+
+#endif /* PROPERTY_BAG_UTILS_REALTIME_TESTING_H */